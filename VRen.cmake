@@ -18,12 +18,23 @@ function (compile_shader _SHADERS IN_PATH OUT_PATH)
     add_custom_command(
             OUTPUT
                 ${OUT_PATH}
+                ${OUT_PATH}.refl # The shader reflection, loaded instead of reflecting the SPIR-V at runtime
                 ${OUT_PATH}__enforce_run # *__enforce_run is a fake output file that won't be created and is here to ensure the command is always run
             COMMAND ${Vulkan_GLSLC_EXECUTABLE} --target-env=vulkan1.3 --target-spv=spv1.4 -I "${VREN_HOME}/vren/resources/shaders" ${ARGN} -o ${OUT_PATH} ${IN_PATH}
+            COMMAND $<TARGET_FILE:vren_reflect_shader> ${OUT_PATH} ${OUT_PATH}.refl
             MAIN_DEPENDENCY ${IN_PATH}
+            DEPENDS vren_reflect_shader
             WORKING_DIRECTORY ${VREN_HOME}
             COMMENT "${Vulkan_GLSLC_EXECUTABLE} --target-env=vulkan1.3 --target-spv=spv1.4 -I \"${VREN_HOME}/vren/resources/shaders\" ${ARGN} -o ${OUT_PATH} ${IN_PATH}"
     )
+
+    # Lists the source of the SPIR-V and its glslc command, read by vren::shader_registry to recompile the shader at runtime
+    if (DEFINED VREN_SHADER_SOURCES_FILE)
+        set(SHADER_SOURCE ${OUT_PATH} ${IN_PATH} ${Vulkan_GLSLC_EXECUTABLE} --target-env=vulkan1.3 --target-spv=spv1.4 -I "${VREN_HOME}/vren/resources/shaders" ${ARGN})
+        string(REPLACE ";" "\t" SHADER_SOURCE "${SHADER_SOURCE}")
+        file(APPEND ${VREN_SHADER_SOURCES_FILE} "${SHADER_SOURCE}\n")
+    endif()
+
     set(SUPER_VAR ${${_SHADERS}})
     list(APPEND SUPER_VAR ${OUT_PATH})
     set(${_SHADERS} ${SUPER_VAR} PARENT_SCOPE)
@@ -55,6 +66,9 @@ function (setup_resources TARGET)
 
     set(SHADERS "")
 
+    set(VREN_SHADER_SOURCES_FILE "${VREN_SHADERS_DIR}/shader_sources.txt")
+    file(WRITE ${VREN_SHADER_SOURCES_FILE} "")
+
     # Pipeline
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/depth_buffer_copy.comp" "${VREN_SHADERS_DIR}/depth_buffer_copy.comp.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/depth_buffer_reduce.comp" "${VREN_SHADERS_DIR}/depth_buffer_reduce.comp.spv")
@@ -62,17 +76,17 @@ function (setup_resources TARGET)
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/debug_draw.vert" "${VREN_SHADERS_DIR}/debug_draw.vert.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/debug_draw.frag" "${VREN_SHADERS_DIR}/debug_draw.frag.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.mesh" "${VREN_SHADERS_DIR}/draw.mesh.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.mesh" "${VREN_SHADERS_DIR}/draw_compressed.mesh.spv" "-DVREN_COMPRESSED_GEOMETRY")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.task" "${VREN_SHADERS_DIR}/draw.task.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.task" "${VREN_SHADERS_DIR}/draw_shadow.task.spv" "-DVREN_SHADOW_CASCADE")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.mesh" "${VREN_SHADERS_DIR}/draw_shadow.mesh.spv" "-DVREN_SHADOW_CASCADE")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/draw.mesh" "${VREN_SHADERS_DIR}/draw_compressed_shadow.mesh.spv" "-DVREN_COMPRESSED_GEOMETRY" "-DVREN_SHADOW_CASCADE")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/pbr_draw.frag" "${VREN_SHADERS_DIR}/pbr_draw.frag.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/deferred.frag" "${VREN_SHADERS_DIR}/deferred.frag.spv")
 
     # Reduce
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_uint_add.comp.spv" "-DVREN_DATA_TYPE=uint" "-DVREN_OPERATION(a,b)=a+b" "-DVREN_OUT_OF_BOUND_VALUE=0")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_uint_min.comp.spv" "-DVREN_DATA_TYPE=uint" "-DVREN_OPERATION(a,b)=min(a,b)" "-DVREN_OUT_OF_BOUND_VALUE=(~0u)")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_uint_max.comp.spv" "-DVREN_DATA_TYPE=uint" "-DVREN_OPERATION(a,b)=max(a,b)" "-DVREN_OUT_OF_BOUND_VALUE=0")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_vec4_add.comp.spv" "-DVREN_DATA_TYPE=vec4" "-DVREN_OPERATION(a,b)=a+b" "-DVREN_OUT_OF_BOUND_VALUE=vec4(0)")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_vec4_min.comp.spv" "-DVREN_DATA_TYPE=vec4" "-DVREN_OPERATION(a,b)=min(a,b)" "-DVREN_OUT_OF_BOUND_VALUE=vec4(1e35)")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_vec4_max.comp.spv" "-DVREN_DATA_TYPE=vec4" "-DVREN_OPERATION(a,b)=max(a,b)" "-DVREN_OUT_OF_BOUND_VALUE=vec4(-1e35)")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_uint.comp.spv" "-DVREN_DATA_TYPE=uint" "-DVREN_DATA_TYPE_LOWEST=0" "-DVREN_DATA_TYPE_HIGHEST=(~0u)")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/reduce.comp" "${VREN_SHADERS_DIR}/reduce_vec4.comp.spv" "-DVREN_DATA_TYPE=vec4" "-DVREN_DATA_TYPE_LOWEST=vec4(-1e35)" "-DVREN_DATA_TYPE_HIGHEST=vec4(1e35)")
 
     # Blelloch scan
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/blelloch_scan_downsweep.comp" "${VREN_SHADERS_DIR}/blelloch_scan_downsweep.comp.spv" "-D_VREN_DOWNSWEEP_ENTRYPOINT")
@@ -92,12 +106,28 @@ function (setup_resources TARGET)
 
     # Clustered shading
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/point_light_position_to_view_space.comp" "${VREN_SHADERS_DIR}/clustered_shading/point_light_position_to_view_space.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/spot_light_to_view_space.comp" "${VREN_SHADERS_DIR}/clustered_shading/spot_light_to_view_space.comp.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/discretize_point_light_positions.comp" "${VREN_SHADERS_DIR}/clustered_shading/discretize_point_light_positions.comp.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/init_light_array_bvh.comp" "${VREN_SHADERS_DIR}/clustered_shading/init_light_array_bvh.comp.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/find_unique_clusters.comp" "${VREN_SHADERS_DIR}/clustered_shading/find_unique_clusters.comp.spv")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/assign_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/assign_lights_count.comp.spv" "-DVREN_CLUSTERED_SHADING_LIGHT_ASSIGNMENT_COUNT" "-g")
-    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/assign_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/assign_lights_write.comp.spv" "-DVREN_CLUSTERED_SHADING_LIGHT_ASSIGNMENT_WRITE" "-g")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/find_unique_clusters.comp" "${VREN_SHADERS_DIR}/clustered_shading/find_unique_clusters_temporal.comp.spv" "-DVREN_CLUSTERED_SHADING_TEMPORAL")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/find_unique_clusters.comp" "${VREN_SHADERS_DIR}/clustered_shading/find_unique_clusters_64_bit_keys.comp.spv" "-DVREN_CLUSTERED_SHADING_64_BIT_KEYS")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/assign_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/assign_lights.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/assign_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/assign_lights_temporal.comp.spv" "-DVREN_CLUSTERED_SHADING_TEMPORAL")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/assign_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/assign_lights_64_bit_keys.comp.spv" "-DVREN_CLUSTERED_SHADING_64_BIT_KEYS")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/bin_lights.comp" "${VREN_SHADERS_DIR}/clustered_shading/bin_lights.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/gather_pixel_materials.comp" "${VREN_SHADERS_DIR}/clustered_shading/gather_pixel_materials.comp.spv")
     compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/shade.comp" "${VREN_SHADERS_DIR}/clustered_shading/shade.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/shade.comp" "${VREN_SHADERS_DIR}/clustered_shading/shade_froxels.comp.spv" "-DVREN_CLUSTERED_SHADING_FROXEL_LIGHT_BITMASKS")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/shade.comp" "${VREN_SHADERS_DIR}/clustered_shading/shade_material_sorted.comp.spv" "-DVREN_CLUSTERED_SHADING_MATERIAL_SORTED_PIXELS")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/clustered_shading/shade.comp" "${VREN_SHADERS_DIR}/clustered_shading/shade_shared_lights.comp.spv" "-DVREN_CLUSTERED_SHADING_SHARED_LIGHTS")
+
+    # Light simulation
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/light_simulation/reset_light_simulation.comp" "${VREN_SHADERS_DIR}/light_simulation/reset_light_simulation.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/light_simulation/spawn_lights.comp" "${VREN_SHADERS_DIR}/light_simulation/spawn_lights.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/light_simulation/prepare_light_simulation.comp" "${VREN_SHADERS_DIR}/light_simulation/prepare_light_simulation.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/light_simulation/simulate_lights.comp" "${VREN_SHADERS_DIR}/light_simulation/simulate_lights.comp.spv")
+    compile_shader(SHADERS "${VREN_HOME}/vren/resources/shaders/light_simulation/clear_dead_lights.comp" "${VREN_SHADERS_DIR}/light_simulation/clear_dead_lights.comp.spv")
 
     add_custom_target(vren_${TARGET}_shaders DEPENDS ${SHADERS})
 
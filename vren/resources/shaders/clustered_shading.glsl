@@ -1,10 +1,13 @@
 #ifndef VREN_CLUSTERED_SHADING_H_
 #define VREN_CLUSTERED_SHADING_H_
 
+#include <vren.glsl>
+
 /**
- * Discretize and pack cluster's normal in 6 bits. Return UINT32_MAX if the normal is null
+ * Discretize the normal on a grid_size x grid_size grid on every cube face, returns an index lower than 6 * grid_size^2.
+ * Return UINT32_MAX if the normal is null
  */
-uint clustered_shading_discretize_normal(vec3 normal)
+uint clustered_shading_discretize_normal(vec3 normal, uint grid_size)
 {
 	if (normal == vec3(0))
 	{
@@ -32,48 +35,39 @@ uint clustered_shading_discretize_normal(vec3 normal)
 	uv.x = p[(axis + 1) % 3];
 	uv.y = p[(axis + 2) % 3];
 
-	// Encode normal by packing the face index and face's grid index in 6 bits
-	//uvec2 disc_uv = uvec2(round(uv + 1)); TODO
-	uvec2 disc_uv = uvec2(floor((uv + 1) / 2.0 * 3.0));
-	uint disc_normal = face_idx * (3 * 3) + disc_uv.x * 3 + disc_uv.y;
-
-	disc_normal &= 0x3F;
+	// Encode normal by packing the face index and face's grid index
+	uvec2 disc_uv = min(uvec2(floor((uv + 1) / 2.0 * grid_size)), uvec2(grid_size - 1));
+	uint disc_normal = face_idx * (grid_size * grid_size) + disc_uv.x * grid_size + disc_uv.y;
 
 	return disc_normal;
 }
 
-uvec3 clustered_shading_decode_normal_idx(uint normal_idx)
+uvec3 clustered_shading_decode_normal_idx(uint normal_idx, uint grid_size)
 {
-	uint face_idx = normal_idx / (3 * 3);
+	uint face_idx = normal_idx / (grid_size * grid_size);
 	
 	uvec2 uv;
-	uv.x = (normal_idx / 3) % 3;
-	uv.y = normal_idx % 3;
+	uv.x = (normal_idx / grid_size) % grid_size;
+	uv.y = normal_idx % grid_size;
 
 	return uvec3(face_idx, uv.x, uv.y);
 }
 
-// void clustered_shading_encode_cluster_key(...)
-
-void clustered_shading_decode_cluster_key(
-	uint cluster_key,
-	out uvec3 cluster_ijk,
-	out uint cluster_normal_idx
-)
+/**
+ * The exponential depth slice of the view-space depth, the slices split the range between the camera near and far planes
+ */
+uint clustered_shading_calc_cluster_slice(float view_z, float camera_near, float camera_far, uint depth_slice_count)
 {
-	cluster_ijk = uvec3(
-		cluster_key & 0xFF,
-		(cluster_key >> 8) & 0xFF,
-		(cluster_key >> 16) & 0x3FF
-	);
-	cluster_normal_idx = cluster_key >> 26;
+	float slice = log(view_z / camera_near) / log(camera_far / camera_near) * depth_slice_count;
+	return uint(clamp(slice, 0.0, float(depth_slice_count - 1)));
 }
 
 void clustered_shading_calc_cluster_aabb(
 	uvec3 cluster_ijk,
 	uvec2 num_tiles,
+	uint depth_slice_count,
 	float camera_near,
-	float camera_half_fov,
+	float camera_far,
 	mat4 camera_proj,
 	out vec4 cluster_min,
 	out vec4 cluster_max
@@ -95,30 +89,110 @@ void clustered_shading_calc_cluster_aabb(
 	cluster_max = inverse_proj * cluster_max;
 	cluster_max /= cluster_max.w;
 
-	// Apply cluster's depth in view space
-	float a = 2 * tan(camera_half_fov) / num_tiles.y + 1.0;
-	float cluster_near = camera_near * pow(a, cluster_ijk.z);
-	float cluster_far = cluster_near * a;
+	// Apply cluster's depth in view space (see clustered_shading_calc_cluster_slice)
+	float cluster_near = camera_near * pow(camera_far / camera_near, cluster_ijk.z / float(depth_slice_count));
+	float cluster_far = camera_near * pow(camera_far / camera_near, (cluster_ijk.z + 1) / float(depth_slice_count));
+
+	vec3 d1 = cluster_min.xyz / cluster_min.z;
+	vec3 d2 = cluster_max.xyz / cluster_max.z;
+
+	// The cluster is a frustum slice, its AABB has to enclose the tile corners on both the near and the far plane
+	vec3 p1 = cluster_near * d1;
+	vec3 p2 = cluster_near * d2;
+	vec3 p3 = cluster_far * d1;
+	vec3 p4 = cluster_far * d2;
+
+	cluster_min = vec4(min(min(p1, p2), min(p3, p4)), 1);
+	cluster_max = vec4(max(max(p1, p2), max(p3, p4)), 1);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Cluster keys
+// ------------------------------------------------------------------------------------------------
+
+#ifdef VREN_CLUSTERED_SHADING_CLUSTER_GRID
+
+/* The cluster key packs, from the lowest bits, the tile coordinates, the depth slice and the normal cone index. The field widths
+ * are sized by the host for the cluster grid and the max screen (see vren::clustered_shading::cluster_key_layout), the keys
+ * are 64-bit if VREN_CLUSTERED_SHADING_64_BIT_KEYS is defined (GL_EXT_shader_explicit_arithmetic_types_int64 is then required).
+ */
+layout(constant_id = 2) const uint k_cluster_key_x_bits = 6;
+layout(constant_id = 3) const uint k_cluster_key_y_bits = 6;
+layout(constant_id = 4) const uint k_cluster_key_z_bits = 10;
+layout(constant_id = 5) const uint k_cluster_key_normal_bits = 6; // Zero if the normals are ignored
+layout(constant_id = 6) const uint k_cluster_depth_slice_count = 1024;
+layout(constant_id = 7) const uint k_cluster_normal_grid_size = 3;
+
+#ifdef VREN_CLUSTERED_SHADING_64_BIT_KEYS
+#define VREN_CLUSTER_KEY_T uint64_t
+#else
+#define VREN_CLUSTER_KEY_T uint
+#endif
+
+// All the bits of the normal field set: the pixels without normal (i.e. the background), never a valid normal cone index
+#define VREN_CLUSTER_NULL_NORMAL_IDX ((1u << k_cluster_key_normal_bits) - 1u)
+
+uint clustered_shading_calc_cluster_normal_idx(vec3 normal)
+{
+	if (k_cluster_key_normal_bits == 0)
+	{
+		return 0;
+	}
+
+	uint normal_idx = clustered_shading_discretize_normal(normal, k_cluster_normal_grid_size);
+	return min(normal_idx, VREN_CLUSTER_NULL_NORMAL_IDX);
+}
+
+VREN_CLUSTER_KEY_T clustered_shading_encode_cluster_key(uvec3 cluster_ijk, uint cluster_normal_idx)
+{
+	VREN_CLUSTER_KEY_T cluster_key =
+		VREN_CLUSTER_KEY_T(cluster_ijk.x) |
+		(VREN_CLUSTER_KEY_T(cluster_ijk.y) << k_cluster_key_x_bits) |
+		(VREN_CLUSTER_KEY_T(cluster_ijk.z) << (k_cluster_key_x_bits + k_cluster_key_y_bits));
 
-	vec3 d1 = normalize(cluster_min.xyz);
-	vec3 d2 = normalize(cluster_max.xyz);
+	// Shifting by the key width is undefined, the normal field may be empty and the other fields fill the key
+	if (k_cluster_key_normal_bits > 0)
+	{
+		cluster_key |= VREN_CLUSTER_KEY_T(cluster_normal_idx) << (k_cluster_key_x_bits + k_cluster_key_y_bits + k_cluster_key_z_bits);
+	}
 
-	cluster_min = vec4(cluster_near / d1.z * d1, 1);
-	cluster_max = vec4(cluster_far / d2.z * d2, 1);
+	return cluster_key;
+}
 
-	// TODO cluster_min = min( ... ), cluster_max = max( ... )
+uint clustered_shading_extract_cluster_key_bits(VREN_CLUSTER_KEY_T cluster_key, uint offset, uint count)
+{
+	return uint(cluster_key >> offset) & ((1u << count) - 1u);
 }
 
+void clustered_shading_decode_cluster_key(
+	VREN_CLUSTER_KEY_T cluster_key,
+	out uvec3 cluster_ijk,
+	out uint cluster_normal_idx
+)
+{
+	cluster_ijk = uvec3(
+		clustered_shading_extract_cluster_key_bits(cluster_key, 0, k_cluster_key_x_bits),
+		clustered_shading_extract_cluster_key_bits(cluster_key, k_cluster_key_x_bits, k_cluster_key_y_bits),
+		clustered_shading_extract_cluster_key_bits(cluster_key, k_cluster_key_x_bits + k_cluster_key_y_bits, k_cluster_key_z_bits)
+	);
+	cluster_normal_idx = k_cluster_key_normal_bits > 0
+		? clustered_shading_extract_cluster_key_bits(cluster_key, k_cluster_key_x_bits + k_cluster_key_y_bits + k_cluster_key_z_bits, k_cluster_key_normal_bits)
+		: 0;
+}
+
+#endif // VREN_CLUSTERED_SHADING_CLUSTER_GRID
+
 float clustered_shading_get_light_intensity(
 	vec3 point_light_pos,
 	vec3 cluster_min,
 	vec3 cluster_max,
-	uint cluster_normal_idx
+	uint cluster_normal_idx,
+	uint normal_grid_size
 )
 {
 	vec3 v;
 
-	uvec3 decoded_normal_idx = clustered_shading_decode_normal_idx(cluster_normal_idx);
+	uvec3 decoded_normal_idx = clustered_shading_decode_normal_idx(cluster_normal_idx, normal_grid_size);
 
 	// Build cluster cone
 	vec3 cluster_pos = (cluster_max + cluster_min) / 2.0;
@@ -130,8 +204,8 @@ float clustered_shading_get_light_intensity(
 	uvec2 uv = decoded_normal_idx.yz;
 
 	v[face_axis] = (decoded_normal_idx.x / 3) == 1 ? 1 : -1;
-	v[u_component] = ((uv.x + 0.5) / 3.0) * 2.0 - 1.0;
-	v[v_component] = ((uv.y + 0.5) / 3.0) * 2.0 - 1.0;
+	v[u_component] = ((uv.x + 0.5) / float(normal_grid_size)) * 2.0 - 1.0;
+	v[v_component] = ((uv.y + 0.5) / float(normal_grid_size)) * 2.0 - 1.0;
 
 	vec3 cluster_normal = normalize(v);
 
@@ -139,8 +213,8 @@ float clustered_shading_get_light_intensity(
 
 	for (uint i = 0; i < 4; i++)
 	{
-		v[u_component] = ((uv.x + (i & 1)) / 3.0) * 2.0 - 1.0;
-		v[v_component] = ((uv.y + ((i >> 1) & 1)) / 3.0) * 2.0 - 1.0;
+		v[u_component] = ((uv.x + (i & 1)) / float(normal_grid_size)) * 2.0 - 1.0;
+		v[v_component] = ((uv.y + ((i >> 1) & 1)) / float(normal_grid_size)) * 2.0 - 1.0;
 
 		alpha = max(alpha, acos(dot(v, cluster_normal) / length(v)));
 	}
@@ -168,4 +242,151 @@ float clustered_shading_get_light_intensity(
 	return 1.0;
 }
 
+// ------------------------------------------------------------------------------------------------
+// Froxels
+// ------------------------------------------------------------------------------------------------
+
+uvec2 clustered_shading_calc_froxel_tile_count(uvec2 screen)
+{
+	return (screen + uvec2(VREN_FROXEL_TILE_SIZE - 1)) / VREN_FROXEL_TILE_SIZE;
+}
+
+/**
+ * The froxel depth slices are exponentially distributed between the camera near and far planes.
+ */
+uint clustered_shading_calc_froxel_slice(float view_z, float camera_near, float camera_far)
+{
+	float slice = log(view_z / camera_near) / log(camera_far / camera_near) * VREN_FROXEL_DEPTH_SLICE_COUNT;
+	return uint(clamp(slice, 0.0, VREN_FROXEL_DEPTH_SLICE_COUNT - 1));
+}
+
+uint clustered_shading_calc_froxel_idx(uvec3 froxel_ijk, uvec2 tile_count)
+{
+	return (froxel_ijk.z * tile_count.y + froxel_ijk.y) * tile_count.x + froxel_ijk.x;
+}
+
+void clustered_shading_calc_froxel_aabb(
+	uvec3 froxel_ijk,
+	uvec2 screen,
+	float camera_near,
+	float camera_far,
+	mat4 camera_inverse_proj,
+	out vec3 froxel_min,
+	out vec3 froxel_max
+)
+{
+	// Screen space tile min and tile max, the last tile could be partially outside of the screen
+	vec2 tile_min = vec2(froxel_ijk.xy * VREN_FROXEL_TILE_SIZE) / vec2(screen);
+	vec2 tile_max = min(vec2((froxel_ijk.xy + 1) * VREN_FROXEL_TILE_SIZE) / vec2(screen), vec2(1));
+
+	// Directions through the tile corners, scaled to have z = 1 in view space
+	vec4 p1 = camera_inverse_proj * vec4(vec2(tile_min.x, 1.0 - tile_min.y) * 2.0 - 1.0, 0.0, 1.0);
+	vec4 p2 = camera_inverse_proj * vec4(vec2(tile_max.x, 1.0 - tile_max.y) * 2.0 - 1.0, 0.0, 1.0);
+
+	vec3 d1 = p1.xyz / p1.z;
+	vec3 d2 = p2.xyz / p2.z;
+
+	float slice_near = camera_near * pow(camera_far / camera_near, float(froxel_ijk.z) / VREN_FROXEL_DEPTH_SLICE_COUNT);
+	float slice_far = camera_near * pow(camera_far / camera_near, float(froxel_ijk.z + 1) / VREN_FROXEL_DEPTH_SLICE_COUNT);
+
+	froxel_min = min(min(slice_near * d1, slice_near * d2), min(slice_far * d1, slice_far * d2));
+	froxel_max = max(max(slice_near * d1, slice_near * d2), max(slice_far * d1, slice_far * d2));
+}
+
+/**
+ * Tests a light sphere (or a BVH node sphere) against a cluster or froxel AABB.
+ * https://developer.mozilla.org/en-US/docs/Games/Techniques/3D_collision_detection
+ */
+bool clustered_shading_test_sphere_aabb(vec3 sphere_o, float sphere_r, vec3 aabb_min, vec3 aabb_max)
+{
+	vec3 d = max(aabb_min, min(sphere_o, aabb_max)) - sphere_o;
+	return dot(d, d) < sphere_r * sphere_r;
+}
+
+// ------------------------------------------------------------------------------------------------
+// Spot lights
+// ------------------------------------------------------------------------------------------------
+
+// The spot lights share the assigned light lists with the point lights, their indices are marked by this bit
+#define VREN_ASSIGNED_SPOT_LIGHT_BIT 0x80000000u
+
+struct ViewSpaceSpotLight
+{
+	vec3 position;  float radius;
+	vec3 direction; float outer_cone_cos;
+};
+
+/**
+ * Tests the spot light cone against the bounding sphere of the AABB.
+ * https://bartwronski.com/2017/04/13/cull-that-cone/
+ */
+bool clustered_shading_test_spot_light_aabb(ViewSpaceSpotLight spot_light, vec3 aabb_min, vec3 aabb_max)
+{
+	vec3 sphere_o = (aabb_min + aabb_max) / 2.0;
+	float sphere_r = length(aabb_max - aabb_min) / 2.0;
+
+	vec3 v = sphere_o - spot_light.position;
+	float v_len_sq = dot(v, v);
+	float v1_len = dot(v, spot_light.direction);
+
+	float cone_sin = sqrt(max(1.0 - spot_light.outer_cone_cos * spot_light.outer_cone_cos, 0.0));
+	float distance_closest_point = spot_light.outer_cone_cos * sqrt(max(v_len_sq - v1_len * v1_len, 0.0)) - v1_len * cone_sin;
+
+	bool angle_cull = distance_closest_point > sphere_r;
+	bool front_cull = v1_len > sphere_r + spot_light.radius;
+	bool back_cull = v1_len < -sphere_r;
+	return !(angle_cull || front_cull || back_cull);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Temporal cluster reuse
+// ------------------------------------------------------------------------------------------------
+
+/**
+ * An entry of the persistent cluster hash table. The frame stamp is the last frame the cluster was seen in, the light epoch
+ * the epoch its light list was assigned in. A cleared entry is all ones.
+ */
+struct ClusterHashTableEntry
+{
+	uint key;
+	uint frame_stamp;
+	uint light_epoch;
+	uint _pad;
+};
+
+struct TemporalClusterStatistics
+{
+	uint changed_tile_count;
+	uint inserted_cluster_count;
+	uint reused_cluster_count;
+	uint assigned_cluster_count;
+	uint assigned_light_allocator_end; // The highest assigned light index allocated
+	uint _pad[3];
+};
+
+struct ClusterStatistics
+{
+	uint cluster_count;
+	uint assigned_light_count; // The sum of the light counts of the clusters
+	uint max_cluster_light_count;
+	uint _pad;
+	uint light_count_histogram[VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE];
+};
+
+uint clustered_shading_calc_light_count_histogram_bucket(uint light_count)
+{
+	return light_count == 0 ? 0 : min(uint(findMSB(light_count)) + 1, VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE - 1);
+}
+
+// https://nullprogram.com/blog/2018/07/31/ (lowbias32)
+uint clustered_shading_hash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
 #endif // VREN_CLUSTERED_SHADING_H_
@@ -32,6 +32,34 @@ struct Vertex
     vec2 texcoord; float _pad2[2];
 };
 
+struct CompressedVertex
+{
+	uint position_xy; // snorm16x2, relative to the meshlet bounding sphere
+	uint position_z;  // snorm16x2, the upper half is padding to a 16-byte stride (see vren::compressed_vertex)
+	uint normal;      // snorm16x2, octahedral-encoded
+	uint texcoord;    // half2x16
+};
+
+vec3 oct_decode(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	if (v.z < 0)
+	{
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(v);
+}
+
+Vertex decode_compressed_vertex(CompressedVertex compressed_vertex, Sphere meshlet_bounding_sphere)
+{
+	Vertex vertex;
+	vec3 local_position = vec3(unpackSnorm2x16(compressed_vertex.position_xy), unpackSnorm2x16(compressed_vertex.position_z).x);
+	vertex.position = meshlet_bounding_sphere.center + local_position * meshlet_bounding_sphere.radius;
+	vertex.normal = oct_decode(unpackSnorm2x16(compressed_vertex.normal));
+	vertex.texcoord = unpackHalf2x16(compressed_vertex.texcoord);
+	return vertex;
+}
+
 struct Meshlet
 {
 	uint vertex_offset;
@@ -85,11 +113,37 @@ struct DirectionalLight
 
 struct SpotLight
 {
-	vec3 direction; float _pad;
-	vec3 color;
-	float radius;
+	// The position is stored in a separate buffer
+	vec3 direction; float intensity;
+	vec3 color;     float inner_cone_cos;
+	float outer_cone_cos;
+	float _pad[3];
+};
+
+struct ShadowCascade
+{
+	mat4 view_projection;
+	float split_far;
+	float texel_world_size;
+	float _pad[2];
 };
 
+/**
+ * The point light attenuation is inverse-square, windowed so that it smoothly reaches zero at the light radius.
+ * The radius is the distance at which the unwindowed attenuation falls below the attenuation threshold.
+ * Keep in sync with vren::calc_point_light_radius.
+ */
+float calc_point_light_radius(float intensity, float attenuation_threshold)
+{
+	return sqrt(max(intensity / attenuation_threshold - 1.0, 0.0));
+}
+
+float calc_point_light_attenuation(float distance, float intensity, float radius)
+{
+	float window = clamp(1.0 - pow(distance / radius, 4.0), 0.0, 1.0);
+	return intensity / (distance * distance + 1.0) * window * window;
+}
+
 struct DebugDrawBufferVertex
 {
 	vec3 position;
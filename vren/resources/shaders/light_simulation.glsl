@@ -0,0 +1,48 @@
+#ifndef VREN_LIGHT_SIMULATION_H_
+#define VREN_LIGHT_SIMULATION_H_
+
+// Mirrors vren::light_simulation_bounds_mode
+#define VREN_LIGHT_SIMULATION_BOUNDS_NONE 0
+#define VREN_LIGHT_SIMULATION_BOUNDS_BOUNCE 1
+#define VREN_LIGHT_SIMULATION_BOUNDS_KILL 2
+
+struct LightParticle
+{
+	vec3 position; float remaining_lifetime; // Infinite for the lights that never die
+	vec3 velocity; float intensity;          // The intensity before the fade out
+	vec3 color; float _pad;
+};
+
+/**
+ * The dead list is consumed by the spawn (from the top) and appended by the simulation, the alive lists are swapped at every
+ * simulation step: the alive particles are consumed from one and the survivors are appended to the other.
+ */
+struct LightSimulationState
+{
+	uint dispatch_params[3]; // The indirect dispatch of the simulation, over the alive particles
+	int dead_count;
+	uint alive_counts[2];
+	uint _pad[2];
+};
+
+// https://nullprogram.com/blog/2018/07/31/ (lowbias32)
+uint light_simulation_hash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+/**
+ * Returns a random number in [0, 1) and advances the given state.
+ */
+float light_simulation_random(inout uint state)
+{
+	state = light_simulation_hash(state);
+	return float(state >> 8) / float(1u << 24);
+}
+
+#endif // VREN_LIGHT_SIMULATION_H_
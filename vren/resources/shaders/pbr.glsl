@@ -78,6 +78,7 @@ vec3 pbr_apply_point_light(
     vec3 N,
     vec3 light_position,
     PointLight point_light,
+    float light_radius,
     vec3 albedo,
     float metallic,
     float roughness
@@ -86,8 +87,32 @@ vec3 pbr_apply_point_light(
     vec3 d = p - light_position;
     vec3 L = normalize(d);
 
-    float intensity = 1.0 - pow(min(length(d) / point_light.intensity, 1.0), 1.5);
-    vec3 radiance = point_light.color * intensity;
+    float attenuation = calc_point_light_attenuation(length(d), point_light.intensity, light_radius);
+    vec3 radiance = point_light.color * attenuation;
+
+    return pbr_apply_light(eye, p, N, L, radiance, albedo, metallic, roughness);
+}
+
+vec3 pbr_apply_spot_light(
+    vec3 eye,
+    vec3 p,
+    vec3 N,
+    vec3 light_position,
+    SpotLight spot_light,
+    float light_radius,
+    vec3 albedo,
+    float metallic,
+    float roughness
+)
+{
+    vec3 d = p - light_position;
+    vec3 L = normalize(d);
+
+    // Distance attenuation as for the point lights, faded out between the inner and the outer cone
+    float attenuation = calc_point_light_attenuation(length(d), spot_light.intensity, light_radius);
+    attenuation *= smoothstep(spot_light.outer_cone_cos, spot_light.inner_cone_cos, dot(L, spot_light.direction));
+
+    vec3 radiance = spot_light.color * attenuation;
 
     return pbr_apply_light(eye, p, N, L, radiance, albedo, metallic, roughness);
 }
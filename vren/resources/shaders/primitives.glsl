@@ -66,7 +66,8 @@
 	}
 
 // https://en.wikipedia.org/wiki/Bitonic_sorter
-#define VREN_WORKGROUP_BITONIC_SORT(_inout_array, _in_length) \
+// The elements are sorted by their x component, _type is the element type (e.g. uvec2, u64vec2)
+#define VREN_WORKGROUP_BITONIC_SORT_T(_type, _inout_array, _in_length) \
 	for (uint _k = 2; _k <= _in_length; _k *= 2) \
 	{ \
 		for (uint _j = _k / 2; _j > 0; _j /= 2) \
@@ -77,7 +78,7 @@
 			{ \
 				if ((((_i & _k) == 0) && _inout_array[_i].x > _inout_array[_l].x) || (((_i & _k) != 0) && _inout_array[_i].x < _inout_array[_l].x)) \
 				{ \
-					uvec2 _tmp = _inout_array[_i]; \
+					_type _tmp = _inout_array[_i]; \
 					_inout_array[_i] = _inout_array[_l]; \
 					_inout_array[_l] = _tmp; \
 				} \
@@ -87,4 +88,7 @@
 		} \
 	}
 
+#define VREN_WORKGROUP_BITONIC_SORT(_inout_array, _in_length) \
+	VREN_WORKGROUP_BITONIC_SORT_T(uvec2, _inout_array, _in_length)
+
 #endif // PRIMITIVES_H
@@ -1,4 +1,35 @@
 #ifndef VREN_H_
 #define VREN_H_
 
+// ------------------------------------------------------------------------------------------------
+// Froxel light binning (shared between host and shaders)
+// ------------------------------------------------------------------------------------------------
+
+#define VREN_FROXEL_TILE_SIZE 64
+#define VREN_FROXEL_DEPTH_SLICE_COUNT 32
+#define VREN_FROXEL_MAX_LIGHT_COUNT 4096
+#define VREN_FROXEL_LIGHT_WORD_COUNT (VREN_FROXEL_MAX_LIGHT_COUNT / 32)
+
+// ------------------------------------------------------------------------------------------------
+// Cluster statistics (shared between host and shaders)
+// ------------------------------------------------------------------------------------------------
+
+// Bucket 0 counts the clusters without lights, bucket i the clusters with [2^(i-1), 2^i) lights, the last bucket is unbounded
+#define VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE 16
+
+// ------------------------------------------------------------------------------------------------
+// Temporal cluster reuse (shared between host and shaders)
+// ------------------------------------------------------------------------------------------------
+
+// Slots of the persistent cluster hash table, must be a power of two. It's cleared when a quarter of it is occupied
+#define VREN_CLUSTER_HASH_TABLE_CAPACITY (1 << 19)
+#define VREN_CLUSTER_HASH_TABLE_EMPTY_KEY 0xFFFFFFFFu
+#define VREN_CLUSTER_HASH_TABLE_INVALID_SLOT VREN_CLUSTER_HASH_TABLE_CAPACITY // Referenced when the table is full, has no light assigned
+
+// ------------------------------------------------------------------------------------------------
+// Cascaded shadow maps (shared between host and shaders)
+// ------------------------------------------------------------------------------------------------
+
+#define VREN_SHADOW_CASCADE_COUNT 4
+
 #endif // VREN_H_
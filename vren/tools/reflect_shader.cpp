@@ -0,0 +1,48 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "vk_helpers/shader_reflection.hpp"
+
+// Usage: vren_reflect_shader <shader.spv> <shader.spv.refl>
+// Run by compile_shader right after glslc, writes the reflection loaded by vren::load_shader_module_from_file.
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: %s <shader.spv> <shader.spv.refl>\n", argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		std::ifstream f(argv[1], std::ios::ate | std::ios::binary);
+		if (!f.is_open())
+		{
+			throw std::runtime_error("Failed to open the SPIR-V file");
+		}
+
+		// Padded to a multiple of 4 bytes like the SPIR-V loaded by vren::load_shader_module_from_file, so that the hashes match
+		size_t file_size = f.tellg();
+		std::vector<uint32_t> code((file_size + sizeof(uint32_t) - 1) / sizeof(uint32_t), 0);
+
+		f.seekg(0);
+		f.read(reinterpret_cast<char*>(code.data()), file_size);
+		if (!f)
+		{
+			throw std::runtime_error("Failed to read the SPIR-V file");
+		}
+
+		vren::shader_reflection reflection = vren::reflect_shader(code.data(), code.size(), argv[1]);
+		vren::write_shader_reflection_file(argv[2], reflection, vren::hash_spirv_code(code.data(), code.size()));
+	}
+	catch (std::exception const& exception)
+	{
+		std::fprintf(stderr, "%s: %s\n", argv[1], exception.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -38,8 +38,9 @@ void vren::bounding_sphere::operator+=(bounding_sphere const& other)
 	}
 	else
 	{
-		float r = m_radius + other.m_radius + glm::length(m_center - other.m_center) / 2.0f;
-		m_center = m_center + (other.m_center - m_center) * (r - m_radius) / glm::length(m_center - other.m_center);
+		float d = glm::length(m_center - other.m_center);
+		float r = (m_radius + other.m_radius + d) / 2.0f;
+		m_center = m_center + (other.m_center - m_center) * (r - m_radius) / d;
 		m_radius = r;
 	}
 }
@@ -1,131 +1,278 @@
 #include "kd_tree.hpp"
 
 #include <cassert>
+#include <array>
+#include <algorithm>
+#include <execution>
 
-size_t vren::kd_tree_build(
-	float const* points,
-	size_t point_stride,
-	uint32_t* indices,
-	size_t count,
-	kd_tree_node* kd_tree,
-	size_t node_offset,
-	size_t max_leaf_point_count
-)
+namespace
 {
-	assert(count > 0);
-
-	if (count <= max_leaf_point_count)
+	size_t build_kd_tree_leaf(uint32_t const* indices, size_t count, vren::kd_tree_node* kd_tree, size_t node_offset)
 	{
-		kd_tree_node& first_leaf_node = kd_tree[node_offset];
+		vren::kd_tree_node& first_leaf_node = kd_tree[node_offset];
 		first_leaf_node.m_index = indices[0];
-		first_leaf_node.m_axis = 0x3;
+		first_leaf_node.m_axis = vren::k_kd_tree_leaf_axis;
 		first_leaf_node.m_leaf_count = count;
 
 		for (uint32_t i = 1; i < count; i++)
 		{
-			kd_tree_node& leaf_node = kd_tree[node_offset + i];
+			vren::kd_tree_node& leaf_node = kd_tree[node_offset + i];
 			leaf_node.m_index = indices[i];
-			leaf_node.m_axis = 0x3;
+			leaf_node.m_axis = vren::k_kd_tree_leaf_axis;
 			leaf_node.m_leaf_count = ~0;
 		}
 		return node_offset + count;
 	}
 
-	float mean[3] = {};
-	float variance[3] = {};
-	float n = 1.0f;
-
-	for (uint32_t i = 0; i < count; i++, n += 1.0f)
+	/// Returns the axis of greatest variance, the mean of the points is written to mean.
+	uint32_t calc_split_axis(float const* points, size_t point_stride, uint32_t const* indices, size_t count, float* mean)
 	{
-		float const* point = points + indices[i] * point_stride;
-		for (uint32_t j = 0; j < 3; j++)
+		float variance[3] = {};
+		float n = 1.0f;
+
+		mean[0] = mean[1] = mean[2] = 0.0f;
+
+		for (uint32_t i = 0; i < count; i++, n += 1.0f)
 		{
-			float d = point[j] - mean[j];
-			mean[j] += d / n;
-			variance[j] += (point[j] - mean[j]) * d; // Welford algorithm for computing variance
+			float const* point = points + indices[i] * point_stride;
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				float d = point[j] - mean[j];
+				mean[j] += d / n;
+				variance[j] += (point[j] - mean[j]) * d; // Welford algorithm for computing variance
+			}
 		}
+
+		// variance[j] /= float(point_count - 1)
+		// We don't need to divide since we don't need the exact variance value, we just have to compare the greatest axis
+
+		return variance[0] > variance[1] && variance[0] > variance[2] ? 0 : (variance[1] > variance[2] ? 1 : 2);
+	}
+
+	/// Partitions the indices so that the first half of the points precedes the second half along the axis, returns the split.
+	float split_at_median(float const* points, size_t point_stride, uint32_t* indices, size_t count, uint32_t axis)
+	{
+		size_t middle = count / 2;
+		std::nth_element(indices, indices + middle, indices + count, [&](uint32_t a, uint32_t b)
+		{
+			return points[a * point_stride + axis] < points[b * point_stride + axis];
+		});
+		return points[indices[middle] * point_stride + axis];
 	}
 
-	// variance[j] /= float(point_count - 1)
-	// We don't need to divide since we don't need the exact variance value, we just have to compare the greatest axis
+	void write_kd_tree_split_node(vren::kd_tree_node* kd_tree, size_t node_offset, uint32_t axis, float split, size_t right_child_offset)
+	{
+		vren::kd_tree_node& node = kd_tree[node_offset];
+		node.m_split = split;
+		node.m_axis = axis;
+		node.m_right_child_distance = right_child_offset - node_offset;
+	}
 
-	uint32_t axis = variance[0] > variance[1] && variance[0] > variance[1] ? 0 : (variance[1] > variance[2] ? 1 : 2);
-	float split = mean[axis];
+	/// The median split of the (at most 2^32) remaining points adds at most 32 levels: the tree never exceeds k_kd_tree_max_depth.
+	const uint32_t k_max_mean_split_depth = vren::k_kd_tree_max_depth - 32;
 
-	size_t middle = 0;
-	for (uint32_t i = 0; i < count; i++)
+	size_t build_kd_tree_mean(
+		float const* points,
+		size_t point_stride,
+		uint32_t* indices,
+		size_t count,
+		vren::kd_tree_node* kd_tree,
+		size_t node_offset,
+		size_t max_leaf_point_count,
+		uint32_t depth
+	)
 	{
-		float const* point = points + indices[i] * point_stride;
+		assert(count > 0);
 
-		if (point[axis] < split)
+		if (count <= max_leaf_point_count)
 		{
-			uint32_t tmp = indices[i];
-			indices[i] = indices[middle];
-			indices[middle] = tmp;
+			return build_kd_tree_leaf(indices, count, kd_tree, node_offset);
+		}
 
-			middle++;
+		// The mean split of skewed points may isolate few points per level, the depth is bounded by splitting the deep subtrees at the
+		// median (the search stack holds k_kd_tree_max_depth entries)
+		if (depth >= k_max_mean_split_depth)
+		{
+			return vren::kd_tree_build_median(points, point_stride, indices, count, kd_tree, node_offset, max_leaf_point_count);
+		}
+
+		float mean[3];
+		uint32_t axis = calc_split_axis(points, point_stride, indices, count, mean);
+		float split = mean[axis];
+
+		size_t middle = 0;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			float const* point = points + indices[i] * point_stride;
+
+			if (point[axis] < split)
+			{
+				uint32_t tmp = indices[i];
+				indices[i] = indices[middle];
+				indices[middle] = tmp;
+
+				middle++;
+			}
 		}
-	}
 
-	size_t next_node_offset = kd_tree_build(points, point_stride, indices, middle, kd_tree, node_offset + 1, max_leaf_point_count);
+		if (middle == 0 || middle == count)
+		{
+			// All the points lie on the same side of the mean (e.g. they are coincident along the axis), recursing would never end
+			split = split_at_median(points, point_stride, indices, count, axis);
+			middle = count / 2;
+		}
+
+		size_t next_node_offset = build_kd_tree_mean(points, point_stride, indices, middle, kd_tree, node_offset + 1, max_leaf_point_count, depth + 1);
 
-	kd_tree_node& node = kd_tree[node_offset];
-	node.m_split = split;
-	node.m_axis = axis;
-	node.m_right_child_distance = next_node_offset - node_offset;
+		write_kd_tree_split_node(kd_tree, node_offset, axis, split, next_node_offset);
 
-	return kd_tree_build(points, point_stride, indices + middle, count - middle, kd_tree, next_node_offset, max_leaf_point_count);
+		return build_kd_tree_mean(points, point_stride, indices + middle, count - middle, kd_tree, next_node_offset, max_leaf_point_count, depth + 1);
+	}
 }
 
-void vren::kd_tree_search(
+size_t vren::kd_tree_build(
 	float const* points,
 	size_t point_stride,
-	uint32_t const* indices,
+	uint32_t* indices,
 	size_t count,
 	kd_tree_node* kd_tree,
 	size_t node_offset,
-	float const* sample,
-	vren::kd_tree_search_filter_t const& filter_predicate,
-	uint32_t& best_point,
-	float& best_distance_squared
+	size_t max_leaf_point_count
 )
 {
-	kd_tree_node& node = kd_tree[node_offset];
+	return build_kd_tree_mean(points, point_stride, indices, count, kd_tree, node_offset, max_leaf_point_count, 0);
+}
+
+size_t vren::kd_tree_calc_median_node_count(size_t count, size_t max_leaf_point_count)
+{
+	// Every subtree is split in two halves, hence the subtrees of a level have at most two distinct point counts (n and n + 1):
+	// the tree is visited level by level keeping the multiplicity of each point count
+	struct level_entry { size_t m_count; size_t m_multiplicity; };
+
+	std::array<level_entry, 2> level{ level_entry{ .m_count = count, .m_multiplicity = count > 0 ? 1u : 0u } };
+	size_t level_size = 1;
 
-	if (node.m_axis == 0x3) // Is children
+	size_t node_count = 0;
+	while (level_size > 0)
 	{
-		for (uint32_t i = 0; i < node.m_leaf_count; i++)
-		{
-			kd_tree_node& leaf_node = kd_tree[node_offset + i];
+		std::array<level_entry, 2> next_level{};
+		size_t next_level_size = 0;
 
-			if (!filter_predicate(leaf_node.m_index)) {
-				continue;
+		auto push = [&](size_t count, size_t multiplicity)
+		{
+			for (size_t i = 0; i < next_level_size; i++)
+			{
+				if (next_level[i].m_count == count)
+				{
+					next_level[i].m_multiplicity += multiplicity;
+					return;
+				}
 			}
 
-			float const* point = points + leaf_node.m_index * point_stride;
-			float distance_squared =
-				(sample[0] - point[0]) * (sample[0] - point[0]) +
-				(sample[1] - point[1]) * (sample[1] - point[1]) +
-				(sample[2] - point[2]) * (sample[2] - point[2]);
-			if (distance_squared < best_distance_squared)
+			assert(next_level_size < next_level.size());
+			next_level[next_level_size++] = { .m_count = count, .m_multiplicity = multiplicity };
+		};
+
+		for (size_t i = 0; i < level_size; i++)
+		{
+			level_entry const& entry = level[i];
+			if (entry.m_count <= max_leaf_point_count)
+			{
+				node_count += entry.m_count * entry.m_multiplicity; // Leaf nodes
+			}
+			else
 			{
-				best_point = leaf_node.m_index;
-				best_distance_squared = distance_squared;
+				node_count += entry.m_multiplicity; // Split nodes
+				push(entry.m_count / 2, entry.m_multiplicity);
+				push(entry.m_count - entry.m_count / 2, entry.m_multiplicity);
 			}
 		}
+
+		level = next_level;
+		level_size = next_level_size;
+	}
+
+	return node_count;
+}
+
+size_t vren::kd_tree_build_median(
+	float const* points,
+	size_t point_stride,
+	uint32_t* indices,
+	size_t count,
+	kd_tree_node* kd_tree,
+	size_t node_offset,
+	size_t max_leaf_point_count
+)
+{
+	const size_t k_min_parallel_point_count = 1 << 14; // Smaller subtrees are built sequentially
+
+	assert(count > 0);
+
+	if (count <= max_leaf_point_count)
+	{
+		return build_kd_tree_leaf(indices, count, kd_tree, node_offset);
+	}
+
+	float mean[3];
+	uint32_t axis = calc_split_axis(points, point_stride, indices, count, mean);
+	float split = split_at_median(points, point_stride, indices, count, axis);
+
+	size_t middle = count / 2;
+
+	// Since the subtree node count only depends on the point count, the offset of the right child is known in advance and
+	// the two subtrees can be built concurrently
+	size_t right_child_offset = node_offset + 1 + kd_tree_calc_median_node_count(middle, max_leaf_point_count);
+
+	write_kd_tree_split_node(kd_tree, node_offset, axis, split, right_child_offset);
+
+	struct subtree { uint32_t* m_indices; size_t m_count; size_t m_node_offset; };
+	std::array<subtree, 2> subtrees{
+		subtree{ .m_indices = indices, .m_count = middle, .m_node_offset = node_offset + 1 },
+		subtree{ .m_indices = indices + middle, .m_count = count - middle, .m_node_offset = right_child_offset }
+	};
+
+	auto build_subtree = [&](subtree const& subtree)
+	{
+		kd_tree_build_median(points, point_stride, subtree.m_indices, subtree.m_count, kd_tree, subtree.m_node_offset, max_leaf_point_count);
+	};
+
+	if (count >= k_min_parallel_point_count)
+	{
+		std::for_each(std::execution::par, subtrees.begin(), subtrees.end(), build_subtree);
 	}
 	else
 	{
-		float d = sample[node.m_axis] - node.m_split;
-		size_t first_node_offset  = d <= 0 ? node_offset + 1 : node_offset + node.m_right_child_distance;
-		size_t second_node_offset = d <= 0 ? node_offset + node.m_right_child_distance : node_offset + 1;
+		std::for_each(subtrees.begin(), subtrees.end(), build_subtree);
+	}
 
-		kd_tree_search(points, point_stride, indices, count, kd_tree, first_node_offset, sample, filter_predicate, best_point, best_distance_squared);
-		if (best_distance_squared > (d * d))
+	return right_child_offset + kd_tree_calc_median_node_count(count - middle, max_leaf_point_count);
+}
+
+void vren::kd_tree_pack_points(
+	float const* points,
+	size_t point_stride,
+	kd_tree_node const* kd_tree,
+	size_t node_count,
+	kd_tree_packed_points& packed_points
+)
+{
+	// Padded so that the last leaf can be scanned k_kd_tree_simd_width points at a time
+	size_t size = node_count + k_kd_tree_simd_width;
+
+	packed_points.m_x.assign(size, 0.0f);
+	packed_points.m_y.assign(size, 0.0f);
+	packed_points.m_z.assign(size, 0.0f);
+
+	for (size_t node_offset = 0; node_offset < node_count; node_offset++)
+	{
+		kd_tree_node const& node = kd_tree[node_offset];
+		if (node.m_axis == k_kd_tree_leaf_axis)
 		{
-			kd_tree_search(points, point_stride, indices, count, kd_tree, second_node_offset, sample, filter_predicate, best_point, best_distance_squared);
+			float const* point = points + node.m_index * point_stride;
+			packed_points.m_x[node_offset] = point[0];
+			packed_points.m_y[node_offset] = point[1];
+			packed_points.m_z[node_offset] = point[2];
 		}
 	}
 }
-
-
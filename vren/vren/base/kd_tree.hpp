@@ -1,7 +1,14 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
+#include <cassert>
+#include <cmath>
+#include <array>
+#include <vector>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <execution>
 
 namespace vren
 {
@@ -17,6 +24,12 @@ namespace vren
 		union { uint32_t m_right_child_distance: 30; uint32_t m_leaf_count: 30; };
 	};
 
+	inline constexpr uint32_t k_kd_tree_leaf_axis = 0x3;
+
+	/** Builds the KD-tree splitting the points at the mean of the axis of greatest variance. The indices are reordered. The subtrees
+	 * deeper than k_kd_tree_max_depth - 32 are split at the median, so that the tree fits the search stack however skewed the points are.
+	 * @return The offset past the last written node. The node count isn't known in advance, at most count * 2 nodes are written.
+	 */
 	size_t kd_tree_build(
 		float const* points,
 		size_t point_stride,
@@ -27,20 +40,296 @@ namespace vren
 		size_t max_leaf_point_count
 	);
 
-	using kd_tree_search_filter_t = std::function<bool(uint32_t point)>;
-
-	const kd_tree_search_filter_t k_kd_tree_default_search_filter = [](uint32_t point) -> bool { return true; };
+	/// The exact number of nodes written by kd_tree_build_median.
+	size_t kd_tree_calc_median_node_count(size_t count, size_t max_leaf_point_count);
 
-	void kd_tree_search(
+	/** Builds the KD-tree splitting the points at the median of the axis of greatest variance (balanced tree, robust to
+	 * clustered points). The subtrees are built in parallel. The indices are reordered.
+	 * @return The offset past the last written node, that is node_offset + kd_tree_calc_median_node_count(count, max_leaf_point_count).
+	 */
+	size_t kd_tree_build_median(
 		float const* points,
 		size_t point_stride,
-		uint32_t const* indices,
+		uint32_t* indices,
 		size_t count,
 		kd_tree_node* kd_tree,
 		size_t node_offset,
-		float const* sample,
-		kd_tree_search_filter_t const& filter_predicate,
-		uint32_t& best_point,
-		float& best_distance_squared
+		size_t max_leaf_point_count
+	);
+
+	// ------------------------------------------------------------------------------------------------
+	// KD-tree packed points
+	// ------------------------------------------------------------------------------------------------
+
+	inline constexpr uint32_t k_kd_tree_simd_width = 8;
+
+	/** The coordinates of the leaf points, laid out as structure of arrays and indexed by node: the points of a leaf are
+	 * contiguous and can be scanned k_kd_tree_simd_width at a time. The arrays are padded so that the scan of the last
+	 * leaf never reads out of bounds.
+	 */
+	struct kd_tree_packed_points
+	{
+		std::vector<float> m_x;
+		std::vector<float> m_y;
+		std::vector<float> m_z;
+	};
+
+	void kd_tree_pack_points(
+		float const* points,
+		size_t point_stride,
+		kd_tree_node const* kd_tree,
+		size_t node_count,
+		kd_tree_packed_points& packed_points
 	);
+
+	// ------------------------------------------------------------------------------------------------
+	// KD-tree search
+	// ------------------------------------------------------------------------------------------------
+
+	inline constexpr uint32_t k_kd_tree_max_depth = 64;
+
+	struct kd_tree_neighbour
+	{
+		uint32_t m_point;
+		float m_distance_squared;
+	};
+
+	/// The default search filter, accepts every point.
+	struct kd_tree_no_filter
+	{
+		inline bool operator()(uint32_t point) const
+		{
+			return true;
+		}
+	};
+
+	namespace detail
+	{
+		struct kd_tree_stack_entry
+		{
+			uint32_t m_node_offset;
+			float m_distance_squared; // Lower bound of the squared distance between the sample and the points of the subtree
+		};
+
+		/** Non-recursive traversal of the KD-tree shared by all the searches. The subtrees whose lower bound distance isn't
+		 * less than get_max_distance_squared() are skipped, the leaf points are scanned k_kd_tree_simd_width at a time and
+		 * the ones closer than the max distance and accepted by the filter are passed to visit_point().
+		 */
+		template<typename _filter_t, typename _get_max_distance_squared_t, typename _visit_point_t>
+		void kd_tree_traverse(
+			kd_tree_node const* kd_tree,
+			kd_tree_packed_points const& packed_points,
+			float const* sample,
+			_filter_t const& filter,
+			_get_max_distance_squared_t const& get_max_distance_squared,
+			_visit_point_t const& visit_point
+		)
+		{
+			std::array<kd_tree_stack_entry, k_kd_tree_max_depth> stack;
+			uint32_t stack_size = 0;
+
+			stack[stack_size++] = { .m_node_offset = 0, .m_distance_squared = 0.0f };
+
+			while (stack_size > 0)
+			{
+				kd_tree_stack_entry entry = stack[--stack_size];
+				if (entry.m_distance_squared >= get_max_distance_squared())
+				{
+					continue;
+				}
+
+				// Descend to the nearest leaf, pushing the farthest children for later
+				uint32_t node_offset = entry.m_node_offset;
+				while (kd_tree[node_offset].m_axis != k_kd_tree_leaf_axis)
+				{
+					kd_tree_node const& node = kd_tree[node_offset];
+
+					float d = sample[node.m_axis] - node.m_split;
+					uint32_t near_node_offset = d <= 0 ? node_offset + 1 : node_offset + node.m_right_child_distance;
+					uint32_t far_node_offset  = d <= 0 ? node_offset + node.m_right_child_distance : node_offset + 1;
+
+					assert(stack_size < k_kd_tree_max_depth);
+					stack[stack_size++] = { .m_node_offset = far_node_offset, .m_distance_squared = std::max(entry.m_distance_squared, d * d) };
+
+					node_offset = near_node_offset;
+				}
+
+				// Scan the leaf
+				uint32_t leaf_count = kd_tree[node_offset].m_leaf_count;
+
+				float const* x = packed_points.m_x.data() + node_offset;
+				float const* y = packed_points.m_y.data() + node_offset;
+				float const* z = packed_points.m_z.data() + node_offset;
+
+				for (uint32_t i = 0; i < leaf_count; i += k_kd_tree_simd_width)
+				{
+					// Fixed width and branchless so that it's vectorized by the compiler
+					float distances_squared[k_kd_tree_simd_width];
+					for (uint32_t j = 0; j < k_kd_tree_simd_width; j++)
+					{
+						float dx = sample[0] - x[i + j];
+						float dy = sample[1] - y[i + j];
+						float dz = sample[2] - z[i + j];
+						float distance_squared = dx * dx + dy * dy + dz * dz;
+						distances_squared[j] = i + j < leaf_count ? distance_squared : std::numeric_limits<float>::infinity();
+					}
+
+					for (uint32_t j = 0; j < k_kd_tree_simd_width; j++)
+					{
+						if (distances_squared[j] < get_max_distance_squared())
+						{
+							uint32_t point = kd_tree[node_offset + i + j].m_index;
+							if (filter(point))
+							{
+								visit_point(point, distances_squared[j]);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		template<typename _function_t>
+		void kd_tree_for_each_batch(size_t sample_count, _function_t const& function)
+		{
+			const size_t k_batch_size = 64;
+
+			std::vector<size_t> batches((sample_count + k_batch_size - 1) / k_batch_size);
+			std::iota(batches.begin(), batches.end(), 0);
+
+			std::for_each(std::execution::par, batches.begin(), batches.end(), [&](size_t batch)
+			{
+				size_t sample_end = std::min((batch + 1) * k_batch_size, sample_count);
+				for (size_t sample_idx = batch * k_batch_size; sample_idx < sample_end; sample_idx++)
+				{
+					function(sample_idx);
+				}
+			});
+		}
+	}
+
+	/** Searches the k points nearest to the sample (among the ones accepted by the filter) and farther less than
+	 * sqrt(max_distance_squared). The found neighbours are written to neighbours sorted by distance.
+	 * @return The number of neighbours found (at most k).
+	 */
+	template<typename _filter_t = kd_tree_no_filter>
+	size_t kd_tree_knn_search(
+		kd_tree_node const* kd_tree,
+		kd_tree_packed_points const& packed_points,
+		float const* sample,
+		size_t k,
+		kd_tree_neighbour* neighbours,
+		_filter_t const& filter = {},
+		float max_distance_squared = std::numeric_limits<float>::infinity()
+	)
+	{
+		assert(k > 0);
+
+		size_t neighbour_count = 0;
+
+		auto get_max_distance_squared = [&]() -> float
+		{
+			return neighbour_count < k ? max_distance_squared : neighbours[k - 1].m_distance_squared;
+		};
+
+		auto visit_point = [&](uint32_t point, float distance_squared)
+		{
+			// Insertion into the sorted neighbour list, the farthest neighbour is dropped when full
+			size_t i = neighbour_count < k ? neighbour_count++ : k - 1;
+			for (; i > 0 && neighbours[i - 1].m_distance_squared > distance_squared; i--)
+			{
+				neighbours[i] = neighbours[i - 1];
+			}
+			neighbours[i] = { .m_point = point, .m_distance_squared = distance_squared };
+		};
+
+		detail::kd_tree_traverse(kd_tree, packed_points, sample, filter, get_max_distance_squared, visit_point);
+
+		return neighbour_count;
+	}
+
+	/** Searches all the points (among the ones accepted by the filter) farther less than radius from the sample and appends
+	 * them, unsorted, to neighbours.
+	 * @return The number of neighbours found.
+	 */
+	template<typename _filter_t = kd_tree_no_filter>
+	size_t kd_tree_radius_search(
+		kd_tree_node const* kd_tree,
+		kd_tree_packed_points const& packed_points,
+		float const* sample,
+		float radius,
+		std::vector<kd_tree_neighbour>& neighbours,
+		_filter_t const& filter = {}
+	)
+	{
+		size_t initial_size = neighbours.size();
+		float radius_squared = radius * radius;
+
+		auto get_max_distance_squared = [&]() -> float
+		{
+			return radius_squared;
+		};
+
+		auto visit_point = [&](uint32_t point, float distance_squared)
+		{
+			neighbours.push_back({ .m_point = point, .m_distance_squared = distance_squared });
+		};
+
+		detail::kd_tree_traverse(kd_tree, packed_points, sample, filter, get_max_distance_squared, visit_point);
+
+		return neighbours.size() - initial_size;
+	}
+
+	/** Runs kd_tree_knn_search for sample_count samples in parallel. The neighbours of the i-th sample are written at
+	 * neighbours[i * k] and their count at neighbour_counts[i]. The filter must be safe to call concurrently.
+	 */
+	template<typename _filter_t = kd_tree_no_filter>
+	void kd_tree_knn_search_batch(
+		kd_tree_node const* kd_tree,
+		kd_tree_packed_points const& packed_points,
+		float const* samples,
+		size_t sample_stride,
+		size_t sample_count,
+		size_t k,
+		kd_tree_neighbour* neighbours,
+		uint32_t* neighbour_counts,
+		_filter_t const& filter = {},
+		float max_distance_squared = std::numeric_limits<float>::infinity()
+	)
+	{
+		detail::kd_tree_for_each_batch(sample_count, [&](size_t sample_idx)
+		{
+			neighbour_counts[sample_idx] = (uint32_t) kd_tree_knn_search(
+				kd_tree,
+				packed_points,
+				samples + sample_idx * sample_stride,
+				k,
+				neighbours + sample_idx * k,
+				filter,
+				max_distance_squared
+			);
+		});
+	}
+
+	/** Runs kd_tree_radius_search for sample_count samples in parallel. The neighbours of the i-th sample are written to
+	 * neighbours[i] (which is cleared first). The filter must be safe to call concurrently.
+	 */
+	template<typename _filter_t = kd_tree_no_filter>
+	void kd_tree_radius_search_batch(
+		kd_tree_node const* kd_tree,
+		kd_tree_packed_points const& packed_points,
+		float const* samples,
+		size_t sample_stride,
+		size_t sample_count,
+		float radius,
+		std::vector<kd_tree_neighbour>* neighbours,
+		_filter_t const& filter = {}
+	)
+	{
+		detail::kd_tree_for_each_batch(sample_count, [&](size_t sample_idx)
+		{
+			neighbours[sample_idx].clear();
+			kd_tree_radius_search(kd_tree, packed_points, samples + sample_idx * sample_stride, radius, neighbours[sample_idx], filter);
+		});
+	}
 }
@@ -25,16 +25,20 @@ namespace vren
             }
         }
 
-        void apply(uint32_t i, _t& object)
+        /// Returns whether any operation was applied (the object was modified).
+        bool apply(uint32_t i, _t& object)
         {
             assert(i < _n);
 
+            bool applied = !m_operations.at(i).empty();
             for (operation_t const& operation : m_operations.at(i))
             {
                 operation(i, object);
             }
 
             m_operations[i].clear();
+
+            return applied;
         }
     };
 }
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace vren
+{
+	// ------------------------------------------------------------------------------------------------
+	// Rolling statistics
+	// ------------------------------------------------------------------------------------------------
+
+	/// Min, average and percentiles of the last samples pushed (at most the window size, the oldest samples are dropped first).
+	class rolling_statistics
+	{
+	public:
+		static constexpr size_t k_default_window_size = 256;
+
+	private:
+		std::vector<double> m_samples; // Ring buffer
+		size_t m_next_idx = 0;
+		size_t m_sample_count = 0;
+
+	public:
+		rolling_statistics() :
+			rolling_statistics(k_default_window_size)
+		{
+		}
+
+		explicit rolling_statistics(size_t window_size) :
+			m_samples(std::max<size_t>(window_size, 1), 0.0)
+		{
+		}
+
+		inline size_t get_window_size() const
+		{
+			return m_samples.size();
+		}
+
+		inline size_t get_sample_count() const
+		{
+			return m_sample_count;
+		}
+
+		inline void push(double sample)
+		{
+			m_samples[m_next_idx] = sample;
+			m_next_idx = (m_next_idx + 1) % m_samples.size();
+			m_sample_count = std::min(m_sample_count + 1, m_samples.size());
+		}
+
+		inline void clear()
+		{
+			m_next_idx = 0;
+			m_sample_count = 0;
+		}
+
+		/// The statistics below return 0 if no sample was pushed.
+		inline double get_last() const
+		{
+			return m_sample_count > 0 ? m_samples[(m_next_idx + m_samples.size() - 1) % m_samples.size()] : 0.0;
+		}
+
+		inline double get_min() const
+		{
+			return m_sample_count > 0 ? *std::min_element(m_samples.begin(), m_samples.begin() + m_sample_count) : 0.0;
+		}
+
+		inline double get_max() const
+		{
+			return m_sample_count > 0 ? *std::max_element(m_samples.begin(), m_samples.begin() + m_sample_count) : 0.0;
+		}
+
+		inline double get_avg() const
+		{
+			double sum = 0.0;
+			for (size_t i = 0; i < m_sample_count; i++)
+			{
+				sum += m_samples[i];
+			}
+			return m_sample_count > 0 ? sum / double(m_sample_count) : 0.0;
+		}
+
+		/// Nearest-rank percentile, percentile in [0, 1].
+		inline double get_percentile(double percentile) const
+		{
+			if (m_sample_count == 0)
+			{
+				return 0.0;
+			}
+
+			std::vector<double> samples(m_samples.begin(), m_samples.begin() + m_sample_count);
+
+			size_t rank = (size_t) std::ceil(std::clamp(percentile, 0.0, 1.0) * double(m_sample_count));
+			auto nth = samples.begin() + (rank > 0 ? rank - 1 : 0);
+			std::nth_element(samples.begin(), nth, samples.end());
+			return *nth;
+		}
+
+		inline double get_p99() const
+		{
+			return get_percentile(0.99);
+		}
+	};
+}
@@ -15,11 +15,15 @@
 #define VREN_MAX_SCREEN_WIDTH 1920
 #define VREN_MAX_SCREEN_HEIGHT 1080
 
-#define VREN_MAX_POINT_LIGHT_COUNT (1 << 20)
+#define VREN_MAX_POINT_LIGHT_COUNT (1 << 21) // ~2M
 #define VREN_MAX_DIRECTIONAL_LIGHT_COUNT (1 << 4)
+#define VREN_MAX_SPOT_LIGHT_COUNT (1 << 10)
 
 #define VREN_MAX_MATERIAL_COUNT (1 << 16)
 
+#define VREN_SHADOW_MAP_RESOLUTION 2048
+#define VREN_SHADOW_MAP_FORMAT VK_FORMAT_D32_SFLOAT
+
 #define VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT (1 << 17) // ~131K
 #define VREN_MAX_ASSIGNED_LIGHT_COUNT (1 << 23) // ~8M
 
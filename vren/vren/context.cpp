@@ -3,8 +3,14 @@
 #include <iostream>
 #include <span>
 
+#include "log.hpp"
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
+#include "vk_helpers/command_recorder.hpp"
+#include "vk_helpers/pipeline_cache.hpp"
+#include "vk_helpers/pipeline_layout_cache.hpp"
+#include "vk_helpers/shader_registry.hpp"
 
 void vren::get_supported_layers(std::vector<VkLayerProperties>& layers)
 {
@@ -193,7 +199,32 @@ VkPhysicalDevice vren::context::find_physical_device()
 		throw std::runtime_error("Can't find a physical device that fits requirements.");
 	}
 	vkGetPhysicalDeviceProperties(found, &m_physical_device_properties);
+
+	m_physical_device_subgroup_size_control_properties = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES,
+		.pNext = nullptr,
+	};
+	m_physical_device_subgroup_properties = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES,
+		.pNext = &m_physical_device_subgroup_size_control_properties,
+	};
+	VkPhysicalDeviceProperties2 physical_device_properties_2{
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+		.pNext = &m_physical_device_subgroup_properties,
+	};
+	vkGetPhysicalDeviceProperties2(found, &physical_device_properties_2);
 	vkGetPhysicalDeviceMemoryProperties(found, &m_physical_device_memory_properties);
+	vkGetPhysicalDeviceFeatures(found, &m_physical_device_features);
+
+	m_physical_device_subgroup_size_control_features = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES,
+		.pNext = nullptr,
+	};
+	VkPhysicalDeviceFeatures2 physical_device_features_2{
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+		.pNext = &m_physical_device_subgroup_size_control_features,
+	};
+	vkGetPhysicalDeviceFeatures2(found, &physical_device_features_2);
 
 	if (!m_physical_device_properties.limits.timestampComputeAndGraphics) {
 		throw std::runtime_error("Unsupported timestamp queries for compute and graphics queue families");
@@ -343,11 +374,14 @@ VkDevice vren::context::create_logical_device()
 		.runtimeDescriptorArray = true,
 		.samplerFilterMinmax = true,
 		.separateDepthStencilLayouts = true,
+		.timelineSemaphore = true,
 	};
 
 	VkPhysicalDeviceVulkan13Features vulkan_13_features{
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
 		.pNext = &vulkan_12_features,
+		.subgroupSizeControl = m_physical_device_subgroup_size_control_features.subgroupSizeControl,
+		.computeFullSubgroups = m_physical_device_subgroup_size_control_features.computeFullSubgroups,
 		.dynamicRendering = true,
 	};
 
@@ -356,6 +390,8 @@ VkDevice vren::context::create_logical_device()
 		.pNext = &vulkan_13_features,
 		.features = {
 			.fillModeNonSolid = VK_TRUE,
+			.pipelineStatisticsQuery = VK_TRUE, // Counted by the profiler scopes (see vren::profiler)
+			.inheritedQueries = m_physical_device_features.inheritedQueries, // The secondary command buffers executed within a profiler scope (see vren::command_recorder)
 		},
 	};
 
@@ -411,6 +447,26 @@ VmaAllocator vren::context::create_vma_allocator()
 	return allocator;
 }
 
+VkPipelineCache vren::context::create_pipeline_cache()
+{
+	if (m_info.m_pipeline_cache_dir.empty())
+	{
+		VkPipelineCacheCreateInfo pipeline_cache_info{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = NULL,
+			.initialDataSize = 0,
+			.pInitialData = nullptr
+		};
+
+		VkPipelineCache pipeline_cache;
+		VREN_CHECK(vkCreatePipelineCache(m_device, &pipeline_cache_info, nullptr, &pipeline_cache), this);
+		return pipeline_cache;
+	}
+
+	return vren::vk_utils::create_pipeline_cache(*this, vren::vk_utils::get_pipeline_cache_file_path(m_physical_device_properties, m_info.m_pipeline_cache_dir));
+}
+
 vren::context::context(context_info const& info) :
 	m_info(info),
 
@@ -423,14 +479,37 @@ vren::context::context(context_info const& info) :
 	m_graphics_queue(m_queues.at(m_queue_families.m_graphics_idx)),
 	m_transfer_queue(m_queues.at(m_queue_families.m_transfer_idx)),
 	//m_compute_queue(m_queues.at(m_queue_families.m_compute_idx)),
-	m_vma_allocator(create_vma_allocator())
+	m_vma_allocator(create_vma_allocator()),
+	m_pipeline_cache(create_pipeline_cache())
 {
+	m_pipeline_layout_cache = std::make_unique<vren::pipeline_layout_cache>(*this);
+	m_pipeline_builder = std::make_unique<vren::pipeline_builder>(m_info.m_pipeline_builder_worker_count);
+	m_command_recorder = std::make_unique<vren::command_recorder>(*this, m_info.m_command_recorder_worker_count);
+	if (m_info.m_shader_hot_reload)
+	{
+		m_shader_registry = std::make_unique<vren::shader_registry>(*this, m_info.m_shader_sources_file);
+	}
 	m_toolbox = std::make_unique<vren::toolbox>(*this);
 }
 
 vren::context::~context()
 {
+	m_shader_registry.reset();
 	m_toolbox.reset();
+	m_command_recorder.reset();
+	m_pipeline_builder.reset();
+	m_pipeline_layout_cache.reset();
+
+	// A failure must not throw out of the destructor: the pipeline cache is only rebuilt at the next launch
+	try
+	{
+		save_pipeline_cache();
+	}
+	catch (std::exception const& exception)
+	{
+		VREN_WARN("[context] Failed to save the pipeline cache: {}\n", exception.what());
+	}
+	vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
 
 	vmaDestroyAllocator(m_vma_allocator);
 
@@ -439,3 +518,11 @@ vren::context::~context()
 	vkDestroyDebugUtilsMessengerEXT(m_instance, m_debug_messenger, nullptr);
 	vkDestroyInstance(m_instance, nullptr);
 }
+
+void vren::context::save_pipeline_cache() const
+{
+	if (!m_info.m_pipeline_cache_dir.empty())
+	{
+		vren::vk_utils::save_pipeline_cache(*this, m_pipeline_cache, vren::vk_utils::get_pipeline_cache_file_path(m_physical_device_properties, m_info.m_pipeline_cache_dir));
+	}
+}
@@ -4,6 +4,7 @@
 #include <array>
 #include <vector>
 #include <filesystem>
+#include <thread>
 
 #include <volk.h>
 #include <vk_mem_alloc.h>
@@ -15,6 +16,10 @@ namespace vren
 {
 	// Forward decl
 	class toolbox;
+	class pipeline_builder;
+	class command_recorder;
+	class pipeline_layout_cache;
+	class shader_registry;
 
 	// ------------------------------------------------------------------------------------------------
 
@@ -32,6 +37,22 @@ namespace vren
 		std::vector<char const*> m_layers;
 		std::vector<char const*> m_extensions;
 		std::vector<char const*> m_device_extensions;
+
+		/// The pipeline cache is loaded from this directory and saved back when the context is destroyed, empty to keep it in memory only.
+		std::filesystem::path m_pipeline_cache_dir = ".vren/pipeline_cache";
+
+		/// The threads creating the pipelines concurrently (see vren::pipeline_builder), 0 to create them on the calling thread.
+		uint32_t m_pipeline_builder_worker_count = std::thread::hardware_concurrency();
+
+		/// The threads recording the render graph nodes marked for parallel recording (see vren::command_recorder), 0 to record them on
+		/// the calling thread.
+		uint32_t m_command_recorder_worker_count = std::thread::hardware_concurrency();
+
+		/// Reloads the watched pipelines when their shaders change on disk (see vren::shader_registry), meant for development builds.
+		bool m_shader_hot_reload = false;
+
+		/// Written by compile_shader, lists the GLSL sources of the SPIR-V and how to recompile them.
+		std::filesystem::path m_shader_sources_file = ".vren/resources/shaders/shader_sources.txt";
 	};
 
 	class context
@@ -60,6 +81,7 @@ namespace vren
 		VkDevice create_logical_device();
 		std::vector<VkQueue> get_queues();
 		VmaAllocator create_vma_allocator();
+		VkPipelineCache create_pipeline_cache();
 
 	public:
 		vren::context_info m_info;
@@ -69,7 +91,11 @@ namespace vren
 
 		VkPhysicalDevice m_physical_device;
 		VkPhysicalDeviceProperties m_physical_device_properties;
+		VkPhysicalDeviceSubgroupProperties m_physical_device_subgroup_properties; // The subgroup size selects the primitives configuration (see vren::primitive_tuning)
 		VkPhysicalDeviceMemoryProperties m_physical_device_memory_properties;
+		VkPhysicalDeviceFeatures m_physical_device_features; // The optional features are enabled if supported (e.g. inheritedQueries)
+		VkPhysicalDeviceSubgroupSizeControlProperties m_physical_device_subgroup_size_control_properties;
+		VkPhysicalDeviceSubgroupSizeControlFeatures m_physical_device_subgroup_size_control_features; // Required by the shaders assuming a subgroup size (see vren::specialized_shader::set_required_subgroup_size)
 
 		vren::context::queue_families m_queue_families;
 		VkDevice m_device;
@@ -81,6 +107,13 @@ namespace vren
 
 		VmaAllocator m_vma_allocator;
 
+		/// Used by every pipeline creation, warm starts skip the driver compilation of the pipelines.
+		VkPipelineCache m_pipeline_cache;
+
+		std::unique_ptr<vren::pipeline_layout_cache> m_pipeline_layout_cache;
+		std::unique_ptr<vren::pipeline_builder> m_pipeline_builder;
+		std::unique_ptr<vren::command_recorder> m_command_recorder;
+		std::unique_ptr<vren::shader_registry> m_shader_registry; // Null unless the shader hot reload is enabled
 		std::unique_ptr<vren::toolbox> m_toolbox;
 
 		explicit context(context_info const& ctx_info);
@@ -88,6 +121,10 @@ namespace vren
 		// TODO move constructor
 
 		~context();
+
+		/// Writes the pipeline cache to its file (e.g. once all the pipelines are created), the context also does it when destroyed
+		/// (where a failure is only warned).
+		void save_pipeline_cache() const;
 	};
 }
 
@@ -32,6 +32,22 @@ namespace vren
 		glm::vec2 m_texcoords; float _pad2[2];
 	};
 
+	/** Compressed variant of vren::vertex, decoded by the mesh shader (see draw.mesh with VREN_COMPRESSED_GEOMETRY).
+	 * The position is quantized to snorm16 relative to the bounding sphere of the meshlet that owns the vertex, the normal is
+	 * octahedral-encoded as snorm16x2 and the texcoords are stored as two half-floats.
+	 *
+	 * The upper half of m_position_z is intentional padding: the 112 bits of payload can't fit in 12 bytes without dropping the normal
+	 * to snorm8x2 (about 1 degree of error, against less than 0.1 degree now), and a 14-byte stride would need 16-bit storage buffer
+	 * access, which the device doesn't enable. The 16-byte stride also keeps every vertex a single aligned 128-bit load.
+	 */
+	struct compressed_vertex
+	{
+		uint32_t m_position_xy; // packSnorm2x16
+		uint32_t m_position_z;  // packSnorm2x16 (the upper half is unused)
+		uint32_t m_normal;      // packSnorm2x16 of the octahedral-encoded normal
+		uint32_t m_texcoords;   // packHalf2x16
+	};
+
 	struct instanced_meshlet
 	{
 		uint32_t m_meshlet_idx;
@@ -60,7 +76,7 @@ namespace vren
 
 	struct point_light
 	{
-		glm::vec3 m_color; float m_intensity;
+		glm::vec3 m_color; float m_intensity; // The influence radius is derived from m_intensity by the clustered shading (see vren::calc_point_light_radius)
 	};
 
 	struct directional_light
@@ -71,8 +87,36 @@ namespace vren
 
 	struct spot_light
 	{
-		glm::vec3 m_direction; float _pad;
-		glm::vec3 m_color;
-		float m_radius;
+		glm::vec3 m_direction; float m_intensity; // The position is stored in a separate buffer, as for the point lights
+		glm::vec3 m_color;     float m_inner_cone_cos; // The cosine of the angle under which the light is at full intensity
+		float m_outer_cone_cos; // The cosine of the angle over which the light doesn't contribute anymore
+		float _pad[3];          // The influence radius is derived from m_intensity as for the point lights
+	};
+
+	struct shadow_cascade
+	{
+		glm::mat4 m_view_projection; // World space to the cascade clip space (orthographic)
+		float m_split_far;           // The view space depth where the cascade ends
+		float m_texel_world_size;    // The world space size of a shadow map texel, used to scale the normal offset bias
+		float _pad[2];
+	};
+
+	// ------------------------------------------------------------------------------------------------
+	// Light simulation
+	// ------------------------------------------------------------------------------------------------
+
+	struct light_particle
+	{
+		glm::vec3 m_position; float m_remaining_lifetime; // Infinite for the lights that never die
+		glm::vec3 m_velocity; float m_intensity;          // The intensity before the fade out
+		glm::vec3 m_color;    float _pad;
+	};
+
+	struct light_simulation_state
+	{
+		uint32_t m_dispatch_params[3]; // The indirect dispatch of the simulation, over the alive particles
+		int32_t m_dead_count;
+		uint32_t m_alive_counts[2];    // The alive lists are swapped at every simulation step
+		uint32_t _pad[2];
 	};
 }
@@ -1,48 +1,32 @@
 #include "light.hpp"
 
+#include <cstring>
+
 #include "base/base.hpp"
 #include "context.hpp"
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
 #include "vk_helpers/debug_utils.hpp"
 
-vren::light_array::light_array(vren::context const& context) :
+vren::vk_utils::buffer alloc_light_buffer(vren::context const& context, size_t size, bool host_visible, char const* name)
+{
+	vren::vk_utils::buffer buffer = host_visible ?
+		vren::vk_utils::alloc_host_visible_buffer(context, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size, true) :
+		vren::vk_utils::alloc_device_only_buffer(context, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, size);
+	vren::vk_utils::set_object_name(context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, name);
+	return buffer;
+}
+
+vren::light_array::light_array(vren::context const& context, bool host_visible) :
 	m_context(&context),
-	m_point_light_position_buffer([&]()
-	{
-		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_visible_buffer(
-			*m_context,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VREN_MAX_POINT_LIGHT_COUNT * sizeof(glm::vec4),
-			true
-		);
-		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, "point_light_position_buffer");
-		return buffer;
-	}()),
-	m_point_light_buffer([&]()
-	{
-		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_visible_buffer(
-			*m_context,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VREN_MAX_POINT_LIGHT_COUNT * sizeof(vren::point_light),
-			true
-		);
-		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, "point_light_buffer");
-		return buffer;
-	}()),
+	m_point_light_position_buffer(alloc_light_buffer(context, VREN_MAX_POINT_LIGHT_COUNT * sizeof(glm::vec4), host_visible, "point_light_position_buffer")),
+	m_point_light_buffer(alloc_light_buffer(context, VREN_MAX_POINT_LIGHT_COUNT * sizeof(vren::point_light), host_visible, "point_light_buffer")),
 	m_point_light_count(0),
-	m_directional_light_buffer([&]()
-	{
-		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_visible_buffer(
-			*m_context,
-			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VREN_MAX_DIRECTIONAL_LIGHT_COUNT * sizeof(vren::directional_light),
-			true
-		);
-		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, "directional_light_buffer");
-		return buffer;
-	}()),
-	m_directional_light_count(0)
+	m_directional_light_buffer(alloc_light_buffer(context, VREN_MAX_DIRECTIONAL_LIGHT_COUNT * sizeof(vren::directional_light), host_visible, "directional_light_buffer")),
+	m_directional_light_count(0),
+	m_spot_light_position_buffer(alloc_light_buffer(context, VREN_MAX_SPOT_LIGHT_COUNT * sizeof(glm::vec4), host_visible, "spot_light_position_buffer")),
+	m_spot_light_buffer(alloc_light_buffer(context, VREN_MAX_SPOT_LIGHT_COUNT * sizeof(vren::spot_light), host_visible, "spot_light_buffer")),
+	m_spot_light_count(0)
 {
 }
 
@@ -51,6 +35,8 @@ void vren::light_array::add_render_graph_node_resources(vren::render_graph_node&
 	node.add_buffer({ .m_buffer = m_point_light_position_buffer.m_buffer.m_handle, }, access_flags);
 	node.add_buffer({ .m_buffer = m_point_light_buffer.m_buffer.m_handle, }, access_flags);
 	node.add_buffer({ .m_buffer = m_directional_light_buffer.m_buffer.m_handle, }, access_flags);
+	node.add_buffer({ .m_buffer = m_spot_light_position_buffer.m_buffer.m_handle, }, access_flags);
+	node.add_buffer({ .m_buffer = m_spot_light_buffer.m_buffer.m_handle, }, access_flags);
 }
 
 void vren::light_array::write_descriptor_set(VkDescriptorSet descriptor_set) const
@@ -58,4 +44,115 @@ void vren::light_array::write_descriptor_set(VkDescriptorSet descriptor_set) con
 	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 0, m_point_light_position_buffer.m_buffer.m_handle, m_point_light_count * sizeof(glm::vec4), 0);
 	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 1, m_point_light_buffer.m_buffer.m_handle, m_point_light_count * sizeof(vren::point_light), 0);
 	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 2, m_directional_light_buffer.m_buffer.m_handle, m_directional_light_count * sizeof(vren::directional_light), 0);
+	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 3, m_spot_light_position_buffer.m_buffer.m_handle, m_spot_light_count * sizeof(glm::vec4), 0);
+	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 4, m_spot_light_buffer.m_buffer.m_handle, m_spot_light_count * sizeof(vren::spot_light), 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// light_store
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::light_store::light_store(vren::context const& context, size_t upload_ring_size) :
+	m_context(&context),
+	m_light_array(context, false),
+	m_upload_ring([&]()
+	{
+		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_only_buffer(context, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, upload_ring_size, true);
+		vren::vk_utils::set_object_name(context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, "light_store_upload_ring");
+		return buffer;
+	}()),
+	m_upload_segment_size(upload_ring_size / VREN_MAX_FRAME_IN_FLIGHT_COUNT),
+	m_point_light_positions(VREN_MAX_POINT_LIGHT_COUNT),
+	m_point_lights(VREN_MAX_POINT_LIGHT_COUNT),
+	m_directional_lights(VREN_MAX_DIRECTIONAL_LIGHT_COUNT),
+	m_spot_light_positions(VREN_MAX_SPOT_LIGHT_COUNT),
+	m_spot_lights(VREN_MAX_SPOT_LIGHT_COUNT)
+{
+}
+
+bool vren::light_store::is_dirty() const
+{
+	return
+		m_point_light_positions.is_dirty() ||
+		m_point_lights.is_dirty() ||
+		m_directional_lights.is_dirty() ||
+		m_spot_light_positions.is_dirty() ||
+		m_spot_lights.is_dirty();
+}
+
+vren::render_graph_t vren::light_store::upload(vren::render_graph_allocator& allocator, uint32_t frame_idx)
+{
+	assert(m_point_light_positions.size() == m_point_lights.size());
+	assert(m_spot_light_positions.size() == m_spot_lights.size());
+
+	struct buffer_upload
+	{
+		VkBuffer m_dst_buffer;
+		std::vector<VkBufferCopy> m_regions;
+	};
+
+	std::array<buffer_upload, 5> buffer_uploads{};
+
+	size_t segment_offset = frame_idx * m_upload_segment_size;
+	uint8_t* segment = m_upload_ring.get_mapped_pointer<uint8_t>() + segment_offset;
+
+	size_t upload_size = 0;
+
+	auto pop = [&]<typename _t>(vren::light_store_stream<_t>& stream, vren::vk_utils::buffer const& dst_buffer, buffer_upload& buffer_upload)
+	{
+		buffer_upload.m_dst_buffer = dst_buffer.m_buffer.m_handle;
+
+		upload_size += stream.pop_dirty_ranges(m_upload_segment_size - upload_size, [&](uint32_t offset, uint32_t count)
+		{
+			std::memcpy(segment + upload_size, stream.data() + offset, count * sizeof(_t));
+
+			buffer_upload.m_regions.push_back({
+				.srcOffset = segment_offset + upload_size,
+				.dstOffset = offset * sizeof(_t),
+				.size = count * sizeof(_t)
+			});
+			upload_size += count * sizeof(_t);
+		});
+	};
+
+	pop(m_point_light_positions, m_light_array.m_point_light_position_buffer, buffer_uploads[0]);
+	pop(m_point_lights, m_light_array.m_point_light_buffer, buffer_uploads[1]);
+	pop(m_directional_lights, m_light_array.m_directional_light_buffer, buffer_uploads[2]);
+	pop(m_spot_light_positions, m_light_array.m_spot_light_position_buffer, buffer_uploads[3]);
+	pop(m_spot_lights, m_light_array.m_spot_light_buffer, buffer_uploads[4]);
+
+	// Only the lights uploaded at least once are published, the ones left to the next frames would be read uninitialized
+	m_light_array.m_point_light_count = std::min(m_point_light_positions.get_uploaded_count(), m_point_lights.get_uploaded_count());
+	m_light_array.m_directional_light_count = m_directional_lights.get_uploaded_count();
+	m_light_array.m_spot_light_count = std::min(m_spot_light_positions.get_uploaded_count(), m_spot_lights.get_uploaded_count());
+
+	m_last_upload_size = upload_size;
+
+	if (upload_size == 0)
+	{
+		return {};
+	}
+
+	VREN_CHECK(vmaFlushAllocation(m_context->m_vma_allocator, m_upload_ring.m_allocation.m_handle, segment_offset, upload_size), m_context);
+
+	vren::render_graph_node* node = allocator.allocate();
+
+	node->set_name("light_store | upload");
+
+	node->set_src_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+	node->set_dst_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	m_light_array.add_render_graph_node_resources(*node, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	node->set_callback([this, buffer_uploads = std::move(buffer_uploads)](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		for (buffer_upload const& buffer_upload : buffer_uploads)
+		{
+			if (!buffer_upload.m_regions.empty())
+			{
+				vkCmdCopyBuffer(command_buffer, m_upload_ring.m_buffer.m_handle, buffer_upload.m_dst_buffer, buffer_upload.m_regions.size(), buffer_upload.m_regions.data());
+			}
+		}
+	});
+	return vren::render_graph_gather(node);
 }
@@ -4,6 +4,7 @@
 #include <queue>
 #include <functional>
 #include <span>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 
@@ -18,6 +19,23 @@ namespace vren
 	// Forward decl
 	class context;
 
+	// ------------------------------------------------------------------------------------------------
+	// Point light radius
+	// ------------------------------------------------------------------------------------------------
+
+	/// The attenuation below which a point light doesn't contribute anymore.
+	inline constexpr float k_default_light_attenuation_threshold = 1.0f / 256.0f;
+
+	/** Calculates the influence radius of a point light: the distance at which its attenuation, intensity / (d^2 + 1),
+	 * falls below the attenuation threshold. Mirrors calc_point_light_radius in common.glsl.
+	 */
+	inline float calc_point_light_radius(float intensity, float attenuation_threshold)
+	{
+		return glm::sqrt(glm::max(intensity / attenuation_threshold - 1.0f, 0.0f));
+	}
+
+	// ------------------------------------------------------------------------------------------------
+
 	class light_array
 	{
 	private:
@@ -31,9 +49,226 @@ namespace vren
 		vren::vk_utils::buffer m_directional_light_buffer;
 		uint32_t m_directional_light_count = 0;
 
-		light_array(vren::context const& context);
+		vren::vk_utils::buffer m_spot_light_position_buffer; // As for the point lights, the w component is unused
+		vren::vk_utils::buffer m_spot_light_buffer;
+		uint32_t m_spot_light_count = 0;
+
+		/// If not host visible the buffers are device-only: they're written by the GPU or through a vren::light_store.
+		light_array(vren::context const& context, bool host_visible = true);
 
 		void add_render_graph_node_resources(vren::render_graph_node& node, VkAccessFlags access_flags) const;
 		void write_descriptor_set(VkDescriptorSet descriptor_set) const;
 	};
+
+	// ------------------------------------------------------------------------------------------------
+	// Light store
+	// ------------------------------------------------------------------------------------------------
+
+	/** The host copy of a light buffer of a vren::light_store. Tracks the element ranges edited since the last upload,
+	 * kept sorted and merged, and the prefix of elements that was uploaded at least once (the ones the device can read).
+	 */
+	template<typename _t>
+	class light_store_stream
+	{
+	public:
+		struct range
+		{
+			uint32_t m_begin;
+			uint32_t m_end;
+		};
+
+		/// The dirty ranges closer than this (in elements) are merged: few redundant bytes are uploaded in exchange for fewer copy regions.
+		static constexpr uint32_t k_merge_gap = 64;
+
+	private:
+		uint32_t m_max_count;
+		std::vector<_t> m_data;
+		std::vector<range> m_dirty_ranges;
+		uint32_t m_uploaded_count = 0;
+
+	public:
+		explicit light_store_stream(uint32_t max_count) :
+			m_max_count(max_count)
+		{}
+
+		inline uint32_t size() const
+		{
+			return (uint32_t) m_data.size();
+		}
+
+		inline _t const* data() const
+		{
+			return m_data.data();
+		}
+
+		inline bool is_dirty() const
+		{
+			return !m_dirty_ranges.empty();
+		}
+
+		inline std::vector<range> const& get_dirty_ranges() const
+		{
+			return m_dirty_ranges;
+		}
+
+		/// The count of the prefix of elements that was uploaded at least once, only these can be published to the device.
+		inline uint32_t get_uploaded_count() const
+		{
+			return m_uploaded_count;
+		}
+
+		/// The added elements are value-initialized and marked dirty, so that they're uploaded even if not edited.
+		void resize(uint32_t count)
+		{
+			assert(count <= m_max_count);
+
+			uint32_t old_count = size();
+			m_data.resize(count);
+
+			m_uploaded_count = std::min(m_uploaded_count, count);
+			if (count > old_count)
+			{
+				mark_dirty(old_count, count);
+			}
+		}
+
+		void mark_dirty(uint32_t begin, uint32_t end)
+		{
+			assert(begin <= end && end <= size());
+			if (begin == end)
+			{
+				return;
+			}
+
+			auto first = std::lower_bound(m_dirty_ranges.begin(), m_dirty_ranges.end(), begin, [](range const& dirty_range, uint32_t value)
+			{
+				return dirty_range.m_end + k_merge_gap < value;
+			});
+
+			auto last = first;
+			for (; last != m_dirty_ranges.end() && last->m_begin <= end + k_merge_gap; last++)
+			{
+				begin = std::min(begin, last->m_begin);
+				end = std::max(end, last->m_end);
+			}
+
+			first = m_dirty_ranges.erase(first, last);
+			m_dirty_ranges.insert(first, { .m_begin = begin, .m_end = end });
+		}
+
+		/// Returns the elements [offset, offset + count) to be written, they're marked dirty.
+		std::span<_t> edit(uint32_t offset, uint32_t count)
+		{
+			mark_dirty(offset, offset + count);
+			return std::span<_t>(m_data.data() + offset, count);
+		}
+
+		/** Pops the dirty ranges that fit in the given byte capacity (the last one may be split), the ranges past the size are
+		 * dropped. Calls on_range(element_offset, element_count) for every popped range.
+		 * @return The number of bytes popped.
+		 */
+		template<typename _on_range_t>
+		size_t pop_dirty_ranges(size_t capacity, _on_range_t const& on_range)
+		{
+			size_t popped_size = 0;
+
+			auto it = m_dirty_ranges.begin();
+			for (; it != m_dirty_ranges.end(); it++)
+			{
+				uint32_t begin = it->m_begin;
+				uint32_t end = std::min(it->m_end, size());
+				if (begin >= end)
+				{
+					continue;
+				}
+
+				uint32_t count = (uint32_t) std::min<size_t>(end - begin, (capacity - popped_size) / sizeof(_t));
+				if (count == 0)
+				{
+					break;
+				}
+
+				on_range(begin, count);
+				popped_size += count * sizeof(_t);
+
+				if (begin + count < end)
+				{
+					it->m_begin = begin + count; // Partially popped, the remainder is uploaded later
+					break;
+				}
+			}
+
+			m_dirty_ranges.erase(m_dirty_ranges.begin(), it);
+
+			// Every element out of the dirty ranges was uploaded at least once (the added elements are marked dirty), therefore the
+			// uploaded prefix extends up to the first dirty element that was never uploaded
+			uint32_t uploaded_count = size();
+			for (range const& dirty_range : m_dirty_ranges)
+			{
+				if (dirty_range.m_end > m_uploaded_count)
+				{
+					uploaded_count = std::max(dirty_range.m_begin, m_uploaded_count);
+					break;
+				}
+			}
+			m_uploaded_count = std::min(uploaded_count, size());
+
+			return popped_size;
+		}
+	};
+
+	/** Keeps the lights in a single device-local vren::light_array and streams to it only the edited spans, through a
+	 * persistently mapped upload ring. The ring is split in a segment per frame in flight: a frame writes its own segment,
+	 * whose previous copies were completed when the frame fence was waited. When the dirty spans don't fit, the rest is
+	 * uploaded by the next frames.
+	 *
+	 * The GPU writers of the light array (e.g. the point lights of the light simulation) aren't reflected on the host copy.
+	 */
+	class light_store
+	{
+	public:
+		static constexpr size_t k_default_upload_ring_size = 8 * 1024 * 1024;
+
+	private:
+		vren::context const* m_context;
+
+		vren::light_array m_light_array;
+
+		vren::vk_utils::buffer m_upload_ring;
+		size_t m_upload_segment_size;
+
+		size_t m_last_upload_size = 0;
+
+	public:
+		vren::light_store_stream<glm::vec4> m_point_light_positions;
+		vren::light_store_stream<vren::point_light> m_point_lights;
+		vren::light_store_stream<vren::directional_light> m_directional_lights;
+		vren::light_store_stream<glm::vec4> m_spot_light_positions;
+		vren::light_store_stream<vren::spot_light> m_spot_lights;
+
+		explicit light_store(vren::context const& context, size_t upload_ring_size = k_default_upload_ring_size);
+
+		/// The light counts are updated by upload(), to the lights that were fully uploaded.
+		inline vren::light_array& get_light_array()
+		{
+			return m_light_array;
+		}
+
+		inline vren::light_array const& get_light_array() const
+		{
+			return m_light_array;
+		}
+
+		inline size_t get_last_upload_size() const
+		{
+			return m_last_upload_size;
+		}
+
+		bool is_dirty() const;
+
+		/** Copies the dirty spans to the light array (within the frame upload segment) and updates the light counts. The lights
+		 * whose upload is left to the next frames aren't counted, unless they were already uploaded once.
+		 */
+		vren::render_graph_t upload(vren::render_graph_allocator& allocator, uint32_t frame_idx);
+	};
 }
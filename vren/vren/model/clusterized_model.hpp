@@ -20,4 +20,19 @@ namespace vren
 		std::vector<vren::instanced_meshlet> m_instanced_meshlets;
 		std::vector<vren::mesh_instance> m_instances;
 	};
+
+	/** Compressed representation of a clusterized_model (see vren::clusterized_model_compressor).
+	 * Vertices are duplicated per meshlet and laid out meshlet by meshlet: vren::meshlet::m_vertex_offset is the index of the
+	 * first vertex of the meshlet in m_vertices, and m_meshlet_triangles are 8-bit indices local to it.
+	 */
+	struct compressed_clusterized_model
+	{
+		std::string m_name = "unnamed";
+
+		std::vector<vren::compressed_vertex> m_vertices;
+		std::vector<uint8_t> m_meshlet_triangles;
+		std::vector<vren::meshlet> m_meshlets;
+		std::vector<vren::instanced_meshlet> m_instanced_meshlets;
+		std::vector<vren::mesh_instance> m_instances;
+	};
 }
@@ -0,0 +1,112 @@
+#include "clusterized_model_compressor.hpp"
+
+#include <algorithm>
+#include <execution>
+
+#include <glm/gtc/packing.hpp>
+
+#include "log.hpp"
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Vertex compression
+// --------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec2 vren::octahedral_encode(glm::vec3 const& normal)
+{
+	glm::vec3 n = normal / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+	glm::vec2 e(n.x, n.y);
+	if (n.z < 0.0f)
+	{
+		e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return e;
+}
+
+glm::vec3 vren::octahedral_decode(glm::vec2 const& encoded_normal)
+{
+	glm::vec3 v(encoded_normal.x, encoded_normal.y, 1.0f - glm::abs(encoded_normal.x) - glm::abs(encoded_normal.y));
+	if (v.z < 0.0f)
+	{
+		glm::vec2 xy = (1.0f - glm::abs(glm::vec2(v.y, v.x))) * glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+		v.x = xy.x;
+		v.y = xy.y;
+	}
+	return glm::normalize(v);
+}
+
+vren::compressed_vertex vren::compress_vertex(vren::vertex const& vertex, vren::bounding_sphere const& meshlet_bounding_sphere)
+{
+	glm::vec3 local_position =
+		meshlet_bounding_sphere.m_radius > 0.0f ? (vertex.m_position - meshlet_bounding_sphere.m_center) / meshlet_bounding_sphere.m_radius : glm::vec3(0.0f);
+	local_position = glm::clamp(local_position, glm::vec3(-1.0f), glm::vec3(1.0f));
+
+	glm::vec3 normal = glm::length(vertex.m_normal) > 0.0f ? glm::normalize(vertex.m_normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+
+	return vren::compressed_vertex{
+		.m_position_xy = glm::packSnorm2x16(glm::vec2(local_position.x, local_position.y)),
+		.m_position_z  = glm::packSnorm2x16(glm::vec2(local_position.z, 0.0f)), // The upper half is padding, see vren::compressed_vertex
+		.m_normal      = glm::packSnorm2x16(vren::octahedral_encode(normal)),
+		.m_texcoords   = glm::packHalf2x16(vertex.m_texcoords)
+	};
+}
+
+vren::vertex vren::decompress_vertex(vren::compressed_vertex const& compressed_vertex, vren::bounding_sphere const& meshlet_bounding_sphere)
+{
+	glm::vec3 local_position(glm::unpackSnorm2x16(compressed_vertex.m_position_xy), glm::unpackSnorm2x16(compressed_vertex.m_position_z).x);
+
+	vren::vertex vertex{};
+	vertex.m_position  = meshlet_bounding_sphere.m_center + local_position * meshlet_bounding_sphere.m_radius;
+	vertex.m_normal    = vren::octahedral_decode(glm::unpackSnorm2x16(compressed_vertex.m_normal));
+	vertex.m_texcoords = glm::unpackHalf2x16(compressed_vertex.m_texcoords);
+	return vertex;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Clusterized model compressor
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::compressed_clusterized_model vren::clusterized_model_compressor::compress(vren::clusterized_model const& clusterized_model)
+{
+	vren::compressed_clusterized_model result{};
+	result.m_name = clusterized_model.m_name;
+	result.m_meshlets = clusterized_model.m_meshlets;
+	result.m_meshlet_triangles = clusterized_model.m_meshlet_triangles;
+	result.m_instanced_meshlets = clusterized_model.m_instanced_meshlets;
+	result.m_instances = clusterized_model.m_instances;
+
+	// Every meshlet owns a contiguous range of vertices, the new vertex offset is the exclusive prefix sum of the vertex counts
+	std::vector<uint32_t> src_vertex_offsets(result.m_meshlets.size());
+
+	uint32_t vertex_count = 0;
+	for (uint32_t i = 0; i < result.m_meshlets.size(); i++)
+	{
+		vren::meshlet& meshlet = result.m_meshlets[i];
+
+		src_vertex_offsets[i] = meshlet.m_vertex_offset;
+		meshlet.m_vertex_offset = vertex_count;
+
+		vertex_count += meshlet.m_vertex_count;
+	}
+
+	result.m_vertices.resize(vertex_count);
+
+	std::for_each(std::execution::par_unseq, result.m_meshlets.begin(), result.m_meshlets.end(), [&](vren::meshlet const& meshlet)
+	{
+		uint32_t src_vertex_offset = src_vertex_offsets[&meshlet - result.m_meshlets.data()];
+
+		for (uint32_t i = 0; i < meshlet.m_vertex_count; i++)
+		{
+			vren::vertex const& vertex = clusterized_model.m_vertices.at(clusterized_model.m_meshlet_vertices.at(src_vertex_offset + i));
+			result.m_vertices[meshlet.m_vertex_offset + i] = vren::compress_vertex(vertex, meshlet.m_bounding_sphere);
+		}
+	});
+
+	size_t src_size =
+		clusterized_model.m_vertices.size() * sizeof(vren::vertex) +
+		clusterized_model.m_meshlet_vertices.size() * sizeof(uint32_t);
+	size_t dst_size = result.m_vertices.size() * sizeof(vren::compressed_vertex);
+
+	VREN_INFO("[clusterized_model_compressor] Compressed model: {}, geometry size: {} -> {} bytes ({:.1f}%)\n", result.m_name, src_size, dst_size, dst_size * 100.0 / glm::max<size_t>(src_size, 1));
+
+	return std::move(result);
+}
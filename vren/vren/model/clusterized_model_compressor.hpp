@@ -0,0 +1,28 @@
+#pragma once
+
+#include "clusterized_model.hpp"
+
+namespace vren
+{
+	// ------------------------------------------------------------------------------------------------
+	// Vertex compression
+	// ------------------------------------------------------------------------------------------------
+
+	glm::vec2 octahedral_encode(glm::vec3 const& normal);
+	glm::vec3 octahedral_decode(glm::vec2 const& encoded_normal);
+
+	vren::compressed_vertex compress_vertex(vren::vertex const& vertex, vren::bounding_sphere const& meshlet_bounding_sphere);
+
+	/** CPU mirror of decode_compressed_vertex (common.glsl), used to validate the compression accuracy. */
+	vren::vertex decompress_vertex(vren::compressed_vertex const& compressed_vertex, vren::bounding_sphere const& meshlet_bounding_sphere);
+
+	// ------------------------------------------------------------------------------------------------
+	// Clusterized model compressor
+	// ------------------------------------------------------------------------------------------------
+
+	class clusterized_model_compressor
+	{
+	public:
+		vren::compressed_clusterized_model compress(vren::clusterized_model const& clusterized_model);
+	};
+}
@@ -12,5 +12,6 @@ namespace vren
 	{
 	public:
 		vren::clusterized_model_draw_buffer upload(vren::context const& context, vren::clusterized_model const& clusterized_model);
+		vren::compressed_clusterized_model_draw_buffer upload(vren::context const& context, vren::compressed_clusterized_model const& compressed_model);
 	};
 }
@@ -10,5 +10,30 @@ namespace vren
 	inline constexpr size_t k_max_meshlet_vertex_count = 64;
 	inline constexpr size_t k_max_meshlet_primitive_count = 124;
 
-	size_t clusterize_mesh(float const* vertices, size_t vertex_stride, uint32_t const* indices, size_t index_count, uint32_t* meshlet_vertices, uint8_t* meshlet_triangles, vren::meshlet* meshlets);
+	/** Meshes with more triangles are split in spatially-coherent partitions that are clusterized in parallel. */
+	inline constexpr uint32_t k_clusterizer_partition_triangle_count = 1 << 14;
+
+	/** The maximum number of meshlets vren::clusterize_mesh could output. The output meshlet vertices and the output meshlet
+	 * triangles are at most index_count.
+	 */
+	inline size_t clusterize_mesh_bound(size_t index_count)
+	{
+		return index_count / 3;
+	}
+
+	/** Native mesh clusterizer: meshlets are seeded along the Morton curve of the triangle midpoints and grown by picking, among the
+	 * triangles sharing a vertex with the meshlet, the one with the lowest cost (the bounding sphere relative growth plus the count
+	 * of vertices it'd introduce). The vertex stride is expressed in floats, the positions are expected at the beginning of the
+	 * vertex. Returns the number of meshlets written.
+	 */
+	size_t clusterize_mesh(
+		float const* vertices,
+		size_t vertex_stride,
+		size_t vertex_count,
+		uint32_t const* indices,
+		size_t index_count,
+		uint32_t* meshlet_vertices,
+		uint8_t* meshlet_triangles,
+		vren::meshlet* meshlets
+	);
 }
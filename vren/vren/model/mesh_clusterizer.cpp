@@ -1,33 +1,49 @@
 #include "mesh.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <execution>
+#include <numeric>
 #include <vector>
 
 #include "base/base.hpp"
-#include "base/kd_tree.hpp"
-#include "log.hpp"
 
-bool is_triangle_adjacent_to_meshlet(uint32_t const* indices, uint32_t triangle, uint32_t const* meshlet_vertices, vren::meshlet const& meshlet)
+// --------------------------------------------------------------------------------------------------------------------------------
+// Mesh adjacency
+// --------------------------------------------------------------------------------------------------------------------------------
+
+struct mesh_adjacency
+{
+	std::vector<uint32_t> m_offsets;   // For every vertex, the offset of its first triangle in m_triangles (vertex_count + 1 elements)
+	std::vector<uint32_t> m_triangles; // The triangles sharing the vertex
+};
+
+mesh_adjacency build_mesh_adjacency(uint32_t const* indices, size_t index_count, size_t vertex_count)
 {
-	uint32_t
-		ai = indices[triangle * 3 + 0],
-		bi = indices[triangle * 3 + 1],
-		ci = indices[triangle * 3 + 2];
+	mesh_adjacency adjacency{};
+	adjacency.m_offsets.resize(vertex_count + 1, 0);
+	adjacency.m_triangles.resize(index_count);
 
-	for (uint32_t i = 0; i < meshlet.m_vertex_count; i++)
+	for (size_t i = 0; i < index_count; i++)
 	{
-		if (
-			meshlet_vertices[meshlet.m_vertex_offset + i] == ai ||
-			meshlet_vertices[meshlet.m_vertex_offset + i] == bi ||
-			meshlet_vertices[meshlet.m_vertex_offset + i] == ci
-		) {
-			return true;
-		}
+		adjacency.m_offsets[indices[i] + 1]++;
 	}
 
-	return false;
+	std::inclusive_scan(adjacency.m_offsets.begin(), adjacency.m_offsets.end(), adjacency.m_offsets.begin());
+
+	std::vector<uint32_t> write_offsets(adjacency.m_offsets.begin(), adjacency.m_offsets.end() - 1);
+	for (size_t i = 0; i < index_count; i++)
+	{
+		adjacency.m_triangles[write_offsets[indices[i]]++] = (uint32_t) (i / 3);
+	}
+
+	return adjacency;
 }
 
+// --------------------------------------------------------------------------------------------------------------------------------
+// Triangle helpers
+// --------------------------------------------------------------------------------------------------------------------------------
+
 void get_triangle_vertices(float const* vertices, size_t vertex_stride, uint32_t const* indices, uint32_t triangle_idx, glm::vec3& p0, glm::vec3& p1, glm::vec3& p2)
 {
 	p0 = *reinterpret_cast<glm::vec3 const*>(&vertices[indices[triangle_idx * 3 + 0] * vertex_stride]);
@@ -48,245 +64,420 @@ vren::bounding_sphere build_triangle_bounding_sphere(float const* vertices, size
 	};
 }
 
-bool does_meshlet_contain_triangle(float const* vertices, size_t vertex_stride, uint32_t const* indices, uint32_t triangle_idx, vren::meshlet& meshlet)
+/** Ritter's bounding sphere: not minimal but contains all the given points. */
+vren::bounding_sphere build_meshlet_bounding_sphere(float const* vertices, size_t vertex_stride, uint32_t const* meshlet_vertices, uint32_t vertex_count)
 {
-	glm::vec3 p0, p1, p2;
-	get_triangle_vertices(vertices, vertex_stride, indices, triangle_idx, p0, p1, p2);
+	auto get_position = [&](uint32_t i) -> glm::vec3
+	{
+		return *reinterpret_cast<glm::vec3 const*>(&vertices[meshlet_vertices[i] * vertex_stride]);
+	};
 
-	return
-		meshlet.m_bounding_sphere.contains(p0) && // Check whether the triangle is fully contained within the meshlet bounding sphere
-		meshlet.m_bounding_sphere.contains(p1) &&
-		meshlet.m_bounding_sphere.contains(p2);
-}
+	glm::vec3 p0 = get_position(0);
 
-uint8_t get_picked_vertex_index(uint32_t vertex, uint32_t const* meshlet_vertices, vren::meshlet const& meshlet)
-{
-	uint8_t already_picked = UINT8_MAX; // Return UINT8_MAX if the given vertex wasn't picked yet
-	for (uint8_t i = 0; i < meshlet.m_vertex_count; i++) {
-		if (meshlet_vertices[meshlet.m_vertex_offset + i] == vertex) {
-			already_picked = i;
-			break;
+	glm::vec3 p1 = p0;
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		if (glm::length(get_position(i) - p0) > glm::length(p1 - p0)) p1 = get_position(i);
+	}
+
+	glm::vec3 p2 = p1;
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		if (glm::length(get_position(i) - p1) > glm::length(p2 - p1)) p2 = get_position(i);
+	}
+
+	vren::bounding_sphere bounding_sphere{
+		.m_center = (p1 + p2) / 2.0f,
+		.m_radius = glm::length(p2 - p1) / 2.0f
+	};
+
+	for (uint32_t i = 0; i < vertex_count; i++)
+	{
+		glm::vec3 p = get_position(i);
+		float d = glm::length(p - bounding_sphere.m_center);
+		if (d > bounding_sphere.m_radius)
+		{
+			float r = (bounding_sphere.m_radius + d) / 2.0f;
+			bounding_sphere.m_center += (p - bounding_sphere.m_center) * ((r - bounding_sphere.m_radius) / d);
+			bounding_sphere.m_radius = r;
 		}
 	}
-	return already_picked;
+
+	return bounding_sphere;
 }
 
-uint32_t pick_vertex(uint32_t vertex, uint32_t* meshlet_vertices, vren::meshlet& meshlet)
+uint32_t expand_bits_10(uint32_t v)
 {
-	meshlet_vertices[meshlet.m_vertex_offset + meshlet.m_vertex_count] = vertex;
-	return meshlet.m_vertex_count++;
+	v = (v * 0x00010001u) & 0xFF0000FFu;
+	v = (v * 0x00000101u) & 0x0F00F00Fu;
+	v = (v * 0x00000011u) & 0xC30C30C3u;
+	v = (v * 0x00000005u) & 0x49249249u;
+	return v;
 }
 
-bool pick_triangle(float const* vertices, size_t vertex_stride, uint32_t const* indices, uint32_t triangle_idx, uint32_t* meshlet_vertices, uint8_t* meshlet_triangles, vren::meshlet& meshlet)
+uint32_t calc_morton_code(glm::vec3 const& normalized_position)
 {
-	if (meshlet.m_triangle_count >= vren::k_max_meshlet_primitive_count) {
-		return false;
-	}
+	glm::uvec3 p = glm::uvec3(glm::clamp(normalized_position * 1024.0f, glm::vec3(0.0f), glm::vec3(1023.0f)));
+	return (expand_bits_10(p.x) << 2) | (expand_bits_10(p.y) << 1) | expand_bits_10(p.z);
+}
 
-	uint32_t
-		a = indices[triangle_idx * 3 + 0],
-		b = indices[triangle_idx * 3 + 1],
-		c = indices[triangle_idx * 3 + 2];
+// --------------------------------------------------------------------------------------------------------------------------------
+// Partition clusterization
+// --------------------------------------------------------------------------------------------------------------------------------
 
-	uint8_t ai, bi, ci;
-	ai = get_picked_vertex_index(a, meshlet_vertices, meshlet);
-	bi = get_picked_vertex_index(b, meshlet_vertices, meshlet);
-	ci = get_picked_vertex_index(c, meshlet_vertices, meshlet);
+struct clusterizer_input
+{
+	float const* m_vertices;
+	size_t m_vertex_stride;
+	size_t m_vertex_count;
+	uint32_t const* m_indices;
+	size_t m_triangle_count;
+
+	mesh_adjacency m_adjacency;
+	std::vector<uint32_t> m_sorted_triangles; // Triangles sorted along the Morton curve of their midpoints
+	std::vector<uint32_t> m_triangle_ranks;   // The position of every triangle within m_sorted_triangles
+};
+
+struct clusterizer_output
+{
+	std::vector<uint32_t> m_meshlet_vertices;
+	std::vector<uint8_t> m_meshlet_triangles;
+	std::vector<vren::meshlet> m_meshlets;
+};
 
-	if (meshlet.m_vertex_count + (ai == UINT8_MAX) + (bi == UINT8_MAX) + (ci == UINT8_MAX) >= vren::k_max_meshlet_vertex_count) {
-		return false;
-	}
+struct triangle_candidate
+{
+	float m_cost;
+	uint32_t m_triangle;
 
-	if (ai == UINT8_MAX) {
-		ai = pick_vertex(a, meshlet_vertices, meshlet);
+	bool operator<(triangle_candidate const& other) const
+	{
+		return m_cost > other.m_cost; // Min-heap
 	}
+};
 
-	if (bi == UINT8_MAX) {
-		bi = pick_vertex(b, meshlet_vertices, meshlet);
-	}
+/** Clusterizes the triangles whose rank (position along the Morton curve) is in [rank_begin, rank_end). Different partitions
+ * don't share triangles and can be clusterized concurrently.
+ */
+void clusterize_partition(clusterizer_input const& input, uint32_t rank_begin, uint32_t rank_end, std::vector<uint8_t>& triangle_picked, clusterizer_output& output)
+{
+	const float k_new_vertex_cost = 4.0f; // The cost of a triangle that introduces three new vertices, compared to the bounding sphere relative growth
 
-	if (ci == UINT8_MAX) {
-		ci = pick_vertex(c, meshlet_vertices, meshlet);
+	// For every vertex, its index within the current meshlet (or UINT8_MAX if not picked); it's reset after every meshlet
+	thread_local std::vector<uint8_t> vertex_slots;
+	if (vertex_slots.size() < input.m_vertex_count)
+	{
+		vertex_slots.resize(input.m_vertex_count, UINT8_MAX);
 	}
 
-	meshlet_triangles[meshlet.m_triangle_offset + meshlet.m_triangle_count * 3 + 0] = ai;
-	meshlet_triangles[meshlet.m_triangle_offset + meshlet.m_triangle_count * 3 + 1] = bi;
-	meshlet_triangles[meshlet.m_triangle_offset + meshlet.m_triangle_count * 3 + 2] = ci;
-	meshlet.m_triangle_count++;
-
-	glm::vec3 p0, p1, p2;
-	get_triangle_vertices(vertices, vertex_stride, indices, triangle_idx, p0, p1, p2);
-
-	meshlet.m_bounding_sphere += build_triangle_bounding_sphere(vertices, vertex_stride, indices, triangle_idx);
-
-	return true;
-}
+	std::vector<triangle_candidate> candidates;
+	candidates.reserve(vren::k_max_meshlet_primitive_count * 16);
 
-size_t vren::clusterize_mesh(
-	float const* vertices,
-	size_t vertex_stride,
-	uint32_t const* indices,
-	size_t index_count,
-	uint32_t* meshlet_vertices,
-	uint8_t* meshlet_triangles,
-	vren::meshlet* meshlets
-)
-{
-	assert(index_count % 3 == 0);
-
-	size_t triangle_count = index_count / 3;
+	std::vector<triangle_candidate> rejected_candidates;
+	rejected_candidates.reserve(vren::k_max_meshlet_primitive_count * 16);
 
-	std::vector<glm::vec3> triangle_midpoints(triangle_count); // A vector holding the midpoints of all triangles
-	for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
+	auto is_triangle_in_partition = [&](uint32_t triangle) -> bool
 	{
-		glm::vec3 p0, p1, p2;
-		get_triangle_vertices(vertices, vertex_stride, indices, triangle, p0, p1, p2);
+		uint32_t rank = input.m_triangle_ranks[triangle];
+		return rank >= rank_begin && rank < rank_end;
+	};
 
-		glm::vec3 midpoint = (p0 + p1 + p2) / glm::vec3(3.0f);
-		triangle_midpoints[triangle] = midpoint;
-	}
+	auto count_new_vertices = [&](uint32_t triangle) -> uint32_t
+	{
+		uint32_t a = input.m_indices[triangle * 3 + 0], b = input.m_indices[triangle * 3 + 1], c = input.m_indices[triangle * 3 + 2];
+		return
+			(vertex_slots[a] == UINT8_MAX) +
+			(vertex_slots[b] == UINT8_MAX && b != a) +
+			(vertex_slots[c] == UINT8_MAX && c != a && c != b);
+	};
 
-	std::vector<uint32_t> kd_tree_triangle_indices(triangle_count); // Temporary vector used to build the KD-tree
-	for (uint32_t i = 0; i < triangle_count; i++)
+	auto count_non_picked_neighbours = [&](uint32_t triangle) -> uint32_t
 	{
-		kd_tree_triangle_indices[i] = i;
-	}
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			uint32_t vertex = input.m_indices[triangle * 3 + i];
+			for (uint32_t j = input.m_adjacency.m_offsets[vertex]; j < input.m_adjacency.m_offsets[vertex + 1]; j++)
+			{
+				uint32_t adjacent_triangle = input.m_adjacency.m_triangles[j];
+				count += is_triangle_in_partition(adjacent_triangle) && !triangle_picked[adjacent_triangle];
+			}
+		}
+		return count;
+	};
 
-	std::vector<vren::kd_tree_node> kd_tree(triangle_count * 2); // TODO max size?
-	vren::kd_tree_build(reinterpret_cast<float const*>(triangle_midpoints.data()), sizeof(glm::vec3) / sizeof(float), kd_tree_triangle_indices.data(), kd_tree_triangle_indices.size(), kd_tree.data(), 0, 8);
+	uint32_t cursor = rank_begin;
+	uint32_t next_seed = UINT32_MAX;
+	while (true)
+	{
+		// Seed the meshlet with a triangle left on the border of the previous meshlet or, if there's none, with the first
+		// non-picked triangle along the Morton curve
+		uint32_t seed = next_seed;
+		if (seed == UINT32_MAX)
+		{
+			while (cursor < rank_end && triangle_picked[input.m_sorted_triangles[cursor]])
+			{
+				cursor++;
+			}
 
-	// 0 = triangle not picked
-	// 1 = triangle picked and put in nearby queue
-	// 2 = triangle picked by the meshlet
-	std::vector<uint8_t> triangle_picked(triangle_count, 0);
+			if (cursor >= rank_end)
+			{
+				break;
+			}
 
-	uint32_t nearby_triangle_queue[vren::k_max_meshlet_primitive_count];
+			seed = input.m_sorted_triangles[cursor];
+		}
 
-	size_t meshlet_count = 0;
-	for (uint32_t triangle = 0; triangle < triangle_count; triangle++)
-	{
-		assert(triangle_picked[triangle] != 1);
+		vren::meshlet meshlet{
+			.m_vertex_offset = (uint32_t) output.m_meshlet_vertices.size(),
+			.m_vertex_count = 0,
+			.m_triangle_offset = (uint32_t) output.m_meshlet_triangles.size(),
+			.m_triangle_count = 0,
+			.m_bounding_sphere = {}
+		};
 
-		if (triangle_picked.at(triangle)) { // We're searching for the first non-picked triangle
-			continue;
-		}
+		auto can_pick_triangle = [&](uint32_t triangle) -> bool
+		{
+			return
+				meshlet.m_triangle_count < vren::k_max_meshlet_primitive_count &&
+				meshlet.m_vertex_count + count_new_vertices(triangle) <= vren::k_max_meshlet_vertex_count;
+		};
 
-		vren::meshlet& meshlet = meshlets[meshlet_count];
-		meshlet.m_vertex_offset = meshlet_count > 0 ? meshlets[meshlet_count - 1].m_vertex_offset + meshlets[meshlet_count - 1].m_vertex_count : 0;
-		meshlet.m_vertex_count = 0;
-		meshlet.m_triangle_offset = meshlet_count > 0 ? meshlets[meshlet_count - 1].m_triangle_offset + meshlets[meshlet_count - 1].m_triangle_count * 3 : 0;
-		meshlet.m_triangle_count = 0;
-		meshlet.m_bounding_sphere = {}; // Degenerate bounding sphere (radius = 0)
+		auto calc_triangle_cost = [&](uint32_t triangle) -> float
+		{
+			glm::vec3 p0, p1, p2;
+			get_triangle_vertices(input.m_vertices, input.m_vertex_stride, input.m_indices, triangle, p0, p1, p2);
 
-		// PICK FIRST NON-PICKED TRIANGLE
-		assert(pick_triangle(vertices, vertex_stride, indices, triangle, meshlet_vertices, meshlet_triangles, meshlet));
-		triangle_picked[triangle] = 2;
+			vren::bounding_sphere const& sphere = meshlet.m_bounding_sphere;
 
-		VREN_DEBUG("Initialized meshlet {} at triangle {}\n", meshlet_count, triangle);
+			float distance = glm::max(glm::length(p0 - sphere.m_center), glm::max(glm::length(p1 - sphere.m_center), glm::length(p2 - sphere.m_center)));
+			float growth = glm::max(distance - sphere.m_radius, 0.0f) / glm::max(sphere.m_radius, std::numeric_limits<float>::epsilon());
 
-		// SEARCH FOR NEARBY TRIANGLES
-		glm::vec3 sample = triangle_midpoints[triangle];
+			return growth + k_new_vertex_cost * (count_new_vertices(triangle) / 3.0f);
+		};
 
-		uint32_t nearby_triangle_count = 0;
-		for (; nearby_triangle_count < std::size(nearby_triangle_queue); nearby_triangle_count++)
+		auto pick_triangle = [&](uint32_t triangle)
 		{
-			float nearest_triangle_distance = std::numeric_limits<float>::infinity();
-			uint32_t nearest_triangle = UINT32_MAX;
-
-			// Search for the nearest non-picked triangle using the built KD-tree
-			auto can_pick = [&](uint32_t triangle) -> bool { return triangle_picked[triangle] == 0; };
-			kd_tree_search(
-				reinterpret_cast<float const*>(triangle_midpoints.data()),
-				sizeof(glm::vec3) / sizeof(float),
-				kd_tree_triangle_indices.data(),
-				kd_tree_triangle_indices.size(),
-				kd_tree.data(),
-				0,
-				(float const*) &sample,
-				can_pick,
-				nearest_triangle,
-				nearest_triangle_distance
-			);
-
-			if (nearest_triangle < UINT32_MAX)
-			{
-				nearby_triangle_queue[nearby_triangle_count] = nearest_triangle;
-				triangle_picked[nearest_triangle] = 1;
-			}
-			else
+			for (uint32_t i = 0; i < 3; i++)
 			{
-				break;
+				uint32_t vertex = input.m_indices[triangle * 3 + i];
+				if (vertex_slots[vertex] == UINT8_MAX)
+				{
+					vertex_slots[vertex] = (uint8_t) meshlet.m_vertex_count++;
+					output.m_meshlet_vertices.push_back(vertex);
+				}
+				output.m_meshlet_triangles.push_back(vertex_slots[vertex]);
 			}
-		}
+			meshlet.m_triangle_count++;
+			meshlet.m_bounding_sphere += build_triangle_bounding_sphere(input.m_vertices, input.m_vertex_stride, input.m_indices, triangle);
 
-		size_t
-			picked_for_adjacency_count = 0,
-			picked_for_bounding_sphere_count = 0;
-		while (true)
-		{
-			size_t picked_triangle_count;
+			triangle_picked[triangle] = 1;
 
-			// PICK ADJACENT TRIANGLES
-			while (true)
+			// Push the non-picked triangles sharing a vertex with the picked one
+			for (uint32_t i = 0; i < 3; i++)
 			{
-				picked_triangle_count = 0;
-				for (uint32_t i = 0; i < nearby_triangle_count; i++)
+				uint32_t vertex = input.m_indices[triangle * 3 + i];
+				for (uint32_t j = input.m_adjacency.m_offsets[vertex]; j < input.m_adjacency.m_offsets[vertex + 1]; j++)
 				{
-					uint32_t nearby_triangle = nearby_triangle_queue[i];
-					if (triangle_picked[nearby_triangle] != 2 && is_triangle_adjacent_to_meshlet(indices, nearby_triangle, meshlet_vertices, meshlet))
+					uint32_t adjacent_triangle = input.m_adjacency.m_triangles[j];
+					if (is_triangle_in_partition(adjacent_triangle) && !triangle_picked[adjacent_triangle])
 					{
-						if (pick_triangle(vertices, vertex_stride, indices, nearby_triangle, meshlet_vertices, meshlet_triangles, meshlet))
-						{
-							triangle_picked[nearby_triangle] = 2;
-							picked_triangle_count++;
-						}
+						candidates.push_back({ calc_triangle_cost(adjacent_triangle), adjacent_triangle });
+						std::push_heap(candidates.begin(), candidates.end());
 					}
 				}
-				picked_for_adjacency_count += picked_triangle_count;
-				if (picked_triangle_count == 0) {
-					break; // Exit when there's no more adjacent triangle or the meshlet is completed
-				}
 			}
+		};
+
+		candidates.clear();
+		rejected_candidates.clear();
+		pick_triangle(seed);
 
-			// PICK TRIANGLES CONTAINED IN MESHLET BOUNDING-SPHERE
-			picked_triangle_count = 0;
-			for (uint32_t i = 0; i < nearby_triangle_count; i++)
+		while (meshlet.m_triangle_count < vren::k_max_meshlet_primitive_count)
+		{
+			if (candidates.empty())
 			{
-				uint32_t nearby_triangle = nearby_triangle_queue[i];
-				if (triangle_picked[nearby_triangle] != 2 && does_meshlet_contain_triangle(vertices, vertex_stride, indices, nearby_triangle, meshlet))
+				// There's no adjacent triangle left (e.g. the mesh is made of disconnected parts), try to continue with the next
+				// triangle along the Morton curve if it's close enough to the meshlet
+				while (cursor < rank_end && triangle_picked[input.m_sorted_triangles[cursor]])
 				{
-					if (pick_triangle(vertices, vertex_stride, indices, nearby_triangle, meshlet_vertices, meshlet_triangles, meshlet))
-					{
-						triangle_picked[nearby_triangle] = 2;
-						picked_triangle_count++;
-					}
+					cursor++;
+				}
+
+				if (cursor >= rank_end)
+				{
+					break;
 				}
+
+				uint32_t triangle = input.m_sorted_triangles[cursor];
+				if (!can_pick_triangle(triangle) || calc_triangle_cost(triangle) > 1.0f + k_new_vertex_cost)
+				{
+					break;
+				}
+
+				pick_triangle(triangle);
+				continue;
 			}
-			picked_for_bounding_sphere_count += picked_triangle_count;
-			if (picked_triangle_count == 0) { // No adjacent triangle and no triangle is contained in the meshlet bounding sphere, there's no more work
-				break;
+
+			std::pop_heap(candidates.begin(), candidates.end());
+			triangle_candidate candidate = candidates.back();
+			candidates.pop_back();
+
+			if (triangle_picked[candidate.m_triangle])
+			{
+				continue;
 			}
+
+			if (!can_pick_triangle(candidate.m_triangle))
+			{
+				rejected_candidates.push_back(candidate); // Kept as seed candidates for the next meshlet
+				continue;
+			}
+
+			// The cost was computed when the candidate was pushed, since then the meshlet may have grown: if the updated cost makes
+			// the candidate worse than the next one, push it back (lazy re-evaluation)
+			float cost = calc_triangle_cost(candidate.m_triangle);
+			if (cost > candidate.m_cost && !candidates.empty() && cost > candidates.front().m_cost)
+			{
+				candidates.push_back({ cost, candidate.m_triangle });
+				std::push_heap(candidates.begin(), candidates.end());
+				continue;
+			}
+
+			pick_triangle(candidate.m_triangle);
 		}
 
-		VREN_DEBUG("Nearby triangle count: {}, Picked for bounding sphere {}, Picked for adjacency {}\n", nearby_triangle_count, picked_for_bounding_sphere_count, picked_for_adjacency_count);
+		// The next seed is the border triangle with the fewest non-picked neighbours: starting from the most enclosed triangles
+		// avoids leaving isolated fragments behind that would end up in small meshlets
+		next_seed = UINT32_MAX;
 
-		// EMPTY QUEUE
-		for (uint32_t i = 0; i < nearby_triangle_count; i++)
+		candidates.insert(candidates.end(), rejected_candidates.begin(), rejected_candidates.end());
+
+		uint32_t next_seed_neighbour_count = UINT32_MAX;
+		for (triangle_candidate const& candidate : candidates)
 		{
-			uint32_t nearby_triangle = nearby_triangle_queue[i];
-			if (triangle_picked[nearby_triangle] == 1) {
-				triangle_picked[nearby_triangle] = 0;
+			if (!triangle_picked[candidate.m_triangle])
+			{
+				uint32_t neighbour_count = count_non_picked_neighbours(candidate.m_triangle);
+				if (neighbour_count < next_seed_neighbour_count)
+				{
+					next_seed = candidate.m_triangle;
+					next_seed_neighbour_count = neighbour_count;
+				}
 			}
 		}
 
-		//VREN_DEBUG("Meshlet {} completed - {} vertices, {} triangles\n", meshlet_count, meshlet.m_vertex_count, meshlet.m_triangle_count);
+		// Meshlet completed
+		for (uint32_t i = 0; i < meshlet.m_vertex_count; i++)
+		{
+			vertex_slots[output.m_meshlet_vertices[meshlet.m_vertex_offset + i]] = UINT8_MAX;
+		}
+
+		meshlet.m_bounding_sphere = build_meshlet_bounding_sphere(input.m_vertices, input.m_vertex_stride, &output.m_meshlet_vertices[meshlet.m_vertex_offset], meshlet.m_vertex_count);
+
+		output.m_meshlets.push_back(meshlet);
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+
+size_t vren::clusterize_mesh(
+	float const* vertices,
+	size_t vertex_stride,
+	size_t vertex_count,
+	uint32_t const* indices,
+	size_t index_count,
+	uint32_t* meshlet_vertices,
+	uint8_t* meshlet_triangles,
+	vren::meshlet* meshlets
+)
+{
+	assert(index_count % 3 == 0);
+
+	if (index_count == 0)
+	{
+		return 0;
+	}
 
-		// MESHLET COMPLETED
-		meshlet_count++;
+	clusterizer_input input{
+		.m_vertices = vertices,
+		.m_vertex_stride = vertex_stride,
+		.m_vertex_count = vertex_count,
+		.m_indices = indices,
+		.m_triangle_count = index_count / 3,
+		.m_adjacency = build_mesh_adjacency(indices, index_count, vertex_count)
+	};
+
+	// Sort the triangles along the Morton curve, so that consecutive triangles are spatially close
+	std::vector<glm::vec3> triangle_midpoints(input.m_triangle_count);
+
+	glm::vec3 min(std::numeric_limits<float>::infinity()), max(-std::numeric_limits<float>::infinity());
+	for (uint32_t triangle = 0; triangle < input.m_triangle_count; triangle++)
+	{
+		glm::vec3 p0, p1, p2;
+		get_triangle_vertices(vertices, vertex_stride, indices, triangle, p0, p1, p2);
+
+		triangle_midpoints[triangle] = (p0 + p1 + p2) / glm::vec3(3.0f);
 
-		VREN_DEBUG("> Meshlet completed - vertices: {}, triangles: {}\n", meshlet.m_vertex_count, meshlet.m_triangle_count);
+		min = glm::min(min, triangle_midpoints[triangle]);
+		max = glm::max(max, triangle_midpoints[triangle]);
+	}
+
+	glm::vec3 extent = glm::max(max - min, glm::vec3(std::numeric_limits<float>::epsilon()));
+
+	std::vector<uint32_t> morton_codes(input.m_triangle_count);
+	for (uint32_t triangle = 0; triangle < input.m_triangle_count; triangle++)
+	{
+		morton_codes[triangle] = calc_morton_code((triangle_midpoints[triangle] - min) / extent);
+	}
+
+	input.m_sorted_triangles.resize(input.m_triangle_count);
+	std::iota(input.m_sorted_triangles.begin(), input.m_sorted_triangles.end(), 0);
+	std::sort(std::execution::par_unseq, input.m_sorted_triangles.begin(), input.m_sorted_triangles.end(), [&](uint32_t a, uint32_t b)
+	{
+		return morton_codes[a] < morton_codes[b];
+	});
+
+	input.m_triangle_ranks.resize(input.m_triangle_count);
+	for (uint32_t rank = 0; rank < input.m_triangle_count; rank++)
+	{
+		input.m_triangle_ranks[input.m_sorted_triangles[rank]] = rank;
+	}
+
+	// Split the Morton curve in partitions that are clusterized in parallel
+	uint32_t partition_count = (uint32_t) vren::divide_and_ceil((uint32_t) input.m_triangle_count, vren::k_clusterizer_partition_triangle_count);
+
+	std::vector<uint8_t> triangle_picked(input.m_triangle_count, 0);
+	std::vector<clusterizer_output> outputs(partition_count);
+
+	std::vector<uint32_t> partitions(partition_count);
+	std::iota(partitions.begin(), partitions.end(), 0);
+
+	std::for_each(std::execution::par, partitions.begin(), partitions.end(), [&](uint32_t partition)
+	{
+		uint32_t rank_begin = partition * vren::k_clusterizer_partition_triangle_count;
+		uint32_t rank_end = (uint32_t) glm::min<size_t>(rank_begin + vren::k_clusterizer_partition_triangle_count, input.m_triangle_count);
+
+		clusterize_partition(input, rank_begin, rank_end, triangle_picked, outputs[partition]);
+	});
+
+	// Gather the partitions' meshlets
+	size_t meshlet_count = 0, meshlet_vertex_count = 0, meshlet_triangle_count = 0;
+	for (clusterizer_output const& output : outputs)
+	{
+		for (vren::meshlet meshlet : output.m_meshlets)
+		{
+			meshlet.m_vertex_offset += (uint32_t) meshlet_vertex_count;
+			meshlet.m_triangle_offset += (uint32_t) meshlet_triangle_count;
+			meshlets[meshlet_count++] = meshlet;
+		}
+
+		std::copy(output.m_meshlet_vertices.begin(), output.m_meshlet_vertices.end(), meshlet_vertices + meshlet_vertex_count);
+		std::copy(output.m_meshlet_triangles.begin(), output.m_meshlet_triangles.end(), meshlet_triangles + meshlet_triangle_count);
+
+		meshlet_vertex_count += output.m_meshlet_vertices.size();
+		meshlet_triangle_count += output.m_meshlet_triangles.size();
 	}
 
 	return meshlet_count;
 }
-
@@ -1,39 +1,68 @@
 #include "model_clusterizer.hpp"
 
-#define VREN_USE_MESH_OPTIMIZER
+#include <stdexcept>
 
-#ifdef VREN_USE_MESH_OPTIMIZER
-#	include <meshoptimizer.h>
-#endif
+#include <meshoptimizer.h>
+
+vren::model_clusterizer::model_clusterizer(vren::clusterizer_backend backend) :
+	m_backend(backend)
+{}
 
 void vren::model_clusterizer::reserve_buffer_space(vren::clusterized_model& output, vren::model const& model)
 {
 	size_t max_meshlets = 0;
 	size_t max_instanced_meshlets = 0;
+	size_t index_count = 0;
 
 	for (auto const& mesh : model.m_meshes)
 	{
-		size_t max_meshlets_per_mesh;
-
-#ifdef VREN_USE_MESH_OPTIMIZER
-		max_meshlets_per_mesh = meshopt_buildMeshletsBound(mesh.m_index_count, vren::k_max_meshlet_vertex_count, vren::k_max_meshlet_primitive_count);
-#else
-		max_meshlets_per_mesh = mesh.m_index_count / 3;
-#endif
+		size_t max_meshlets_per_mesh =
+			m_backend == vren::ClusterizerBackendMeshOptimizer ?
+			meshopt_buildMeshletsBound(mesh.m_index_count, vren::k_max_meshlet_vertex_count, vren::k_max_meshlet_primitive_count) :
+			vren::clusterize_mesh_bound(mesh.m_index_count);
 
 		max_meshlets += max_meshlets_per_mesh;
+		index_count += mesh.m_index_count;
 		max_instanced_meshlets += max_meshlets_per_mesh * mesh.m_instance_count;
 	}
 
-	output.m_meshlet_vertices.reserve(max_meshlets * vren::k_max_meshlet_vertex_count);
-	output.m_meshlet_triangles.reserve(max_meshlets * vren::k_max_meshlet_primitive_count * 3);
+	if (m_backend == vren::ClusterizerBackendMeshOptimizer)
+	{
+		output.m_meshlet_vertices.reserve(max_meshlets * vren::k_max_meshlet_vertex_count);
+		output.m_meshlet_triangles.reserve(max_meshlets * vren::k_max_meshlet_primitive_count * 3);
+	}
+	else
+	{
+		// The native clusterizer outputs at most one meshlet vertex and one meshlet triangle index per index
+		output.m_meshlet_vertices.reserve(index_count);
+		output.m_meshlet_triangles.reserve(index_count);
+	}
 	output.m_meshlets.reserve(max_meshlets);
 	output.m_instanced_meshlets.reserve(max_instanced_meshlets);
 }
 
 void vren::model_clusterizer::clusterize_mesh(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh)
 {
-#ifdef VREN_USE_MESH_OPTIMIZER
+	if (mesh.m_index_count == 0)
+	{
+		return;
+	}
+
+	switch (m_backend)
+	{
+	case vren::ClusterizerBackendMeshOptimizer:
+		clusterize_mesh_with_mesh_optimizer(output, model, mesh);
+		break;
+	case vren::ClusterizerBackendNative:
+		clusterize_mesh_natively(output, model, mesh);
+		break;
+	default:
+		throw std::runtime_error("Invalid clusterizer backend");
+	}
+}
+
+void vren::model_clusterizer::clusterize_mesh_with_mesh_optimizer(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh)
+{
 	size_t meshopt_max_meshlets = meshopt_buildMeshletsBound(mesh.m_index_count, vren::k_max_meshlet_vertex_count, vren::k_max_meshlet_primitive_count);
 	std::vector<meshopt_Meshlet> meshopt_meshlets(meshopt_max_meshlets);
 
@@ -60,6 +89,8 @@ void vren::model_clusterizer::clusterize_mesh(vren::clusterized_model& output, v
 		0.0f // cone_weight
 	);
 
+	meshopt_meshlets.resize(meshlet_count);
+
 	meshopt_Meshlet const& last_meshlet = meshopt_meshlets[meshlet_count - 1];
 	output.m_meshlet_vertices.resize(meshlet_vertices_offset + last_meshlet.vertex_offset + last_meshlet.vertex_count);
 	output.m_meshlet_triangles.resize(meshlet_triangles_offset + last_meshlet.triangle_offset + ((last_meshlet.triangle_count * 3 + 3) & ~3));
@@ -92,19 +123,51 @@ void vren::model_clusterizer::clusterize_mesh(vren::clusterized_model& output, v
 		// Since we're erasing the concept of mesh, we need to offset the meshlet' vertices by the mesh' vertex offset
 		output.m_meshlet_vertices[i] += mesh.m_vertex_offset;
 	}
-#else
-	// TODO
+}
+
+void vren::model_clusterizer::clusterize_mesh_natively(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh)
+{
+	size_t max_meshlets = vren::clusterize_mesh_bound(mesh.m_index_count);
+
+	float const* vertices = reinterpret_cast<float const*>(&model.m_vertices.front() + mesh.m_vertex_offset);
+	uint32_t const* indices = &model.m_indices.front() + mesh.m_index_offset;
+
+	size_t meshlet_vertices_offset = output.m_meshlet_vertices.size();
+	size_t meshlet_triangles_offset = output.m_meshlet_triangles.size();
+	size_t meshlets_offset = output.m_meshlets.size();
+
+	output.m_meshlet_vertices.resize(meshlet_vertices_offset + mesh.m_index_count);
+	output.m_meshlet_triangles.resize(meshlet_triangles_offset + mesh.m_index_count);
+	output.m_meshlets.resize(meshlets_offset + max_meshlets);
 
-	meshlet_count = vren::clusterize_mesh(
-		reinterpret_cast<float const*>(vertices + mesh.m_vertex_offset),
+	size_t meshlet_count = vren::clusterize_mesh(
+		vertices,
 		sizeof(vren::vertex) / sizeof(float),
-		indices + mesh.m_index_offset,
+		mesh.m_vertex_count,
+		indices,
 		mesh.m_index_count,
-		meshlet_vertices,
-		meshlet_triangles,
-		meshlets
+		&output.m_meshlet_vertices[meshlet_vertices_offset],
+		&output.m_meshlet_triangles[meshlet_triangles_offset],
+		&output.m_meshlets[meshlets_offset]
 	);
-#endif
+
+	output.m_meshlets.resize(meshlets_offset + meshlet_count);
+
+	vren::meshlet const& last_meshlet = output.m_meshlets.back();
+	output.m_meshlet_vertices.resize(meshlet_vertices_offset + last_meshlet.m_vertex_offset + last_meshlet.m_vertex_count);
+	output.m_meshlet_triangles.resize(meshlet_triangles_offset + last_meshlet.m_triangle_offset + last_meshlet.m_triangle_count * 3);
+
+	for (size_t i = meshlets_offset; i < output.m_meshlets.size(); i++)
+	{
+		output.m_meshlets[i].m_vertex_offset += (uint32_t) meshlet_vertices_offset;
+		output.m_meshlets[i].m_triangle_offset += (uint32_t) meshlet_triangles_offset;
+	}
+
+	for (size_t i = meshlet_vertices_offset; i < output.m_meshlet_vertices.size(); i++)
+	{
+		// Since we're erasing the concept of mesh, we need to offset the meshlet' vertices by the mesh' vertex offset
+		output.m_meshlet_vertices[i] += mesh.m_vertex_offset;
+	}
 }
 
 void vren::model_clusterizer::clusterize_model(vren::clusterized_model& output, vren::model const& model)
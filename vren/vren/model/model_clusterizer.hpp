@@ -5,14 +5,31 @@
 
 namespace vren
 {
+	enum clusterizer_backend
+	{
+		ClusterizerBackendMeshOptimizer, // meshopt_buildMeshlets
+		ClusterizerBackendNative         // vren::clusterize_mesh
+	};
+
 	class model_clusterizer
 	{
 	private:
+		vren::clusterizer_backend m_backend;
+
 		void reserve_buffer_space(vren::clusterized_model& output, vren::model const& model);
 		void clusterize_mesh(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh);
+		void clusterize_mesh_with_mesh_optimizer(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh);
+		void clusterize_mesh_natively(vren::clusterized_model& output, vren::model const& model, vren::model::mesh const& mesh);
 		void clusterize_model(vren::clusterized_model& output, vren::model const& model);
 
 	public:
+		explicit model_clusterizer(vren::clusterizer_backend backend = vren::ClusterizerBackendMeshOptimizer);
+
+		inline vren::clusterizer_backend get_backend() const
+		{
+			return m_backend;
+		}
+
 		vren::clusterized_model clusterize(vren::model const& model);
 	};
 }
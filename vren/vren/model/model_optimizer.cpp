@@ -0,0 +1,94 @@
+#include "model_optimizer.hpp"
+
+#include <algorithm>
+#include <execution>
+
+#include <meshoptimizer.h>
+
+#include "log.hpp"
+
+void vren::model_optimizer::optimize_mesh(vren::model& model, vren::model::mesh& mesh) const
+{
+	if (mesh.m_index_count == 0)
+	{
+		return;
+	}
+
+	// Mesh indices are local to the mesh vertex range, thus every mesh can be processed independently
+	uint32_t* indices = &model.m_indices[mesh.m_index_offset];
+	vren::vertex* vertices = &model.m_vertices[mesh.m_vertex_offset];
+
+	if (m_optimize_vertex_cache)
+	{
+		meshopt_optimizeVertexCache(indices, indices, mesh.m_index_count, mesh.m_vertex_count);
+	}
+
+	if (m_optimize_overdraw)
+	{
+		// Reorders clusters of triangles in view-independent front-to-back order, keeping the vertex cache efficiency
+		meshopt_optimizeOverdraw(indices, indices, mesh.m_index_count, &vertices->m_position.x, mesh.m_vertex_count, sizeof(vren::vertex), k_overdraw_threshold);
+	}
+
+	if (m_optimize_vertex_fetch)
+	{
+		// Vertices are reordered in the order they're referenced by the index buffer, unreferenced vertices are dropped
+		std::vector<vren::vertex> reordered_vertices(mesh.m_vertex_count);
+
+		size_t vertex_count = meshopt_optimizeVertexFetch(reordered_vertices.data(), indices, mesh.m_index_count, vertices, mesh.m_vertex_count, sizeof(vren::vertex));
+		std::copy(reordered_vertices.begin(), reordered_vertices.begin() + vertex_count, vertices);
+
+		mesh.m_vertex_count = (uint32_t) vertex_count;
+	}
+}
+
+void vren::model_optimizer::optimize(vren::model& model) const
+{
+	std::for_each(std::execution::par, model.m_meshes.begin(), model.m_meshes.end(), [&](vren::model::mesh& mesh)
+	{
+		optimize_mesh(model, mesh);
+	});
+
+	VREN_INFO("[model_optimizer] Optimized model: {}, meshes: {}\n", model.m_name, model.m_meshes.size());
+}
+
+vren::model_optimizer::statistics vren::model_optimizer::analyze(vren::model const& model)
+{
+	vren::model_optimizer::statistics result{};
+
+	double triangle_count = 0;
+	double acmr = 0, atvr = 0, overdraw = 0;
+
+	for (vren::model::mesh const& mesh : model.m_meshes)
+	{
+		if (mesh.m_index_count == 0)
+		{
+			continue;
+		}
+
+		uint32_t const* indices = &model.m_indices[mesh.m_index_offset];
+		vren::vertex const* vertices = &model.m_vertices[mesh.m_vertex_offset];
+
+		meshopt_VertexCacheStatistics vertex_cache_statistics =
+			meshopt_analyzeVertexCache(indices, mesh.m_index_count, mesh.m_vertex_count, k_vertex_cache_size, 0, 0);
+
+		meshopt_OverdrawStatistics overdraw_statistics =
+			meshopt_analyzeOverdraw(indices, mesh.m_index_count, &vertices->m_position.x, mesh.m_vertex_count, sizeof(vren::vertex));
+
+		double mesh_triangle_count = mesh.m_index_count / 3;
+
+		acmr += vertex_cache_statistics.acmr * mesh_triangle_count;
+		atvr += vertex_cache_statistics.atvr * mesh_triangle_count;
+		overdraw += overdraw_statistics.overdraw * mesh_triangle_count;
+
+		triangle_count += mesh_triangle_count;
+	}
+
+	if (triangle_count > 0)
+	{
+		result.m_acmr = (float) (acmr / triangle_count);
+		result.m_atvr = (float) (atvr / triangle_count);
+		result.m_overdraw = (float) (overdraw / triangle_count);
+	}
+
+	return result;
+}
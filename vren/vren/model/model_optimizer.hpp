@@ -0,0 +1,37 @@
+#pragma once
+
+#include "model.hpp"
+
+namespace vren
+{
+	/** Reorders the geometry of every mesh of a vren::model (in parallel) to improve the GPU post-transform vertex cache hit rate,
+	 * the overdraw and the vertex fetch locality. It's meant to run on the intermediate model, before it's uploaded
+	 * (vren::basic_model_uploader) or clusterized (vren::model_clusterizer).
+	 */
+	class model_optimizer
+	{
+	public:
+		struct statistics
+		{
+			float m_acmr;     // Average cache miss ratio: transformed vertices / triangle count (1.0 .. 3.0, lower is better)
+			float m_atvr;     // Average transformed vertex ratio: transformed vertices / vertex count (>= 1.0, 1.0 is ideal)
+			float m_overdraw; // Shaded pixels / covered pixels (>= 1.0, 1.0 is ideal)
+		};
+
+		static constexpr uint32_t k_vertex_cache_size = 16;
+		static constexpr float k_overdraw_threshold = 1.05f; // Allowed ACMR degradation in favour of overdraw
+
+		bool m_optimize_vertex_cache = true;
+		bool m_optimize_overdraw = true;
+		bool m_optimize_vertex_fetch = true;
+
+	private:
+		void optimize_mesh(vren::model& model, vren::model::mesh& mesh) const;
+
+	public:
+		void optimize(vren::model& model) const;
+
+		/** Computes the statistics of the given model weighting every mesh by its triangle count. */
+		static vren::model_optimizer::statistics analyze(vren::model const& model);
+	};
+}
@@ -0,0 +1,359 @@
+#include "offscreen_presenter.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <glm/gtc/packing.hpp>
+#include <fmt/format.h>
+#include <stb_image_write.h>
+
+#include "context.hpp"
+#include "toolbox.hpp"
+#include "log.hpp"
+
+namespace
+{
+	bool is_float_format(VkFormat format)
+	{
+		return format == VK_FORMAT_R16G16B16A16_SFLOAT || format == VK_FORMAT_R32G32B32A32_SFLOAT;
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Offscreen presenter
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::offscreen_presenter::offscreen_presenter(
+	vren::context const& context,
+	vren::offscreen_presenter_info const& info,
+	std::function<void(vren::swapchain const& swapchain)> const& swapchain_callback
+) :
+	m_context(&context),
+	m_info(info),
+	m_images(create_images()),
+	m_swapchain(std::make_unique<vren::swapchain>(context, get_image_handles(), info.m_width, info.m_height, info.m_format)),
+	m_texel_size(get_texel_size(info.m_format)),
+	m_readback_buffers(create_readback_buffers())
+{
+	m_writer_thread = std::thread([this]()
+	{
+		run_writer();
+	});
+
+	VREN_INFO("[offscreen_presenter] Offscreen images created: Size {}x{} - Format: {:#x} - Image count: {} - Readback interval: {}\n",
+		m_info.m_width, m_info.m_height, m_info.m_format, m_info.m_image_count, m_info.m_readback_interval);
+
+	if (swapchain_callback)
+	{
+		swapchain_callback(*m_swapchain);
+	}
+}
+
+vren::offscreen_presenter::~offscreen_presenter()
+{
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	m_writer_thread.join();
+}
+
+uint32_t vren::offscreen_presenter::get_texel_size(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		return 4;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return 8;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+		return 16;
+	default:
+		return 0; // Can't be read back
+	}
+}
+
+std::vector<vren::vk_utils::image> vren::offscreen_presenter::create_images()
+{
+	if (m_info.m_image_count == 0)
+	{
+		throw std::runtime_error("The offscreen presenter needs at least one image");
+	}
+
+	std::vector<vren::vk_utils::image> images;
+	for (uint32_t i = 0; i < m_info.m_image_count; i++)
+	{
+		images.push_back(vren::vk_utils::create_image(
+			*m_context,
+			m_info.m_width,
+			m_info.m_height,
+			m_info.m_format,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		));
+	}
+	return images;
+}
+
+std::vector<VkImage> vren::offscreen_presenter::get_image_handles() const
+{
+	std::vector<VkImage> image_handles;
+	for (vren::vk_utils::image const& image : m_images)
+	{
+		image_handles.push_back(image.m_image.m_handle);
+	}
+	return image_handles;
+}
+
+std::vector<vren::vk_utils::buffer> vren::offscreen_presenter::create_readback_buffers()
+{
+	std::vector<vren::vk_utils::buffer> readback_buffers;
+	if (m_info.m_readback_interval == 0)
+	{
+		return readback_buffers;
+	}
+
+	if (m_texel_size == 0)
+	{
+		throw std::runtime_error(fmt::format("Unsupported offscreen readback format: {:#x}", (uint32_t) m_info.m_format));
+	}
+
+	for (uint32_t i = 0; i < VREN_MAX_FRAME_IN_FLIGHT_COUNT; i++)
+	{
+		readback_buffers.push_back(vren::vk_utils::alloc_host_only_buffer(
+			*m_context,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VkDeviceSize(m_info.m_width) * m_info.m_height * m_texel_size,
+			true
+		));
+	}
+	return readback_buffers;
+}
+
+void vren::offscreen_presenter::record_readback(VkCommandBuffer command_buffer, uint32_t frame_idx, uint32_t image_idx)
+{
+	VkImage image = m_swapchain->m_images.at(image_idx);
+	VkBuffer readback_buffer = m_readback_buffers.at(frame_idx).m_buffer.m_handle;
+
+	VkImageMemoryBarrier image_memory_barrier{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+		.oldLayout = m_info.m_final_layout,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .baseMipLevel = 0, .levelCount = 1, .baseArrayLayer = 0, .layerCount = 1, }
+	};
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+
+	VkBufferImageCopy region{
+		.bufferOffset = 0,
+		.bufferRowLength = 0, // Tightly packed
+		.bufferImageHeight = 0,
+		.imageSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1, },
+		.imageOffset = { 0, 0, 0 },
+		.imageExtent = { m_info.m_width, m_info.m_height, 1 },
+	};
+	vkCmdCopyImageToBuffer(command_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback_buffer, 1, &region);
+
+	VkBufferMemoryBarrier buffer_memory_barrier{
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = readback_buffer,
+		.offset = 0,
+		.size = VK_WHOLE_SIZE
+	};
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+}
+
+void vren::offscreen_presenter::read_back(uint32_t frame_idx)
+{
+	pending_readback& pending_readback = m_pending_readbacks.at(frame_idx);
+	if (!pending_readback.m_pending)
+	{
+		return;
+	}
+
+	pending_readback.m_pending = false;
+
+	// The frame's submission has completed: the copy is done
+	vren::vk_utils::buffer& readback_buffer = m_readback_buffers.at(frame_idx);
+	vmaInvalidateAllocation(m_context->m_vma_allocator, readback_buffer.m_allocation.m_handle, 0, VK_WHOLE_SIZE);
+
+	size_t size = size_t(m_info.m_width) * m_info.m_height * m_texel_size;
+	std::span<uint8_t const> pixels(readback_buffer.get_mapped_pointer<uint8_t const>(), size);
+
+	if (m_info.m_readback_callback)
+	{
+		m_info.m_readback_callback(vren::offscreen_readback{
+			.m_frame_number = pending_readback.m_frame_number,
+			.m_width = m_info.m_width,
+			.m_height = m_info.m_height,
+			.m_format = m_info.m_format,
+			.m_pixels = pixels,
+		});
+	}
+
+	if (!m_info.m_readback_dir.empty())
+	{
+		std::string file_name = fmt::format("frame_{:06}.{}", pending_readback.m_frame_number, is_float_format(m_info.m_format) ? "hdr" : "png");
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_image_writes.push_back(image_write{
+				.m_path = m_info.m_readback_dir / file_name,
+				.m_width = m_info.m_width,
+				.m_height = m_info.m_height,
+				.m_format = m_info.m_format,
+				.m_pixels = std::vector<uint8_t>(pixels.begin(), pixels.end()),
+			});
+		}
+		m_condition.notify_one();
+	}
+}
+
+void vren::offscreen_presenter::run_writer()
+{
+	while (true)
+	{
+		image_write image_write;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_image_writes.empty(); });
+
+			if (m_image_writes.empty())
+			{
+				return; // Stopping, the pending writes are done before
+			}
+
+			image_write = std::move(m_image_writes.front());
+			m_image_writes.pop_front();
+		}
+
+		write_image(image_write);
+	}
+}
+
+void vren::offscreen_presenter::write_image(image_write const& image_write)
+{
+	std::error_code error_code;
+	std::filesystem::create_directories(image_write.m_path.parent_path(), error_code);
+
+	uint32_t texel_count = image_write.m_width * image_write.m_height;
+	std::string path = image_write.m_path.string();
+
+	int result;
+	if (image_write.m_format == VK_FORMAT_R16G16B16A16_SFLOAT || image_write.m_format == VK_FORMAT_R32G32B32A32_SFLOAT)
+	{
+		std::vector<float> texels(texel_count * 4);
+		for (uint32_t i = 0; i < texel_count * 4; i++)
+		{
+			if (image_write.m_format == VK_FORMAT_R16G16B16A16_SFLOAT)
+			{
+				texels[i] = glm::unpackHalf1x16(reinterpret_cast<uint16_t const*>(image_write.m_pixels.data())[i]);
+			}
+			else
+			{
+				texels[i] = reinterpret_cast<float const*>(image_write.m_pixels.data())[i];
+			}
+		}
+
+		result = stbi_write_hdr(path.c_str(), (int) image_write.m_width, (int) image_write.m_height, 4, texels.data());
+	}
+	else
+	{
+		std::vector<uint8_t> texels = image_write.m_pixels;
+		if (image_write.m_format == VK_FORMAT_B8G8R8A8_UNORM || image_write.m_format == VK_FORMAT_B8G8R8A8_SRGB)
+		{
+			for (uint32_t i = 0; i < texel_count; i++)
+			{
+				std::swap(texels[i * 4 + 0], texels[i * 4 + 2]);
+			}
+		}
+
+		result = stbi_write_png(path.c_str(), (int) image_write.m_width, (int) image_write.m_height, 4, texels.data(), (int) image_write.m_width * 4);
+	}
+
+	if (result == 0)
+	{
+		VREN_WARN("[offscreen_presenter] Failed to write the frame: {}\n", path);
+	}
+}
+
+void vren::offscreen_presenter::present(vren::presenter::render_func_t const& render_func)
+{
+	auto& frame_data = m_swapchain->m_frame_data.at(m_current_frame_idx);
+
+	m_swapchain->wait_frame(m_current_frame_idx);
+
+	read_back(m_current_frame_idx);
+
+	frame_data.m_resource_container.clear();
+
+	/* Command buffer init */
+	auto cmd_buf = std::make_shared<vren::pooled_vk_command_buffer>(
+		m_context->m_toolbox->m_graphics_command_pool.acquire()
+	);
+	frame_data.m_resource_container.add_resource(cmd_buf);
+
+	VkCommandBufferBeginInfo cmd_buf_begin_info{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.pNext = nullptr,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		.pInheritanceInfo = nullptr,
+	};
+	VREN_CHECK(vkBeginCommandBuffer(cmd_buf->m_handle, &cmd_buf_begin_info), m_context);
+
+	// The images are used in turn, an image is used again once the frame that last used it has completed (there are at least as many
+	// images as frames in flight used)
+	uint32_t img_idx = m_frame_number % m_swapchain->m_images.size();
+
+	// Frame callback
+	render_func(m_current_frame_idx, img_idx, *m_swapchain, cmd_buf->m_handle, frame_data.m_resource_container);
+
+	if (m_info.m_readback_interval > 0 && m_frame_number % m_info.m_readback_interval == 0)
+	{
+		record_readback(cmd_buf->m_handle, m_current_frame_idx, img_idx);
+
+		m_pending_readbacks.at(m_current_frame_idx) = pending_readback{
+			.m_pending = true,
+			.m_frame_number = m_frame_number,
+		};
+	}
+
+	// Submit
+	VREN_CHECK(vkEndCommandBuffer(cmd_buf->m_handle), m_context);
+	m_swapchain->submit(m_current_frame_idx, cmd_buf->m_handle);
+
+	m_current_frame_idx = (m_current_frame_idx + 1) % m_swapchain->get_frame_in_flight_count();
+	m_frame_number++;
+}
+
+void vren::offscreen_presenter::flush()
+{
+	// From the oldest frame in flight, for the readbacks to be done in order
+	uint32_t frame_in_flight_count = m_swapchain->get_frame_in_flight_count();
+	for (uint32_t i = 0; i < frame_in_flight_count; i++)
+	{
+		uint32_t frame_idx = (m_current_frame_idx + i) % frame_in_flight_count;
+
+		m_swapchain->wait_frame(frame_idx);
+
+		read_back(frame_idx);
+	}
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <volk.h>
+
+#include "presenter.hpp"
+#include "vk_helpers/buffer.hpp"
+#include "vk_helpers/image.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// --------------------------------------------------------------------------------------------------------------------------------
+	// Offscreen readback
+	// --------------------------------------------------------------------------------------------------------------------------------
+
+	struct offscreen_readback
+	{
+		uint64_t m_frame_number; // Counts the frames presented since the creation of the presenter
+		uint32_t m_width, m_height;
+		VkFormat m_format;
+		std::span<uint8_t const> m_pixels; // Tightly packed rows, only valid during the callback
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------
+	// Offscreen presenter
+	// --------------------------------------------------------------------------------------------------------------------------------
+
+	struct offscreen_presenter_info
+	{
+		uint32_t m_width;
+		uint32_t m_height;
+		uint32_t m_image_count = 3;
+		VkFormat m_format = VK_FORMAT_B8G8R8A8_UNORM; // The format picked by vren::presenter
+
+		/// The layout the render function leaves the images in: the present layout for the render functions written for a swapchain.
+		VkImageLayout m_final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		/// Reads back one frame every m_readback_interval frames, 0 never reads back.
+		uint32_t m_readback_interval = 0;
+
+		/// The frames read back are written to this directory as frame_<number>.png (8-bit formats) or .hdr (float formats), empty
+		/// not to write them.
+		std::filesystem::path m_readback_dir;
+
+		std::function<void(vren::offscreen_readback const& readback)> m_readback_callback;
+	};
+
+	/** Presents the frames to a set of offscreen images instead of a swapchain, e.g. to render and benchmark whole frames without
+	 * a window. The render function is the one of vren::presenter, it's given a vren::swapchain wrapping the offscreen images (with a
+	 * null handle) and the frame data are ring-buffered the same way.
+	 *
+	 * The frames read back are copied to a host buffer of their frame in flight, at the end of their command buffer: the pixels are
+	 * read once the frame has completed, when the frame in flight is used again (or in flush), so the readback never stalls the
+	 * GPU. The callback is called on the presenting thread, the images are encoded and written by a background thread.
+	 */
+	class offscreen_presenter
+	{
+	private:
+		struct pending_readback
+		{
+			bool m_pending = false;
+			uint64_t m_frame_number;
+		};
+
+		struct image_write
+		{
+			std::filesystem::path m_path;
+			uint32_t m_width, m_height;
+			VkFormat m_format;
+			std::vector<uint8_t> m_pixels;
+		};
+
+		vren::context const* m_context;
+		vren::offscreen_presenter_info m_info;
+
+		std::vector<vren::vk_utils::image> m_images;
+		std::unique_ptr<vren::swapchain> m_swapchain;
+
+		uint32_t m_texel_size = 0;
+		std::vector<vren::vk_utils::buffer> m_readback_buffers; // One per frame in flight, empty if the frames aren't read back
+		std::array<pending_readback, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_pending_readbacks{};
+
+		uint32_t m_current_frame_idx = 0;
+		uint64_t m_frame_number = 0;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<image_write> m_image_writes;
+		bool m_stopping = false;
+		std::thread m_writer_thread;
+
+		static uint32_t get_texel_size(VkFormat format);
+
+		std::vector<vren::vk_utils::image> create_images();
+		std::vector<VkImage> get_image_handles() const;
+		std::vector<vren::vk_utils::buffer> create_readback_buffers();
+
+		void record_readback(VkCommandBuffer command_buffer, uint32_t frame_idx, uint32_t image_idx);
+		void read_back(uint32_t frame_idx);
+
+		void run_writer();
+		void write_image(image_write const& image_write);
+
+	public:
+		/// The swapchain callback is called once with the offscreen images, as vren::presenter does when the swapchain is created.
+		offscreen_presenter(
+			vren::context const& context,
+			vren::offscreen_presenter_info const& info,
+			std::function<void(vren::swapchain const& swapchain)> const& swapchain_callback = nullptr
+		);
+		offscreen_presenter(vren::offscreen_presenter const& other) = delete;
+		offscreen_presenter(vren::offscreen_presenter&& other) = delete;
+
+		~offscreen_presenter();
+
+		inline vren::swapchain* get_swapchain() const
+		{
+			return m_swapchain.get();
+		}
+
+		inline uint64_t get_frame_number() const
+		{
+			return m_frame_number;
+		}
+
+		void present(vren::presenter::render_func_t const& render_func);
+
+		/// Waits for the frames in flight and reads back their pending readbacks. Doesn't wait for the images to be written.
+		void flush();
+	};
+}
@@ -0,0 +1,514 @@
+#include "cascaded_shadow_map.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+#include "context.hpp"
+#include "toolbox.hpp"
+#include "base/base.hpp"
+#include "vk_helpers/misc.hpp"
+#include "vk_helpers/debug_utils.hpp"
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// cascaded_shadow_map
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::cascaded_shadow_map::cascaded_shadow_map(vren::context const& context, uint32_t resolution) :
+	m_context(&context),
+	m_resolution(resolution),
+	m_image(create_image()),
+	m_image_view(create_image_view()),
+	m_cascade_image_views(create_cascade_image_views()),
+	m_sampler(create_sampler()),
+	m_cascade_buffers(create_cascade_buffers())
+{}
+
+vren::vk_utils::image vren::cascaded_shadow_map::create_image()
+{
+	VkImageCreateInfo image_info{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = VREN_SHADOW_MAP_FORMAT,
+		.extent = {
+			.width = m_resolution,
+			.height = m_resolution,
+			.depth = 1,
+		},
+		.mipLevels = 1,
+		.arrayLayers = k_cascade_count,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 0,
+		.pQueueFamilyIndices = nullptr,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	VmaAllocationCreateInfo allocation_info{
+		.usage = VMA_MEMORY_USAGE_GPU_ONLY,
+		.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+	};
+
+	VkImage image;
+	VmaAllocation allocation;
+	VREN_CHECK(vmaCreateImage(m_context->m_vma_allocator, &image_info, &allocation_info, &image, &allocation, nullptr), m_context);
+
+	vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_IMAGE, (uint64_t) image, "cascaded_shadow_map");
+
+	return {
+		.m_image = vren::vk_image(*m_context, image),
+		.m_allocation = vren::vma_allocation(*m_context, allocation)
+	};
+}
+
+vren::vk_image_view vren::cascaded_shadow_map::create_image_view()
+{
+	VkImageViewCreateInfo image_view_info{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.image = m_image.m_image.m_handle,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+		.format = VREN_SHADOW_MAP_FORMAT,
+		.components = {},
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = k_cascade_count
+		}
+	};
+
+	VkImageView image_view;
+	VREN_CHECK(vkCreateImageView(m_context->m_device, &image_view_info, nullptr, &image_view), m_context);
+	return vren::vk_image_view(*m_context, image_view);
+}
+
+std::vector<vren::vk_image_view> vren::cascaded_shadow_map::create_cascade_image_views()
+{
+	std::vector<vren::vk_image_view> image_views;
+
+	for (uint32_t i = 0; i < k_cascade_count; i++)
+	{
+		VkImageViewCreateInfo image_view_info{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = NULL,
+			.image = m_image.m_image.m_handle,
+			.viewType = VK_IMAGE_VIEW_TYPE_2D,
+			.format = VREN_SHADOW_MAP_FORMAT,
+			.components = {},
+			.subresourceRange = {
+				.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = i,
+				.layerCount = 1
+			}
+		};
+
+		VkImageView image_view;
+		VREN_CHECK(vkCreateImageView(m_context->m_device, &image_view_info, nullptr, &image_view), m_context);
+
+		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t) image_view, fmt::format("cascaded_shadow_map cascade={}", i).c_str());
+
+		image_views.emplace_back(*m_context, image_view);
+	}
+
+	return image_views;
+}
+
+vren::vk_sampler vren::cascaded_shadow_map::create_sampler()
+{
+	VkSamplerCreateInfo sampler_info{
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.magFilter = VK_FILTER_LINEAR,
+		.minFilter = VK_FILTER_LINEAR,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+		.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+		.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+		.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER,
+		.compareEnable = VK_TRUE,
+		.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL,
+		.minLod = 0.0f,
+		.maxLod = 0.0f,
+		.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE // Outside of the cascade nothing is in shadow
+	};
+	VkSampler sampler;
+	VREN_CHECK(vkCreateSampler(m_context->m_device, &sampler_info, nullptr, &sampler), m_context);
+	return vren::vk_sampler(*m_context, sampler);
+}
+
+std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> vren::cascaded_shadow_map::create_cascade_buffers()
+{
+	return vren::create_array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index)
+	{
+		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_visible_buffer(
+			*m_context,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			k_cascade_count * sizeof(vren::shadow_cascade),
+			true
+		);
+		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_BUFFER, (uint64_t) buffer.m_buffer.m_handle, fmt::format("shadow_cascade_buffer frame={}", index).c_str());
+		return buffer;
+	});
+}
+
+void vren::cascaded_shadow_map::update_cascades(uint32_t frame_idx, vren::camera const& camera, glm::vec3 const& light_direction)
+{
+	float near = camera.m_near_plane;
+	float far = glm::min(camera.m_far_plane, m_max_distance);
+
+	// Light space basis, the light looks along +z as the camera does
+	glm::vec3 forward = glm::normalize(light_direction);
+	glm::vec3 up = glm::abs(forward.y) > 0.99f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+	glm::vec3 right = glm::normalize(glm::cross(up, forward));
+	up = glm::cross(forward, right);
+
+	glm::mat4 light_view(1.0f);
+	light_view[0][0] = right.x; light_view[1][0] = right.y; light_view[2][0] = right.z;
+	light_view[0][1] = up.x;    light_view[1][1] = up.y;    light_view[2][1] = up.z;
+	light_view[0][2] = forward.x; light_view[1][2] = forward.y; light_view[2][2] = forward.z;
+
+	// Every frustum slice is seen under the same angle: k^2 is the squared tangent of the half diagonal
+	float tan_half_fov_y = glm::tan(camera.m_fov_y / 2.0f);
+	float k2 = tan_half_fov_y * tan_half_fov_y * (1.0f + camera.m_aspect_ratio * camera.m_aspect_ratio);
+
+	float split_near = near;
+	for (uint32_t i = 0; i < k_cascade_count; i++)
+	{
+		// Practical split scheme (Parallel-Split Shadow Maps for Large-scale Virtual Environments. Zhang et al. 2006)
+		float t = (i + 1) / float(k_cascade_count);
+		float log_split = near * glm::pow(far / near, t);
+		float uniform_split = near + (far - near) * t;
+		float split_far = m_split_lambda * log_split + (1.0f - m_split_lambda) * uniform_split;
+
+		// The minimal bounding sphere of the frustum slice, its center lies on the view axis
+		float n = split_near, f = split_far;
+		float center_z, radius;
+		if (k2 >= (f - n) / (f + n))
+		{
+			center_z = f;
+			radius = f * glm::sqrt(k2);
+		}
+		else
+		{
+			center_z = 0.5f * (f + n) * (1.0f + k2);
+			radius = 0.5f * glm::sqrt((f - n) * (f - n) + 2.0f * (f * f + n * n) * k2 + (f + n) * (f + n) * k2 * k2);
+		}
+
+		glm::vec3 center = camera.m_position + camera.get_forward() * center_z;
+
+		// Snap the center to the texels, the cascade moves by whole texels
+		float texel_world_size = 2.0f * radius / float(m_resolution);
+
+		glm::vec3 light_space_center = light_view * glm::vec4(center, 1.0f);
+		light_space_center.x = glm::floor(light_space_center.x / texel_world_size) * texel_world_size;
+		light_space_center.y = glm::floor(light_space_center.y / texel_world_size) * texel_world_size;
+
+		// Orthographic projection of the cascade box, the casters behind it (toward the light) are kept
+		float z_near = light_space_center.z - radius - m_caster_extrusion;
+		float z_far = light_space_center.z + radius;
+
+		glm::mat4 projection(1.0f);
+		projection[0][0] = 1.0f / radius;
+		projection[1][1] = 1.0f / radius;
+		projection[2][2] = 1.0f / (z_far - z_near);
+		projection[3][0] = -light_space_center.x / radius;
+		projection[3][1] = -light_space_center.y / radius;
+		projection[3][2] = -z_near / (z_far - z_near);
+
+		m_cascades[i] = {
+			.m_view_projection = projection * light_view,
+			.m_split_far = split_far,
+			.m_texel_world_size = texel_world_size,
+		};
+
+		split_near = split_far;
+	}
+
+	std::memcpy(m_cascade_buffers.at(frame_idx).get_mapped_pointer(), m_cascades.data(), sizeof(m_cascades));
+}
+
+void vren::cascaded_shadow_map::add_render_graph_node_resources(vren::render_graph_node& node, VkImageLayout image_layout, VkAccessFlags access_flags) const
+{
+	static const std::array<std::string, k_cascade_count> k_cascade_names = vren::create_array<std::string, k_cascade_count>([](uint32_t index)
+	{
+		return fmt::format("cascaded_shadow_map[{}]", index);
+	});
+
+	for (uint32_t cascade_idx = 0; cascade_idx < k_cascade_count; cascade_idx++)
+	{
+		node.add_image({
+			.m_name = k_cascade_names.at(cascade_idx).c_str(),
+			.m_image = m_image.m_image.m_handle,
+			.m_image_aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+			.m_layer = cascade_idx,
+		}, image_layout, access_flags);
+	}
+}
+
+void vren::cascaded_shadow_map::write_descriptor_set(uint32_t frame_idx, VkDescriptorSet descriptor_set) const
+{
+	vren::vk_utils::write_combined_image_sampler_descriptor(*m_context, descriptor_set, 0, m_sampler.m_handle, m_image_view.m_handle, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 1, m_cascade_buffers.at(frame_idx).m_buffer.m_handle, k_cascade_count * sizeof(vren::shadow_cascade), 0);
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// cascaded_shadow_map_renderer
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::cascaded_shadow_map_renderer::cascaded_shadow_map_renderer(vren::context const& context, VkBool32 compressed_geometry) :
+	m_context(&context),
+	m_compressed_geometry(compressed_geometry),
+	m_pipeline(create_graphics_pipeline())
+{}
+
+vren::pipeline vren::cascaded_shadow_map_renderer::create_graphics_pipeline()
+{
+	/* Vertex input state */
+	/* Input assembly state */
+	/* Tessellation state */
+
+	/* Viewport state */
+	VkPipelineViewportStateCreateInfo viewport_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.viewportCount = 1,
+		.pViewports = nullptr,
+		.scissorCount = 1,
+		.pScissors = nullptr
+	};
+
+	/* Rasterization state */
+	VkPipelineRasterizationStateCreateInfo rasterization_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.depthClampEnable = VK_FALSE,
+		.rasterizerDiscardEnable = VK_FALSE,
+		.polygonMode = VK_POLYGON_MODE_FILL,
+		.cullMode = VK_CULL_MODE_NONE,
+		.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+		.depthBiasEnable = VK_TRUE, // Slope-scaled depth bias against shadow acne
+		.depthBiasConstantFactor = 1.25f,
+		.depthBiasClamp = 0.0f,
+		.depthBiasSlopeFactor = 1.75f,
+		.lineWidth = 1.0f
+	};
+
+	/* Multisample state */
+	VkPipelineMultisampleStateCreateInfo multisample_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+		.sampleShadingEnable = VK_FALSE,
+		.minSampleShading = 0.0f,
+		.pSampleMask = nullptr,
+		.alphaToCoverageEnable = VK_FALSE,
+		.alphaToOneEnable = VK_FALSE
+	};
+
+	/* Depth-stencil state */
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		.depthTestEnable = true,
+		.depthWriteEnable = true,
+		.depthCompareOp = VK_COMPARE_OP_LESS
+	};
+
+	/* Color blend state */
+	VkPipelineColorBlendStateCreateInfo color_blend_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.logicOpEnable = VK_FALSE,
+		.logicOp = {},
+		.attachmentCount = 0,
+		.pAttachments = nullptr,
+		.blendConstants = {}
+	};
+
+	/* Dynamic state */
+	VkDynamicState dynamic_states[]{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+	VkPipelineDynamicStateCreateInfo dynamic_state_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.dynamicStateCount = std::size(dynamic_states),
+		.pDynamicStates = dynamic_states
+	};
+
+	// Pipeline rendering (depth-only)
+	VkPipelineRenderingCreateInfoKHR pipeline_rendering_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
+		.pNext = nullptr,
+		.viewMask = 0,
+		.colorAttachmentCount = 0,
+		.pColorAttachmentFormats = nullptr,
+		.depthAttachmentFormat = VREN_SHADOW_MAP_FORMAT,
+		.stencilAttachmentFormat = VK_FORMAT_UNDEFINED
+	};
+
+	//
+	vren::shader_module task_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/draw_shadow.task.spv");
+	vren::shader_module mesh_shader_mod = vren::load_shader_module_from_file(*m_context, m_compressed_geometry ? ".vren/resources/shaders/draw_compressed_shadow.mesh.spv" : ".vren/resources/shaders/draw_shadow.mesh.spv");
+
+	vren::specialized_shader shaders[] = {
+		vren::specialized_shader(task_shader_mod, "main"),
+		vren::specialized_shader(mesh_shader_mod, "main")
+	};
+	return vren::create_graphics_pipeline(
+		*m_context,
+		shaders,
+		nullptr,
+		nullptr,
+		nullptr,
+		&viewport_info,
+		&rasterization_info,
+		&multisample_info,
+		&depth_stencil_info,
+		&color_blend_info,
+		&dynamic_state_info,
+		&pipeline_rendering_info,
+		VK_NULL_HANDLE,
+		0
+	);
+}
+
+template<typename _draw_buffer_t>
+vren::render_graph_t vren::cascaded_shadow_map_renderer::render_cascade_draw_buffer(
+	vren::render_graph_allocator& render_graph_allocator,
+	vren::cascaded_shadow_map const& shadow_map,
+	uint32_t cascade_idx,
+	_draw_buffer_t const& draw_buffer
+)
+{
+	static const std::array<std::string, vren::cascaded_shadow_map::k_cascade_count> k_node_names =
+		vren::create_array<std::string, vren::cascaded_shadow_map::k_cascade_count>([](uint32_t index)
+		{
+			return fmt::format("cascaded_shadow_map | cascade {}", index);
+		});
+
+	vren::render_graph_node* node = render_graph_allocator.allocate();
+
+	node->set_name(k_node_names.at(cascade_idx).c_str());
+
+	node->set_src_stage(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	node->set_dst_stage(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+	node->set_parallel_recording(true); // The cascades only share the read-only draw buffer
+
+	node->add_image({
+		.m_name = "cascaded_shadow_map",
+		.m_image = shadow_map.get_image(),
+		.m_image_aspect = VK_IMAGE_ASPECT_DEPTH_BIT,
+		.m_layer = cascade_idx,
+	}, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+	node->set_callback([=, this, &shadow_map, &draw_buffer](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		uint32_t resolution = shadow_map.get_resolution();
+
+		VkRect2D render_area = {
+			.offset = {0, 0},
+			.extent = {resolution, resolution}
+		};
+
+		VkRenderingAttachmentInfoKHR depth_attachment{
+			.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR,
+			.pNext = nullptr,
+			.imageView = shadow_map.get_cascade_image_view(cascade_idx),
+			.imageLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+			.resolveMode = VK_RESOLVE_MODE_NONE,
+			.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+			.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+			.clearValue = { .depthStencil = { .depth = 1.0f } }
+		};
+
+		VkRenderingInfoKHR rendering_info{
+			.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR,
+			.pNext = nullptr,
+			.flags = NULL,
+			.renderArea = render_area,
+			.layerCount = 1,
+			.viewMask = 0,
+			.colorAttachmentCount = 0,
+			.pColorAttachments = nullptr,
+			.pDepthAttachment = &depth_attachment,
+			.pStencilAttachment = nullptr
+		};
+		vkCmdBeginRendering(command_buffer, &rendering_info);
+
+		// Same viewport convention as the mesh_shader_renderer, the shading samples the cascades with uv.y = 0.5 - 0.5 * ndc.y
+		VkViewport viewport{
+			.x = 0,
+			.y = (float) resolution,
+			.width = (float) resolution,
+			.height = -((float) resolution),
+			.minDepth = 0.0f,
+			.maxDepth = 1.0f
+		};
+		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+		vkCmdSetScissor(command_buffer, 0, 1, &render_area);
+
+		m_pipeline.bind(command_buffer);
+
+		glm::mat4 const& view_projection = shadow_map.get_cascade(cascade_idx).m_view_projection;
+		m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_TASK_BIT_NV | VK_SHADER_STAGE_MESH_BIT_NV, &view_projection, sizeof(view_projection));
+
+		// Bind draw buffer (the compressed layout has no meshlet vertex buffer at binding 1)
+		m_pipeline.acquire_and_bind_descriptor_set(*m_context, command_buffer, resource_container, 2, [&](VkDescriptorSet descriptor_set)
+		{
+			vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 0, draw_buffer.m_vertex_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+			if constexpr (std::is_same_v<_draw_buffer_t, vren::clusterized_model_draw_buffer>)
+			{
+				vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 1, draw_buffer.m_meshlet_vertex_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+			}
+			vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 2, draw_buffer.m_meshlet_triangle_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+			vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 3, draw_buffer.m_meshlet_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+			vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 4, draw_buffer.m_instanced_meshlet_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+			vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 5, draw_buffer.m_instance_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+		});
+
+		// The task shader culls the meshlets against the cascade box
+		uint32_t workgroups_num = (uint32_t) glm::ceil(draw_buffer.m_instanced_meshlet_count / (float) 32);
+		vkCmdDrawMeshTasksNV(command_buffer, workgroups_num, 0);
+
+		vkCmdEndRendering(command_buffer);
+	});
+	return vren::render_graph_gather(node);
+}
+
+vren::render_graph_t vren::cascaded_shadow_map_renderer::render_cascade(
+	vren::render_graph_allocator& render_graph_allocator,
+	vren::cascaded_shadow_map const& shadow_map,
+	uint32_t cascade_idx,
+	vren::clusterized_model_draw_buffer const& draw_buffer
+)
+{
+	assert(!m_compressed_geometry);
+	return render_cascade_draw_buffer(render_graph_allocator, shadow_map, cascade_idx, draw_buffer);
+}
+
+vren::render_graph_t vren::cascaded_shadow_map_renderer::render_cascade(
+	vren::render_graph_allocator& render_graph_allocator,
+	vren::cascaded_shadow_map const& shadow_map,
+	uint32_t cascade_idx,
+	vren::compressed_clusterized_model_draw_buffer const& draw_buffer
+)
+{
+	assert(m_compressed_geometry);
+	return render_cascade_draw_buffer(render_graph_allocator, shadow_map, cascade_idx, draw_buffer);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "config.hpp"
+#include "gpu_repr.hpp"
+#include "camera.hpp"
+#include "pipeline/render_graph.hpp"
+#include "vk_helpers/shader.hpp"
+#include "vk_helpers/image.hpp"
+#include "vk_helpers/buffer.hpp"
+#include "model/clusterized_model_draw_buffer.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// ------------------------------------------------------------------------------------------------
+	// cascaded_shadow_map
+	// ------------------------------------------------------------------------------------------------
+
+	/** The shadow map of a directional light: a depth image with a layer per cascade, every cascade covers a slice of the
+	 * camera frustum (split along the view depth) with an orthographic projection along the light direction.
+	 */
+	class cascaded_shadow_map
+	{
+	public:
+		static constexpr uint32_t k_cascade_count = VREN_SHADOW_CASCADE_COUNT;
+
+	private:
+		vren::context const* m_context;
+
+		uint32_t m_resolution;
+		vren::vk_utils::image m_image;
+		vren::vk_image_view m_image_view; // Image view covering all cascades (2D array), used for sampling
+		std::vector<vren::vk_image_view> m_cascade_image_views; // Image views per-cascade, used as depth attachment
+		vren::vk_sampler m_sampler; // Comparison sampler: a texture lookup returns the filtered depth test result
+
+		std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_cascade_buffers;
+
+		std::array<vren::shadow_cascade, k_cascade_count> m_cascades{};
+
+	public:
+		/// The blend between the logarithmic (1) and the uniform (0) split scheme.
+		float m_split_lambda = 0.75f;
+
+		/// The shadows are only cast within this distance from the camera (clamped to the camera far plane).
+		float m_max_distance = 100.0f;
+
+		/// How far behind the cascade bounds the shadow casters are still rendered, along the light direction.
+		float m_caster_extrusion = 50.0f;
+
+		explicit cascaded_shadow_map(vren::context const& context, uint32_t resolution = VREN_SHADOW_MAP_RESOLUTION);
+
+	private:
+		vren::vk_utils::image create_image();
+		vren::vk_image_view create_image_view();
+		std::vector<vren::vk_image_view> create_cascade_image_views();
+		vren::vk_sampler create_sampler();
+		std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> create_cascade_buffers();
+
+	public:
+		inline uint32_t get_resolution() const
+		{
+			return m_resolution;
+		}
+
+		inline VkImage get_image() const
+		{
+			return m_image.m_image.m_handle;
+		}
+
+		inline VkImageView get_image_view() const
+		{
+			return m_image_view.m_handle;
+		}
+
+		inline VkImageView get_cascade_image_view(uint32_t cascade_idx) const
+		{
+			return m_cascade_image_views.at(cascade_idx).m_handle;
+		}
+
+		inline VkSampler get_sampler() const
+		{
+			return m_sampler.m_handle;
+		}
+
+		inline vren::shadow_cascade const& get_cascade(uint32_t cascade_idx) const
+		{
+			return m_cascades.at(cascade_idx);
+		}
+
+		/** Fits the cascades to the camera frustum. Every cascade bounds its frustum slice with a sphere, so that its size
+		 * doesn't change as the camera rotates, and its origin is snapped to the shadow map texels, so that the shadow
+		 * edges don't shimmer as the camera moves. The cascades are uploaded to the buffer of the given frame.
+		 * @param light_direction The direction the light travels along (as directional_light::m_direction).
+		 */
+		void update_cascades(uint32_t frame_idx, vren::camera const& camera, glm::vec3 const& light_direction);
+
+		void add_render_graph_node_resources(vren::render_graph_node& node, VkImageLayout image_layout, VkAccessFlags access_flags) const;
+
+		/// Writes binding 0 (shadow map) and binding 1 (cascades of the given frame).
+		void write_descriptor_set(uint32_t frame_idx, VkDescriptorSet descriptor_set) const;
+	};
+
+	// ------------------------------------------------------------------------------------------------
+	// cascaded_shadow_map_renderer
+	// ------------------------------------------------------------------------------------------------
+
+	/** Renders the shadow casters into the cascades through the mesh shader path: the task shader culls every meshlet
+	 * against the box of the cascade being rendered.
+	 */
+	class cascaded_shadow_map_renderer
+	{
+	private:
+		vren::context const* m_context;
+		VkBool32 m_compressed_geometry;
+		vren::pipeline m_pipeline;
+
+	public:
+		explicit cascaded_shadow_map_renderer(vren::context const& context, VkBool32 compressed_geometry = VK_FALSE);
+
+		inline bool is_compressed_geometry() const
+		{
+			return m_compressed_geometry;
+		}
+
+	private:
+		vren::pipeline create_graphics_pipeline();
+
+		template<typename _draw_buffer_t>
+		vren::render_graph_t render_cascade_draw_buffer(
+			vren::render_graph_allocator& render_graph_allocator,
+			vren::cascaded_shadow_map const& shadow_map,
+			uint32_t cascade_idx,
+			_draw_buffer_t const& draw_buffer
+		);
+
+	public:
+		vren::render_graph_t render_cascade(
+			vren::render_graph_allocator& render_graph_allocator,
+			vren::cascaded_shadow_map const& shadow_map,
+			uint32_t cascade_idx,
+			vren::clusterized_model_draw_buffer const& draw_buffer
+		);
+
+		vren::render_graph_t render_cascade(
+			vren::render_graph_allocator& render_graph_allocator,
+			vren::cascaded_shadow_map const& shadow_map,
+			uint32_t cascade_idx,
+			vren::compressed_clusterized_model_draw_buffer const& draw_buffer
+		);
+	};
+}
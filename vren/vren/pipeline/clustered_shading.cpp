@@ -1,28 +1,31 @@
 #include "clustered_shading.hpp"
 
+#include <bit>
+
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
 
+vren::pipeline_futures<4> vren::clustered_shading::construct_point_light_bvh::create_pipelines(vren::context const& context)
+{
+    return {
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/point_light_position_to_view_space.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/discretize_point_light_positions.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/init_light_array_bvh.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/spot_light_to_view_space.comp.spv")
+    };
+}
+
 vren::clustered_shading::construct_point_light_bvh::construct_point_light_bvh(vren::context const& context) :
+    construct_point_light_bvh(context, create_pipelines(context))
+{
+}
+
+vren::clustered_shading::construct_point_light_bvh::construct_point_light_bvh(vren::context const& context, vren::pipeline_futures<4> pipelines) :
     m_context(&context),
-    m_point_light_position_to_view_space_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/point_light_position_to_view_space.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_discretize_point_light_positions_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/discretize_point_light_positions.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_init_light_array_bvh_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/init_light_array_bvh.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_point_light_position_to_view_space_pipeline(pipelines[0].get()),
+    m_discretize_point_light_positions_pipeline(pipelines[1].get()),
+    m_init_light_array_bvh_pipeline(pipelines[2].get()),
+    m_spot_light_to_view_space_pipeline(pipelines[3].get())
 {
 }
 
@@ -57,38 +60,18 @@ size_t vren::clustered_shading::construct_point_light_bvh::get_required_point_li
     );
 }
 
-void vren::clustered_shading::construct_point_light_bvh::operator()(
+void vren::clustered_shading::construct_point_light_bvh::transform_point_lights_to_view_space(
     VkCommandBuffer command_buffer,
     vren::resource_container& resource_container,
     vren::light_array const& light_array,
     vren::vk_utils::buffer const& view_space_point_light_position_buffer,
     vren::camera const& camera,
-    vren::vk_utils::buffer const& bvh_buffer,
-    vren::vk_utils::buffer const& point_light_index_buffer
+    float attenuation_threshold
 )
 {
     uint32_t point_light_count = light_array.m_point_light_count;
 
-    assert(bvh_buffer.m_allocation_info.size >= get_required_bvh_buffer_size(point_light_count));
-    assert(point_light_index_buffer.m_allocation_info.size >= get_required_point_light_index_buffer_size(point_light_count));
-
-    uint32_t light_count_power_of_2 = vren::round_to_next_power_of_2(point_light_count); // For reduction operations
-    uint32_t light_count_for_bvh = vren::calc_bvh_padded_leaf_count(point_light_count); // For BVH construction
-
-    size_t bvh_size = vren::calc_bvh_buffer_size(point_light_count);
-
-    VkBufferMemoryBarrier buffer_memory_barrier{};
-    uint32_t num_workgroups{};
-    std::shared_ptr<vren::pooled_vk_descriptor_set> descriptor_set{};
-    std::array<VkBufferCopy, 3> buffer_copies{};
-
     vren::vk_utils::buffer const& point_light_buffer = light_array.m_point_light_buffer;
-    vren::vk_utils::buffer const& scratch_buffer_1 = bvh_buffer;
-    vren::vk_utils::buffer const& scratch_buffer_2 = point_light_index_buffer;
-
-    // ------------------------------------------------------------------------------------------------
-    // 1. Convert the world-space point light positions to view-space
-    // ------------------------------------------------------------------------------------------------
 
     // Bind pipeline
     m_point_light_position_to_view_space_pipeline.bind(command_buffer);
@@ -97,22 +80,26 @@ void vren::clustered_shading::construct_point_light_bvh::operator()(
     {
         struct {
             glm::mat4 m_camera_view;
+            float m_attenuation_threshold;
+            float _pad[3];
         } push_constants;
 
         push_constants = {
             .m_camera_view = camera.get_view(),
+            .m_attenuation_threshold = attenuation_threshold,
         };
 
         m_point_light_position_to_view_space_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
     }
 
     // Descriptor set 0
-    descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
+    auto descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
         m_context->m_toolbox->m_descriptor_pool.acquire(m_point_light_position_to_view_space_pipeline.m_descriptor_set_layouts.at(0))
     );
 
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, light_array.m_point_light_position_buffer.m_buffer.m_handle, point_light_count * sizeof(glm::vec4), 0);
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 1, view_space_point_light_position_buffer.m_buffer.m_handle, point_light_count * sizeof(glm::vec4), 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, point_light_buffer.m_buffer.m_handle, point_light_count * sizeof(vren::point_light), 0);
 
     m_point_light_position_to_view_space_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
 
@@ -121,18 +108,149 @@ void vren::clustered_shading::construct_point_light_bvh::operator()(
 
     resource_container.add_resource(descriptor_set);
 
-    buffer_memory_barrier = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-        .pNext = nullptr,
-        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
-        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .buffer = view_space_point_light_position_buffer.m_buffer.m_handle,
-        .offset = 0,
-        .size = point_light_count * sizeof(glm::vec4)
+    std::array<VkBufferMemoryBarrier, 2> buffer_memory_barriers = {
+        VkBufferMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = view_space_point_light_position_buffer.m_buffer.m_handle,
+            .offset = 0,
+            .size = point_light_count * sizeof(glm::vec4)
+        },
+        VkBufferMemoryBarrier{ // The point light radii are read while shading
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = point_light_buffer.m_buffer.m_handle,
+            .offset = 0,
+            .size = point_light_count * sizeof(vren::point_light)
+        }
     };
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, buffer_memory_barriers.size(), buffer_memory_barriers.data(), 0, nullptr);
+}
+
+size_t vren::clustered_shading::construct_point_light_bvh::get_required_view_space_spot_light_buffer_size(uint32_t spot_light_count)
+{
+    return spot_light_count * 2 * sizeof(glm::vec4); // ViewSpaceSpotLight
+}
+
+void vren::clustered_shading::construct_point_light_bvh::transform_spot_lights_to_view_space(
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    vren::light_array const& light_array,
+    vren::vk_utils::buffer const& view_space_spot_light_buffer,
+    vren::camera const& camera,
+    float attenuation_threshold
+)
+{
+    uint32_t spot_light_count = light_array.m_spot_light_count;
+
+    assert(view_space_spot_light_buffer.m_allocation_info.size >= get_required_view_space_spot_light_buffer_size(spot_light_count));
+
+    vren::vk_utils::buffer const& spot_light_buffer = light_array.m_spot_light_buffer;
+
+    // Bind pipeline
+    m_spot_light_to_view_space_pipeline.bind(command_buffer);
+
+    // Push constants
+    {
+        struct {
+            glm::mat4 m_camera_view;
+            float m_attenuation_threshold;
+            float _pad[3];
+        } push_constants;
+
+        push_constants = {
+            .m_camera_view = camera.get_view(),
+            .m_attenuation_threshold = attenuation_threshold,
+        };
+
+        m_spot_light_to_view_space_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+    }
+
+    // Descriptor set 0
+    auto descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
+        m_context->m_toolbox->m_descriptor_pool.acquire(m_spot_light_to_view_space_pipeline.m_descriptor_set_layouts.at(0))
+    );
+
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, light_array.m_spot_light_position_buffer.m_buffer.m_handle, spot_light_count * sizeof(glm::vec4), 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 1, view_space_spot_light_buffer.m_buffer.m_handle, get_required_view_space_spot_light_buffer_size(spot_light_count), 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, spot_light_buffer.m_buffer.m_handle, spot_light_count * sizeof(vren::spot_light), 0);
+
+    m_spot_light_to_view_space_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
+
+    // Dispatch
+    m_spot_light_to_view_space_pipeline.dispatch(command_buffer, vren::divide_and_ceil(spot_light_count, 1024), 1, 1);
+
+    resource_container.add_resource(descriptor_set);
+
+    std::array<VkBufferMemoryBarrier, 2> buffer_memory_barriers = {
+        VkBufferMemoryBarrier{
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = view_space_spot_light_buffer.m_buffer.m_handle,
+            .offset = 0,
+            .size = get_required_view_space_spot_light_buffer_size(spot_light_count)
+        },
+        VkBufferMemoryBarrier{ // The spot light radii are read while shading
+            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+            .pNext = nullptr,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer = spot_light_buffer.m_buffer.m_handle,
+            .offset = 0,
+            .size = spot_light_count * sizeof(vren::spot_light)
+        }
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, buffer_memory_barriers.size(), buffer_memory_barriers.data(), 0, nullptr);
+}
+
+void vren::clustered_shading::construct_point_light_bvh::operator()(
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    vren::light_array const& light_array,
+    vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+    vren::camera const& camera,
+    float attenuation_threshold,
+    vren::vk_utils::buffer const& bvh_buffer,
+    vren::vk_utils::buffer const& point_light_index_buffer
+)
+{
+    uint32_t point_light_count = light_array.m_point_light_count;
+
+    assert(bvh_buffer.m_allocation_info.size >= get_required_bvh_buffer_size(point_light_count));
+    assert(point_light_index_buffer.m_allocation_info.size >= get_required_point_light_index_buffer_size(point_light_count));
+
+    uint32_t light_count_power_of_2 = vren::round_to_next_power_of_2(point_light_count); // For reduction operations
+    uint32_t light_count_for_bvh = vren::calc_bvh_padded_leaf_count(point_light_count); // For BVH construction
+
+    size_t bvh_size = vren::calc_bvh_buffer_size(point_light_count);
+
+    VkBufferMemoryBarrier buffer_memory_barrier{};
+    uint32_t num_workgroups{};
+    std::shared_ptr<vren::pooled_vk_descriptor_set> descriptor_set{};
+    std::array<VkBufferCopy, 3> buffer_copies{};
+
+    vren::vk_utils::buffer const& scratch_buffer_1 = bvh_buffer;
+    vren::vk_utils::buffer const& scratch_buffer_2 = point_light_index_buffer;
+
+    // ------------------------------------------------------------------------------------------------
+    // 1. Convert the world-space point light positions to view-space
+    // ------------------------------------------------------------------------------------------------
+
+    transform_point_lights_to_view_space(command_buffer, resource_container, light_array, view_space_point_light_position_buffer, camera, attenuation_threshold);
 
     // ------------------------------------------------------------------------------------------------
     // 2. Reduce the light positions to find max
@@ -308,7 +426,6 @@ void vren::clustered_shading::construct_point_light_bvh::operator()(
         m_context->m_toolbox->m_descriptor_pool.acquire(m_init_light_array_bvh_pipeline.m_descriptor_set_layouts.at(0))
         );
 
-    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, point_light_buffer.m_buffer.m_handle, point_light_count * sizeof(vren::point_light), 0);
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 1, view_space_point_light_position_buffer.m_buffer.m_handle, point_light_count * sizeof(glm::vec4), 0);
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, scratch_buffer_2.m_buffer.m_handle, point_light_count * sizeof(glm::uvec2), 0);
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 3, scratch_buffer_1.m_buffer.m_handle, light_count_for_bvh * sizeof(vren::bvh_node), 0);
@@ -345,18 +462,142 @@ void vren::clustered_shading::construct_point_light_bvh::operator()(
     );
 }
 
+// --------------------------------------------------------------------------------------------------------------------------------
+// Cluster grid
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::clustered_shading::cluster_key_layout vren::clustered_shading::make_cluster_key_layout(
+    vren::clustered_shading::cluster_grid const& cluster_grid,
+    glm::uvec2 const& max_screen
+)
+{
+    // The tile is a workgroup, the tile pixels are sorted by a bitonic sort
+    if (cluster_grid.m_tile_size < 8 || cluster_grid.m_tile_size > 32 || !vren::is_power_of_2(cluster_grid.m_tile_size))
+    {
+        throw std::runtime_error("Invalid cluster tile size, must be 8, 16 or 32");
+    }
+
+    if (cluster_grid.m_depth_slice_count == 0 || cluster_grid.m_depth_slice_count > (1 << 16))
+    {
+        throw std::runtime_error("Invalid cluster depth slice count, must be between 1 and 65536");
+    }
+
+    // At least a cone per cube face, and a spare index for the pixels without normal
+    if (cluster_grid.m_normal_bits != 0 && (cluster_grid.m_normal_bits < 3 || cluster_grid.m_normal_bits > 12))
+    {
+        throw std::runtime_error("Invalid cluster normal bits, must be 0 or between 3 and 12");
+    }
+
+    if (max_screen.x == 0 || max_screen.y == 0)
+    {
+        throw std::runtime_error("Invalid max screen");
+    }
+
+    auto calc_bit_count = [](uint32_t value_count)
+    {
+        return value_count > 1 ? (uint32_t) std::bit_width(value_count - 1) : 0;
+    };
+
+    vren::clustered_shading::cluster_key_layout cluster_key_layout{
+        .m_max_screen = max_screen,
+        .m_tile_size = cluster_grid.m_tile_size,
+        .m_depth_slice_count = cluster_grid.m_depth_slice_count,
+        .m_normal_grid_size = 0,
+        .m_x_bits = calc_bit_count(vren::divide_and_ceil(max_screen.x, cluster_grid.m_tile_size)),
+        .m_y_bits = calc_bit_count(vren::divide_and_ceil(max_screen.y, cluster_grid.m_tile_size)),
+        .m_z_bits = calc_bit_count(cluster_grid.m_depth_slice_count),
+        .m_normal_bits = cluster_grid.m_normal_bits,
+    };
+
+    // The largest grid whose 6 faces fit the normal field without its all-ones value (see VREN_CLUSTER_NULL_NORMAL_IDX)
+    if (cluster_grid.m_normal_bits > 0)
+    {
+        uint32_t normal_idx_count = (1 << cluster_grid.m_normal_bits) - 1;
+        while (6 * (cluster_key_layout.m_normal_grid_size + 1) * (cluster_key_layout.m_normal_grid_size + 1) <= normal_idx_count)
+        {
+            cluster_key_layout.m_normal_grid_size++;
+        }
+    }
+
+    // The tile coordinates are 16-bit at most (so are the workgroup counts of the dispatch)
+    if (cluster_key_layout.m_x_bits > 16 || cluster_key_layout.m_y_bits > 16)
+    {
+        throw std::runtime_error("The max screen has too many cluster tiles");
+    }
+
+    return cluster_key_layout;
+}
+
+void vren::clustered_shading::specialize_cluster_key_layout(
+    vren::specialized_shader& shader,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+)
+{
+    std::pair<char const*, uint32_t> specialization_constants[]{
+        {"k_cluster_key_x_bits", cluster_key_layout.m_x_bits},
+        {"k_cluster_key_y_bits", cluster_key_layout.m_y_bits},
+        {"k_cluster_key_z_bits", cluster_key_layout.m_z_bits},
+        {"k_cluster_key_normal_bits", cluster_key_layout.m_normal_bits},
+        {"k_cluster_depth_slice_count", cluster_key_layout.m_depth_slice_count},
+        {"k_cluster_normal_grid_size", cluster_key_layout.m_normal_grid_size},
+    };
+
+    // The compiler strips the unused constants
+    for (auto const& [constant_name, value] : specialization_constants)
+    {
+        if (shader.get_shader_module().has_specialization_constant(constant_name))
+        {
+            shader.set_specialization_data(constant_name, &value, sizeof(uint32_t));
+        }
+    }
+}
+
 // --------------------------------------------------------------------------------------------------------------------------------
 // find_unique_cluster_list
 // --------------------------------------------------------------------------------------------------------------------------------
 
-vren::clustered_shading::find_unique_cluster_list::find_unique_cluster_list(vren::context const& context) :
-    m_context(&context),
-    m_pipeline([&]()
+vren::pipeline_futures<2> vren::clustered_shading::find_unique_cluster_list::create_pipelines(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+)
+{
+    auto specialize = [cluster_key_layout](vren::specialized_shader& shader)
     {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/find_unique_clusters.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+        // The workgroup is a tile (local_size_x_id = 0, local_size_y_id = 1)
+        shader.set_specialization_data(0, &cluster_key_layout.m_tile_size, sizeof(uint32_t));
+        shader.set_specialization_data(1, &cluster_key_layout.m_tile_size, sizeof(uint32_t));
+        vren::clustered_shading::specialize_cluster_key_layout(shader, cluster_key_layout);
+    };
+
+    return {
+        vren::create_compute_pipeline_async(
+            context,
+            cluster_key_layout.is_64_bit()
+                ? ".vren/resources/shaders/clustered_shading/find_unique_clusters_64_bit_keys.comp.spv"
+                : ".vren/resources/shaders/clustered_shading/find_unique_clusters.comp.spv",
+            specialize
+        ),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/find_unique_clusters_temporal.comp.spv", specialize)
+    };
+}
+
+vren::clustered_shading::find_unique_cluster_list::find_unique_cluster_list(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+) :
+    find_unique_cluster_list(context, cluster_key_layout, create_pipelines(context, cluster_key_layout))
+{
+}
+
+vren::clustered_shading::find_unique_cluster_list::find_unique_cluster_list(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout,
+    vren::pipeline_futures<2> pipelines
+) :
+    m_context(&context),
+    m_cluster_key_layout(cluster_key_layout),
+    m_pipeline(pipelines[0].get()),
+    m_temporal_pipeline(pipelines[1].get())
 {
 }
 
@@ -370,13 +611,22 @@ void vren::clustered_shading::find_unique_cluster_list::operator()(
     vren::vk_utils::depth_buffer_t const& depth_buffer,
     vren::vk_utils::buffer const& cluster_key_buffer,
     vren::vk_utils::buffer const& cluster_key_dispatch_params_buffer,
-    vren::vk_utils::combined_image_view const& cluster_reference_buffer
+    vren::vk_utils::combined_image_view const& cluster_reference_buffer,
+    vren::clustered_shading::temporal_cluster_params const* temporal_params
 )
 {
     assert(gbuffer.m_width == screen.x);
     assert(gbuffer.m_height == screen.y);
+    assert(!temporal_params || !m_cluster_key_layout.is_64_bit());
 
-    m_pipeline.bind(command_buffer);
+    if (screen.x > m_cluster_key_layout.m_max_screen.x || screen.y > m_cluster_key_layout.m_max_screen.y)
+    {
+        throw std::runtime_error("The screen exceeds the max screen of the cluster key layout");
+    }
+
+    vren::pipeline const& pipeline = temporal_params ? m_temporal_pipeline : m_pipeline;
+
+    pipeline.bind(command_buffer);
 
     struct {
         uint32_t m_x;
@@ -409,37 +659,45 @@ void vren::clustered_shading::find_unique_cluster_list::operator()(
     struct
     {
         float m_camera_near;
-        float m_camera_half_fov_y;
-        float _pad[2];
+        float m_camera_far;
+        uint32_t m_frame_stamp;
+        float _pad;
         glm::mat4 m_camera_projection;
     } push_constants;
 
     push_constants = {
         .m_camera_near = camera.m_near_plane,
-        .m_camera_half_fov_y = camera.m_fov_y / 2.0f,
+        .m_camera_far = camera.m_far_plane,
+        .m_frame_stamp = temporal_params ? temporal_params->m_frame_stamp : 0,
         .m_camera_projection = camera.get_projection(),
     };
-    m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+    pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
 
     auto descriptor_set_0 = std::make_shared<vren::pooled_vk_descriptor_set>(
-        m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(0))
+        m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(0))
     );
     gbuffer.write_descriptor_set(descriptor_set_0->m_handle.m_descriptor_set, depth_buffer);
 
-    m_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set_0->m_handle.m_descriptor_set);
+    pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set_0->m_handle.m_descriptor_set);
 
     auto descriptor_set_1 = std::make_shared<vren::pooled_vk_descriptor_set>(
-        m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(1))
+        m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(1))
     );
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 0, cluster_key_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
     vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 1, cluster_key_dispatch_params_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
     vren::vk_utils::write_storage_image_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 2, cluster_reference_buffer.m_image_view.m_handle, VK_IMAGE_LAYOUT_GENERAL);
 
-    m_pipeline.bind_descriptor_set(command_buffer, 1, descriptor_set_1->m_handle.m_descriptor_set);
+    if (temporal_params)
+    {
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 3, temporal_params->m_cluster_hash_table_buffer->m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 4, temporal_params->m_tile_signature_buffer->m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 5, temporal_params->m_statistics_buffer->m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    }
 
-    uint32_t num_workgroups_x = vren::divide_and_ceil(screen.x, 32);
-    uint32_t num_workgroups_y = vren::divide_and_ceil(screen.y, 32);
-    m_pipeline.dispatch(command_buffer, num_workgroups_x, num_workgroups_y, 1);
+    pipeline.bind_descriptor_set(command_buffer, 1, descriptor_set_1->m_handle.m_descriptor_set);
+
+    glm::uvec2 num_workgroups = m_cluster_key_layout.get_tile_count(screen);
+    pipeline.dispatch(command_buffer, num_workgroups.x, num_workgroups.y, 1);
 
     resource_container.add_resources(
         descriptor_set_0,
@@ -451,22 +709,49 @@ void vren::clustered_shading::find_unique_cluster_list::operator()(
 // assign_lights
 // --------------------------------------------------------------------------------------------------------------------------------
 
+vren::pipeline_futures<2> vren::clustered_shading::assign_lights::create_pipelines(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+)
+{
+    auto specialize = [cluster_key_layout](vren::specialized_shader& shader)
+    {
+        vren::clustered_shading::specialize_cluster_key_layout(shader, cluster_key_layout);
+
+        // The BVH traversal stack and the staged lights are shared by the workgroup and written at subgroup ballot offsets: the
+        // workgroup of 32 invocations must be a single subgroup
+        shader.set_required_subgroup_size(32);
+    };
+
+    return {
+        vren::create_compute_pipeline_async(
+            context,
+            cluster_key_layout.is_64_bit()
+                ? ".vren/resources/shaders/clustered_shading/assign_lights_64_bit_keys.comp.spv"
+                : ".vren/resources/shaders/clustered_shading/assign_lights.comp.spv",
+            specialize
+        ),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/assign_lights_temporal.comp.spv", specialize)
+    };
+}
+
 vren::clustered_shading::assign_lights::assign_lights(
-    vren::context const& context
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+) :
+    assign_lights(context, cluster_key_layout, create_pipelines(context, cluster_key_layout))
+{
+}
+
+vren::clustered_shading::assign_lights::assign_lights(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout,
+    vren::pipeline_futures<2> pipelines
 ) :
     m_context(&context),
-    m_count_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/assign_lights_count.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_write_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/assign_lights_write.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_cluster_key_layout(cluster_key_layout),
+    m_pipeline(pipelines[0].get()),
+    m_temporal_pipeline(pipelines[1].get())
 {
 }
 
@@ -485,16 +770,32 @@ void vren::clustered_shading::assign_lights::operator()(
     vren::vk_utils::buffer const& assigned_light_indices_buffer,
     vren::vk_utils::buffer const& assigned_light_counts_buffer,
     vren::vk_utils::buffer const& assigned_light_offsets_buffer,
-    vren::vk_utils::buffer const& view_space_point_light_position_buffer
+    vren::vk_utils::buffer const& assigned_light_allocator_buffer,
+    vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+    uint32_t spot_light_count,
+    vren::vk_utils::buffer const& view_space_spot_light_buffer,
+    vren::vk_utils::buffer const& cluster_statistics_buffer,
+    vren::clustered_shading::temporal_cluster_params const* temporal_params
 )
 {
+    assert(!temporal_params || !m_cluster_key_layout.is_64_bit());
+
     VkBufferMemoryBarrier buffer_memory_barrier{};
     std::shared_ptr<vren::pooled_vk_descriptor_set> descriptor_set;
 
-    vkCmdFillBuffer(command_buffer, assigned_light_counts_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+    if (light_count == 0 && spot_light_count == 0)
+    {
+        // No light to assign, every cluster has no light assigned
+        vkCmdFillBuffer(command_buffer, assigned_light_counts_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+        return;
+    }
 
-    if (light_count > 0)
+    // The clusters allocate their range of assigned light indices atomically, the allocator is reset every frame (with temporal
+    // reuse only when the light epoch changes, the reused clusters keep their range)
+    if (!temporal_params || temporal_params->m_reset_assigned_light_allocator)
     {
+        vkCmdFillBuffer(command_buffer, assigned_light_allocator_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+
         buffer_memory_barrier = {
             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
             .pNext = nullptr,
@@ -502,211 +803,341 @@ void vren::clustered_shading::assign_lights::operator()(
             .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
             .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
             .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = assigned_light_counts_buffer.m_buffer.m_handle,
+            .buffer = assigned_light_allocator_buffer.m_buffer.m_handle,
             .offset = 0,
             .size = VK_WHOLE_SIZE
         };
         vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+    }
 
-        // ------------------------------------------------------------------------------------------------
-        // 1. Count the number of light assignments per cluster
-        // ------------------------------------------------------------------------------------------------
+    // ------------------------------------------------------------------------------------------------
+    // Traverse the light BVH, count and write the light assignments of every cluster in a single pass
+    // ------------------------------------------------------------------------------------------------
+
+    vkCmdSetCheckpointNV(command_buffer, "clustered_shading/assign_lights");
 
-        vkCmdSetCheckpointNV(command_buffer, "clustered_shading/assign_lights/count");
+    vren::pipeline const& pipeline = temporal_params ? m_temporal_pipeline : m_pipeline;
 
-        // Bind pipeline
-        m_count_pipeline.bind(command_buffer);
+    // Bind pipeline
+    pipeline.bind(command_buffer);
 
-        // Push constants
+    // Push constants
+    {
+        struct
         {
-            struct
-            {
-                glm::uvec2 m_num_tiles;
-                float m_camera_near;
-                float m_camera_half_fov_y;
-                glm::mat4 m_camera_proj;
-                uint32_t m_bvh_root_index;
-                uint32_t m_bvh_level_count;
-                float _pad1[2];
-            } push_constants;
-
-            push_constants = {
-                .m_num_tiles = glm::uvec2(
-                    vren::divide_and_ceil(screen.x, 32u),
-                    vren::divide_and_ceil(screen.y, 32u)
-                ),
-                .m_camera_near = camera.m_near_plane,
-                .m_camera_half_fov_y = camera.m_fov_y / 2.0f,
-                .m_camera_proj = camera.get_projection(),
-                .m_bvh_root_index = light_bvh_root_index,
-                .m_bvh_level_count = vren::calc_bvh_level_count(light_count)
-            };
+            glm::uvec2 m_num_tiles;
+            float m_camera_near;
+            float m_camera_far;
+            glm::mat4 m_camera_proj;
+            uint32_t m_bvh_root_index;
+            uint32_t m_max_assigned_light_count;
+            uint32_t m_light_epoch;
+            uint32_t m_point_light_count;
+            uint32_t m_spot_light_count;
+            float _pad1[3];
+        } push_constants;
 
-            m_count_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
-        }
+        push_constants = {
+            .m_num_tiles = m_cluster_key_layout.get_tile_count(screen),
+            .m_camera_near = camera.m_near_plane,
+            .m_camera_far = camera.m_far_plane,
+            .m_camera_proj = camera.get_projection(),
+            .m_bvh_root_index = light_bvh_root_index,
+            .m_max_assigned_light_count = (uint32_t) (assigned_light_indices_buffer.m_allocation_info.size / sizeof(uint32_t)),
+            .m_light_epoch = temporal_params ? temporal_params->m_light_epoch : 0,
+            .m_point_light_count = light_count,
+            .m_spot_light_count = spot_light_count,
+        };
 
-        // Bind descriptor set 0
-        descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_count_pipeline.m_descriptor_set_layouts.at(0))
-        );
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, cluster_key_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, light_bvh_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 3, light_index_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 4, assigned_light_indices_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 5, assigned_light_counts_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 6, assigned_light_offsets_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 7, view_space_point_light_position_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+    }
 
-        m_count_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
+    // Bind descriptor set 0
+    descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
+        m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(0))
+    );
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, cluster_key_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, light_bvh_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 3, light_index_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 4, assigned_light_indices_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 5, assigned_light_counts_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 6, assigned_light_offsets_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 7, view_space_point_light_position_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 8, assigned_light_allocator_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 11, view_space_spot_light_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 12, cluster_statistics_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+
+    if (temporal_params)
+    {
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 9, temporal_params->m_cluster_hash_table_buffer->m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 10, temporal_params->m_statistics_buffer->m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    }
 
-        // Dispatch
-        vkCmdDispatchIndirect(command_buffer, cluster_key_dispatch_params_buffer.m_buffer.m_handle, 0);
+    pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
 
-        resource_container.add_resources(descriptor_set);
+    // Dispatch
+    vkCmdDispatchIndirect(command_buffer, cluster_key_dispatch_params_buffer.m_buffer.m_handle, 0);
 
-        // ------------------------------------------------------------------------------------------------
-        // 2. Copy counts buffer to offsets buffer in order to exclusive-scan
-        // ------------------------------------------------------------------------------------------------
+    resource_container.add_resources(descriptor_set);
+}
 
-        vkCmdSetCheckpointNV(command_buffer, "clustered_shading/assign_lights/copy_count_buffer_to_offset_buffer");
+// --------------------------------------------------------------------------------------------------------------------------------
+// bin_lights
+// --------------------------------------------------------------------------------------------------------------------------------
 
-        buffer_memory_barrier = {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .pNext = nullptr,
-            .srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = assigned_light_counts_buffer.m_buffer.m_handle,
-            .offset = 0,
-            .size = VK_WHOLE_SIZE
-        };
-        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+vren::pipeline_future vren::clustered_shading::bin_lights::create_pipeline(vren::context const& context)
+{
+    return vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/bin_lights.comp.spv");
+}
 
-        VkBufferCopy buffer_copy{
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size = VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT * sizeof(uint32_t)
-        };
-        vkCmdCopyBuffer(command_buffer, assigned_light_counts_buffer.m_buffer.m_handle, assigned_light_offsets_buffer.m_buffer.m_handle, 1, &buffer_copy);
+vren::clustered_shading::bin_lights::bin_lights(
+    vren::context const& context
+) :
+    bin_lights(context, create_pipeline(context))
+{
+}
 
-        // ------------------------------------------------------------------------------------------------
-        // 3. Use exclusive-scan to find indices offsets
-        // ------------------------------------------------------------------------------------------------
+vren::clustered_shading::bin_lights::bin_lights(
+    vren::context const& context,
+    vren::pipeline_future pipeline
+) :
+    m_context(&context),
+    m_pipeline(pipeline.get())
+{
+}
 
-        vkCmdSetCheckpointNV(command_buffer, "clustered_shading/assign_lights/exclusive_scan");
+size_t vren::clustered_shading::bin_lights::get_required_froxel_light_bitmask_buffer_size(glm::uvec2 const& screen)
+{
+    size_t froxel_count =
+        vren::divide_and_ceil(screen.x, VREN_FROXEL_TILE_SIZE) *
+        vren::divide_and_ceil(screen.y, VREN_FROXEL_TILE_SIZE) *
+        VREN_FROXEL_DEPTH_SLICE_COUNT;
+    return froxel_count * VREN_FROXEL_LIGHT_WORD_COUNT * sizeof(uint32_t);
+}
 
-        buffer_memory_barrier = {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .pNext = nullptr,
-            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = assigned_light_offsets_buffer.m_buffer.m_handle,
-            .offset = 0,
-            .size = VK_WHOLE_SIZE
-        };
-        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+void vren::clustered_shading::bin_lights::operator()(
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    glm::uvec2 const& screen,
+    vren::camera const& camera,
+    uint32_t point_light_count,
+    vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+    vren::vk_utils::buffer const& froxel_light_bitmask_buffer
+)
+{
+    assert(point_light_count <= VREN_FROXEL_MAX_LIGHT_COUNT);
+    assert(froxel_light_bitmask_buffer.m_allocation_info.size >= get_required_froxel_light_bitmask_buffer_size(screen));
 
-        m_context->m_toolbox->m_blelloch_scan( // TODO : use indirect dispatch ?
-            command_buffer,
-            resource_container,
-            assigned_light_offsets_buffer,
-            VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT, // The unique clsuter keys actual count is not known by the host
-            0,
-            1
-        );
+    vkCmdSetCheckpointNV(command_buffer, "clustered_shading/bin_lights");
 
-        // ------------------------------------------------------------------------------------------------
-        // 4. Finally write point light indices
-        // ------------------------------------------------------------------------------------------------
+    // Bind pipeline
+    m_pipeline.bind(command_buffer);
 
-        vkCmdSetCheckpointNV(command_buffer, "clustered_shading/assign_lights/write");
+    // Push constants
+    {
+        struct
+        {
+            glm::uvec2 m_screen;
+            float m_camera_near;
+            float m_camera_far;
+            glm::mat4 m_camera_inverse_proj;
+            uint32_t m_point_light_count;
+            float _pad[3];
+        } push_constants;
 
-        buffer_memory_barrier = {
-            .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
-            .pNext = nullptr,
-            .srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
-            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .buffer = assigned_light_offsets_buffer.m_buffer.m_handle,
-            .offset = 0,
-            .size = VK_WHOLE_SIZE
+        push_constants = {
+            .m_screen = screen,
+            .m_camera_near = camera.m_near_plane,
+            .m_camera_far = camera.m_far_plane,
+            .m_camera_inverse_proj = glm::inverse(camera.get_projection()),
+            .m_point_light_count = point_light_count,
         };
-        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
 
-        // Bind pipeline
-        m_write_pipeline.bind(command_buffer);
+        m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+    }
 
-        // Push constants
-        {
-            struct
-            {
-                glm::uvec2 m_num_tiles;
-                float m_camera_near;
-                float m_camera_half_fov_y;
-                glm::mat4 m_camera_proj;
-                uint32_t m_bvh_root_index;
-                uint32_t m_bvh_level_count;
-                float _pad1[2];
-            } push_constants;
-
-            push_constants = {
-                .m_num_tiles = glm::uvec2(
-                    vren::divide_and_ceil(screen.x, 32u),
-                    vren::divide_and_ceil(screen.y, 32u)
-                ),
-                .m_camera_near = camera.m_near_plane,
-                .m_camera_half_fov_y = camera.m_fov_y / 2.0f,
-                .m_camera_proj = camera.get_projection(),
-                .m_bvh_root_index = light_bvh_root_index,
-                .m_bvh_level_count = vren::calc_bvh_level_count(light_count)
-            };
+    // Bind descriptor set 0
+    auto descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
+        m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(0))
+    );
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, view_space_point_light_position_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 1, froxel_light_bitmask_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
 
-            m_write_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
-        }
+    m_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
 
-        // Bind descriptor set 0
-        descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_write_pipeline.m_descriptor_set_layouts.at(0))
-        );
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 0, cluster_key_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 2, light_bvh_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 3, light_index_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 4, assigned_light_indices_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 5, assigned_light_counts_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 6, assigned_light_offsets_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set->m_handle.m_descriptor_set, 7, view_space_point_light_position_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    // Dispatch
+    uint32_t num_workgroups_x = vren::divide_and_ceil(screen.x, VREN_FROXEL_TILE_SIZE);
+    uint32_t num_workgroups_y = vren::divide_and_ceil(screen.y, VREN_FROXEL_TILE_SIZE);
+    m_pipeline.dispatch(command_buffer, num_workgroups_x, num_workgroups_y, VREN_FROXEL_DEPTH_SLICE_COUNT);
 
-        m_write_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
+    resource_container.add_resources(descriptor_set);
+}
 
-        // Dispatch
-        vkCmdDispatchIndirect(command_buffer, cluster_key_dispatch_params_buffer.m_buffer.m_handle, 0);
+// --------------------------------------------------------------------------------------------------------------------------------
+// bin_pixels_by_material
+// --------------------------------------------------------------------------------------------------------------------------------
 
-        resource_container.add_resources(descriptor_set);
-    }
+vren::pipeline_future vren::clustered_shading::bin_pixels_by_material::create_pipeline(vren::context const& context)
+{
+    return vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/gather_pixel_materials.comp.spv");
+}
+
+vren::clustered_shading::bin_pixels_by_material::bin_pixels_by_material(
+    vren::context const& context
+) :
+    bin_pixels_by_material(context, create_pipeline(context))
+{
+}
+
+vren::clustered_shading::bin_pixels_by_material::bin_pixels_by_material(
+    vren::context const& context,
+    vren::pipeline_future pipeline
+) :
+    m_context(&context),
+    m_pipeline(pipeline.get())
+{
+}
+
+size_t vren::clustered_shading::bin_pixels_by_material::get_required_pixel_material_buffer_size(glm::uvec2 const& screen)
+{
+    return screen.x * screen.y * sizeof(glm::uvec2);
+}
+
+VkBufferUsageFlags vren::clustered_shading::bin_pixels_by_material::get_required_material_sorted_pixel_buffer_usage_flags()
+{
+    return vren::bucket_sort::get_required_output_buffer_usage_flags();
+}
+
+size_t vren::clustered_shading::bin_pixels_by_material::get_required_material_sorted_pixel_buffer_size(glm::uvec2 const& screen)
+{
+    return vren::bucket_sort::get_required_output_buffer_size(screen.x * screen.y);
+}
+
+void vren::clustered_shading::bin_pixels_by_material::operator()(
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    glm::uvec2 const& screen,
+    vren::gbuffer const& gbuffer,
+    vren::vk_utils::depth_buffer_t const& depth_buffer,
+    vren::vk_utils::buffer const& pixel_material_buffer,
+    vren::vk_utils::buffer const& material_sorted_pixel_buffer
+)
+{
+    assert(pixel_material_buffer.m_allocation_info.size >= get_required_pixel_material_buffer_size(screen));
+    assert(material_sorted_pixel_buffer.m_allocation_info.size >= get_required_material_sorted_pixel_buffer_size(screen));
+
+    uint32_t pixel_count = screen.x * screen.y;
+
+    // ------------------------------------------------------------------------------------------------
+    // Gather the material index of every pixel
+    // ------------------------------------------------------------------------------------------------
+
+    m_pipeline.bind(command_buffer);
+
+    struct
+    {
+        glm::uvec2 m_screen;
+        float _pad[2];
+    } push_constants;
+
+    push_constants = {
+        .m_screen = screen,
+    };
+    m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+
+    auto descriptor_set_0 = std::make_shared<vren::pooled_vk_descriptor_set>(
+        m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(0))
+    );
+    gbuffer.write_descriptor_set(descriptor_set_0->m_handle.m_descriptor_set, depth_buffer);
+
+    m_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set_0->m_handle.m_descriptor_set);
+
+    auto descriptor_set_1 = std::make_shared<vren::pooled_vk_descriptor_set>(
+        m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(1))
+    );
+    vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 0, pixel_material_buffer.m_buffer.m_handle, pixel_count * sizeof(glm::uvec2), 0);
+
+    m_pipeline.bind_descriptor_set(command_buffer, 1, descriptor_set_1->m_handle.m_descriptor_set);
+
+    uint32_t num_workgroups_x = vren::divide_and_ceil(screen.x, 32);
+    uint32_t num_workgroups_y = vren::divide_and_ceil(screen.y, 32);
+    m_pipeline.dispatch(command_buffer, num_workgroups_x, num_workgroups_y, 1);
+
+    resource_container.add_resources(
+        descriptor_set_0,
+        descriptor_set_1
+    );
+
+    VkBufferMemoryBarrier buffer_memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = pixel_material_buffer.m_buffer.m_handle,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+
+    // ------------------------------------------------------------------------------------------------
+    // Sort the pixels by material index
+    // ------------------------------------------------------------------------------------------------
+
+    m_context->m_toolbox->m_bucket_sort(
+        command_buffer,
+        resource_container,
+        pixel_material_buffer,
+        pixel_count,
+        0,
+        material_sorted_pixel_buffer,
+        0
+    );
 }
 
 // --------------------------------------------------------------------------------------------------------------------------------
 // shade
 // --------------------------------------------------------------------------------------------------------------------------------
 
+vren::pipeline_futures<4> vren::clustered_shading::shade::create_pipelines(vren::context const& context)
+{
+    return {
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/shade.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/shade_froxels.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/shade_material_sorted.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/clustered_shading/shade_shared_lights.comp.spv")
+    };
+}
+
 vren::clustered_shading::shade::shade(
     vren::context const& context
+) :
+    shade(context, create_pipelines(context))
+{
+}
+
+vren::clustered_shading::shade::shade(
+    vren::context const& context,
+    vren::pipeline_futures<4> pipelines
 ) :
     m_context(&context),
-    m_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/clustered_shading/shade.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_pipeline(pipelines[0].get()),
+    m_froxel_pipeline(pipelines[1].get()),
+    m_material_sorted_pipeline(pipelines[2].get()),
+    m_shared_lights_pipeline(pipelines[3].get())
 {
+    if (context.m_shader_registry)
+    {
+        m_shader_watches.push_back(context.m_shader_registry->watch_compute_pipeline(m_pipeline, ".vren/resources/shaders/clustered_shading/shade.comp.spv"));
+        m_shader_watches.push_back(context.m_shader_registry->watch_compute_pipeline(m_froxel_pipeline, ".vren/resources/shaders/clustered_shading/shade_froxels.comp.spv"));
+        m_shader_watches.push_back(context.m_shader_registry->watch_compute_pipeline(m_material_sorted_pipeline, ".vren/resources/shaders/clustered_shading/shade_material_sorted.comp.spv"));
+        m_shader_watches.push_back(context.m_shader_registry->watch_compute_pipeline(m_shared_lights_pipeline, ".vren/resources/shaders/clustered_shading/shade_shared_lights.comp.spv"));
+    }
 }
 
-void vren::clustered_shading::shade::operator()(
+void vren::clustered_shading::shade::dispatch(
+    vren::pipeline const& pipeline,
     uint32_t frame_idx,
     VkCommandBuffer command_buffer,
     vren::resource_container& resource_container,
@@ -714,86 +1145,98 @@ void vren::clustered_shading::shade::operator()(
     vren::camera const& camera,
     vren::gbuffer const& gbuffer,
     vren::vk_utils::depth_buffer_t const& depth_buffer,
-    vren::vk_utils::combined_image_view const& cluster_reference_buffer,
-    vren::vk_utils::buffer const& assigned_light_indices_buffer,
-    vren::vk_utils::buffer const& assigned_light_counts_buffer,
-    vren::vk_utils::buffer const& assigned_light_offsets_buffer,
+    std::function<void(VkDescriptorSet descriptor_set)> const& write_light_binning_descriptor_set,
     vren::light_array const& light_array,
     vren::material_buffer const& material_buffer,
-    vren::vk_utils::combined_image_view const& output
+    vren::cascaded_shadow_map const& shadow_map,
+    uint32_t shadow_cascade_count,
+    float attenuation_threshold,
+    vren::vk_utils::combined_image_view const& output,
+    vren::vk_utils::buffer const* material_sorted_pixel_buffer
 )
 {
     assert(gbuffer.m_width == screen.x);
     assert(gbuffer.m_height == screen.y);
 
-    m_pipeline.bind(command_buffer);
+    pipeline.bind(command_buffer);
 
     // Push constants
     struct
     {
         glm::vec3 m_camera_position; float m_camera_far_plane;
-        glm::mat4 m_camera_view;
-        glm::mat4 m_camera_projection;
+        glm::mat4 m_camera_inverse_view;
+        glm::mat4 m_camera_inverse_projection;
+        float m_camera_near_plane;
+        uint32_t m_shadow_cascade_count;
+        float m_attenuation_threshold;
+        float _pad;
     } push_constants;
 
     push_constants = {
         .m_camera_position = camera.m_position,
         .m_camera_far_plane = camera.m_far_plane,
-        .m_camera_view = camera.get_view(),
-        .m_camera_projection = camera.get_projection(),
+        .m_camera_inverse_view = glm::inverse(camera.get_view()),
+        .m_camera_inverse_projection = glm::inverse(camera.get_projection()),
+        .m_camera_near_plane = camera.m_near_plane,
+        .m_shadow_cascade_count = shadow_cascade_count,
+        .m_attenuation_threshold = attenuation_threshold,
     };
 
-    m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+    pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
 
     // Descriptors
     {
         // gBuffer
         auto descriptor_set_0 = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(0))
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(0))
         );
         gbuffer.write_descriptor_set(descriptor_set_0->m_handle.m_descriptor_set, depth_buffer);
 
-        m_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set_0->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set_0->m_handle.m_descriptor_set);
 
-        // Clustered shading buffers
+        // Light binning buffers (clusters or froxels)
         auto descriptor_set_1 = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(1))
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(1))
         );
+        write_light_binning_descriptor_set(descriptor_set_1->m_handle.m_descriptor_set);
 
-        vren::vk_utils::write_storage_image_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 0, cluster_reference_buffer.m_image_view.m_handle, VK_IMAGE_LAYOUT_GENERAL);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 1, assigned_light_indices_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 2, assigned_light_counts_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_1->m_handle.m_descriptor_set, 3, assigned_light_offsets_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
-
-        m_pipeline.bind_descriptor_set(command_buffer, 1, descriptor_set_1->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 1, descriptor_set_1->m_handle.m_descriptor_set);
 
         // Textures
         auto descriptor_set_2 = m_context->m_toolbox->m_texture_manager.m_descriptor_set;
-        m_pipeline.bind_descriptor_set(command_buffer, 2, descriptor_set_2->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 2, descriptor_set_2->m_handle.m_descriptor_set);
 
         // Light array
         auto descriptor_set_3 = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(3))
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(3))
         );
         light_array.write_descriptor_set(descriptor_set_3->m_handle.m_descriptor_set);
 
-        m_pipeline.bind_descriptor_set(command_buffer, 3, descriptor_set_3->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 3, descriptor_set_3->m_handle.m_descriptor_set);
 
         // Materials
         auto descriptor_set_4 = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(4))
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(4))
         );
         material_buffer.write_descriptor_set(descriptor_set_4->m_handle.m_descriptor_set);
 
-        m_pipeline.bind_descriptor_set(command_buffer, 4, descriptor_set_4->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 4, descriptor_set_4->m_handle.m_descriptor_set);
 
         // Output
         auto descriptor_set_5 = std::make_shared<vren::pooled_vk_descriptor_set>(
-            m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(5))
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(5))
         );
         vren::vk_utils::write_storage_image_descriptor(*m_context, descriptor_set_5->m_handle.m_descriptor_set, 0, output.get_image_view(), VK_IMAGE_LAYOUT_GENERAL);
 
-        m_pipeline.bind_descriptor_set(command_buffer, 5, descriptor_set_5->m_handle.m_descriptor_set);
+        pipeline.bind_descriptor_set(command_buffer, 5, descriptor_set_5->m_handle.m_descriptor_set);
+
+        // Cascaded shadow map (always bound, the shadows are skipped when shadow_cascade_count is 0)
+        auto descriptor_set_7 = std::make_shared<vren::pooled_vk_descriptor_set>(
+            m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(7))
+        );
+        shadow_map.write_descriptor_set(frame_idx, descriptor_set_7->m_handle.m_descriptor_set);
+
+        pipeline.bind_descriptor_set(command_buffer, 7, descriptor_set_7->m_handle.m_descriptor_set);
 
         resource_container.add_resources(
             descriptor_set_0,
@@ -801,28 +1244,137 @@ void vren::clustered_shading::shade::operator()(
             descriptor_set_2,
             descriptor_set_3,
             descriptor_set_4,
-            descriptor_set_5
+            descriptor_set_5,
+            descriptor_set_7
         );
+
+        // Material sorted pixels
+        if (material_sorted_pixel_buffer)
+        {
+            auto descriptor_set_6 = std::make_shared<vren::pooled_vk_descriptor_set>(
+                m_context->m_toolbox->m_descriptor_pool.acquire(pipeline.m_descriptor_set_layouts.at(6))
+            );
+            vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set_6->m_handle.m_descriptor_set, 0, material_sorted_pixel_buffer->m_buffer.m_handle, screen.x * screen.y * sizeof(glm::uvec2), 0);
+
+            pipeline.bind_descriptor_set(command_buffer, 6, descriptor_set_6->m_handle.m_descriptor_set);
+
+            resource_container.add_resource(descriptor_set_6);
+        }
     }
 
-    uint32_t num_workgroups_x = vren::divide_and_ceil(screen.x, 32);
-    uint32_t num_workgroups_y = vren::divide_and_ceil(screen.y, 32);
-    m_pipeline.dispatch(command_buffer, num_workgroups_x, num_workgroups_y, 1);
+    if (material_sorted_pixel_buffer)
+    {
+        // The workgroups shade 32x32 pixels of the sorted list
+        pipeline.dispatch(command_buffer, vren::divide_and_ceil(screen.x * screen.y, 32 * 32), 1, 1);
+    }
+    else
+    {
+        uint32_t num_workgroups_x = vren::divide_and_ceil(screen.x, 32);
+        uint32_t num_workgroups_y = vren::divide_and_ceil(screen.y, 32);
+        pipeline.dispatch(command_buffer, num_workgroups_x, num_workgroups_y, 1);
+    }
+}
+
+void vren::clustered_shading::shade::operator()(
+    uint32_t frame_idx,
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    glm::uvec2 const& screen,
+    vren::camera const& camera,
+    vren::gbuffer const& gbuffer,
+    vren::vk_utils::depth_buffer_t const& depth_buffer,
+    vren::vk_utils::combined_image_view const& cluster_reference_buffer,
+    vren::vk_utils::buffer const& assigned_light_indices_buffer,
+    vren::vk_utils::buffer const& assigned_light_counts_buffer,
+    vren::vk_utils::buffer const& assigned_light_offsets_buffer,
+    vren::light_array const& light_array,
+    vren::material_buffer const& material_buffer,
+    vren::cascaded_shadow_map const& shadow_map,
+    uint32_t shadow_cascade_count,
+    float attenuation_threshold,
+    vren::vk_utils::combined_image_view const& output,
+    vren::vk_utils::buffer const* material_sorted_pixel_buffer,
+    bool shared_light_prefetch
+)
+{
+    assert(!(material_sorted_pixel_buffer && shared_light_prefetch));
+
+    vren::pipeline const& pipeline =
+        material_sorted_pixel_buffer ? m_material_sorted_pipeline : (shared_light_prefetch ? m_shared_lights_pipeline : m_pipeline);
+
+    dispatch(pipeline, frame_idx, command_buffer, resource_container, screen, camera, gbuffer, depth_buffer, [&](VkDescriptorSet descriptor_set)
+    {
+        vren::vk_utils::write_storage_image_descriptor(*m_context, descriptor_set, 0, cluster_reference_buffer.m_image_view.m_handle, VK_IMAGE_LAYOUT_GENERAL);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 1, assigned_light_indices_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 2, assigned_light_counts_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 3, assigned_light_offsets_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    }, light_array, material_buffer, shadow_map, shadow_cascade_count, attenuation_threshold, output, material_sorted_pixel_buffer);
+}
+
+void vren::clustered_shading::shade::operator()(
+    uint32_t frame_idx,
+    VkCommandBuffer command_buffer,
+    vren::resource_container& resource_container,
+    glm::uvec2 const& screen,
+    vren::camera const& camera,
+    vren::gbuffer const& gbuffer,
+    vren::vk_utils::depth_buffer_t const& depth_buffer,
+    vren::vk_utils::buffer const& froxel_light_bitmask_buffer,
+    vren::light_array const& light_array,
+    vren::material_buffer const& material_buffer,
+    vren::cascaded_shadow_map const& shadow_map,
+    uint32_t shadow_cascade_count,
+    float attenuation_threshold,
+    vren::vk_utils::combined_image_view const& output
+)
+{
+    dispatch(m_froxel_pipeline, frame_idx, command_buffer, resource_container, screen, camera, gbuffer, depth_buffer, [&](VkDescriptorSet descriptor_set)
+    {
+        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 0, froxel_light_bitmask_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+    }, light_array, material_buffer, shadow_map, shadow_cascade_count, attenuation_threshold, output, nullptr);
 }
 
 // --------------------------------------------------------------------------------------------------------------------------------
 // cluster_and_shade
 // --------------------------------------------------------------------------------------------------------------------------------
 
+vren::cluster_and_shade::step_pipelines vren::cluster_and_shade::create_pipelines(
+    vren::context const& context,
+    vren::clustered_shading::cluster_key_layout const& cluster_key_layout
+)
+{
+    return {
+        .m_cluster_key_layout = cluster_key_layout,
+        .m_construct_point_light_bvh = vren::clustered_shading::construct_point_light_bvh::create_pipelines(context),
+        .m_find_unique_cluster_list = vren::clustered_shading::find_unique_cluster_list::create_pipelines(context, cluster_key_layout),
+        .m_assign_lights = vren::clustered_shading::assign_lights::create_pipelines(context, cluster_key_layout),
+        .m_bin_lights = vren::clustered_shading::bin_lights::create_pipeline(context),
+        .m_bin_pixels_by_material = vren::clustered_shading::bin_pixels_by_material::create_pipeline(context),
+        .m_shade = vren::clustered_shading::shade::create_pipelines(context),
+    };
+}
+
 vren::cluster_and_shade::cluster_and_shade(
-    vren::context const& context
+    vren::context const& context,
+    vren::clustered_shading::cluster_grid const& cluster_grid
+) :
+    cluster_and_shade(context, create_pipelines(context, vren::clustered_shading::make_cluster_key_layout(cluster_grid)))
+{
+}
+
+vren::cluster_and_shade::cluster_and_shade(
+    vren::context const& context,
+    step_pipelines pipelines
 ) :
     m_context(&context),
+    m_cluster_key_layout(pipelines.m_cluster_key_layout),
 
-    m_construct_point_light_bvh(context),
-    m_find_unique_cluster_list(context),
-    m_assign_lights(context),
-    m_shade(context),
+    m_construct_point_light_bvh(context, std::move(pipelines.m_construct_point_light_bvh)),
+    m_find_unique_cluster_list(context, m_cluster_key_layout, std::move(pipelines.m_find_unique_cluster_list)),
+    m_assign_lights(context, m_cluster_key_layout, std::move(pipelines.m_assign_lights)),
+    m_bin_lights(context, std::move(pipelines.m_bin_lights)),
+    m_bin_pixels_by_material(context, std::move(pipelines.m_bin_pixels_by_material)),
+    m_shade(context, std::move(pipelines.m_shade)),
 
     m_view_space_point_light_position_buffer([&]()
     {
@@ -854,11 +1406,21 @@ vren::cluster_and_shade::cluster_and_shade(
         vren::vk_utils::set_name(*m_context, buffer, "point_light_index_buffer");
         return buffer;
     }()),
+    m_view_space_spot_light_buffer([&]()
+    {
+        auto buffer = vren::vk_utils::alloc_device_only_buffer(
+            *m_context,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            vren::clustered_shading::construct_point_light_bvh::get_required_view_space_spot_light_buffer_size(VREN_MAX_SPOT_LIGHT_COUNT)
+        );
+        vren::vk_utils::set_name(*m_context, buffer, "view_space_spot_light_buffer");
+        return buffer;
+    }()),
 
     m_cluster_key_buffer(vren::vk_utils::alloc_device_only_buffer(
         *m_context,
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT * sizeof(uint32_t)
+        VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT * m_cluster_key_layout.get_key_size()
     )),
     m_cluster_key_dispatch_params_buffer(vren::vk_utils::alloc_device_only_buffer(
         *m_context,
@@ -883,13 +1445,61 @@ vren::cluster_and_shade::cluster_and_shade(
     m_assigned_light_counts_buffer(vren::vk_utils::alloc_device_only_buffer(
         *m_context,
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT * sizeof(uint32_t)
+        std::max(VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT, VREN_CLUSTER_HASH_TABLE_CAPACITY + 1) * sizeof(uint32_t) // Indexed by hash table slot with temporal reuse
     )),
     m_assigned_light_offsets_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        std::max(VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT, VREN_CLUSTER_HASH_TABLE_CAPACITY + 1) * sizeof(uint32_t)
+    )),
+    m_assigned_light_allocator_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        sizeof(uint32_t)
+    )),
+    m_froxel_light_bitmask_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        vren::clustered_shading::bin_lights::get_required_froxel_light_bitmask_buffer_size(glm::uvec2(VREN_MAX_SCREEN_WIDTH, VREN_MAX_SCREEN_HEIGHT))
+    )),
+    m_pixel_material_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        vren::clustered_shading::bin_pixels_by_material::get_required_pixel_material_buffer_size(glm::uvec2(VREN_MAX_SCREEN_WIDTH, VREN_MAX_SCREEN_HEIGHT))
+    )),
+    m_material_sorted_pixel_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        vren::clustered_shading::bin_pixels_by_material::get_required_material_sorted_pixel_buffer_usage_flags(),
+        vren::clustered_shading::bin_pixels_by_material::get_required_material_sorted_pixel_buffer_size(glm::uvec2(VREN_MAX_SCREEN_WIDTH, VREN_MAX_SCREEN_HEIGHT))
+    )),
+    m_cluster_statistics_buffers(vren::create_array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index)
+    {
+        return vren::vk_utils::alloc_host_only_buffer(
+            *m_context,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            sizeof(vren::clustered_shading::cluster_statistics),
+            true
+        );
+    })),
+    m_cluster_hash_table_buffer(vren::vk_utils::alloc_device_only_buffer(
         *m_context,
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VREN_MAX_UNIQUE_CLUSTER_KEY_COUNT * sizeof(uint32_t)
-    ))
+        VREN_CLUSTER_HASH_TABLE_CAPACITY * sizeof(glm::uvec4)
+    )),
+    m_tile_signature_buffer(vren::vk_utils::alloc_device_only_buffer(
+        *m_context,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        m_cluster_key_layout.get_tile_count(m_cluster_key_layout.m_max_screen).x * m_cluster_key_layout.get_tile_count(m_cluster_key_layout.m_max_screen).y * sizeof(uint32_t)
+    )),
+    m_temporal_cluster_statistics_buffers(vren::create_array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index)
+    {
+        return vren::vk_utils::alloc_host_only_buffer(
+            *m_context,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            sizeof(vren::clustered_shading::temporal_cluster_statistics),
+            true
+        );
+    }))
 {
     vren::vk_utils::set_name(*m_context, m_cluster_key_buffer, "cluster_key_buffer");
     vren::vk_utils::set_name(*m_context, m_cluster_key_dispatch_params_buffer, "cluster_key_dispatch_params_buffer");
@@ -898,6 +1508,15 @@ vren::cluster_and_shade::cluster_and_shade(
     vren::vk_utils::set_name(*m_context, m_assigned_light_indices_buffer, "assigned_light_indices_buffer");
     vren::vk_utils::set_name(*m_context, m_assigned_light_counts_buffer, "assigned_light_counts_buffer");
     vren::vk_utils::set_name(*m_context, m_assigned_light_offsets_buffer, "assigned_light_offsets_buffer");
+    vren::vk_utils::set_name(*m_context, m_assigned_light_allocator_buffer, "assigned_light_allocator_buffer");
+
+    vren::vk_utils::set_name(*m_context, m_froxel_light_bitmask_buffer, "froxel_light_bitmask_buffer");
+
+    vren::vk_utils::set_name(*m_context, m_pixel_material_buffer, "pixel_material_buffer");
+    vren::vk_utils::set_name(*m_context, m_material_sorted_pixel_buffer, "material_sorted_pixel_buffer");
+
+    vren::vk_utils::set_name(*m_context, m_cluster_hash_table_buffer, "cluster_hash_table_buffer");
+    vren::vk_utils::set_name(*m_context, m_tile_signature_buffer, "tile_signature_buffer");
 
     vren::vk_utils::immediate_graphics_queue_submit(*m_context, [&](VkCommandBuffer command_buffer, vren::resource_container& resource_container)
     {
@@ -921,6 +1540,181 @@ vren::cluster_and_shade::cluster_and_shade(
     });
 }
 
+vren::light_binning_mode vren::cluster_and_shade::select_light_binning_mode(uint32_t point_light_count) const
+{
+    if (point_light_count > VREN_FROXEL_MAX_LIGHT_COUNT)
+    {
+        return vren::LightBinningModeClusters; // Froxel light bitmasks can't hold more lights
+    }
+
+    if (m_light_binning_mode == vren::LightBinningModeAuto)
+    {
+        return point_light_count < m_froxel_max_point_light_count ? vren::LightBinningModeFroxels : vren::LightBinningModeClusters;
+    }
+    return m_light_binning_mode;
+}
+
+void vren::cluster_and_shade::invalidate_light_assignments()
+{
+    m_invalidate_light_assignments = true;
+}
+
+float vren::cluster_and_shade::get_cluster_occupancy() const
+{
+    float cluster_grid_size = (float) m_cluster_statistics_tile_count * m_cluster_key_layout.m_depth_slice_count * m_cluster_key_layout.get_normal_cone_count();
+    return cluster_grid_size > 0 ? m_cluster_statistics.m_cluster_count / cluster_grid_size : 0.0f;
+}
+
+float vren::cluster_and_shade::get_average_cluster_light_count() const
+{
+    return m_cluster_statistics.m_cluster_count > 0 ? m_cluster_statistics.m_assigned_light_count / (float) m_cluster_statistics.m_cluster_count : 0.0f;
+}
+
+float vren::cluster_and_shade::get_temporal_cluster_reuse_hit_rate() const
+{
+    uint32_t cluster_count = m_temporal_cluster_statistics.m_reused_cluster_count + m_temporal_cluster_statistics.m_assigned_cluster_count;
+    return cluster_count > 0 ? m_temporal_cluster_statistics.m_reused_cluster_count / (float) cluster_count : 0.0f;
+}
+
+void vren::cluster_and_shade::prepare_cluster_statistics(uint32_t frame_idx, VkCommandBuffer command_buffer, glm::uvec2 const& screen)
+{
+    vren::vk_utils::buffer& statistics_buffer = m_cluster_statistics_buffers.at(frame_idx);
+
+    // The frame that last used this statistics buffer has completed
+    if (m_cluster_statistics_pending.at(frame_idx))
+    {
+        vmaInvalidateAllocation(m_context->m_vma_allocator, statistics_buffer.m_allocation.m_handle, 0, VK_WHOLE_SIZE);
+        m_cluster_statistics = *statistics_buffer.get_mapped_pointer<vren::clustered_shading::cluster_statistics>();
+    }
+
+    glm::uvec2 tile_count = m_cluster_key_layout.get_tile_count(screen);
+    m_cluster_statistics_tile_count = tile_count.x * tile_count.y;
+
+    vkCmdFillBuffer(command_buffer, statistics_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+
+    VkBufferMemoryBarrier buffer_memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = statistics_buffer.m_buffer.m_handle,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+
+    m_cluster_statistics_pending.at(frame_idx) = true;
+}
+
+vren::clustered_shading::temporal_cluster_params vren::cluster_and_shade::prepare_temporal_cluster_params(
+    uint32_t frame_idx,
+    VkCommandBuffer command_buffer,
+    glm::uvec2 const& screen,
+    vren::camera const& camera,
+    uint32_t point_light_count,
+    uint32_t spot_light_count
+)
+{
+    vren::vk_utils::buffer& statistics_buffer = m_temporal_cluster_statistics_buffers.at(frame_idx);
+
+    // The frame that last used this statistics buffer has completed
+    if (m_temporal_cluster_statistics_pending.at(frame_idx))
+    {
+        vmaInvalidateAllocation(m_context->m_vma_allocator, statistics_buffer.m_allocation.m_handle, 0, VK_WHOLE_SIZE);
+        m_temporal_cluster_statistics = *statistics_buffer.get_mapped_pointer<vren::clustered_shading::temporal_cluster_statistics>();
+
+        m_cluster_hash_table_occupancy += m_temporal_cluster_statistics.m_inserted_cluster_count;
+
+        // Until the light epoch changes the new light lists are appended, start over before the assigned light indices are full
+        if (m_temporal_cluster_statistics.m_assigned_light_allocator_end >= VREN_MAX_ASSIGNED_LIGHT_COUNT / 2)
+        {
+            m_invalidate_light_assignments = true;
+        }
+    }
+
+    glm::uvec2 tile_count = m_cluster_key_layout.get_tile_count(screen);
+    m_temporal_cluster_tile_count = tile_count.x * tile_count.y;
+
+    // The clusters that went out of sight are never removed, the hash table is cleared once it gets crowded. The cluster keys also
+    // depend on the projection and on the tile count
+    glm::mat4 camera_view = camera.get_view();
+    glm::mat4 camera_projection = camera.get_projection();
+
+    if (m_cluster_hash_table_occupancy >= VREN_CLUSTER_HASH_TABLE_CAPACITY / 4 || camera_projection != m_last_camera_projection || screen != m_last_screen)
+    {
+        m_clear_cluster_hash_table = true;
+    }
+
+    // The light lists depend on the view-space light positions and radii
+    if (m_clear_cluster_hash_table ||
+        camera_view != m_last_camera_view ||
+        point_light_count != m_last_point_light_count ||
+        spot_light_count != m_last_spot_light_count ||
+        m_light_attenuation_threshold != m_last_light_attenuation_threshold)
+    {
+        m_invalidate_light_assignments = true;
+    }
+
+    m_last_camera_view = camera_view;
+    m_last_camera_projection = camera_projection;
+    m_last_screen = screen;
+    m_last_point_light_count = point_light_count;
+    m_last_spot_light_count = spot_light_count;
+    m_last_light_attenuation_threshold = m_light_attenuation_threshold;
+
+    // The buffers are shared by the frames in flight, the previous frame may still be assigning the lights and shading
+    VkMemoryBarrier clear_memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, NULL, 1, &clear_memory_barrier, 0, nullptr, 0, nullptr);
+
+    if (m_clear_cluster_hash_table)
+    {
+        // All ones is the empty key, and a frame stamp and a light epoch that are never matched
+        vkCmdFillBuffer(command_buffer, m_cluster_hash_table_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, UINT32_MAX);
+        vkCmdFillBuffer(command_buffer, m_tile_signature_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(command_buffer, m_assigned_light_counts_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0); // VREN_CLUSTER_HASH_TABLE_INVALID_SLOT has no light
+
+        m_cluster_hash_table_occupancy = 0;
+    }
+
+    vkCmdFillBuffer(command_buffer, statistics_buffer.m_buffer.m_handle, 0, VK_WHOLE_SIZE, 0);
+
+    // The hash table and the light lists were written by the previous frame
+    VkMemoryBarrier memory_barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .pNext = nullptr,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+    if (m_invalidate_light_assignments)
+    {
+        m_light_epoch++;
+    }
+
+    vren::clustered_shading::temporal_cluster_params temporal_params{
+        .m_cluster_hash_table_buffer = &m_cluster_hash_table_buffer,
+        .m_tile_signature_buffer = &m_tile_signature_buffer,
+        .m_statistics_buffer = &statistics_buffer,
+        .m_frame_stamp = ++m_frame_stamp,
+        .m_light_epoch = m_light_epoch,
+        .m_reset_assigned_light_allocator = m_invalidate_light_assignments,
+    };
+
+    m_temporal_cluster_statistics_pending.at(frame_idx) = true;
+    m_clear_cluster_hash_table = false;
+    m_invalidate_light_assignments = false;
+
+    return temporal_params;
+}
+
 vren::render_graph_t vren::cluster_and_shade::operator()(
     vren::render_graph_allocator& allocator,
     glm::uvec2 const& screen,
@@ -929,6 +1723,7 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
     vren::vk_utils::depth_buffer_t const& depth_buffer,
     vren::light_array const& light_array,
     vren::material_buffer const& material_buffer,
+    vren::cascaded_shadow_map const& shadow_map,
     vren::vk_utils::combined_image_view const& output
 )
 {
@@ -947,6 +1742,7 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
         .m_layer = 0,
     }, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT);
     light_array.add_render_graph_node_resources(*node, VK_ACCESS_SHADER_READ_BIT);
+    shadow_map.add_render_graph_node_resources(*node, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT);
     node->add_image({
         .m_image = output.get_image(),
         .m_image_aspect = VK_IMAGE_ASPECT_COLOR_BIT,
@@ -962,6 +1758,7 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
         &depth_buffer,
         &light_array,
         &material_buffer,
+        &shadow_map,
         &output
     ](
         uint32_t frame_idx,
@@ -972,6 +1769,94 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
         std::array<VkBufferMemoryBarrier, 3> buffer_memory_barriers{};
         std::array<VkImageMemoryBarrier, 3> image_memory_barriers{};
 
+        uint32_t shadow_cascade_count = m_directional_light_shadows && light_array.m_directional_light_count > 0 ? vren::cascaded_shadow_map::k_cascade_count : 0;
+
+        // The spot lights aren't binned by the froxels, but their radii are needed for shading in both modes
+        if (light_array.m_spot_light_count > 0)
+        {
+            m_construct_point_light_bvh.transform_spot_lights_to_view_space(
+                command_buffer,
+                resource_container,
+                light_array,
+                m_view_space_spot_light_buffer,
+                camera,
+                m_light_attenuation_threshold
+            );
+        }
+
+        if (select_light_binning_mode(light_array.m_point_light_count) == vren::LightBinningModeFroxels)
+        {
+            // ------------------------------------------------------------------------------------------------
+            // Froxels: bin the point lights in a single pass and shade
+            // ------------------------------------------------------------------------------------------------
+
+            if (light_array.m_point_light_count > 0)
+            {
+                m_construct_point_light_bvh.transform_point_lights_to_view_space(
+                    command_buffer,
+                    resource_container,
+                    light_array,
+                    m_view_space_point_light_position_buffer,
+                    camera,
+                    m_light_attenuation_threshold
+                );
+
+                m_bin_lights(
+                    command_buffer,
+                    resource_container,
+                    screen,
+                    camera,
+                    light_array.m_point_light_count,
+                    m_view_space_point_light_position_buffer,
+                    m_froxel_light_bitmask_buffer
+                );
+
+                buffer_memory_barriers[0] = {
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .pNext = nullptr,
+                    .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                    .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                    .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                    .buffer = m_froxel_light_bitmask_buffer.m_buffer.m_handle,
+                    .offset = 0,
+                    .size = VK_WHOLE_SIZE
+                };
+                vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, buffer_memory_barriers.data(), 0, nullptr);
+            }
+
+            m_shade(
+                frame_idx,
+                command_buffer,
+                resource_container,
+                screen,
+                camera,
+                gbuffer,
+                depth_buffer,
+                m_froxel_light_bitmask_buffer,
+                light_array,
+                material_buffer,
+                shadow_map,
+                shadow_cascade_count,
+                m_light_attenuation_threshold,
+                output
+            );
+
+            return;
+        }
+
+        prepare_cluster_statistics(frame_idx, command_buffer, screen);
+
+        std::optional<vren::clustered_shading::temporal_cluster_params> temporal_params;
+        if (m_temporal_cluster_reuse && !m_cluster_key_layout.is_64_bit())
+        {
+            temporal_params = prepare_temporal_cluster_params(frame_idx, command_buffer, screen, camera, light_array.m_point_light_count, light_array.m_spot_light_count);
+        }
+        else
+        {
+            m_clear_cluster_hash_table = true; // The cluster references and the light lists are overwritten
+        }
+
         // ------------------------------------------------------------------------------------------------
         // 1. Construct point light BVH
         // ------------------------------------------------------------------------------------------------
@@ -984,6 +1869,7 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
                 light_array,
                 m_view_space_point_light_position_buffer,
                 camera,
+                m_light_attenuation_threshold,
                 m_point_light_bvh_buffer,
                 m_point_light_index_buffer
             );
@@ -1036,7 +1922,8 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
             depth_buffer,
             m_cluster_key_buffer,
             m_cluster_key_dispatch_params_buffer,
-            m_cluster_reference_buffer
+            m_cluster_reference_buffer,
+            temporal_params ? &temporal_params.value() : nullptr
         );
 
         buffer_memory_barriers = {
@@ -1109,14 +1996,19 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
             m_assigned_light_indices_buffer,
             m_assigned_light_counts_buffer,
             m_assigned_light_offsets_buffer,
-            m_view_space_point_light_position_buffer
+            m_assigned_light_allocator_buffer,
+            m_view_space_point_light_position_buffer,
+            light_array.m_spot_light_count,
+            m_view_space_spot_light_buffer,
+            m_cluster_statistics_buffers.at(frame_idx),
+            temporal_params ? &temporal_params.value() : nullptr
         );
 
         buffer_memory_barriers = {
             VkBufferMemoryBarrier{
                 .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
                 .pNext = nullptr,
-                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT,
                 .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -1135,6 +2027,17 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
                 .offset = 0,
                 .size = VK_WHOLE_SIZE
             },
+            VkBufferMemoryBarrier{
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = m_assigned_light_offsets_buffer.m_buffer.m_handle,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE
+            },
         };
         vkCmdPipelineBarrier(
             command_buffer,
@@ -1142,12 +2045,42 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
             NULL,
             0, nullptr,
-            2, buffer_memory_barriers.data(),
+            3, buffer_memory_barriers.data(),
             0, nullptr
         );
 
         // ------------------------------------------------------------------------------------------------
-        // 4. Shading
+        // 4. Bin pixels by material (optional)
+        // ------------------------------------------------------------------------------------------------
+
+        if (m_material_sorted_shading)
+        {
+            m_bin_pixels_by_material(
+                command_buffer,
+                resource_container,
+                screen,
+                gbuffer,
+                depth_buffer,
+                m_pixel_material_buffer,
+                m_material_sorted_pixel_buffer
+            );
+
+            buffer_memory_barriers[0] = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                .pNext = nullptr,
+                .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer = m_material_sorted_pixel_buffer.m_buffer.m_handle,
+                .offset = 0,
+                .size = VK_WHOLE_SIZE
+            };
+            vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, NULL, 0, nullptr, 1, buffer_memory_barriers.data(), 0, nullptr);
+        }
+
+        // ------------------------------------------------------------------------------------------------
+        // 5. Shading
         // ------------------------------------------------------------------------------------------------
 
         m_shade(
@@ -1164,7 +2097,12 @@ vren::render_graph_t vren::cluster_and_shade::operator()(
             m_assigned_light_offsets_buffer,
             light_array,
             material_buffer,
-            output
+            shadow_map,
+            shadow_cascade_count,
+            m_light_attenuation_threshold,
+            output,
+            m_material_sorted_shading ? &m_material_sorted_pixel_buffer : nullptr,
+            m_shared_light_prefetch && !m_material_sorted_shading
         );
     });
 
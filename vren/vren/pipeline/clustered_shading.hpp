@@ -1,12 +1,18 @@
 #pragma once
 
+#include <array>
+#include <optional>
+
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
+#include "vk_helpers/shader_registry.hpp"
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/image.hpp"
 #include "gbuffer.hpp"
 #include "camera.hpp"
 #include "light.hpp"
 #include "material.hpp"
+#include "cascaded_shadow_map.hpp"
 
 namespace vren
 {
@@ -24,9 +30,13 @@ namespace vren
             vren::pipeline m_point_light_position_to_view_space_pipeline;
             vren::pipeline m_discretize_point_light_positions_pipeline;
             vren::pipeline m_init_light_array_bvh_pipeline;
+            vren::pipeline m_spot_light_to_view_space_pipeline;
 
         public:
+            static vren::pipeline_futures<4> create_pipelines(vren::context const& context);
+
             construct_point_light_bvh(vren::context const& context);
+            construct_point_light_bvh(vren::context const& context, vren::pipeline_futures<4> pipelines);
 
             static VkBufferUsageFlags get_required_bvh_buffer_usage_flags();
             static size_t get_required_bvh_buffer_size(uint32_t point_light_count);
@@ -34,17 +44,145 @@ namespace vren
             static VkBufferUsageFlags get_required_point_light_index_buffer_usage_flags();
             static size_t get_required_point_light_index_buffer_size(uint32_t point_light_count);
 
+            /// Writes the view-space point light positions, with the point light radius in w. The light array is only read.
+            void transform_point_lights_to_view_space(
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                vren::light_array const& light_array,
+                vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+                vren::camera const& camera,
+                float attenuation_threshold
+            );
+
+            static size_t get_required_view_space_spot_light_buffer_size(uint32_t spot_light_count);
+
+            /** Writes the view-space spot light cones (see ViewSpaceSpotLight in clustered_shading.glsl), with their radii.
+             * The spot lights aren't part of the BVH, they're tested against every cluster.
+             */
+            void transform_spot_lights_to_view_space(
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                vren::light_array const& light_array,
+                vren::vk_utils::buffer const& view_space_spot_light_buffer,
+                vren::camera const& camera,
+                float attenuation_threshold
+            );
+
             void operator()(
                 VkCommandBuffer command_buffer,
                 vren::resource_container& resource_container,
                 vren::light_array const& light_array,
                 vren::vk_utils::buffer const& view_space_point_light_position_buffer,
                 vren::camera const& camera,
+                float attenuation_threshold,
                 vren::vk_utils::buffer const& bvh_buffer,
                 vren::vk_utils::buffer const& point_light_index_buffer
             );
         };
 
+        // ------------------------------------------------------------------------------------------------
+        // Cluster grid
+        // ------------------------------------------------------------------------------------------------
+
+        /// The clusters are the screen tiles split in exponential depth slices and normal cones. The grid is baked in the pipelines.
+        struct cluster_grid
+        {
+            uint32_t m_tile_size = 32;           // The tile side in pixels, a tile is a workgroup of find_unique_cluster_list: 8, 16 or 32
+            uint32_t m_depth_slice_count = 1024; // The depth slices between the camera near and far planes, at most 65536
+            uint32_t m_normal_bits = 6;          // The bits of the normal cone index, between 3 and 12, or 0 to ignore the normals
+        };
+
+        /** The cluster key packs, from the lowest bits, the tile coordinates, the depth slice and the normal cone index. The fields
+         * are sized for the tile count of the max screen, the keys are 64-bit if they don't fit in 32 bits (then the temporal
+         * cluster reuse isn't available, the cluster hash table holds 32-bit keys).
+         */
+        struct cluster_key_layout
+        {
+            glm::uvec2 m_max_screen;
+
+            uint32_t m_tile_size;
+            uint32_t m_depth_slice_count;
+            uint32_t m_normal_grid_size; // The normal cones are a grid of this size on every cube face
+
+            uint32_t m_x_bits;
+            uint32_t m_y_bits;
+            uint32_t m_z_bits;
+            uint32_t m_normal_bits;
+
+            inline uint32_t get_bit_count() const
+            {
+                return m_x_bits + m_y_bits + m_z_bits + m_normal_bits;
+            }
+
+            inline bool is_64_bit() const
+            {
+                return get_bit_count() > 32;
+            }
+
+            inline size_t get_key_size() const
+            {
+                return is_64_bit() ? sizeof(uint64_t) : sizeof(uint32_t);
+            }
+
+            inline uint32_t get_normal_cone_count() const
+            {
+                return m_normal_bits > 0 ? 6 * m_normal_grid_size * m_normal_grid_size : 1;
+            }
+
+            inline glm::uvec2 get_tile_count(glm::uvec2 const& screen) const
+            {
+                return glm::uvec2(vren::divide_and_ceil(screen.x, m_tile_size), vren::divide_and_ceil(screen.y, m_tile_size));
+            }
+        };
+
+        /// Sizes the cluster key fields for the max screen, throws if the cluster grid is invalid.
+        vren::clustered_shading::cluster_key_layout make_cluster_key_layout(
+            vren::clustered_shading::cluster_grid const& cluster_grid,
+            glm::uvec2 const& max_screen = glm::uvec2(VREN_MAX_SCREEN_WIDTH, VREN_MAX_SCREEN_HEIGHT)
+        );
+
+        /// Sets the cluster grid specialization constants the shader declares (see VREN_CLUSTERED_SHADING_CLUSTER_GRID in clustered_shading.glsl).
+        void specialize_cluster_key_layout(vren::specialized_shader& shader, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+
+        /// Matches ClusterStatistics in clustered_shading.glsl.
+        struct cluster_statistics
+        {
+            uint32_t m_cluster_count;
+            uint32_t m_assigned_light_count;
+            uint32_t m_max_cluster_light_count;
+            uint32_t _pad;
+            uint32_t m_light_count_histogram[VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE]; // See VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE for the buckets
+        };
+
+        // ------------------------------------------------------------------------------------------------
+        // Temporal cluster reuse
+        // ------------------------------------------------------------------------------------------------
+
+        /// Matches TemporalClusterStatistics in clustered_shading.glsl.
+        struct temporal_cluster_statistics
+        {
+            uint32_t m_changed_tile_count;
+            uint32_t m_inserted_cluster_count;
+            uint32_t m_reused_cluster_count;
+            uint32_t m_assigned_cluster_count;
+            uint32_t m_assigned_light_allocator_end;
+            uint32_t _pad[3];
+        };
+
+        /** The persistent state of the temporal variants of find_unique_cluster_list and assign_lights. The cluster keys are hashed
+         * in a table that outlives the frame: the tiles whose cluster keys didn't change skip the sort, and the clusters whose light
+         * list was assigned in the current light epoch aren't assigned again.
+         */
+        struct temporal_cluster_params
+        {
+            vren::vk_utils::buffer const* m_cluster_hash_table_buffer;
+            vren::vk_utils::buffer const* m_tile_signature_buffer;
+            vren::vk_utils::buffer const* m_statistics_buffer;
+            uint32_t m_frame_stamp;
+            uint32_t m_light_epoch;
+            bool m_reset_assigned_light_allocator; // Only when the light epoch changed, otherwise the new clusters are appended
+        };
+
         // ------------------------------------------------------------------------------------------------
         // find_unique_cluster_list
         // ------------------------------------------------------------------------------------------------
@@ -53,11 +191,20 @@ namespace vren
         {
         private:
             vren::context const* m_context;
+            vren::clustered_shading::cluster_key_layout m_cluster_key_layout;
 
             vren::pipeline m_pipeline;
+            vren::pipeline m_temporal_pipeline; // Never used with 64-bit keys
 
         public:
-            find_unique_cluster_list(vren::context const& context);
+            static vren::pipeline_futures<2> create_pipelines(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+
+            find_unique_cluster_list(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+            find_unique_cluster_list(
+                vren::context const& context,
+                vren::clustered_shading::cluster_key_layout const& cluster_key_layout,
+                vren::pipeline_futures<2> pipelines
+            );
 
             void operator()(
                 uint32_t frame_idx,
@@ -69,7 +216,8 @@ namespace vren
                 vren::vk_utils::depth_buffer_t const& depth_buffer,
                 vren::vk_utils::buffer const& cluster_key_buffer,
                 vren::vk_utils::buffer const& allocation_index_buffer,
-                vren::vk_utils::combined_image_view const& cluster_reference_buffer
+                vren::vk_utils::combined_image_view const& cluster_reference_buffer,
+                vren::clustered_shading::temporal_cluster_params const* temporal_params = nullptr // The cluster keys are the hash table slots if set
             );
         };
 
@@ -81,12 +229,20 @@ namespace vren
         {
         private:
             vren::context const* m_context;
+            vren::clustered_shading::cluster_key_layout m_cluster_key_layout;
 
-            vren::pipeline m_count_pipeline;
-            vren::pipeline m_write_pipeline;
+            vren::pipeline m_pipeline;
+            vren::pipeline m_temporal_pipeline; // Never used with 64-bit keys
 
         public:
-            assign_lights(vren::context const& context);
+            static vren::pipeline_futures<2> create_pipelines(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+
+            assign_lights(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+            assign_lights(
+                vren::context const& context,
+                vren::clustered_shading::cluster_key_layout const& cluster_key_layout,
+                vren::pipeline_futures<2> pipelines
+            );
 
             void operator()(
                 uint32_t frame_idx,
@@ -103,7 +259,82 @@ namespace vren
                 vren::vk_utils::buffer const& assigned_light_indices_buffer,
                 vren::vk_utils::buffer const& assigned_light_counts_buffer,
                 vren::vk_utils::buffer const& assigned_light_offsets_buffer,
-                vren::vk_utils::buffer const& view_space_point_light_position_buffer
+                vren::vk_utils::buffer const& assigned_light_allocator_buffer, // A single uint32_t, the next free assigned light index
+                vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+                uint32_t spot_light_count,
+                vren::vk_utils::buffer const& view_space_spot_light_buffer, // The spot lights are appended to the light lists of the clusters
+                vren::vk_utils::buffer const& cluster_statistics_buffer, // A vren::clustered_shading::cluster_statistics, must be zero
+                vren::clustered_shading::temporal_cluster_params const* temporal_params = nullptr
+            );
+        };
+
+        // ------------------------------------------------------------------------------------------------
+        // bin_lights
+        // ------------------------------------------------------------------------------------------------
+
+        /** Bins the point lights in a fixed grid of froxels (tiles of VREN_FROXEL_TILE_SIZE pixels and VREN_FROXEL_DEPTH_SLICE_COUNT
+         * exponential depth slices), writing for every froxel a bitmask of VREN_FROXEL_LIGHT_WORD_COUNT words. A single pass, meant
+         * for point light counts up to VREN_FROXEL_MAX_LIGHT_COUNT.
+         */
+        class bin_lights
+        {
+        private:
+            vren::context const* m_context;
+
+            vren::pipeline m_pipeline;
+
+        public:
+            static vren::pipeline_future create_pipeline(vren::context const& context);
+
+            bin_lights(vren::context const& context);
+            bin_lights(vren::context const& context, vren::pipeline_future pipeline);
+
+            static size_t get_required_froxel_light_bitmask_buffer_size(glm::uvec2 const& screen);
+
+            void operator()(
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                glm::uvec2 const& screen,
+                vren::camera const& camera,
+                uint32_t point_light_count,
+                vren::vk_utils::buffer const& view_space_point_light_position_buffer,
+                vren::vk_utils::buffer const& froxel_light_bitmask_buffer
+            );
+        };
+
+        // ------------------------------------------------------------------------------------------------
+        // bin_pixels_by_material
+        // ------------------------------------------------------------------------------------------------
+
+        /** Sorts the pixels by material index (bucket sort), the background pixels last. Shading the sorted pixels a subgroup
+         * mostly shades a single material, at the cost of a lower cluster coherence.
+         */
+        class bin_pixels_by_material
+        {
+        private:
+            vren::context const* m_context;
+
+            vren::pipeline m_pipeline;
+
+        public:
+            static vren::pipeline_future create_pipeline(vren::context const& context);
+
+            bin_pixels_by_material(vren::context const& context);
+            bin_pixels_by_material(vren::context const& context, vren::pipeline_future pipeline);
+
+            static size_t get_required_pixel_material_buffer_size(glm::uvec2 const& screen);
+
+            static VkBufferUsageFlags get_required_material_sorted_pixel_buffer_usage_flags();
+            static size_t get_required_material_sorted_pixel_buffer_size(glm::uvec2 const& screen);
+
+            void operator()(
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                glm::uvec2 const& screen,
+                vren::gbuffer const& gbuffer,
+                vren::vk_utils::depth_buffer_t const& depth_buffer,
+                vren::vk_utils::buffer const& pixel_material_buffer,
+                vren::vk_utils::buffer const& material_sorted_pixel_buffer
             );
         };
 
@@ -117,10 +348,41 @@ namespace vren
             vren::context const* m_context;
 
             vren::pipeline m_pipeline;
+            vren::pipeline m_froxel_pipeline;
+            vren::pipeline m_material_sorted_pipeline;
+            vren::pipeline m_shared_lights_pipeline;
+
+            std::vector<vren::shader_watch> m_shader_watches; // Empty unless the shader hot reload is enabled
 
         public:
+            static vren::pipeline_futures<4> create_pipelines(vren::context const& context);
+
             shade(vren::context const& context);
+            shade(vren::context const& context, vren::pipeline_futures<4> pipelines);
+            shade(vren::clustered_shading::shade&& other) = delete; // The watched pipelines are referenced by address
+
+        private:
+            void dispatch(
+                vren::pipeline const& pipeline,
+                uint32_t frame_idx,
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                glm::uvec2 const& screen,
+                vren::camera const& camera,
+                vren::gbuffer const& gbuffer,
+                vren::vk_utils::depth_buffer_t const& depth_buffer,
+                std::function<void(VkDescriptorSet descriptor_set)> const& write_light_binning_descriptor_set,
+                vren::light_array const& light_array,
+                vren::material_buffer const& material_buffer,
+                vren::cascaded_shadow_map const& shadow_map,
+                uint32_t shadow_cascade_count,
+                float attenuation_threshold, // The light radii are derived from the intensities (see vren::calc_point_light_radius)
+                vren::vk_utils::combined_image_view const& output,
+                vren::vk_utils::buffer const* material_sorted_pixel_buffer
+            );
 
+        public:
+            /// Shades using the lights assigned to the clusters.
             void operator()(
                 uint32_t frame_idx,
                 VkCommandBuffer command_buffer,
@@ -135,11 +397,45 @@ namespace vren
                 vren::vk_utils::buffer const& assigned_light_offsets_buffer,
                 vren::light_array const& light_array,
                 vren::material_buffer const& material_buffer,
+                vren::cascaded_shadow_map const& shadow_map,
+                uint32_t shadow_cascade_count,
+                float attenuation_threshold,
+                vren::vk_utils::combined_image_view const& output,
+                vren::vk_utils::buffer const* material_sorted_pixel_buffer = nullptr, // If set, the pixels are shaded in this order (see bin_pixels_by_material)
+                bool shared_light_prefetch = false // Not with material_sorted_pixel_buffer, see cluster_and_shade::m_shared_light_prefetch
+            );
+
+            /// Shades using the light bitmasks of the froxels.
+            void operator()(
+                uint32_t frame_idx,
+                VkCommandBuffer command_buffer,
+                vren::resource_container& resource_container,
+                glm::uvec2 const& screen,
+                vren::camera const& camera,
+                vren::gbuffer const& gbuffer,
+                vren::vk_utils::depth_buffer_t const& depth_buffer,
+                vren::vk_utils::buffer const& froxel_light_bitmask_buffer,
+                vren::light_array const& light_array,
+                vren::material_buffer const& material_buffer,
+                vren::cascaded_shadow_map const& shadow_map,
+                uint32_t shadow_cascade_count,
+                float attenuation_threshold,
                 vren::vk_utils::combined_image_view const& output
             );
         };
     }
 
+    // ------------------------------------------------------------------------------------------------
+    // Light binning mode
+    // ------------------------------------------------------------------------------------------------
+
+    enum light_binning_mode
+    {
+        LightBinningModeAuto = 0,
+        LightBinningModeClusters, // Cluster keys sort and compaction, light BVH, per-cluster light lists
+        LightBinningModeFroxels,  // Fixed froxel grid with per-froxel light bitmasks (at most VREN_FROXEL_MAX_LIGHT_COUNT point lights)
+    };
+
     // ------------------------------------------------------------------------------------------------
     // cluster_and_shade
     // ------------------------------------------------------------------------------------------------
@@ -148,16 +444,30 @@ namespace vren
     {
     private:
         vren::context const* m_context;
+        vren::clustered_shading::cluster_key_layout m_cluster_key_layout;
 
     public:
         vren::clustered_shading::construct_point_light_bvh m_construct_point_light_bvh;
         vren::clustered_shading::find_unique_cluster_list m_find_unique_cluster_list;
         vren::clustered_shading::assign_lights m_assign_lights;
+        vren::clustered_shading::bin_lights m_bin_lights;
+        vren::clustered_shading::bin_pixels_by_material m_bin_pixels_by_material;
         vren::clustered_shading::shade m_shade;
 
+        /// With LightBinningModeAuto the froxels are used below this point light count, where the clusters setup costs more than it saves.
+        vren::light_binning_mode m_light_binning_mode = vren::LightBinningModeAuto;
+        uint32_t m_froxel_max_point_light_count = VREN_FROXEL_MAX_LIGHT_COUNT;
+
+        /// The first directional light is shadowed by the cascaded shadow map.
+        bool m_directional_light_shadows = true;
+
+        /// The light intensity under which a point light doesn't contribute anymore, determines the point light radius.
+        float m_light_attenuation_threshold = vren::k_default_light_attenuation_threshold;
+
         vren::vk_utils::buffer m_view_space_point_light_position_buffer;
         vren::vk_utils::buffer m_point_light_bvh_buffer;
         vren::vk_utils::buffer m_point_light_index_buffer;
+        vren::vk_utils::buffer m_view_space_spot_light_buffer;
 
         vren::vk_utils::buffer m_cluster_key_buffer;
         vren::vk_utils::buffer m_cluster_key_dispatch_params_buffer; // TODO : Find a better name for this (like dispatch params buffer or something)
@@ -166,8 +476,107 @@ namespace vren
         vren::vk_utils::buffer m_assigned_light_indices_buffer;
         vren::vk_utils::buffer m_assigned_light_counts_buffer;
         vren::vk_utils::buffer m_assigned_light_offsets_buffer;
+        vren::vk_utils::buffer m_assigned_light_allocator_buffer;
+
+        vren::vk_utils::buffer m_froxel_light_bitmask_buffer;
+
+        /// Shades the pixels sorted by material (only for LightBinningModeClusters), see bin_pixels_by_material.
+        bool m_material_sorted_shading = false;
+
+        vren::vk_utils::buffer m_pixel_material_buffer;
+        vren::vk_utils::buffer m_material_sorted_pixel_buffer;
+
+        /// The pixels of a shading workgroup that share a cluster read its light list once: the lights are packed to 16 bytes of halfs in
+        /// shared memory (only for LightBinningModeClusters, ignored with m_material_sorted_shading). Meant for long light lists, the
+        /// workgroup synchronizes once per cluster it covers. The gain over shade.comp wasn't measured yet, hence it's off by default.
+        bool m_shared_light_prefetch = false;
+
+        /// The statistics of the clusters of the last completed frame that used LightBinningModeClusters (none if there was no light).
+        std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_cluster_statistics_buffers;
+        vren::clustered_shading::cluster_statistics m_cluster_statistics{};
+        uint32_t m_cluster_statistics_tile_count = 0;
+
+        /// Keeps the clusters in a persistent hash table across frames (only for LightBinningModeClusters and 32-bit cluster keys): the
+        /// unchanged tiles aren't sorted again and the light lists are reused until the camera or the lights change.
+        bool m_temporal_cluster_reuse = false;
+
+        vren::vk_utils::buffer m_cluster_hash_table_buffer;
+        vren::vk_utils::buffer m_tile_signature_buffer;
+        std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_temporal_cluster_statistics_buffers;
+
+        /// The statistics of the last completed frame that used the temporal cluster reuse.
+        vren::clustered_shading::temporal_cluster_statistics m_temporal_cluster_statistics{};
+        uint32_t m_temporal_cluster_tile_count = 0;
+
+    private:
+        std::array<bool, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_cluster_statistics_pending{};
+        std::array<bool, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_temporal_cluster_statistics_pending{};
+
+        uint32_t m_frame_stamp = 0;
+        uint32_t m_light_epoch = 0;
+        uint32_t m_cluster_hash_table_occupancy = 0;
+        bool m_clear_cluster_hash_table = true;
+        bool m_invalidate_light_assignments = true;
+
+        glm::mat4 m_last_camera_view{};
+        glm::mat4 m_last_camera_projection{};
+        glm::uvec2 m_last_screen{};
+        uint32_t m_last_point_light_count = 0;
+        uint32_t m_last_spot_light_count = 0;
+        float m_last_light_attenuation_threshold = 0.0f;
+
+        /// The pipelines of all the steps, submitted together to the pipeline builder.
+        struct step_pipelines
+        {
+            vren::clustered_shading::cluster_key_layout m_cluster_key_layout;
+
+            vren::pipeline_futures<4> m_construct_point_light_bvh;
+            vren::pipeline_futures<2> m_find_unique_cluster_list;
+            vren::pipeline_futures<2> m_assign_lights;
+            vren::pipeline_future m_bin_lights;
+            vren::pipeline_future m_bin_pixels_by_material;
+            vren::pipeline_futures<4> m_shade;
+        };
+
+        static step_pipelines create_pipelines(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
+
+        cluster_and_shade(vren::context const& context, step_pipelines pipelines);
+
+        /// Reads back the cluster statistics of the last completed use of the frame and clears them.
+        void prepare_cluster_statistics(uint32_t frame_idx, VkCommandBuffer command_buffer, glm::uvec2 const& screen);
+
+        /// Reads back the statistics, clears the hash table and bumps the light epoch when needed.
+        vren::clustered_shading::temporal_cluster_params prepare_temporal_cluster_params(
+            uint32_t frame_idx,
+            VkCommandBuffer command_buffer,
+            glm::uvec2 const& screen,
+            vren::camera const& camera,
+            uint32_t point_light_count,
+            uint32_t spot_light_count
+        );
+
+    public:
+        explicit cluster_and_shade(vren::context const& context, vren::clustered_shading::cluster_grid const& cluster_grid = {});
+
+        inline vren::clustered_shading::cluster_key_layout const& get_cluster_key_layout() const
+        {
+            return m_cluster_key_layout;
+        }
+
+        /// The fraction of the clusters of the grid that were found on screen, in the last statistics.
+        float get_cluster_occupancy() const;
+
+        /// The mean light count of the clusters found on screen, in the last statistics.
+        float get_average_cluster_light_count() const;
+
+        /// The mode actually used for the given point light count (never LightBinningModeAuto).
+        vren::light_binning_mode select_light_binning_mode(uint32_t point_light_count) const;
+
+        /// Must be called when the point lights or the spot lights are modified: the light lists of the temporal cluster reuse are assigned again.
+        void invalidate_light_assignments();
 
-        cluster_and_shade(vren::context const& context);
+        /// The fraction of the clusters seen in the last temporal frame whose light list was reused.
+        float get_temporal_cluster_reuse_hit_rate() const;
 
         vren::render_graph_t operator()(
             vren::render_graph_allocator& allocator,
@@ -177,6 +586,7 @@ namespace vren
             vren::vk_utils::depth_buffer_t const& depth_buffer,
             vren::light_array const& light_array,
             vren::material_buffer const& material_buffer,
+            vren::cascaded_shadow_map const& shadow_map,
             vren::vk_utils::combined_image_view const& output
         );
     };
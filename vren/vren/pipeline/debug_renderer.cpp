@@ -8,6 +8,8 @@
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/misc.hpp"
 #include "vk_helpers/debug_utils.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
+#include "context.hpp"
 
 // --------------------------------------------------------------------------------------------------------------------------------
 // debug_renderer_draw_buffer
@@ -123,16 +125,28 @@ void vren::debug_renderer_draw_buffer::add_cubes(vren::debug_renderer_cube const
 // debug_renderer
 // --------------------------------------------------------------------------------------------------------------------------------
 
+vren::pipeline_futures<2> vren::debug_renderer::create_pipelines(vren::context const& context)
+{
+	return {
+		context.m_pipeline_builder->submit([&context]() { return create_graphics_pipeline(context, /* depth_test */ true); }),
+		context.m_pipeline_builder->submit([&context]() { return create_graphics_pipeline(context, false); })
+	};
+}
+
 vren::debug_renderer::debug_renderer(vren::context const& ctx) :
+	debug_renderer(ctx, create_pipelines(ctx))
+{}
+
+vren::debug_renderer::debug_renderer(vren::context const& ctx, vren::pipeline_futures<2> pipelines) :
 	m_context(&ctx),
-	m_pipeline(create_graphics_pipeline(/* depth_test */ true)),
-	m_no_depth_test_pipeline(create_graphics_pipeline(false))
+	m_pipeline(pipelines[0].get()),
+	m_no_depth_test_pipeline(pipelines[1].get())
 {
 	vren::vk_utils::set_name(*m_context, m_pipeline, "debug_renderer_pipeline");
 	vren::vk_utils::set_name(*m_context, m_no_depth_test_pipeline, "debug_renderer_no_depth_test_pipeline");
 }
 
-vren::pipeline vren::debug_renderer::create_graphics_pipeline(bool depth_test)
+vren::pipeline vren::debug_renderer::create_graphics_pipeline(vren::context const& context, bool depth_test)
 {
 	VkVertexInputBindingDescription vtx_bindings[]{
 		{ .binding = 0, .stride = sizeof(vren::debug_renderer_vertex), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX, }, // Vertex buffer
@@ -259,8 +273,8 @@ vren::pipeline vren::debug_renderer::create_graphics_pipeline(bool depth_test)
 	};
 
 	//
-	vren::shader_module vert_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/debug_draw.vert.spv");
-	vren::shader_module frag_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/debug_draw.frag.spv");
+	vren::shader_module vert_shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/debug_draw.vert.spv");
+	vren::shader_module frag_shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/debug_draw.frag.spv");
 
 	vren::specialized_shader vert_shader = vren::specialized_shader(vert_shader_mod, "main");
 	vren::specialized_shader frag_shader = vren::specialized_shader(frag_shader_mod, "main");
@@ -271,7 +285,7 @@ vren::pipeline vren::debug_renderer::create_graphics_pipeline(bool depth_test)
 	};
 
 	return vren::create_graphics_pipeline(
-		*m_context,
+		context,
 		shaders,
 		&vtx_input_info,
 		&input_assembly_info,
@@ -300,6 +314,7 @@ vren::render_graph_t vren::debug_renderer::render(
 	node->set_name("debug_renderer | render");
 	node->set_src_stage(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 	node->set_dst_stage(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT);
+	node->set_parallel_recording(true);
 	node->add_buffer({
 		.m_name = "debug_draw_buffer",
 		.m_buffer = draw_buffer.m_vertex_buffer.m_buffer->m_buffer.m_handle,
@@ -120,10 +120,13 @@ namespace vren
 
 
 	public:
+		static vren::pipeline_futures<2> create_pipelines(vren::context const& context);
+
 		explicit debug_renderer(vren::context const& context);
+		debug_renderer(vren::context const& context, vren::pipeline_futures<2> pipelines);
 
 	private:
-		vren::pipeline create_graphics_pipeline(bool depth_test);
+		static vren::pipeline create_graphics_pipeline(vren::context const& context, bool depth_test);
 
 	public:
 		vren::render_graph_t render(
@@ -171,27 +171,39 @@ void vren::depth_buffer_pyramid::add_render_graph_node_resources(vren::render_gr
 // depth_buffer_reductor
 // --------------------------------------------------------------------------------------------------------------------------------
 
+vren::pipeline_futures<2> vren::depth_buffer_reductor::create_pipelines(vren::context const& context)
+{
+	return {
+		context.m_pipeline_builder->submit([&context]() { return create_copy_pipeline(context); }),
+		context.m_pipeline_builder->submit([&context]() { return create_reduce_pipeline(context); })
+	};
+}
+
 vren::depth_buffer_reductor::depth_buffer_reductor(vren::context const& context) :
+	depth_buffer_reductor(context, create_pipelines(context))
+{}
+
+vren::depth_buffer_reductor::depth_buffer_reductor(vren::context const& context, vren::pipeline_futures<2> pipelines) :
 	m_context(&context),
-	m_copy_pipeline(create_copy_pipeline()),
-	m_reduce_pipeline(create_reduce_pipeline()),
+	m_copy_pipeline(pipelines[0].get()),
+	m_reduce_pipeline(pipelines[1].get()),
 	m_depth_buffer_sampler(create_depth_buffer_sampler())
 {}
 
-vren::pipeline vren::depth_buffer_reductor::create_copy_pipeline()
+vren::pipeline vren::depth_buffer_reductor::create_copy_pipeline(vren::context const& context)
 {
-	vren::shader_module shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/depth_buffer_copy.comp.spv");
+	vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/depth_buffer_copy.comp.spv");
 	vren::specialized_shader shader = vren::specialized_shader(shader_mod, "main");
 
-	return vren::create_compute_pipeline(*m_context, shader);
+	return vren::create_compute_pipeline(context, shader);
 }
 
-vren::pipeline vren::depth_buffer_reductor::create_reduce_pipeline()
+vren::pipeline vren::depth_buffer_reductor::create_reduce_pipeline(vren::context const& context)
 {
-	vren::shader_module shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/depth_buffer_reduce.comp.spv");
+	vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/depth_buffer_reduce.comp.spv");
 	vren::specialized_shader shader = vren::specialized_shader(shader_mod, "main");
 
-	return vren::create_compute_pipeline(*m_context, shader);
+	return vren::create_compute_pipeline(context, shader);
 }
 
 vren::vk_sampler vren::depth_buffer_reductor::create_depth_buffer_sampler()
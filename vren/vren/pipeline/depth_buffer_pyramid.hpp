@@ -4,6 +4,7 @@
 
 #include "pipeline/render_graph.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 #include "vk_helpers/image.hpp"
 
 namespace vren
@@ -100,11 +101,14 @@ namespace vren
 		vren::vk_sampler m_depth_buffer_sampler; // Used to copy the depth buffer in a depth image format (D32 sfloat) to a color image format (R32 sfloat)
 
 	public:
+		static vren::pipeline_futures<2> create_pipelines(vren::context const& context);
+
 		depth_buffer_reductor(vren::context const& context);
+		depth_buffer_reductor(vren::context const& context, vren::pipeline_futures<2> pipelines);
 
 	private:
-		vren::pipeline create_copy_pipeline();
-		vren::pipeline create_reduce_pipeline();
+		static vren::pipeline create_copy_pipeline(vren::context const& context);
+		static vren::pipeline create_reduce_pipeline(vren::context const& context);
 		vren::vk_sampler create_depth_buffer_sampler();
 
 	public:
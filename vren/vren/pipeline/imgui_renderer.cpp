@@ -36,7 +36,7 @@ vren::imgui_renderer::imgui_renderer(vren::context const& context, imgui_windowi
 	init_info.Device = context.m_device;
 	init_info.QueueFamily = context.m_queue_families.m_graphics_idx;
 	init_info.Queue = context.m_graphics_queue;
-	init_info.PipelineCache = nullptr;
+	init_info.PipelineCache = context.m_pipeline_cache;
 	init_info.DescriptorPool = m_descriptor_pool.m_handle;
 	init_info.Subpass = 0;
 	init_info.MinImageCount = 3; // Why do you need to know about image count here, dear imgui vulkan backend...?
@@ -0,0 +1,321 @@
+#include "light_simulation.hpp"
+
+#include <cstddef>
+#include <initializer_list>
+
+#include "context.hpp"
+#include "toolbox.hpp"
+#include "base/base.hpp"
+#include "vk_helpers/misc.hpp"
+#include "vk_helpers/debug_utils.hpp"
+
+void light_simulation_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags src_stage_mask, VkAccessFlags src_access_mask)
+{
+	VkMemoryBarrier memory_barrier{
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = src_access_mask,
+		.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT
+	};
+	vkCmdPipelineBarrier(
+		command_buffer,
+		src_stage_mask,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		NULL,
+		1, &memory_barrier,
+		0, nullptr,
+		0, nullptr
+	);
+}
+
+vren::light_simulation::light_simulation(vren::context const& context, uint32_t capacity, uint32_t first_point_light) :
+	m_context(&context),
+	m_first_point_light(first_point_light),
+	m_capacity(capacity),
+	m_reset_pipeline(create_pipeline(".vren/resources/shaders/light_simulation/reset_light_simulation.comp.spv")),
+	m_spawn_pipeline(create_pipeline(".vren/resources/shaders/light_simulation/spawn_lights.comp.spv")),
+	m_prepare_pipeline(create_pipeline(".vren/resources/shaders/light_simulation/prepare_light_simulation.comp.spv")),
+	m_simulate_pipeline(create_pipeline(".vren/resources/shaders/light_simulation/simulate_lights.comp.spv")),
+	m_clear_dead_lights_pipeline(create_pipeline(".vren/resources/shaders/light_simulation/clear_dead_lights.comp.spv")),
+	m_state_buffer(vren::vk_utils::alloc_device_only_buffer(
+		context,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		sizeof(vren::light_simulation_state)
+	)),
+	m_particle_buffer(vren::vk_utils::alloc_device_only_buffer(context, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, capacity * sizeof(vren::light_particle))),
+	m_dead_list_buffer(vren::vk_utils::alloc_device_only_buffer(context, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, capacity * sizeof(uint32_t))),
+	m_alive_list_buffers(vren::create_array<vren::vk_utils::buffer, 2>([&](uint32_t index)
+	{
+		return vren::vk_utils::alloc_device_only_buffer(context, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, capacity * sizeof(uint32_t));
+	})),
+	m_alive_count_readback_buffers(vren::create_array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index)
+	{
+		return vren::vk_utils::alloc_host_only_buffer(context, VK_BUFFER_USAGE_TRANSFER_DST_BIT, sizeof(uint32_t), true);
+	}))
+{
+	assert(capacity > 0);
+	assert(first_point_light + capacity <= VREN_MAX_POINT_LIGHT_COUNT);
+
+	vren::vk_utils::set_name(context, m_state_buffer, "light_simulation_state_buffer");
+	vren::vk_utils::set_name(context, m_particle_buffer, "light_simulation_particle_buffer");
+	vren::vk_utils::set_name(context, m_dead_list_buffer, "light_simulation_dead_list_buffer");
+	vren::vk_utils::set_name(context, m_alive_list_buffers[0], "light_simulation_alive_list_buffer_0");
+	vren::vk_utils::set_name(context, m_alive_list_buffers[1], "light_simulation_alive_list_buffer_1");
+}
+
+vren::pipeline vren::light_simulation::create_pipeline(char const* shader_path)
+{
+	vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, shader_path);
+	vren::specialized_shader shader = vren::specialized_shader(shader_module);
+	return vren::create_compute_pipeline(*m_context, shader);
+}
+
+void vren::light_simulation::emit(vren::light_emitter const& emitter, uint32_t count)
+{
+	if (count > 0)
+	{
+		m_pending_emissions.emplace_back(emitter, count);
+	}
+}
+
+void vren::light_simulation::clear()
+{
+	m_reset_pending = true;
+	m_pending_emissions.clear();
+}
+
+vren::render_graph_t vren::light_simulation::operator()(
+	vren::render_graph_allocator& render_graph_allocator,
+	uint32_t frame_idx,
+	vren::light_array& light_array,
+	float dt
+)
+{
+	assert(light_array.m_point_light_count <= m_first_point_light);
+
+	// The alive count of the last step recorded for this frame, the frame has completed
+	uint32_t alive_count = 0;
+
+	vren::vk_utils::buffer& alive_count_readback_buffer = m_alive_count_readback_buffers.at(frame_idx);
+	if (m_alive_count_readback_pending.at(frame_idx))
+	{
+		vmaInvalidateAllocation(m_context->m_vma_allocator, alive_count_readback_buffer.m_allocation.m_handle, 0, VK_WHOLE_SIZE);
+		alive_count = *alive_count_readback_buffer.get_mapped_pointer<uint32_t>();
+	}
+
+	// Only the emissions increase the alive count. A reset doesn't lower the bound: the lights written by the previous steps
+	// must be turned off
+	uint32_t emitted_count = 0;
+	for (auto const& [emitter, count] : m_pending_emissions)
+	{
+		emitted_count += glm::min(count, m_capacity - glm::min(emitted_count, m_capacity));
+	}
+	m_emitted_counts.at(frame_idx) = emitted_count;
+
+	uint64_t point_light_bound = alive_count;
+	for (uint32_t count : m_emitted_counts)
+	{
+		point_light_bound += count;
+	}
+
+	m_point_light_bound = (uint32_t) glm::min<uint64_t>(point_light_bound, m_capacity);
+	light_array.m_point_light_count = m_first_point_light + m_point_light_bound;
+
+	// Record
+	vren::render_graph_node* node = render_graph_allocator.allocate();
+
+	node->set_name("light_simulation");
+
+	node->set_src_stage(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+	node->set_dst_stage(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	node->add_buffer({ .m_name = "point_light_position_buffer", .m_buffer = light_array.m_point_light_position_buffer.m_buffer.m_handle }, VK_ACCESS_SHADER_WRITE_BIT);
+	node->add_buffer({ .m_name = "point_light_buffer", .m_buffer = light_array.m_point_light_buffer.m_buffer.m_handle }, VK_ACCESS_SHADER_WRITE_BIT);
+
+	node->set_callback([
+		this,
+		&light_array,
+		alive_list_idx = m_alive_list_idx,
+		point_light_bound = m_point_light_bound,
+		reset = m_reset_pending,
+		emissions = std::move(m_pending_emissions),
+		seed = m_seed,
+		dt
+	](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		uint32_t next_alive_list_idx = 1 - alive_list_idx;
+
+		VkBuffer state_buffer = m_state_buffer.m_buffer.m_handle;
+		VkBuffer particle_buffer = m_particle_buffer.m_buffer.m_handle;
+		VkBuffer dead_list_buffer = m_dead_list_buffer.m_buffer.m_handle;
+		VkBuffer alive_list_buffer = m_alive_list_buffers.at(alive_list_idx).m_buffer.m_handle;
+		VkBuffer next_alive_list_buffer = m_alive_list_buffers.at(next_alive_list_idx).m_buffer.m_handle;
+		VkBuffer point_light_position_buffer = light_array.m_point_light_position_buffer.m_buffer.m_handle;
+		VkBuffer point_light_buffer = light_array.m_point_light_buffer.m_buffer.m_handle;
+
+		// Binds the pipeline and the given buffers, at the binding given by their index (VK_NULL_HANDLE for the bindings not used)
+		auto bind = [&](vren::pipeline const& pipeline, std::initializer_list<VkBuffer> buffers)
+		{
+			pipeline.bind(command_buffer);
+			pipeline.acquire_and_bind_descriptor_set(*m_context, command_buffer, resource_container, 0, [&](VkDescriptorSet descriptor_set)
+			{
+				uint32_t binding = 0;
+				for (VkBuffer buffer : buffers)
+				{
+					if (buffer != VK_NULL_HANDLE)
+					{
+						vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, binding, buffer, VK_WHOLE_SIZE, 0);
+					}
+					binding++;
+				}
+			});
+		};
+
+		// The state was written by the steps of the previous frames
+		light_simulation_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		// Reset
+		if (reset)
+		{
+			bind(m_reset_pipeline, { state_buffer, VK_NULL_HANDLE, dead_list_buffer });
+			m_reset_pipeline.dispatch(command_buffer, vren::divide_and_ceil(m_capacity, k_workgroup_size), 1, 1);
+
+			light_simulation_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		// Spawn (every emission consumes the dead list atomically, they're serialized)
+		uint32_t emission_idx = 0;
+		for (auto const& [emitter, count] : emissions)
+		{
+			struct
+			{
+				glm::vec3 m_position; uint32_t m_spawn_count;
+				glm::vec3 m_extent; uint32_t m_seed;
+				glm::vec3 m_direction; float m_cos_spread;
+				glm::vec3 m_color; float m_color_variation;
+				float m_min_speed;
+				float m_max_speed;
+				float m_intensity;
+				float m_lifetime;
+				float m_lifetime_variation;
+				uint32_t m_alive_list_idx;
+				float _pad[2];
+			} push_constants;
+
+			push_constants = {
+				.m_position = emitter.m_position,
+				.m_spawn_count = glm::min(count, m_capacity),
+				.m_extent = emitter.m_extent,
+				.m_seed = seed + emission_idx,
+				.m_direction = glm::normalize(emitter.m_direction),
+				.m_cos_spread = glm::cos(glm::clamp(emitter.m_spread, 0.0f, glm::pi<float>())),
+				.m_color = emitter.m_color,
+				.m_color_variation = emitter.m_color_variation,
+				.m_min_speed = emitter.m_min_speed,
+				.m_max_speed = emitter.m_max_speed,
+				.m_intensity = emitter.m_intensity,
+				.m_lifetime = emitter.m_lifetime,
+				.m_lifetime_variation = glm::clamp(emitter.m_lifetime_variation, 0.0f, 0.999f),
+				.m_alive_list_idx = alive_list_idx,
+			};
+
+			bind(m_spawn_pipeline, { state_buffer, particle_buffer, dead_list_buffer, alive_list_buffer });
+			m_spawn_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+			m_spawn_pipeline.dispatch(command_buffer, vren::divide_and_ceil(push_constants.m_spawn_count, k_workgroup_size), 1, 1);
+
+			light_simulation_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+			emission_idx++;
+		}
+
+		// Prepare the indirect dispatch over the alive particles
+		{
+			struct
+			{
+				uint32_t m_alive_list_idx;
+				float _pad[3];
+			} push_constants;
+
+			push_constants = {
+				.m_alive_list_idx = alive_list_idx,
+			};
+
+			bind(m_prepare_pipeline, { state_buffer });
+			m_prepare_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+			m_prepare_pipeline.dispatch(command_buffer, 1, 1, 1);
+
+			light_simulation_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		// Simulate
+		{
+			struct
+			{
+				glm::vec3 m_acceleration; float m_dt;
+				glm::vec3 m_bounds_min; uint32_t m_bounds_mode;
+				glm::vec3 m_bounds_max; float m_damping;
+				float m_fade_out_time;
+				uint32_t m_first_point_light;
+				uint32_t m_alive_list_idx;
+				float _pad;
+			} push_constants;
+
+			push_constants = {
+				.m_acceleration = m_acceleration,
+				.m_dt = dt,
+				.m_bounds_min = m_bounds_min,
+				.m_bounds_mode = (uint32_t) m_bounds_mode,
+				.m_bounds_max = m_bounds_max,
+				.m_damping = m_damping,
+				.m_fade_out_time = m_fade_out_time,
+				.m_first_point_light = m_first_point_light,
+				.m_alive_list_idx = alive_list_idx,
+			};
+
+			bind(m_simulate_pipeline, { state_buffer, particle_buffer, dead_list_buffer, alive_list_buffer, next_alive_list_buffer, point_light_position_buffer, point_light_buffer });
+			m_simulate_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+			vkCmdDispatchIndirect(command_buffer, m_state_buffer.m_buffer.m_handle, offsetof(vren::light_simulation_state, m_dispatch_params));
+
+			light_simulation_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		}
+
+		// Turn off the lights past the alive ones
+		if (point_light_bound > 0)
+		{
+			struct
+			{
+				uint32_t m_first_point_light;
+				uint32_t m_point_light_bound;
+				uint32_t m_alive_list_idx;
+				float _pad;
+			} push_constants;
+
+			push_constants = {
+				.m_first_point_light = m_first_point_light,
+				.m_point_light_bound = point_light_bound,
+				.m_alive_list_idx = next_alive_list_idx,
+			};
+
+			bind(m_clear_dead_lights_pipeline, { state_buffer, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_NULL_HANDLE, point_light_position_buffer, point_light_buffer });
+			m_clear_dead_lights_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants), 0);
+			m_clear_dead_lights_pipeline.dispatch(command_buffer, vren::divide_and_ceil(point_light_bound, k_workgroup_size), 1, 1);
+		}
+
+		// Read back the alive count to bound the light count of the next use of this frame
+		VkBufferCopy buffer_copy{
+			.srcOffset = offsetof(vren::light_simulation_state, m_alive_counts) + next_alive_list_idx * sizeof(uint32_t),
+			.dstOffset = 0,
+			.size = sizeof(uint32_t)
+		};
+		vkCmdCopyBuffer(command_buffer, m_state_buffer.m_buffer.m_handle, m_alive_count_readback_buffers.at(frame_idx).m_buffer.m_handle, 1, &buffer_copy);
+	});
+
+	m_alive_count_readback_pending.at(frame_idx) = true;
+
+	m_alive_list_idx = 1 - m_alive_list_idx;
+	m_reset_pending = false;
+	m_pending_emissions.clear();
+	m_seed += 0x9e3779b9u;
+
+	return vren::render_graph_gather(node);
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include "config.hpp"
+#include "gpu_repr.hpp"
+#include "light.hpp"
+#include "pipeline/render_graph.hpp"
+#include "vk_helpers/shader.hpp"
+#include "vk_helpers/buffer.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// ------------------------------------------------------------------------------------------------
+	// Light emitter
+	// ------------------------------------------------------------------------------------------------
+
+	/// Describes the lights spawned by vren::light_simulation::emit, every light is randomized on the device.
+	struct light_emitter
+	{
+		glm::vec3 m_position = glm::vec3(0.0f);
+		glm::vec3 m_extent = glm::vec3(0.0f); // The half size of the box the lights are spawned in
+
+		glm::vec3 m_direction = glm::vec3(0.0f, 1.0f, 0.0f);
+		float m_spread = glm::pi<float>(); // The half angle of the cone the lights are shot in, pi shoots them in every direction
+		float m_min_speed = 0.0f;
+		float m_max_speed = 1.0f;
+
+		glm::vec3 m_color = glm::vec3(1.0f);
+		float m_color_variation = 0.0f; // The blend toward a random color
+		float m_intensity = 1.0f;
+
+		float m_lifetime = std::numeric_limits<float>::infinity(); // The lights with an infinite lifetime never die
+		float m_lifetime_variation = 0.0f; // The fraction of the lifetime that is randomly cut, in [0, 1)
+	};
+
+	// ------------------------------------------------------------------------------------------------
+	// Light simulation
+	// ------------------------------------------------------------------------------------------------
+
+	enum light_simulation_bounds_mode
+	{
+		LightSimulationBoundsModeNone = 0,
+		LightSimulationBoundsModeBounce, // The lights bounce on the bounds faces
+		LightSimulationBoundsModeKill,   // The lights leaving the bounds die
+	};
+
+	/** Animates point lights entirely on the device: the lights are particles with a velocity and a lifetime, spawned by
+	 * consuming a dead list and killed by appending to it. The alive particles are written compacted to a range of the point
+	 * lights of a vren::light_array, starting at first_point_light, and the alive count never leaves the device: the simulation
+	 * is an indirect dispatch over it.
+	 *
+	 * The host sizes the light array with an upper bound of the alive count: the count read back from the last completed use of
+	 * the frame plus the lights emitted since then. The lights between the alive count and the bound are turned off.
+	 */
+	class light_simulation
+	{
+	public:
+		static constexpr uint32_t k_workgroup_size = 1024;
+
+	private:
+		vren::context const* m_context;
+
+		uint32_t m_first_point_light;
+		uint32_t m_capacity;
+
+		vren::pipeline m_reset_pipeline;
+		vren::pipeline m_spawn_pipeline;
+		vren::pipeline m_prepare_pipeline;
+		vren::pipeline m_simulate_pipeline;
+		vren::pipeline m_clear_dead_lights_pipeline;
+
+		vren::vk_utils::buffer m_state_buffer;
+		vren::vk_utils::buffer m_particle_buffer;
+		vren::vk_utils::buffer m_dead_list_buffer;
+		std::array<vren::vk_utils::buffer, 2> m_alive_list_buffers;
+		uint32_t m_alive_list_idx = 0;
+
+		std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_alive_count_readback_buffers;
+		std::array<bool, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_alive_count_readback_pending{};
+		std::array<uint32_t, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_emitted_counts{}; // The lights emitted by every frame, until it's read back
+
+		std::vector<std::pair<vren::light_emitter, uint32_t>> m_pending_emissions;
+		bool m_reset_pending = true;
+		uint32_t m_seed = 0;
+
+		uint32_t m_point_light_bound = 0;
+
+	public:
+		glm::vec3 m_acceleration = glm::vec3(0.0f);
+		float m_damping = 0.0f; // The fraction of the velocity lost per second
+
+		vren::light_simulation_bounds_mode m_bounds_mode = vren::LightSimulationBoundsModeNone;
+		glm::vec3 m_bounds_min = glm::vec3(-std::numeric_limits<float>::infinity());
+		glm::vec3 m_bounds_max = glm::vec3(std::numeric_limits<float>::infinity());
+
+		float m_fade_out_time = 0.0f; // The lights fade out over the last seconds of their lifetime
+
+		light_simulation(vren::context const& context, uint32_t capacity, uint32_t first_point_light = 0);
+
+	private:
+		vren::pipeline create_pipeline(char const* shader_path);
+
+	public:
+		inline uint32_t get_capacity() const
+		{
+			return m_capacity;
+		}
+
+		/// The upper bound of the alive lights the light array was last sized with.
+		inline uint32_t get_point_light_bound() const
+		{
+			return m_point_light_bound;
+		}
+
+		/// Spawns count lights at the next step, the spawns exceeding the capacity are dropped on the device.
+		void emit(vren::light_emitter const& emitter, uint32_t count);
+
+		/// Kills all the lights at the next step.
+		void clear();
+
+		/** Records a simulation step: the pending spawns, the integration and the write of the alive lights to the light array.
+		 * Sets the light array point light count to cover the simulated lights, thus it must be called after the light count
+		 * is written by others (e.g. vren::light_store::upload).
+		 */
+		vren::render_graph_t operator()(
+			vren::render_graph_allocator& render_graph_allocator,
+			uint32_t frame_idx,
+			vren::light_array& light_array,
+			float dt
+		);
+	};
+}
@@ -4,17 +4,44 @@
 #include "toolbox.hpp"
 #include "mesh_shader_renderer.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/misc.hpp"
 #include "vk_helpers/debug_utils.hpp"
 
+vren::pipeline_future vren::mesh_shader_draw_pass::create_pipeline(
+	vren::context const& context,
+	VkBool32 occlusion_culling,
+	VkBool32 compressed_geometry
+)
+{
+	return context.m_pipeline_builder->submit([&context, occlusion_culling, compressed_geometry]()
+	{
+		return create_graphics_pipeline(context, occlusion_culling, compressed_geometry);
+	});
+}
+
+vren::mesh_shader_draw_pass::mesh_shader_draw_pass(
+	vren::context const& context,
+	VkBool32 occlusion_culling,
+	VkBool32 compressed_geometry
+) :
+	mesh_shader_draw_pass(context, compressed_geometry, create_pipeline(context, occlusion_culling, compressed_geometry))
+{}
+
 vren::mesh_shader_draw_pass::mesh_shader_draw_pass(
 	vren::context const& context,
-	VkBool32 occlusion_culling
+	VkBool32 compressed_geometry,
+	vren::pipeline_future pipeline
 ) :
 	m_context(&context),
-	m_pipeline(create_graphics_pipeline(occlusion_culling))
+	m_compressed_geometry(compressed_geometry),
+	m_pipeline(pipeline.get())
 {}
 
-vren::pipeline vren::mesh_shader_draw_pass::create_graphics_pipeline(VkBool32 occlusion_culling)
+vren::pipeline vren::mesh_shader_draw_pass::create_graphics_pipeline(
+	vren::context const& context,
+	VkBool32 occlusion_culling,
+	VkBool32 compressed_geometry
+)
 {
 	/* Vertex input state */
 	/* Input assembly state */
@@ -116,9 +143,9 @@ vren::pipeline vren::mesh_shader_draw_pass::create_graphics_pipeline(VkBool32 oc
 	};
 
 	//
-	vren::shader_module task_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/draw.task.spv");
-	vren::shader_module mesh_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/draw.mesh.spv");
-	vren::shader_module frag_shader_mod = vren::load_shader_module_from_file(*m_context, ".vren/resources/shaders/deferred.frag.spv");
+	vren::shader_module task_shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/draw.task.spv");
+	vren::shader_module mesh_shader_mod = vren::load_shader_module_from_file(context, compressed_geometry ? ".vren/resources/shaders/draw_compressed.mesh.spv" : ".vren/resources/shaders/draw.mesh.spv");
+	vren::shader_module frag_shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/deferred.frag.spv");
 
 	vren::specialized_shader task_shader = vren::specialized_shader(task_shader_mod, "main");
 	task_shader.set_specialization_data("k_occlusion_culling", &occlusion_culling, sizeof(occlusion_culling));
@@ -132,7 +159,7 @@ vren::pipeline vren::mesh_shader_draw_pass::create_graphics_pipeline(VkBool32 oc
 		std::move(frag_shader)
 	};
 	return vren::create_graphics_pipeline(
-		*m_context,
+		context,
 		shaders,
 		nullptr,
 		nullptr,
@@ -208,6 +235,30 @@ void write_meshlet_buffer_descriptor_set(
 	}
 }
 
+void vren::mesh_shader_draw_pass::draw(
+	VkCommandBuffer command_buffer,
+	vren::resource_container& resource_container,
+	vren::camera_data const& camera_data,
+	size_t instanced_meshlet_count,
+	vren::depth_buffer_pyramid const& depth_buffer_pyramid
+)
+{
+	// Bind depth-buffer pyramid
+	auto descriptor_set_4 = std::make_shared<vren::pooled_vk_descriptor_set>(
+		m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(4))
+	);
+
+	vren::vk_utils::write_combined_image_sampler_descriptor(*m_context, descriptor_set_4->m_handle.m_descriptor_set, 0, depth_buffer_pyramid.get_sampler(), depth_buffer_pyramid.get_image_view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	m_pipeline.bind_descriptor_set(command_buffer, 4, descriptor_set_4->m_handle.m_descriptor_set);
+
+	resource_container.add_resource(descriptor_set_4);
+
+	// Draw
+	uint32_t workgroups_num = (uint32_t) glm::ceil(instanced_meshlet_count / (float) 32);
+	vkCmdDrawMeshTasksNV(command_buffer, workgroups_num, 0);
+}
+
 void vren::mesh_shader_draw_pass::render(
 	uint32_t frame_idx,
 	VkCommandBuffer command_buffer,
@@ -218,6 +269,8 @@ void vren::mesh_shader_draw_pass::render(
 	vren::depth_buffer_pyramid const& depth_buffer_pyramid
 )
 {
+	assert(!m_compressed_geometry);
+
 	m_pipeline.bind(command_buffer);
 
 	// Push constants
@@ -239,18 +292,37 @@ void vren::mesh_shader_draw_pass::render(
 		);
 	});
 
-	// Bind depth-buffer pyramid
-	auto descriptor_set_4 = std::make_shared<vren::pooled_vk_descriptor_set>(
-		m_context->m_toolbox->m_descriptor_pool.acquire(m_pipeline.m_descriptor_set_layouts.at(4))
-	);
+	draw(command_buffer, resource_container, camera_data, draw_buffer.m_instanced_meshlet_count, depth_buffer_pyramid);
+}
 
-	vren::vk_utils::write_combined_image_sampler_descriptor(*m_context, descriptor_set_4->m_handle.m_descriptor_set, 0, depth_buffer_pyramid.get_sampler(), depth_buffer_pyramid.get_image_view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+void vren::mesh_shader_draw_pass::render(
+	uint32_t frame_idx,
+	VkCommandBuffer command_buffer,
+	vren::resource_container& resource_container,
+	vren::camera_data const& camera_data,
+	vren::compressed_clusterized_model_draw_buffer const& draw_buffer,
+	vren::light_array const& light_array,
+	vren::depth_buffer_pyramid const& depth_buffer_pyramid
+)
+{
+	assert(m_compressed_geometry);
 
-	m_pipeline.bind_descriptor_set(command_buffer, 4, descriptor_set_4->m_handle.m_descriptor_set);
+	m_pipeline.bind(command_buffer);
 
-	resource_container.add_resource(descriptor_set_4);
+	// Push constants
+	m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_TASK_BIT_NV | VK_SHADER_STAGE_MESH_BIT_NV, &camera_data, sizeof(camera_data));
 
-	// Draw
-	uint32_t workgroups_num = (uint32_t) glm::ceil(draw_buffer.m_instanced_meshlet_count / (float) 32);
-	vkCmdDrawMeshTasksNV(command_buffer, workgroups_num, 0);
+	// Bind draw buffer (the compressed layout has no meshlet vertex buffer at binding 1)
+	m_pipeline.acquire_and_bind_descriptor_set(*m_context, command_buffer, resource_container, 2, [&](VkDescriptorSet descriptor_set)
+	{
+		vren::vk_utils::set_object_name(*m_context, VK_OBJECT_TYPE_DESCRIPTOR_SET, (uint64_t) descriptor_set, "compressed_meshlet_buffer");
+
+		vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 0, draw_buffer.m_vertex_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+		vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 2, draw_buffer.m_meshlet_triangle_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+		vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 3, draw_buffer.m_meshlet_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+		vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 4, draw_buffer.m_instanced_meshlet_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+		vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 5, draw_buffer.m_instance_buffer.m_buffer.m_handle, VK_WHOLE_SIZE, 0);
+	});
+
+	draw(command_buffer, resource_container, camera_data, draw_buffer.m_instanced_meshlet_count, depth_buffer_pyramid);
 }
@@ -10,6 +10,7 @@
 #include "light.hpp"
 #include "gpu_repr.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 #include "depth_buffer_pyramid.hpp"
 #include "model/clusterized_model_draw_buffer.hpp"
 
@@ -23,17 +24,45 @@ namespace vren
 	{
 	private:
 		vren::context const* m_context;
+		VkBool32 m_compressed_geometry;
 		vren::pipeline m_pipeline;
 
 	public:
+		static vren::pipeline_future create_pipeline(
+			vren::context const& context,
+			VkBool32 occlusion_culling,
+			VkBool32 compressed_geometry = VK_FALSE
+		);
+
+		mesh_shader_draw_pass(
+			vren::context const& context,
+			VkBool32 occlusion_culling,
+			VkBool32 compressed_geometry = VK_FALSE
+		);
 		mesh_shader_draw_pass(
 			vren::context const& context,
-			VkBool32 occlusion_culling
+			VkBool32 compressed_geometry,
+			vren::pipeline_future pipeline // See create_pipeline
 		);
 
+		inline bool is_compressed_geometry() const
+		{
+			return m_compressed_geometry;
+		}
+
 	private:
-		vren::pipeline create_graphics_pipeline(
-			VkBool32 occlusion_culling
+		static vren::pipeline create_graphics_pipeline(
+			vren::context const& context,
+			VkBool32 occlusion_culling,
+			VkBool32 compressed_geometry
+		);
+
+		void draw(
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container,
+			vren::camera_data const& camera_data,
+			size_t instanced_meshlet_count,
+			vren::depth_buffer_pyramid const& depth_buffer_pyramid
 		);
 
 	public:
@@ -46,6 +75,16 @@ namespace vren
 			vren::light_array const& light_array,
 			vren::depth_buffer_pyramid const& depth_buffer_pyramid
 		);
+
+		void render(
+			uint32_t frame_idx,
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container,
+			vren::camera_data const& camera_data,
+			vren::compressed_clusterized_model_draw_buffer const& draw_buffer,
+			vren::light_array const& light_array,
+			vren::depth_buffer_pyramid const& depth_buffer_pyramid
+		);
 	};
 }
 
@@ -8,19 +8,21 @@
 
 vren::mesh_shader_renderer::mesh_shader_renderer(
 	vren::context const& context,
-	VkBool32 occlusion_culling
+	VkBool32 occlusion_culling,
+	VkBool32 compressed_geometry
 ) :
 	m_context(&context),
-	m_mesh_shader_draw_pass(context, occlusion_culling),
+	m_mesh_shader_draw_pass(context, occlusion_culling, compressed_geometry),
 	m_occlusion_culling(occlusion_culling)
 {}
 
-vren::render_graph_t vren::mesh_shader_renderer::render(
+template<typename _draw_buffer_t>
+vren::render_graph_t vren::mesh_shader_renderer::render_draw_buffer(
 	vren::render_graph_allocator& render_graph_allocator,
 	glm::uvec2 const& screen,
 	vren::camera_data const& camera_data,
 	vren::light_array const& light_array,
-	vren::clusterized_model_draw_buffer const& draw_buffer,
+	_draw_buffer_t const& draw_buffer,
 	vren::depth_buffer_pyramid const& depth_buffer_pyramid,
 	vren::gbuffer const& gbuffer,
 	vren::vk_utils::depth_buffer_t const& depth_buffer
@@ -33,6 +35,8 @@ vren::render_graph_t vren::mesh_shader_renderer::render(
 	node->set_src_stage(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 	node->set_dst_stage(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
+	node->set_parallel_recording(true);
+
 	gbuffer.add_render_graph_node_resources(*node, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
 	node->add_image({ .m_image = depth_buffer.get_image(), .m_image_aspect = VK_IMAGE_ASPECT_DEPTH_BIT, }, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
 	depth_buffer_pyramid.add_render_graph_node_resources(*node, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT);
@@ -118,3 +122,31 @@ vren::render_graph_t vren::mesh_shader_renderer::render(
 	});
 	return vren::render_graph_gather(node);
 }
+
+vren::render_graph_t vren::mesh_shader_renderer::render(
+	vren::render_graph_allocator& render_graph_allocator,
+	glm::uvec2 const& screen,
+	vren::camera_data const& camera_data,
+	vren::light_array const& light_array,
+	vren::clusterized_model_draw_buffer const& draw_buffer,
+	vren::depth_buffer_pyramid const& depth_buffer_pyramid,
+	vren::gbuffer const& gbuffer,
+	vren::vk_utils::depth_buffer_t const& depth_buffer
+)
+{
+	return render_draw_buffer(render_graph_allocator, screen, camera_data, light_array, draw_buffer, depth_buffer_pyramid, gbuffer, depth_buffer);
+}
+
+vren::render_graph_t vren::mesh_shader_renderer::render(
+	vren::render_graph_allocator& render_graph_allocator,
+	glm::uvec2 const& screen,
+	vren::camera_data const& camera_data,
+	vren::light_array const& light_array,
+	vren::compressed_clusterized_model_draw_buffer const& draw_buffer,
+	vren::depth_buffer_pyramid const& depth_buffer_pyramid,
+	vren::gbuffer const& gbuffer,
+	vren::vk_utils::depth_buffer_t const& depth_buffer
+)
+{
+	return render_draw_buffer(render_graph_allocator, screen, camera_data, light_array, draw_buffer, depth_buffer_pyramid, gbuffer, depth_buffer);
+}
@@ -27,7 +27,8 @@ namespace vren
 	public:
 		explicit mesh_shader_renderer(
 			vren::context const& context,
-			VkBool32 occlusion_culling
+			VkBool32 occlusion_culling,
+			VkBool32 compressed_geometry = VK_FALSE
 		);
 
 		inline bool is_occlusion_culling_enabled() const
@@ -35,6 +36,26 @@ namespace vren
 			return m_occlusion_culling;
 		}
 
+		inline bool is_compressed_geometry() const
+		{
+			return m_mesh_shader_draw_pass.is_compressed_geometry();
+		}
+
+	private:
+		template<typename _draw_buffer_t>
+		vren::render_graph_t render_draw_buffer(
+			vren::render_graph_allocator& render_graph_allocator,
+			glm::uvec2 const& screen,
+			vren::camera_data const& camera_data,
+			vren::light_array const& light_array,
+			_draw_buffer_t const& draw_buffer,
+			vren::depth_buffer_pyramid const& depth_buffer_pyramid,
+			vren::gbuffer const& gbuffer,
+			vren::vk_utils::depth_buffer_t const& depth_buffer
+		);
+
+	public:
+
 		vren::render_graph_t render(
 			vren::render_graph_allocator& render_graph_allocator,
 			glm::uvec2 const& screen,
@@ -45,5 +66,16 @@ namespace vren
 			vren::gbuffer const& gbuffer,
 			vren::vk_utils::depth_buffer_t const& depth_buffer
 		);
+
+		vren::render_graph_t render(
+			vren::render_graph_allocator& render_graph_allocator,
+			glm::uvec2 const& screen,
+			vren::camera_data const& camera_data,
+			vren::light_array const& light_array,
+			vren::compressed_clusterized_model_draw_buffer const& draw_buffer,
+			vren::depth_buffer_pyramid const& depth_buffer_pyramid,
+			vren::gbuffer const& gbuffer,
+			vren::vk_utils::depth_buffer_t const& depth_buffer
+		);
 	};
 }
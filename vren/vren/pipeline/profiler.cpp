@@ -1,27 +1,70 @@
 #include "profiler.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 
+#include <fmt/format.h>
+
 #include "context.hpp"
 #include "vk_helpers/misc.hpp"
 
+namespace
+{
+	bool is_scope_named(std::string_view scope_name, std::string_view name)
+	{
+		if (scope_name.size() < name.size() || scope_name.substr(scope_name.size() - name.size()) != name)
+		{
+			return false;
+		}
+		return scope_name.size() == name.size() || scope_name[scope_name.size() - name.size() - 1] == '/';
+	}
+
+	std::string escape_json_string(std::string_view string)
+	{
+		std::string escaped_string;
+		for (char c : string)
+		{
+			if (c == '"' || c == '\\')
+			{
+				escaped_string += '\\';
+			}
+			if ((unsigned char) c >= 0x20)
+			{
+				escaped_string += c;
+			}
+		}
+		return escaped_string;
+	}
+}
+
 vren::profiler::profiler(vren::context const& context) :
 	m_context(&context),
 	m_query_pool(create_query_pool())
-{}
+{
+	m_timestamp_period = context.m_physical_device_properties.limits.timestampPeriod;
+
+	uint32_t timestamp_valid_bits = vren::vk_utils::get_queue_families_properties(context.m_physical_device).at(context.m_queue_families.m_graphics_idx).timestampValidBits;
+	m_timestamp_mask = timestamp_valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << timestamp_valid_bits) - 1;
+}
 
 vren::profiler::~profiler()
 {}
 
 vren::vk_query_pool vren::profiler::create_query_pool() const
+{
+	return create_query_pool(VK_QUERY_TYPE_TIMESTAMP, k_max_slot_count * 2, NULL);
+}
+
+vren::vk_query_pool vren::profiler::create_query_pool(VkQueryType query_type, uint32_t query_count, VkQueryPipelineStatisticFlags pipeline_statistics) const
 {
 	VkQueryPoolCreateInfo query_pool_info{
 		.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
 		.pNext = nullptr,
 		.flags = NULL,
-		.queryType = VK_QUERY_TYPE_TIMESTAMP,
-		.queryCount = k_max_slot_count * 2,
-		.pipelineStatistics = NULL
+		.queryType = query_type,
+		.queryCount = query_count,
+		.pipelineStatistics = pipeline_statistics
 	};
 
 	VkQueryPool query_pool;
@@ -29,6 +72,371 @@ vren::vk_query_pool vren::profiler::create_query_pool() const
 	return vren::vk_query_pool(*m_context, query_pool);
 }
 
+uint32_t vren::profiler::get_or_register_scope(std::string name, uint32_t depth)
+{
+	auto found = m_scope_indices.find(name);
+	if (found != m_scope_indices.end())
+	{
+		return found->second;
+	}
+
+	uint32_t scope_idx = (uint32_t) m_scopes.size();
+	if (scope_idx / k_scope_block_size >= m_scope_query_blocks.size())
+	{
+		uint32_t query_count = k_scope_block_size * VREN_MAX_FRAME_IN_FLIGHT_COUNT;
+		m_scope_query_blocks.push_back(scope_query_block{
+			.m_timestamp_query_pool = create_query_pool(VK_QUERY_TYPE_TIMESTAMP, query_count * 2, NULL),
+			.m_pipeline_statistics_query_pool = create_query_pool(VK_QUERY_TYPE_PIPELINE_STATISTICS, query_count, k_pipeline_statistics),
+		});
+	}
+
+	m_scope_indices.emplace(name, scope_idx);
+	m_scopes.push_back(vren::profiler_scope{
+		.m_name = std::move(name),
+		.m_depth = depth,
+	});
+	return scope_idx;
+}
+
+uint64_t vren::profiler::get_elapsed_nanoseconds(uint64_t start_timestamp, uint64_t end_timestamp) const
+{
+	uint64_t elapsed_ticks = (end_timestamp - start_timestamp) & m_timestamp_mask; // Also right if the counter wrapped around
+	return (uint64_t) std::llround(double(elapsed_ticks) * m_timestamp_period);
+}
+
+void vren::profiler::begin_scope(VkCommandBuffer command_buffer, uint32_t frame_idx, std::string_view name)
+{
+	std::string scope_name(name);
+	if (!m_open_scopes.empty())
+	{
+		scope_name = m_scopes.at(m_open_scopes.back().m_scope_idx).m_name + "/" + scope_name;
+	}
+
+	uint32_t scope_idx = get_or_register_scope(std::move(scope_name), (uint32_t) m_open_scopes.size());
+
+	bool pipeline_statistics = std::none_of(m_open_scopes.begin(), m_open_scopes.end(), [](recorded_scope const& open_scope)
+	{
+		return open_scope.m_pipeline_statistics;
+	});
+
+	scope_query_block const& query_block = m_scope_query_blocks.at(scope_idx / k_scope_block_size);
+	uint32_t query_idx = (scope_idx % k_scope_block_size) * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx;
+
+	vkCmdResetQueryPool(command_buffer, query_block.m_timestamp_query_pool.m_handle, query_idx * 2, 2);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, query_block.m_timestamp_query_pool.m_handle, query_idx * 2 + 0);
+
+	if (pipeline_statistics)
+	{
+		vkCmdResetQueryPool(command_buffer, query_block.m_pipeline_statistics_query_pool.m_handle, query_idx, 1);
+		vkCmdBeginQuery(command_buffer, query_block.m_pipeline_statistics_query_pool.m_handle, query_idx, NULL);
+	}
+
+	m_open_scopes.push_back(recorded_scope{
+		.m_scope_idx = scope_idx,
+		.m_pipeline_statistics = pipeline_statistics,
+	});
+}
+
+void vren::profiler::end_scope(VkCommandBuffer command_buffer, uint32_t frame_idx, std::string_view name)
+{
+	auto open_scope = std::find_if(m_open_scopes.rbegin(), m_open_scopes.rend(), [&](recorded_scope const& candidate)
+	{
+		return is_scope_named(m_scopes.at(candidate.m_scope_idx).m_name, name);
+	});
+	if (open_scope == m_open_scopes.rend())
+	{
+		throw std::runtime_error("Profiler scope isn't open");
+	}
+
+	recorded_scope scope = *open_scope;
+	m_open_scopes.erase(std::next(open_scope).base());
+
+	scope_query_block const& query_block = m_scope_query_blocks.at(scope.m_scope_idx / k_scope_block_size);
+	uint32_t query_idx = (scope.m_scope_idx % k_scope_block_size) * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx;
+
+	if (scope.m_pipeline_statistics)
+	{
+		vkCmdEndQuery(command_buffer, query_block.m_pipeline_statistics_query_pool.m_handle, query_idx);
+	}
+
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, query_block.m_timestamp_query_pool.m_handle, query_idx * 2 + 1);
+
+	// A scope recorded twice in the same frame reuses its queries, the last recording is read
+	std::vector<recorded_scope>& recorded_scopes = m_recorded_scopes.at(frame_idx);
+	std::erase_if(recorded_scopes, [&](recorded_scope const& recorded_scope)
+	{
+		return recorded_scope.m_scope_idx == scope.m_scope_idx;
+	});
+	recorded_scopes.push_back(scope);
+}
+
+void vren::profiler::profile_scope(
+	VkCommandBuffer command_buffer,
+	vren::resource_container& resource_container,
+	uint32_t frame_idx,
+	std::string_view name,
+	std::function<void(VkCommandBuffer command_buffer, vren::resource_container& resource_container)> const& sample_func
+)
+{
+	begin_scope(command_buffer, frame_idx, name);
+
+	sample_func(command_buffer, resource_container);
+
+	end_scope(command_buffer, frame_idx, name);
+}
+
+vren::render_graph_t vren::profiler::profile_scope(
+	vren::render_graph_allocator& allocator,
+	vren::render_graph_t const& sample,
+	std::string name
+)
+{
+	auto head = allocator.allocate();
+	head->set_name("profiler_scope_begin");
+	head->set_callback([this, name](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		begin_scope(command_buffer, frame_idx, name);
+	});
+
+	auto tail = allocator.allocate();
+	tail->set_name("profiler_scope_end");
+	tail->set_callback([this, name](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		end_scope(command_buffer, frame_idx, name);
+	});
+
+	if (sample.empty())
+	{
+		head->add_next(tail); // The scope must be ended even if there's nothing to profile
+	}
+	else
+	{
+		for (auto node_idx : vren::render_graph_get_start(allocator, sample))
+		{
+			head->add_next(node_idx);
+		}
+
+		for (auto node_idx : vren::render_graph_get_end(allocator, sample))
+		{
+			allocator.get_node_at(node_idx)->add_next(tail);
+		}
+	}
+
+	return vren::render_graph_gather(head);
+}
+
+void vren::profiler::read_scopes(uint32_t frame_idx)
+{
+	std::vector<gpu_trace_sample> gpu_trace_samples;
+
+	bool capturing_trace = is_capturing_trace();
+
+	for (recorded_scope const& recorded_scope : m_recorded_scopes.at(frame_idx))
+	{
+		vren::profiler_scope& scope = m_scopes.at(recorded_scope.m_scope_idx);
+
+		scope_query_block const& query_block = m_scope_query_blocks.at(recorded_scope.m_scope_idx / k_scope_block_size);
+		uint32_t query_idx = (recorded_scope.m_scope_idx % k_scope_block_size) * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx;
+
+		uint64_t timestamps[2];
+		VkResult result = vkGetQueryPoolResults(m_context->m_device, query_block.m_timestamp_query_pool.m_handle, query_idx * 2, 2, sizeof(timestamps), &timestamps[0], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result == VK_NOT_READY)
+		{
+			continue;
+		}
+		VREN_CHECK(result, m_context);
+
+		scope.m_elapsed_time.push(double(get_elapsed_nanoseconds(timestamps[0], timestamps[1])));
+
+		if (capturing_trace)
+		{
+			gpu_trace_samples.push_back({ .m_name = scope.m_name, .m_start_timestamp = timestamps[0], .m_end_timestamp = timestamps[1] });
+		}
+
+		if (recorded_scope.m_pipeline_statistics)
+		{
+			std::array<uint64_t, vren::PipelineStatisticCount> pipeline_statistics{};
+			result = vkGetQueryPoolResults(m_context->m_device, query_block.m_pipeline_statistics_query_pool.m_handle, query_idx, 1, sizeof(pipeline_statistics), pipeline_statistics.data(), sizeof(pipeline_statistics), VK_QUERY_RESULT_64_BIT);
+			if (result == VK_NOT_READY)
+			{
+				continue;
+			}
+			VREN_CHECK(result, m_context);
+
+			scope.m_has_pipeline_statistics = true;
+			scope.m_pipeline_statistics = pipeline_statistics;
+		}
+	}
+
+	m_recorded_scopes.at(frame_idx).clear();
+
+	// Nodes
+	m_node_timings.clear();
+
+	std::vector<char const*>& recorded_nodes = m_recorded_nodes.at(frame_idx);
+	for (uint32_t node_idx = 0; node_idx < recorded_nodes.size(); node_idx++)
+	{
+		vren::vk_query_pool const& query_pool = m_node_query_pools.at(frame_idx).at(node_idx / k_node_block_size);
+		uint32_t query_idx = node_idx % k_node_block_size;
+
+		uint64_t timestamps[2];
+		VkResult result = vkGetQueryPoolResults(m_context->m_device, query_pool.m_handle, query_idx * 2, 2, sizeof(timestamps), &timestamps[0], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result == VK_NOT_READY)
+		{
+			continue;
+		}
+		VREN_CHECK(result, m_context);
+
+		m_node_timings.push_back(vren::profiler_node_timing{
+			.m_name = recorded_nodes.at(node_idx),
+			.m_elapsed_time = get_elapsed_nanoseconds(timestamps[0], timestamps[1]),
+		});
+
+		if (capturing_trace)
+		{
+			gpu_trace_samples.push_back({ .m_name = recorded_nodes.at(node_idx), .m_start_timestamp = timestamps[0], .m_end_timestamp = timestamps[1] });
+		}
+	}
+
+	recorded_nodes.clear();
+
+	if (capturing_trace)
+	{
+		add_gpu_trace_events(gpu_trace_samples);
+	}
+}
+
+void vren::profiler::begin_node(VkCommandBuffer command_buffer, uint32_t frame_idx, char const* name)
+{
+	std::vector<vren::vk_query_pool>& query_pools = m_node_query_pools.at(frame_idx);
+	std::vector<char const*>& recorded_nodes = m_recorded_nodes.at(frame_idx);
+
+	uint32_t node_idx = (uint32_t) recorded_nodes.size();
+	if (node_idx / k_node_block_size >= query_pools.size())
+	{
+		query_pools.push_back(create_query_pool(VK_QUERY_TYPE_TIMESTAMP, k_node_block_size * 2, NULL));
+	}
+
+	VkQueryPool query_pool = query_pools.at(node_idx / k_node_block_size).m_handle;
+	uint32_t query_idx = node_idx % k_node_block_size;
+
+	vkCmdResetQueryPool(command_buffer, query_pool, query_idx * 2, 2);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, query_pool, query_idx * 2 + 0);
+
+	recorded_nodes.push_back(name);
+}
+
+void vren::profiler::end_node(VkCommandBuffer command_buffer, uint32_t frame_idx)
+{
+	uint32_t node_idx = (uint32_t) m_recorded_nodes.at(frame_idx).size() - 1;
+
+	VkQueryPool query_pool = m_node_query_pools.at(frame_idx).at(node_idx / k_node_block_size).m_handle;
+	uint32_t query_idx = node_idx % k_node_block_size;
+
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, query_pool, query_idx * 2 + 1);
+}
+
+void vren::profiler::start_trace_capture(uint32_t frame_count)
+{
+	std::lock_guard<std::mutex> lock(m_trace_mutex);
+
+	m_trace_frame_count = frame_count;
+	m_trace_start_time = std::chrono::steady_clock::now();
+	m_trace_gpu_start_timestamp_set = false;
+	m_trace_events.clear();
+	m_trace_thread_indices.clear();
+}
+
+bool vren::profiler::is_capturing_trace() const
+{
+	std::lock_guard<std::mutex> lock(m_trace_mutex);
+	return m_trace_frame_count > 0;
+}
+
+void vren::profiler::add_gpu_trace_events(std::vector<gpu_trace_sample> const& samples)
+{
+	std::lock_guard<std::mutex> lock(m_trace_mutex);
+
+	if (m_trace_frame_count == 0)
+	{
+		return;
+	}
+
+	// The GPU timeline starts at the earliest timestamp of the first frame captured
+	if (!m_trace_gpu_start_timestamp_set && !samples.empty())
+	{
+		m_trace_gpu_start_timestamp = std::min_element(samples.begin(), samples.end(), [](gpu_trace_sample const& a, gpu_trace_sample const& b)
+		{
+			return a.m_start_timestamp < b.m_start_timestamp;
+		})->m_start_timestamp;
+		m_trace_gpu_start_timestamp_set = true;
+	}
+
+	for (gpu_trace_sample const& sample : samples)
+	{
+		m_trace_events.push_back(vren::profiler_trace_event{
+			.m_name = sample.m_name,
+			.m_start_time = get_elapsed_nanoseconds(m_trace_gpu_start_timestamp, sample.m_start_timestamp),
+			.m_duration = get_elapsed_nanoseconds(sample.m_start_timestamp, sample.m_end_timestamp),
+			.m_gpu = true,
+			.m_thread_idx = 0,
+		});
+	}
+
+	m_trace_frame_count--;
+}
+
+void vren::profiler::add_cpu_zone(char const* name, std::chrono::steady_clock::time_point start_time, std::chrono::steady_clock::time_point end_time)
+{
+	std::lock_guard<std::mutex> lock(m_trace_mutex);
+
+	if (m_trace_frame_count == 0 || start_time < m_trace_start_time)
+	{
+		return;
+	}
+
+	auto [thread_index, inserted] = m_trace_thread_indices.try_emplace(std::this_thread::get_id(), (uint32_t) m_trace_thread_indices.size());
+
+	m_trace_events.push_back(vren::profiler_trace_event{
+		.m_name = name,
+		.m_start_time = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(start_time - m_trace_start_time).count(),
+		.m_duration = (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count(),
+		.m_gpu = false,
+		.m_thread_idx = thread_index->second,
+	});
+}
+
+void vren::profiler::write_chrome_trace(std::ostream& output) const
+{
+	std::lock_guard<std::mutex> lock(m_trace_mutex);
+
+	// Chrome trace event format: complete events ("X") in microseconds, nested by time on every thread
+	output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	output << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+	output << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}";
+
+	for (vren::profiler_trace_event const& event : m_trace_events)
+	{
+		output << fmt::format(
+			",\n{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+			escape_json_string(event.m_name),
+			event.m_gpu ? "gpu" : "cpu",
+			event.m_start_time / 1000.0,
+			event.m_duration / 1000.0,
+			event.m_gpu ? 1 : 0,
+			event.m_thread_idx
+		);
+	}
+
+	output << "\n]}\n";
+}
+
+vren::profiler_scope const* vren::profiler::find_scope(std::string_view name) const
+{
+	auto found = m_scope_indices.find(std::string(name));
+	return found != m_scope_indices.end() ? &m_scopes.at(found->second) : nullptr;
+}
+
 void vren::profiler::profile(
 	VkCommandBuffer command_buffer,
 	vren::resource_container& resource_container,
@@ -84,9 +492,6 @@ bool vren::profiler::read_timestamps(uint32_t slot_idx, uint64_t& start_timestam
 	uint64_t timestamps[2];
 	VkResult result = vkGetQueryPoolResults(m_context->m_device, m_query_pool.m_handle, slot_idx * 2, 2, sizeof(uint64_t) * 2, &timestamps[0], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
 
-	// TODO USE IT (assumed 1): auto t_period = m_context->m_physical_device_properties.limits.timestampPeriod;
-	// TODO USE IT (assumed 64): auto t_valid_bits = vren::vk_utils::get_queue_families_properties(m_context->m_physical_device).at(m_context->m_queue_families.m_graphics_idx).timestampValidBits;
-
 	if (result == VK_NOT_READY)
 	{
 		return false;
@@ -102,3 +507,18 @@ bool vren::profiler::read_timestamps(uint32_t slot_idx, uint64_t& start_timestam
 		throw std::runtime_error("Failed to read query results");
 	}
 }
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Profiler CPU zone
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::profiler_cpu_zone::profiler_cpu_zone(vren::profiler& profiler, char const* name) :
+	m_profiler(&profiler),
+	m_name(name),
+	m_start_time(std::chrono::steady_clock::now())
+{}
+
+vren::profiler_cpu_zone::~profiler_cpu_zone()
+{
+	m_profiler->add_cpu_zone(m_name, m_start_time, std::chrono::steady_clock::now());
+}
@@ -1,6 +1,17 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 #include "base/resource_container.hpp"
+#include "base/rolling_statistics.hpp"
 #include "vk_helpers/vk_raii.hpp"
 #include "render_graph.hpp"
 
@@ -9,27 +20,192 @@ namespace vren
 	// Forward decl
 	class context;
 
+	// ------------------------------------------------------------------------------------------------
+	// Profiler scope
+	// ------------------------------------------------------------------------------------------------
+
+	enum profiler_pipeline_statistic
+	{
+		PipelineStatisticInputAssemblyPrimitives = 0,
+		PipelineStatisticVertexShaderInvocations,
+		PipelineStatisticClippingPrimitives,
+		PipelineStatisticFragmentShaderInvocations,
+		PipelineStatisticComputeShaderInvocations,
+
+		PipelineStatisticCount
+	};
+
+	struct profiler_scope
+	{
+		std::string m_name; // Prefixed by the names of the enclosing scopes, e.g. "shadow_map/cascade_0"
+		uint32_t m_depth;
+
+		vren::rolling_statistics m_elapsed_time; // In nanoseconds
+
+		/// Only the outermost scope of a command buffer counts the pipeline statistics (a single pipeline statistics query can be
+		/// active at once), the last frame read is kept.
+		bool m_has_pipeline_statistics = false;
+		std::array<uint64_t, vren::PipelineStatisticCount> m_pipeline_statistics{};
+	};
+
+	struct profiler_node_timing
+	{
+		char const* m_name; // The name of the render graph node
+		uint64_t m_elapsed_time; // In nanoseconds
+	};
+
+	struct profiler_trace_event
+	{
+		std::string m_name;
+		uint64_t m_start_time; // In nanoseconds, from the start of the capture (CPU) or from the first GPU timestamp of the capture (GPU)
+		uint64_t m_duration;
+		bool m_gpu;
+		uint32_t m_thread_idx; // The CPU thread, in the order the threads recorded their first zone
+	};
+
 	// ------------------------------------------------------------------------------------------------
 	// Profiler
 	// ------------------------------------------------------------------------------------------------
 
+	/** Measures the GPU time of the commands, converted to nanoseconds with the timestamp period of the device.
+	 *
+	 * The scopes are named, registered on first use and may nest: a scope begun while another one is open is its child. Every scope has
+	 * its own queries for every frame in flight, allocated in blocks as the scopes are registered. read_scopes reads back the queries of
+	 * a frame, once its fence is signaled, into the rolling statistics of the scopes.
+	 *
+	 * A render graph executor given the profiler also timestamps every node it executes (see vren::render_graph_executor).
+	 *
+	 * A trace capture records the GPU scopes and nodes of the next frames read, along with the CPU zones (see vren::profiler_cpu_zone),
+	 * and writes them as Chrome trace events (chrome://tracing, Perfetto). The CPU and GPU clocks aren't calibrated against each
+	 * other: they're shown as two processes with their own timeline.
+	 *
+	 * The slots are the previous fixed interface, kept for the tests measuring a single submission.
+	 */
 	class profiler
 	{
 	public:
 		static constexpr uint32_t k_max_slot_count = 256;
+		static constexpr uint32_t k_scope_block_size = 64; // Scopes per query pool
+		static constexpr uint32_t k_node_block_size = 256; // Nodes per query pool
+
+		/// In the order of the results: the statistics are written by ascending bit. The secondary command buffers executed while a scope
+		/// is open must inherit them, which requires the inheritedQueries feature (see vren::command_recorder).
+		static constexpr VkQueryPipelineStatisticFlags k_pipeline_statistics =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
 
 	private:
+		struct scope_query_block
+		{
+			vren::vk_query_pool m_timestamp_query_pool;           // 2 queries per scope per frame in flight
+			vren::vk_query_pool m_pipeline_statistics_query_pool; // 1 query per scope per frame in flight
+		};
+
+		struct recorded_scope
+		{
+			uint32_t m_scope_idx;
+			bool m_pipeline_statistics;
+		};
+
+		struct gpu_trace_sample
+		{
+			std::string m_name;
+			uint64_t m_start_timestamp;
+			uint64_t m_end_timestamp;
+		};
+
 		vren::context const* m_context;
 		vren::vk_query_pool m_query_pool;
 
+		double m_timestamp_period; // Nanoseconds per tick
+		uint64_t m_timestamp_mask; // The valid bits of the timestamps
+
+		std::vector<vren::profiler_scope> m_scopes;
+		std::unordered_map<std::string, uint32_t> m_scope_indices;
+		std::vector<scope_query_block> m_scope_query_blocks;
+
+		std::vector<recorded_scope> m_open_scopes; // Innermost last
+		std::array<std::vector<recorded_scope>, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_recorded_scopes;
+
+		std::array<std::vector<vren::vk_query_pool>, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_node_query_pools; // 2 queries per node
+		std::array<std::vector<char const*>, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_recorded_nodes;
+		std::vector<vren::profiler_node_timing> m_node_timings;
+
+		mutable std::mutex m_trace_mutex; // The CPU zones may be recorded by any thread
+		uint32_t m_trace_frame_count = 0; // Frames left to capture
+		std::chrono::steady_clock::time_point m_trace_start_time;
+		bool m_trace_gpu_start_timestamp_set = false;
+		uint64_t m_trace_gpu_start_timestamp = 0;
+		std::vector<vren::profiler_trace_event> m_trace_events;
+		std::unordered_map<std::thread::id, uint32_t> m_trace_thread_indices;
+
 	public:
 		profiler(vren::context const& context);
 		~profiler();
 
 	private:
 		vren::vk_query_pool create_query_pool() const;
+		vren::vk_query_pool create_query_pool(VkQueryType query_type, uint32_t query_count, VkQueryPipelineStatisticFlags pipeline_statistics) const;
+
+		uint32_t get_or_register_scope(std::string name, uint32_t depth);
+
+		uint64_t get_elapsed_nanoseconds(uint64_t start_timestamp, uint64_t end_timestamp) const;
+
+		void add_gpu_trace_events(std::vector<gpu_trace_sample> const& samples);
 
 	public:
+		/// Must be called outside of a render pass.
+		void begin_scope(VkCommandBuffer command_buffer, uint32_t frame_idx, std::string_view name);
+
+		/// Ends the innermost open scope with the given name (its name without the enclosing scopes).
+		void end_scope(VkCommandBuffer command_buffer, uint32_t frame_idx, std::string_view name);
+
+		void profile_scope(
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container,
+			uint32_t frame_idx,
+			std::string_view name,
+			std::function<void(VkCommandBuffer command_buffer, vren::resource_container& resource_container)> const& sample_func
+		);
+
+		vren::render_graph_t profile_scope(
+			vren::render_graph_allocator& allocator,
+			vren::render_graph_t const& sample,
+			std::string name
+		);
+
+		/// Reads the queries of the scopes recorded the last time the frame was used, its command buffer must have completed.
+		void read_scopes(uint32_t frame_idx);
+
+		inline std::vector<vren::profiler_scope> const& get_scopes() const
+		{
+			return m_scopes;
+		}
+
+		vren::profiler_scope const* find_scope(std::string_view name) const;
+
+		/// Timestamps a render graph node, called by the render graph executor. The nodes are read with the scopes of the frame.
+		void begin_node(VkCommandBuffer command_buffer, uint32_t frame_idx, char const* name);
+		void end_node(VkCommandBuffer command_buffer, uint32_t frame_idx);
+
+		/// The nodes of the last frame read, in execution order.
+		inline std::vector<vren::profiler_node_timing> const& get_node_timings() const
+		{
+			return m_node_timings;
+		}
+
+		/// Clears the previous capture and captures the next frames read by read_scopes.
+		void start_trace_capture(uint32_t frame_count);
+		bool is_capturing_trace() const;
+
+		void add_cpu_zone(char const* name, std::chrono::steady_clock::time_point start_time, std::chrono::steady_clock::time_point end_time);
+
+		/// Writes the last capture as Chrome trace event JSON.
+		void write_chrome_trace(std::ostream& output) const;
+
 		void profile(
 			VkCommandBuffer command_buffer,
 			vren::resource_container& resource_container,
@@ -53,6 +229,7 @@ namespace vren
 			return profile(allocator, sample, slot_idx * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx);
 		}
 
+		/// The raw timestamps, in ticks.
 		bool read_timestamps(uint32_t slot_idx, uint64_t& start_timestamp, uint64_t& end_timestamp);
 
 		inline bool read_timestamps(uint32_t slot_idx, uint32_t frame_idx, uint64_t& start_timestamp, uint64_t& end_timestamp)
@@ -60,11 +237,12 @@ namespace vren
 			return read_timestamps(slot_idx * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx, start_timestamp, end_timestamp);
 		}
 
+		/// In nanoseconds, UINT64_MAX if the timestamps aren't available yet.
 		inline uint64_t read_elapsed_time(uint32_t slot_idx)
 		{
 			uint64_t start_timestamp, end_timestamp;
 			if (read_timestamps(slot_idx, start_timestamp, end_timestamp)) {
-				return end_timestamp - start_timestamp;
+				return get_elapsed_nanoseconds(start_timestamp, end_timestamp);
 			} else {
 				return UINT64_MAX;
 			}
@@ -75,4 +253,24 @@ namespace vren
 			return read_elapsed_time(slot_idx * VREN_MAX_FRAME_IN_FLIGHT_COUNT + frame_idx);
 		}
 	};
+
+	// ------------------------------------------------------------------------------------------------
+	// Profiler CPU zone
+	// ------------------------------------------------------------------------------------------------
+
+	/// Records the CPU time spent in its lifetime while the profiler captures a trace.
+	class profiler_cpu_zone
+	{
+	private:
+		vren::profiler* m_profiler;
+		char const* m_name;
+		std::chrono::steady_clock::time_point m_start_time;
+
+	public:
+		profiler_cpu_zone(vren::profiler& profiler, char const* name);
+		profiler_cpu_zone(vren::profiler_cpu_zone const& other) = delete;
+		profiler_cpu_zone(vren::profiler_cpu_zone&& other) = delete;
+
+		~profiler_cpu_zone();
+	};
 }
@@ -7,6 +7,8 @@
 #include <fmt/format.h>
 
 #include "log.hpp"
+#include "profiler.hpp"
+#include "vk_helpers/command_recorder.hpp"
 #include "vk_helpers/vk_enums.hpp"
 
 #ifdef VREN_LOG_RENDER_GRAPH_DETAILED
@@ -248,11 +250,116 @@ void vren::detail::render_graph_executor::execute(vren::render_graph_allocator&
 // Render-graph executor
 // --------------------------------------------------------------------------------------------------------------------------------
 
-vren::render_graph_executor::render_graph_executor(uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container) :
+struct vren::render_graph_executor::deferred_step
+{
+	std::function<void(VkCommandBuffer command_buffer)> m_record_func; // An initial layout transition or a barrier, null for a node
+
+	vren::render_graph_node const* m_node = nullptr;
+	vren::secondary_command_buffer_future m_secondary_command_buffer; // Only valid if the node is recorded on a worker
+	std::shared_ptr<vren::resource_container> m_resource_container;   // The resources of the node recorded on a worker
+};
+
+vren::render_graph_executor::render_graph_executor(
+	uint32_t frame_idx,
+	VkCommandBuffer command_buffer,
+	vren::resource_container& resource_container,
+	vren::profiler* profiler,
+	vren::command_recorder* command_recorder
+) :
 	m_frame_idx(frame_idx),
 	m_command_buffer(command_buffer),
-	m_resource_container(&resource_container)
+	m_resource_container(&resource_container),
+	m_profiler(profiler),
+	m_command_recorder(command_recorder)
+{
+}
+
+vren::render_graph_executor::~render_graph_executor()
+{
+}
+
+void vren::render_graph_executor::record(std::function<void(VkCommandBuffer command_buffer)> record_func)
+{
+	if (m_command_recorder)
+	{
+		m_deferred_steps.push_back(deferred_step{ .m_record_func = std::move(record_func) });
+	}
+	else
+	{
+		record_func(m_command_buffer);
+	}
+}
+
+void vren::render_graph_executor::record_node(vren::render_graph_node const& node)
 {
+	if (m_profiler)
+	{
+		m_profiler->begin_node(m_command_buffer, m_frame_idx, node.get_name());
+	}
+
+	node(m_frame_idx, m_command_buffer, *m_resource_container);
+
+	if (m_profiler)
+	{
+		m_profiler->end_node(m_command_buffer, m_frame_idx);
+	}
+}
+
+void vren::render_graph_executor::record_deferred_steps()
+{
+	size_t step_idx = 0;
+	try
+	{
+		for (; step_idx < m_deferred_steps.size(); step_idx++)
+		{
+			deferred_step& step = m_deferred_steps.at(step_idx);
+
+			if (step.m_record_func)
+			{
+				step.m_record_func(m_command_buffer);
+			}
+			else if (step.m_secondary_command_buffer.valid())
+			{
+				auto secondary_command_buffer = std::make_shared<vren::pooled_vk_command_buffer>(step.m_secondary_command_buffer.get());
+
+				// The node is timestamped on the primary command buffer, around the execution of its secondary command buffer
+				if (m_profiler)
+				{
+					m_profiler->begin_node(m_command_buffer, m_frame_idx, step.m_node->get_name());
+				}
+
+				vkCmdExecuteCommands(m_command_buffer, 1, &secondary_command_buffer->m_handle);
+
+				if (m_profiler)
+				{
+					m_profiler->end_node(m_command_buffer, m_frame_idx);
+				}
+
+				m_resource_container->inherit(*step.m_resource_container);
+				m_resource_container->add_resource(secondary_command_buffer);
+			}
+			else
+			{
+				record_node(*step.m_node);
+			}
+		}
+	}
+	catch (...)
+	{
+		// The workers may still be recording the following nodes, they mustn't outlive the graph
+		for (; step_idx < m_deferred_steps.size(); step_idx++)
+		{
+			if (m_deferred_steps.at(step_idx).m_secondary_command_buffer.valid())
+			{
+				m_deferred_steps.at(step_idx).m_secondary_command_buffer.wait();
+			}
+		}
+
+		m_deferred_steps.clear();
+		throw;
+	}
+
+	m_deferred_steps.clear();
 }
 
 void vren::render_graph_executor::make_initial_image_layout_transition(vren::render_graph_node const& node, vren::render_graph_node_image_access const& image_access)
@@ -284,7 +391,10 @@ void vren::render_graph_executor::make_initial_image_layout_transition(vren::ren
 			.layerCount = 1
 		}
 	};
-	vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, node.get_src_stage(), NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	record([=, src_stage = node.get_src_stage()](VkCommandBuffer command_buffer)
+	{
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, src_stage, NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	});
 }
 
 void vren::render_graph_executor::execute_node(vren::render_graph_node const& node)
@@ -293,7 +403,41 @@ void vren::render_graph_executor::execute_node(vren::render_graph_node const& no
 	VREN_DEBUG("[render_graph] {}\n", fmt::format(fmt::fg(fmt::color::lime), "Executing node: {}", fmt::format(fmt::fg(fmt::color::yellow), node.get_name())));
 #endif
 
-	node(m_frame_idx, m_command_buffer, *m_resource_container);
+	if (!m_command_recorder)
+	{
+		record_node(node);
+		return;
+	}
+
+	// The nodes are recorded on the primary command buffer once the graph is traversed, the nodes marked for parallel recording are
+	// recorded on the workers meanwhile
+	deferred_step step{ .m_node = &node };
+
+	// The profiler scopes are opened by nodes too, it's unknown yet whether a pipeline statistics query will be active when the node is
+	// executed: without inherited queries the nodes are all recorded on the primary command buffer while profiling
+	bool parallel_recording = node.get_parallel_recording() && (!m_profiler || m_command_recorder->can_inherit_queries());
+	if (parallel_recording)
+	{
+		step.m_resource_container = std::make_shared<vren::resource_container>();
+
+		VkCommandBufferInheritanceInfo inheritance_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+			.pNext = nullptr,
+			.renderPass = VK_NULL_HANDLE,
+			.subpass = 0,
+			.framebuffer = VK_NULL_HANDLE,
+			.occlusionQueryEnable = VK_FALSE,
+			.queryFlags = NULL,
+			.pipelineStatistics = m_profiler ? vren::profiler::k_pipeline_statistics : 0, // A profiler scope may be open on the primary command buffer
+		};
+		step.m_secondary_command_buffer = m_command_recorder->record(inheritance_info,
+			[&node, frame_idx = m_frame_idx, resource_container = step.m_resource_container](VkCommandBuffer command_buffer)
+		{
+			node(frame_idx, command_buffer, *resource_container);
+		});
+	}
+
+	m_deferred_steps.push_back(std::move(step));
 }
 
 void vren::render_graph_executor::place_image_memory_barrier(
@@ -344,7 +488,10 @@ void vren::render_graph_executor::place_image_memory_barrier(
 			.layerCount = 1,
 		}
 	};
-	vkCmdPipelineBarrier(m_command_buffer, node_1.get_dst_stage(), node_2.get_src_stage(), NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	record([=, src_stage = node_1.get_dst_stage(), dst_stage = node_2.get_src_stage()](VkCommandBuffer command_buffer)
+	{
+		vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+	});
 }
 
 void vren::render_graph_executor::place_buffer_memory_barrier(
@@ -368,12 +515,20 @@ void vren::render_graph_executor::place_buffer_memory_barrier(
 		.offset = 0,//buffer_access_2.m_offset,
 		.size = VK_WHOLE_SIZE//buffer_access_1.m_size
 	};
-	vkCmdPipelineBarrier(m_command_buffer, node_1.get_dst_stage(), node_2.get_src_stage(), NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+	record([=, src_stage = node_1.get_dst_stage(), dst_stage = node_2.get_src_stage()](VkCommandBuffer command_buffer)
+	{
+		vkCmdPipelineBarrier(command_buffer, src_stage, dst_stage, NULL, 0, nullptr, 1, &buffer_memory_barrier, 0, nullptr);
+	});
 }
 
 void vren::render_graph_executor::execute(vren::render_graph_allocator& allocator, vren::render_graph_t const& graph)
 {
 	vren::detail::render_graph_executor::execute(allocator, graph);
+
+	if (m_command_recorder)
+	{
+		record_deferred_steps();
+	}
 }
 
 // --------------------------------------------------------------------------------------------------------------------------------
@@ -17,6 +17,8 @@ namespace vren
 {
 	// Forward decl
 	class render_graph_allocator;
+	class profiler;
+	class command_recorder;
 
 	// ------------------------------------------------------------------------------------------------
 	// Render-graph image resource
@@ -121,6 +123,8 @@ namespace vren
 		VkPipelineStageFlags m_src_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 		VkPipelineStageFlags m_dst_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
 
+		bool m_parallel_recording = false;
+
 		vren::static_vector_t<vren::render_graph_node_image_access, k_max_image_accesses> m_image_accesses;
 		vren::static_vector_t<vren::render_graph_node_buffer_access, k_max_buffer_accesses> m_buffer_accesses;
 
@@ -175,6 +179,19 @@ namespace vren
 			m_dst_stage = stage;
 		}
 
+		inline bool get_parallel_recording() const
+		{
+			return m_parallel_recording;
+		}
+
+		/// The node may be recorded into a secondary command buffer on a worker thread, concurrently with the other nodes of the graph
+		/// (see vren::render_graph_executor). Its callback then must not begin a render pass (dynamic rendering is fine), use the profiler
+		/// or write state that another node of the graph reads or writes while recording.
+		inline void set_parallel_recording(bool parallel_recording)
+		{
+			m_parallel_recording = parallel_recording;
+		}
+
 		inline auto const& get_image_accesses() const
 		{
 			return m_image_accesses;
@@ -472,13 +489,38 @@ namespace vren
 		) override;
 
 	private:
+		struct deferred_step; // Defined in render_graph.cpp
+
 		uint32_t m_frame_idx;
 		VkCommandBuffer m_command_buffer;
 		vren::resource_container* m_resource_container;
+		vren::profiler* m_profiler;
+		vren::command_recorder* m_command_recorder;
+
+		std::vector<deferred_step> m_deferred_steps;
+
+		void record(std::function<void(VkCommandBuffer command_buffer)> record_func);
+		void record_node(vren::render_graph_node const& node);
+		void record_deferred_steps();
 
 	public:
-		render_graph_executor(uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container);
-		
+		/** With a profiler, every node is timestamped under its name (see vren::profiler::begin_node).
+		 *
+		 * With a command recorder, the nodes marked for parallel recording are recorded into secondary command buffers on its workers
+		 * while the graph is traversed. The traversal only collects the steps: once it's done, the initial layout transitions, the barriers
+		 * and the other nodes are recorded on the primary command buffer in execution order, with the secondary command buffers executed
+		 * in place of their nodes. If the device doesn't support inherited queries, the nodes aren't recorded in parallel when there's a
+		 * profiler (a secondary command buffer can't be executed within a scope counting the pipeline statistics).
+		 */
+		render_graph_executor(
+			uint32_t frame_idx,
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container,
+			vren::profiler* profiler = nullptr,
+			vren::command_recorder* command_recorder = nullptr
+		);
+		~render_graph_executor();
+
 		void execute(vren::render_graph_allocator& allocator, vren::render_graph_t const& graph);
 	};
 
@@ -7,9 +7,11 @@
 
 vren::command_pool::command_pool(
 	vren::context const& ctx,
-	vren::vk_command_pool&& cmd_pool
+	vren::vk_command_pool&& cmd_pool,
+	VkCommandBufferLevel level
 ) :
 	m_context(&ctx),
+	m_level(level),
 	m_command_pool(std::move(cmd_pool))
 {
 }
@@ -18,9 +20,20 @@ vren::command_pool::~command_pool()
 {
 }
 
+void vren::command_pool::release(VkCommandBuffer&& command_buffer)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	vren::object_pool<VkCommandBuffer>::release(std::move(command_buffer));
+}
+
 vren::pooled_vk_command_buffer vren::command_pool::acquire()
 {
-	auto pooled = try_acquire();
+	std::optional<vren::pooled_vk_command_buffer> pooled;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		pooled = try_acquire();
+	}
+
 	if (pooled.has_value())
 	{
 		vkResetCommandBuffer(pooled.value().m_handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
@@ -31,7 +44,7 @@ vren::pooled_vk_command_buffer vren::command_pool::acquire()
     alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     alloc_info.pNext = nullptr;
     alloc_info.commandPool = m_command_pool.m_handle;
-    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    alloc_info.level = m_level;
     alloc_info.commandBufferCount = 1;
 
     VkCommandBuffer cmd_buf;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include <volk.h>
@@ -19,15 +20,23 @@ namespace vren
 	using pooled_vk_command_buffer = pooled_object<VkCommandBuffer>;
 
 	// TODO Doubt: does this class make any sense? Aren't we creating a pool of a pool?
+	/// The command buffers may be released from another thread than the one acquiring them (e.g. the secondary command buffers recorded
+	/// by the workers of vren::command_recorder, released with the resources of their frame), the unused list is synchronized.
     class command_pool : public vren::object_pool<VkCommandBuffer>
 	{
 	private:
 		vren::context const* m_context;
+		VkCommandBufferLevel m_level;
+
+		std::mutex m_mutex;
+
+	protected:
+		void release(VkCommandBuffer&& command_buffer) override;
 
 	public:
 		vren::vk_command_pool m_command_pool;
 
-		explicit command_pool(vren::context const& ctx, vren::vk_command_pool&& cmd_pool);
+		explicit command_pool(vren::context const& ctx, vren::vk_command_pool&& cmd_pool, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 		~command_pool();
 
 		pooled_vk_command_buffer acquire();
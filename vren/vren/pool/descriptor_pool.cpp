@@ -46,8 +46,16 @@ VkDescriptorSet vren::descriptor_pool::allocate_descriptor_set(VkDescriptorPool
 	return descriptor_set;
 }
 
+void vren::descriptor_pool::release(managed_vk_descriptor_set&& descriptor_set)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	vren::object_pool<managed_vk_descriptor_set>::release(std::move(descriptor_set));
+}
+
 vren::pooled_vk_descriptor_set vren::descriptor_pool::acquire(VkDescriptorSetLayout desc_set_layout)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
 	VkDescriptorPool desc_pool = VK_NULL_HANDLE;
 
 	if (m_unused_objects.size() > 0)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <span>
 
@@ -27,6 +28,7 @@ namespace vren
 
 	using pooled_vk_descriptor_set = vren::pooled_object<managed_vk_descriptor_set>;
 
+	/// Synchronized: the render graph nodes recorded on the workers of vren::command_recorder acquire their descriptor sets concurrently.
 	class descriptor_pool : public vren::object_pool<managed_vk_descriptor_set>
 	{
 	protected:
@@ -35,9 +37,13 @@ namespace vren
 		uint32_t m_max_sets;
 		std::vector<VkDescriptorPoolSize> m_pool_sizes;
 
+		std::mutex m_mutex; // Also guards the VkDescriptorPool(s), allocating and freeing descriptor sets requires external synchronization
+
 		virtual vren::vk_descriptor_pool create_descriptor_pool();
 		virtual VkDescriptorSet allocate_descriptor_set(VkDescriptorPool descriptor_pool, VkDescriptorSetLayout descriptor_set_layout);
 
+		void release(managed_vk_descriptor_set&& descriptor_set) override;
+
 	public:
 		std::vector<vren::vk_descriptor_pool> m_descriptor_pools;
 		size_t m_last_pool_allocated_count = 0;
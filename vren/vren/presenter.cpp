@@ -1,5 +1,6 @@
 #include "presenter.hpp"
 
+#include <algorithm>
 #include <iostream>
 
 #include "base/base.hpp"
@@ -14,8 +15,7 @@
 
 vren::swapchain_frame_data::swapchain_frame_data(vren::context const& ctx) :
 	m_image_available_semaphore(vren::vk_utils::create_semaphore(ctx)),
-	m_render_finished_semaphore(vren::vk_utils::create_semaphore(ctx)),
-	m_frame_fence(vren::vk_utils::create_fence(ctx, true))
+	m_render_finished_semaphore(vren::vk_utils::create_semaphore(ctx))
 {}
 
 // --------------------------------------------------------------------------------------------------------------------------------
@@ -40,7 +40,9 @@ vren::swapchain::swapchain(
 
 	m_frame_data(vren::create_array<vren::swapchain_frame_data, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t idx) {
 		return vren::swapchain_frame_data(*m_context);
-	}))
+	})),
+
+	m_timeline_semaphore(vren::vk_utils::create_timeline_semaphore(context))
 {
 	uint32_t image_count;
 	vkGetSwapchainImagesKHR(m_context->m_device, m_handle, &image_count, nullptr);
@@ -48,6 +50,37 @@ vren::swapchain::swapchain(
 	m_images.resize(image_count);
 	vkGetSwapchainImagesKHR(m_context->m_device, m_handle, &image_count, m_images.data());
 
+	create_image_views();
+}
+
+vren::swapchain::swapchain(
+	vren::context const& context,
+	std::vector<VkImage> images,
+	uint32_t image_width,
+	uint32_t image_height,
+	VkFormat format
+) :
+	m_context(&context),
+	m_handle(VK_NULL_HANDLE),
+
+	m_image_width(image_width),
+	m_image_height(image_height),
+	m_surface_format({ .format = format, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }),
+	m_present_mode(VK_PRESENT_MODE_IMMEDIATE_KHR),
+
+	m_images(std::move(images)),
+
+	m_frame_data(vren::create_array<vren::swapchain_frame_data, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t idx) {
+		return vren::swapchain_frame_data(*m_context);
+	})),
+
+	m_timeline_semaphore(vren::vk_utils::create_timeline_semaphore(context))
+{
+	create_image_views();
+}
+
+void vren::swapchain::create_image_views()
+{
 	for (VkImage image : m_images)
 	{
 		auto image_view = vren::vk_utils::create_image_view(*m_context, image, m_surface_format.format, VK_IMAGE_ASPECT_COLOR_BIT);
@@ -71,7 +104,10 @@ vren::swapchain::swapchain(swapchain&& other) :
 	m_images(std::move(other.m_images)),
 	m_image_views(std::move(other.m_image_views)),
 
-	m_frame_data(std::move(other.m_frame_data))
+	m_frame_data(std::move(other.m_frame_data)),
+
+	m_timeline_semaphore(std::move(other.m_timeline_semaphore)),
+	m_timeline_value(other.m_timeline_value)
 {
 	other.m_handle = VK_NULL_HANDLE;
 }
@@ -99,6 +135,9 @@ void vren::swapchain::swap(swapchain& other)
 	std::swap(m_present_mode, other.m_present_mode);
 
 	std::swap(m_frame_data, other.m_frame_data);
+
+	std::swap(m_timeline_semaphore, other.m_timeline_semaphore);
+	std::swap(m_timeline_value, other.m_timeline_value);
 }
 
 vren::swapchain& vren::swapchain::operator=(swapchain&& other)
@@ -107,6 +146,81 @@ vren::swapchain& vren::swapchain::operator=(swapchain&& other)
 	return *this;
 }
 
+void vren::swapchain::submit(
+	uint32_t frame_idx,
+	VkCommandBuffer command_buffer,
+	VkSemaphore wait_semaphore,
+	VkSemaphore signal_semaphore,
+	bool wait_last_submission
+)
+{
+	auto& frame_data = m_frame_data.at(frame_idx);
+
+	// The values of the binary semaphores are ignored
+	std::array<VkSemaphore, 2> wait_semaphores{};
+	std::array<uint64_t, 2> wait_values{};
+	std::array<VkPipelineStageFlags, 2> wait_dst_stages{};
+	uint32_t wait_semaphore_count = 0;
+
+	if (wait_semaphore != VK_NULL_HANDLE)
+	{
+		wait_semaphores[wait_semaphore_count] = wait_semaphore;
+		wait_dst_stages[wait_semaphore_count] = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		wait_semaphore_count++;
+	}
+
+	if (wait_last_submission)
+	{
+		wait_semaphores[wait_semaphore_count] = m_timeline_semaphore.m_handle;
+		wait_values[wait_semaphore_count] = frame_data.m_timeline_value;
+		wait_dst_stages[wait_semaphore_count] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		wait_semaphore_count++;
+	}
+
+	uint64_t timeline_value = m_timeline_value + 1;
+
+	std::array<VkSemaphore, 2> signal_semaphores{ m_timeline_semaphore.m_handle, signal_semaphore };
+	std::array<uint64_t, 2> signal_values{ timeline_value, 0 };
+	uint32_t signal_semaphore_count = signal_semaphore != VK_NULL_HANDLE ? 2 : 1;
+
+	VkTimelineSemaphoreSubmitInfo timeline_semaphore_submit_info{
+		.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+		.pNext = nullptr,
+		.waitSemaphoreValueCount = wait_semaphore_count,
+		.pWaitSemaphoreValues = wait_values.data(),
+		.signalSemaphoreValueCount = signal_semaphore_count,
+		.pSignalSemaphoreValues = signal_values.data(),
+	};
+	VkSubmitInfo submit_info{
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+		.pNext = &timeline_semaphore_submit_info,
+		.waitSemaphoreCount = wait_semaphore_count,
+		.pWaitSemaphores = wait_semaphores.data(),
+		.pWaitDstStageMask = wait_dst_stages.data(),
+		.commandBufferCount = 1,
+		.pCommandBuffers = &command_buffer,
+		.signalSemaphoreCount = signal_semaphore_count,
+		.pSignalSemaphores = signal_semaphores.data(),
+	};
+	VREN_CHECK(vkQueueSubmit(m_context->m_graphics_queue, 1, &submit_info, VK_NULL_HANDLE), m_context);
+
+	m_timeline_value = timeline_value;
+	frame_data.m_timeline_value = timeline_value;
+}
+
+void vren::swapchain::wait_timeline_value(uint64_t value) const
+{
+	VkSemaphoreWaitInfo wait_info{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.semaphoreCount = 1,
+		.pSemaphores = &m_timeline_semaphore.m_handle,
+		.pValues = &value,
+	};
+	VREN_CHECK(vkWaitSemaphores(m_context->m_device, &wait_info, UINT64_MAX), m_context);
+}
+
 // --------------------------------------------------------------------------------------------------------------------------------
 // Presenter
 // --------------------------------------------------------------------------------------------------------------------------------
@@ -114,8 +228,14 @@ vren::swapchain& vren::swapchain::operator=(swapchain&& other)
 vren::presenter::presenter(vren::context const& context, vren::vk_surface_khr const& surface, std::function<void(vren::swapchain const& swapchain)> const& swapchain_recreate_callback) :
 	m_context(&context),
 	m_surface(&surface),
-	m_swapchain_recreate_callback(swapchain_recreate_callback)
+	m_swapchain_recreate_callback(swapchain_recreate_callback),
+	m_timestamp_query_pool(create_timestamp_query_pool())
 {
+	m_timestamp_period = context.m_physical_device_properties.limits.timestampPeriod;
+
+	uint32_t timestamp_valid_bits = vren::vk_utils::get_queue_families_properties(context.m_physical_device).at(context.m_queue_families.m_graphics_idx).timestampValidBits;
+	m_timestamp_mask = timestamp_valid_bits >= 64 ? UINT64_MAX : (uint64_t(1) << timestamp_valid_bits) - 1;
+
 	m_present_queue_family_idx = context.m_queue_families.m_graphics_idx;
 
 	VkBool32 has_support;
@@ -158,13 +278,91 @@ VkPresentModeKHR vren::presenter::pick_present_mode(vren::vk_utils::surface_deta
     throw std::runtime_error("Unsupported present modes");
 }
 
+vren::vk_query_pool vren::presenter::create_timestamp_query_pool()
+{
+	VkQueryPoolCreateInfo query_pool_info{
+		.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.queryType = VK_QUERY_TYPE_TIMESTAMP,
+		.queryCount = VREN_MAX_FRAME_IN_FLIGHT_COUNT * 2,
+		.pipelineStatistics = NULL
+	};
+	VkQueryPool query_pool;
+	VREN_CHECK(vkCreateQueryPool(m_context->m_device, &query_pool_info, nullptr, &query_pool), m_context);
+	return vren::vk_query_pool(*m_context, query_pool);
+}
+
+void vren::presenter::read_timestamps(uint32_t frame_idx)
+{
+	if (!m_timestamps_written.at(frame_idx))
+	{
+		return;
+	}
+
+	// The frames in flight are read in turn, hence in submission order
+	uint64_t timestamps[2];
+	VREN_CHECK(vkGetQueryPoolResults(m_context->m_device, m_timestamp_query_pool.m_handle, frame_idx * 2, 2, sizeof(timestamps), &timestamps[0], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT), m_context);
+
+	uint64_t start_timestamp = timestamps[0] & m_timestamp_mask;
+	uint64_t end_timestamp = timestamps[1] & m_timestamp_mask;
+
+	m_timings.m_gpu_time.push(double((end_timestamp - start_timestamp) & m_timestamp_mask) * m_timestamp_period);
+
+	if (m_last_end_timestamp_valid)
+	{
+		// The frames can overlap on the GPU, the queue didn't wait then (a wrap-around of the counter is also taken as no wait)
+		uint64_t wait_ticks = start_timestamp > m_last_end_timestamp ? start_timestamp - m_last_end_timestamp : 0;
+		m_timings.m_gpu_wait_time.push(double(wait_ticks) * m_timestamp_period);
+	}
+
+	m_last_end_timestamp = end_timestamp;
+	m_last_end_timestamp_valid = true;
+
+	m_timestamps_written.at(frame_idx) = false;
+}
+
+VkCommandBuffer vren::presenter::begin_command_buffer(vren::resource_container& resource_container)
+{
+	auto cmd_buf = std::make_shared<vren::pooled_vk_command_buffer>(
+		m_context->m_toolbox->m_graphics_command_pool.acquire()
+	);
+	resource_container.add_resource(cmd_buf);
+
+	VkCommandBufferBeginInfo cmd_buf_begin_info{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.pNext = nullptr,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		.pInheritanceInfo = nullptr,
+	};
+	VREN_CHECK(vkBeginCommandBuffer(cmd_buf->m_handle, &cmd_buf_begin_info), m_context);
+
+	return cmd_buf->m_handle;
+}
+
+bool vren::presenter::acquire_next_image(vren::swapchain_frame_data& frame_data, uint32_t& image_idx, std::chrono::nanoseconds& acquire_time)
+{
+	auto acquire_start_time = std::chrono::steady_clock::now();
+	VkResult result = vkAcquireNextImageKHR(m_context->m_device, m_swapchain->m_handle, UINT64_MAX, frame_data.m_image_available_semaphore.m_handle, VK_NULL_HANDLE, &image_idx);
+	acquire_time = std::chrono::steady_clock::now() - acquire_start_time;
+
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		recreate_swapchain(m_swapchain->m_image_width, m_swapchain->m_image_height);
+		return false;
+	}
+	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	{
+		throw std::runtime_error("Acquirement of the next swapchain image failed");
+	}
+	return true;
+}
+
 void vren::presenter::recreate_swapchain(uint32_t width, uint32_t height)
 {
 	// If a swapchain was already created, waits for all the frames attached to the old swapchain to end before destroying it.
 	if (m_swapchain) {
-		for (auto& frame : m_swapchain->m_frame_data) {
-			VREN_CHECK(vkWaitForFences(m_context->m_device, 1, &frame.m_frame_fence.m_handle, VK_TRUE, UINT64_MAX), m_context);
-		}
+		m_swapchain->wait_idle();
 	}
 
 	auto surface_details = vren::vk_utils::get_surface_details(m_context->m_physical_device, m_surface->m_handle);
@@ -199,6 +397,10 @@ void vren::presenter::recreate_swapchain(uint32_t width, uint32_t height)
 
 	m_current_frame_idx = 0;
 
+	// The timestamps of the old swapchain's frames are dropped
+	m_timestamps_written.fill(false);
+	m_last_end_timestamp_valid = false;
+
 	VREN_INFO(
 		"[presenter] Swapchain re-created: Size {}x{} - Surface format: {:#x} - Surface color-space: {:#x} - Present mode: {:#x} - Image count: {} (min. requested: {})\n",
 		width, height, surface_format.format, surface_format.colorSpace, present_mode, m_swapchain->m_images.size(), min_image_count
@@ -208,6 +410,11 @@ void vren::presenter::recreate_swapchain(uint32_t width, uint32_t height)
 }
 
 void vren::presenter::present(render_func_t const& render_func)
+{
+	present(nullptr, render_func);
+}
+
+void vren::presenter::present(record_func_t const& record_func, render_func_t const& render_func)
 {
 	if (!m_swapchain)
 	{
@@ -217,57 +424,76 @@ void vren::presenter::present(render_func_t const& render_func)
 	VkResult result;
 	auto& frame_data = m_swapchain->m_frame_data.at(m_current_frame_idx);
 
-	VREN_CHECK(vkWaitForFences(m_context->m_device, 1, &frame_data.m_frame_fence.m_handle, VK_TRUE, UINT64_MAX), m_context);
-	vkResetFences(m_context->m_device, 1, &frame_data.m_frame_fence.m_handle);
+	// Waits for the frame submitted max frame latency frames before, which is the last use of this frame in flight or a later frame
+	uint32_t frame_in_flight_count = m_swapchain->get_frame_in_flight_count();
+	uint32_t frame_latency = std::clamp<uint32_t>(m_max_frame_latency, 1, frame_in_flight_count);
+
+	auto wait_start_time = std::chrono::steady_clock::now();
+	m_swapchain->wait_frame((m_current_frame_idx + frame_in_flight_count - frame_latency) % frame_in_flight_count);
+	std::chrono::nanoseconds frame_wait_time = std::chrono::steady_clock::now() - wait_start_time;
+
+	read_timestamps(m_current_frame_idx);
 
 	frame_data.m_resource_container.clear();
 
 	/* Command buffer init */
-	auto cmd_buf = std::make_shared<vren::pooled_vk_command_buffer>(
-		m_context->m_toolbox->m_graphics_command_pool.acquire()
-	);
-	frame_data.m_resource_container.add_resource(cmd_buf);
+	VkCommandBuffer cmd_buf = begin_command_buffer(frame_data.m_resource_container);
 
-	VkCommandBufferBeginInfo cmd_buf_begin_info{
-		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-		.pNext = nullptr,
-		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-		.pInheritanceInfo = nullptr,
-	};
-	VREN_CHECK(vkBeginCommandBuffer(cmd_buf->m_handle, &cmd_buf_begin_info), m_context);
+	vkCmdResetQueryPool(cmd_buf, m_timestamp_query_pool.m_handle, m_current_frame_idx * 2, 2);
+	vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestamp_query_pool.m_handle, m_current_frame_idx * 2 + 0);
 
 	/* Image acquirement */
 	uint32_t img_idx;
-	result = vkAcquireNextImageKHR(m_context->m_device, m_swapchain->m_handle, UINT64_MAX, frame_data.m_image_available_semaphore.m_handle, VK_NULL_HANDLE, &img_idx);
-	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	std::chrono::nanoseconds acquire_time;
+
+	bool late_acquire = m_late_acquire && record_func;
+	if (late_acquire)
 	{
-		recreate_swapchain(m_swapchain->m_image_width, m_swapchain->m_image_height);
-		return;
+		// The first part of the frame is submitted before the image is acquired, the second part waits for it
+		record_func(m_current_frame_idx, cmd_buf, frame_data.m_resource_container);
+
+		VREN_CHECK(vkEndCommandBuffer(cmd_buf), m_context);
+		m_swapchain->submit(m_current_frame_idx, cmd_buf);
+
+		if (!acquire_next_image(frame_data, img_idx, acquire_time))
+		{
+			return;
+		}
+
+		cmd_buf = begin_command_buffer(frame_data.m_resource_container);
 	}
-	else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+	else
 	{
-		throw std::runtime_error("Acquirement of the next swapchain image failed");
+		if (!acquire_next_image(frame_data, img_idx, acquire_time))
+		{
+			return;
+		}
+
+		if (record_func)
+		{
+			record_func(m_current_frame_idx, cmd_buf, frame_data.m_resource_container);
+		}
 	}
 
 	// Frame callback
-	render_func(m_current_frame_idx, img_idx, *m_swapchain, cmd_buf->m_handle, frame_data.m_resource_container);
+	render_func(m_current_frame_idx, img_idx, *m_swapchain, cmd_buf, frame_data.m_resource_container);
+
+	vkCmdWriteTimestamp(cmd_buf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestamp_query_pool.m_handle, m_current_frame_idx * 2 + 1);
 
 	// Submit
-	VREN_CHECK(vkEndCommandBuffer(cmd_buf->m_handle), m_context);
+	VREN_CHECK(vkEndCommandBuffer(cmd_buf), m_context);
+	m_swapchain->submit(
+		m_current_frame_idx,
+		cmd_buf,
+		frame_data.m_image_available_semaphore.m_handle,
+		frame_data.m_render_finished_semaphore.m_handle,
+		late_acquire // The timeline signal of a submission only covers its own commands: the frame's value must imply the first part's
+	);
 
-	VkPipelineStageFlags wait_dst_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-	VkSubmitInfo submit_info{
-		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-		.pNext = nullptr,
-		.waitSemaphoreCount = 1,
-		.pWaitSemaphores = &frame_data.m_image_available_semaphore.m_handle,
-		.pWaitDstStageMask = &wait_dst_stages,
-		.commandBufferCount = 1,
-		.pCommandBuffers = &cmd_buf->m_handle,
-		.signalSemaphoreCount = 1,
-		.pSignalSemaphores = &frame_data.m_render_finished_semaphore.m_handle,
-	};
-	VREN_CHECK(vkQueueSubmit(m_context->m_graphics_queue, 1, &submit_info, frame_data.m_frame_fence.m_handle), m_context);
+	m_timestamps_written.at(m_current_frame_idx) = true;
+
+	m_timings.m_cpu_wait_time.push(double((frame_wait_time + acquire_time).count()));
+	m_timings.m_acquire_time.push(double(acquire_time.count()));
 
 	// Present
 	VkPresentInfoKHR present_info{
@@ -291,8 +517,7 @@ void vren::presenter::present(render_func_t const& render_func)
 		throw std::runtime_error("Failed to present the swapchain image");
 	}
 
-	// The number of frame-in-flight(s) actually used can't exceed the number of swapchain images
-	m_current_frame_idx = (m_current_frame_idx + 1) % std::min<uint32_t>(VREN_MAX_FRAME_IN_FLIGHT_COUNT, m_swapchain->m_images.size());
+	m_current_frame_idx = (m_current_frame_idx + 1) % frame_in_flight_count;
 }
 
 // --------------------------------------------------------------------------------------------------------------------------------
@@ -357,3 +582,68 @@ vren::render_graph_t vren::transit_swapchain_image_to_present_layout(
 	node->set_callback([](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container) {});
 	return vren::render_graph_gather(node);
 }
+
+vren::render_graph_t vren::transit_color_buffer_to_blit_layout(
+	vren::render_graph_allocator& allocator,
+	vren::vk_utils::color_buffer_t const& color_buffer
+)
+{
+	auto node = allocator.allocate();
+	node->set_name("transit_color_buffer_to_blit_layout");
+	node->set_src_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+	node->set_dst_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+	node->add_image({
+		.m_name = "color_buffer",
+		.m_image = color_buffer.get_image(),
+		.m_image_aspect = VK_IMAGE_ASPECT_COLOR_BIT,
+	}, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+	node->set_callback([](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container) {});
+	return vren::render_graph_gather(node);
+}
+
+void vren::record_blit_color_buffer_to_swapchain_image(
+	VkCommandBuffer command_buffer,
+	vren::vk_utils::color_buffer_t const& color_buffer,
+	uint32_t width,
+	uint32_t height,
+	VkImage swapchain_image,
+	uint32_t swapchain_image_width,
+	uint32_t swapchain_image_height
+)
+{
+	vren::vk_utils::transition_image_layout_undefined_to_transfer_dst(command_buffer, swapchain_image);
+
+	VkImageBlit image_blit{
+		.srcSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1 },
+		.srcOffsets = {
+			{ 0, 0, 0 },
+			{ (int32_t) width, (int32_t) height, 1 },
+		},
+		.dstSubresource = { .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = 0, .baseArrayLayer = 0, .layerCount = 1, },
+		.dstOffsets = {
+			{ 0, 0, 0 },
+			{ (int32_t) swapchain_image_width, (int32_t) swapchain_image_height, 1 }
+		},
+	};
+	vkCmdBlitImage(command_buffer, color_buffer.get_image(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapchain_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &image_blit, VK_FILTER_LINEAR);
+
+	VkImageMemoryBarrier image_memory_barrier{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.pNext = nullptr,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_NONE_KHR,
+		.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = swapchain_image,
+		.subresourceRange = {
+			.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		}
+	};
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, NULL, 0, nullptr, 0, nullptr, 1, &image_memory_barrier);
+}
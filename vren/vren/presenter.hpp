@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <vector>
 #include <functional>
 
@@ -9,6 +12,7 @@
 #include "vk_helpers/misc.hpp"
 #include "light.hpp"
 #include "base/resource_container.hpp"
+#include "base/rolling_statistics.hpp"
 #include "pipeline/render_graph.hpp"
 
 namespace vren
@@ -25,7 +29,10 @@ namespace vren
 		vren::vk_semaphore m_image_available_semaphore;
 		vren::vk_semaphore m_render_finished_semaphore;
 
-		vren::vk_fence m_frame_fence;
+		/**
+		 * The value of the swapchain's timeline semaphore signaled by the last submission of the frame, 0 if the frame was never submitted.
+		 */
+		uint64_t m_timeline_value = 0;
 
 		/**
 		 * The resource container holds the resources that are in-use by the frame and ensures they live enough.
@@ -45,7 +52,7 @@ namespace vren
 		vren::context const* m_context;
 
 	public:
-		VkSwapchainKHR m_handle;
+		VkSwapchainKHR m_handle; // VK_NULL_HANDLE for the offscreen images of vren::offscreen_presenter
 
 		uint32_t m_image_width, m_image_height;
 		VkSurfaceFormatKHR m_surface_format;
@@ -56,6 +63,9 @@ namespace vren
 
 		std::array<vren::swapchain_frame_data, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_frame_data;
 
+		vren::vk_semaphore m_timeline_semaphore; // Signaled by every submission of the frames with increasing values
+		uint64_t m_timeline_value = 0;           // The value of the last submission
+
 		swapchain(
 			vren::context const& context,
 			VkSwapchainKHR handle,
@@ -64,6 +74,16 @@ namespace vren
             VkSurfaceFormatKHR surface_format,
             VkPresentModeKHR present_mode
 		);
+
+		/// Offscreen images owned by the caller, presented by vren::offscreen_presenter.
+		swapchain(
+			vren::context const& context,
+			std::vector<VkImage> images,
+			uint32_t image_width,
+			uint32_t image_height,
+			VkFormat format
+		);
+
 		swapchain(swapchain const& other) = delete;
 		swapchain(swapchain&& other);
 		~swapchain();
@@ -72,8 +92,40 @@ namespace vren
 		void swap(swapchain& other);
 
 		std::vector<VkImage> get_swapchain_images();
+		void create_image_views();
 
 	public:
+		/// The number of frames in flight actually used, it can't exceed the number of images.
+		inline uint32_t get_frame_in_flight_count() const
+		{
+			return std::min<uint32_t>(VREN_MAX_FRAME_IN_FLIGHT_COUNT, (uint32_t) m_images.size());
+		}
+
+		/// Submits a command buffer of the frame to the graphics queue, it signals the timeline semaphore with a new value that becomes the
+		/// frame's one. The wait semaphore is waited at the top of the pipe and, if wait_last_submission is set, the last submission of the
+		/// frame must complete before the command buffer starts.
+		void submit(
+			uint32_t frame_idx,
+			VkCommandBuffer command_buffer,
+			VkSemaphore wait_semaphore = VK_NULL_HANDLE,
+			VkSemaphore signal_semaphore = VK_NULL_HANDLE,
+			bool wait_last_submission = false
+		);
+
+		void wait_timeline_value(uint64_t value) const;
+
+		/// Waits for the last submission of the frame to complete, its data can then be reused.
+		inline void wait_frame(uint32_t frame_idx) const
+		{
+			wait_timeline_value(m_frame_data.at(frame_idx).m_timeline_value);
+		}
+
+		/// Waits for all the frames submitted to complete.
+		inline void wait_idle() const
+		{
+			wait_timeline_value(m_timeline_value);
+		}
+
 		swapchain& operator=(swapchain const& other) = delete;
 		swapchain& operator=(swapchain&& other);
 	};
@@ -82,6 +134,25 @@ namespace vren
 	// Presenter
 	// --------------------------------------------------------------------------------------------------------------------------------
 
+	/// The wait times of the last frames, in nanoseconds. The GPU times are read when the frame in flight is used again, so they lag the CPU
+	/// times by the number of frames in flight.
+	struct presenter_timings
+	{
+		vren::rolling_statistics m_cpu_wait_time; // Blocked on the previous frames (frame latency) and on the image acquirement
+		vren::rolling_statistics m_acquire_time;  // The part of the CPU wait spent acquiring the image
+		vren::rolling_statistics m_gpu_wait_time; // Graphics queue idle between the end of the previous frame and the start of the frame
+		vren::rolling_statistics m_gpu_time;      // From the start of the frame's first command buffer to the end of its last one
+	};
+
+	/** Presents the frames to the swapchain. The frames are synchronized with the swapchain's timeline semaphore: before recording a frame,
+	 * the presenter waits for the frame submitted max frame latency frames before to complete. A latency of 1 never overlaps the CPU and
+	 * the GPU work of two frames (lowest input latency), the number of frames in flight (the default) overlaps them the most (highest
+	 * throughput).
+	 *
+	 * With late acquire, the swapchain image is acquired only once the part of the frame that doesn't write it (the record function) has
+	 * been recorded and submitted, the render function then records the commands writing the image in a second command buffer. The CPU
+	 * doesn't wait for the image before recording and the GPU starts rendering the frame before the image is available.
+	 */
 	class presenter
 	{
 	public:
@@ -99,6 +170,18 @@ namespace vren
 		uint32_t m_present_queue_family_idx = -1;
 		uint32_t m_current_frame_idx = 0;
 
+		uint32_t m_max_frame_latency = VREN_MAX_FRAME_IN_FLIGHT_COUNT;
+		bool m_late_acquire = false;
+
+		vren::vk_query_pool m_timestamp_query_pool; // 2 queries per frame in flight: start and end of the frame
+		std::array<bool, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_timestamps_written{};
+		double m_timestamp_period; // Nanoseconds per tick
+		uint64_t m_timestamp_mask; // The valid bits of the timestamps
+		bool m_last_end_timestamp_valid = false;
+		uint64_t m_last_end_timestamp = 0;
+
+		vren::presenter_timings m_timings;
+
 	public:
 		presenter(vren::context const& context, vren::vk_surface_khr const& surface, std::function<void(vren::swapchain const& swapchain)> const& swapchain_recreate_callback);
 
@@ -107,14 +190,53 @@ namespace vren
 		VkSurfaceFormatKHR pick_surface_format(vren::vk_utils::surface_details const& surf_details);
 		VkPresentModeKHR pick_present_mode(vren::vk_utils::surface_details const& surf_details);
 
+		vren::vk_query_pool create_timestamp_query_pool();
+		void read_timestamps(uint32_t frame_idx);
+
+		VkCommandBuffer begin_command_buffer(vren::resource_container& resource_container);
+		bool acquire_next_image(vren::swapchain_frame_data& frame_data, uint32_t& image_idx, std::chrono::nanoseconds& acquire_time);
+
 	public:
 		inline vren::swapchain* get_swapchain() const
 		{
 			return m_swapchain.get();
 		}
 
+		inline uint32_t get_max_frame_latency() const
+		{
+			return m_max_frame_latency;
+		}
+
+		/// The latency is clamped between 1 and the number of frames in flight used.
+		inline void set_max_frame_latency(uint32_t max_frame_latency)
+		{
+			m_max_frame_latency = max_frame_latency;
+		}
+
+		inline bool get_late_acquire() const
+		{
+			return m_late_acquire;
+		}
+
+		/// Only applies to the frames presented with a record function.
+		inline void set_late_acquire(bool late_acquire)
+		{
+			m_late_acquire = late_acquire;
+		}
+
+		inline vren::presenter_timings const& get_timings() const
+		{
+			return m_timings;
+		}
+
 		void recreate_swapchain(uint32_t width, uint32_t height);
 
+		using record_func_t = std::function<void(
+			uint32_t frame_idx,
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container
+		)>;
+
 		using render_func_t = std::function<void(
 			uint32_t frame_idx,
 			uint32_t swapchain_image_idx,
@@ -123,6 +245,10 @@ namespace vren
 			vren::resource_container& resource_container
 		)>;
 		void present(render_func_t const& render_func);
+
+		/// Presents a frame split in the commands that don't write the swapchain image (record_func) and the ones that do (render_func), the
+		/// image is acquired in between with late acquire. Without, both are recorded in the same command buffer after the acquirement.
+		void present(record_func_t const& record_func, render_func_t const& render_func);
 	};
 
 	// --------------------------------------------------------------------------------------------------------------------------------
@@ -139,5 +265,23 @@ namespace vren
 		vren::render_graph_allocator& allocator,
 		VkImage swapchain_image
 	);
+
+	/// Ends a render graph leaving the color buffer ready to be blit to the swapchain image by a later command buffer, see
+	/// vren::record_blit_color_buffer_to_swapchain_image.
+	vren::render_graph_t transit_color_buffer_to_blit_layout(
+		vren::render_graph_allocator& allocator,
+		vren::vk_utils::color_buffer_t const& color_buffer
+	);
+
+	/// Records the blit of a color buffer transited by vren::transit_color_buffer_to_blit_layout earlier in submission order (e.g. in the
+	/// record function of a late acquired frame) and leaves the swapchain image in the present layout. A render graph can't be used there:
+	/// its initial layout transition of the color buffer would discard the frame.
+	void record_blit_color_buffer_to_swapchain_image(
+		VkCommandBuffer command_buffer,
+		vren::vk_utils::color_buffer_t const& color_buffer,
+		uint32_t width, uint32_t height,
+		VkImage swapchain_image,
+		uint32_t swapchain_image_width, uint32_t swapchain_image_height
+	);
 }
 
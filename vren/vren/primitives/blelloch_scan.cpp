@@ -6,21 +6,33 @@
 #include <fmt/format.h>
 
 #include "toolbox.hpp"
+#include "primitives/primitive_tuning.hpp"
+
+vren::pipeline_futures<2> vren::blelloch_scan::create_pipelines(vren::context const& context)
+{
+    uint32_t workgroup_size = vren::get_primitive_tuning(context).m_blelloch_scan_workgroup_size;
+
+    auto specialize = [workgroup_size](vren::specialized_shader& shader)
+    {
+        shader.set_specialization_data(0, &workgroup_size, sizeof(uint32_t)); // local_size_x_id = 0
+    };
+
+    return {
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/blelloch_scan_downsweep.comp.spv", specialize),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/blelloch_scan_workgroup_downsweep.comp.spv", specialize)
+    };
+}
 
 vren::blelloch_scan::blelloch_scan(vren::context const& context) :
+    blelloch_scan(context, create_pipelines(context))
+{
+}
+
+vren::blelloch_scan::blelloch_scan(vren::context const& context, vren::pipeline_futures<2> pipelines) :
     m_context(&context),
-    m_downsweep_pipeline([&]()
-    {
-        vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/blelloch_scan_downsweep.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_mod);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_workgroup_downsweep_pipeline([&]()
-    {
-        vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/blelloch_scan_workgroup_downsweep.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_mod);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_workgroup_size(vren::get_primitive_tuning(context).m_blelloch_scan_workgroup_size),
+    m_downsweep_pipeline(pipelines[0].get()),
+    m_workgroup_downsweep_pipeline(pipelines[1].get())
 {
 }
 
@@ -84,7 +96,7 @@ void vren::blelloch_scan::downsweep(
     uint32_t num_items = 1; // TODO num_items could be dynamically calculated
     assert(num_items <= k_max_items);
 
-    int32_t levels_per_workgroup = glm::log2<int32_t>(k_workgroup_size * num_items);
+    int32_t levels_per_workgroup = glm::log2<int32_t>(m_workgroup_size * num_items);
 
     // Downsweep (on global memory)
     for (int32_t level = glm::log2(length) - 1, i = 0; level > levels_per_workgroup - 1; level--, i++)
@@ -101,7 +113,7 @@ void vren::blelloch_scan::downsweep(
 
         m_downsweep_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
 
-        uint32_t workgroups_num = vren::divide_and_ceil(1 << i, k_workgroup_size * num_items);
+        uint32_t workgroups_num = vren::divide_and_ceil(1 << i, m_workgroup_size * num_items);
         m_downsweep_pipeline.dispatch(command_buffer, workgroups_num, blocks_num, 1);
 
         VkBufferMemoryBarrier buffer_memory_barrier{
@@ -134,7 +146,7 @@ void vren::blelloch_scan::downsweep(
 
     m_workgroup_downsweep_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set->m_handle.m_descriptor_set);
 
-    uint32_t workgroups_num = vren::divide_and_ceil(length, k_workgroup_size * num_items);
+    uint32_t workgroups_num = vren::divide_and_ceil(length, m_workgroup_size * num_items);
     m_workgroup_downsweep_pipeline.dispatch(command_buffer, workgroups_num, blocks_num, 1);
 }
 
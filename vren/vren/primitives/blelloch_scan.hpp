@@ -2,22 +2,32 @@
 
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 #include "primitives/reduce.hpp"
 
 namespace vren
 {
+    /// The workgroup size is a specialization constant (see vren::primitive_tuning).
     class blelloch_scan
     {
     public:
-        inline static const uint32_t k_workgroup_size = 1024;
         inline static const uint32_t k_max_items = 1;
 
     private:
         vren::context const* m_context;
+        uint32_t m_workgroup_size;
         vren::pipeline m_downsweep_pipeline, m_workgroup_downsweep_pipeline;
 
     public:
+        static vren::pipeline_futures<2> create_pipelines(vren::context const& context);
+
         blelloch_scan(vren::context const& context);
+        blelloch_scan(vren::context const& context, vren::pipeline_futures<2> pipelines);
+
+        inline uint32_t get_workgroup_size() const
+        {
+            return m_workgroup_size;
+        }
 
     private:
         void write_descriptor_set(
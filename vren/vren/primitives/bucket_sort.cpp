@@ -3,22 +3,34 @@
 #include "context.hpp"
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
+#include "primitives/primitive_tuning.hpp"
+
+vren::pipeline_futures<2> vren::bucket_sort::create_pipelines(vren::context const& context)
+{
+    uint32_t workgroup_size = vren::get_primitive_tuning(context).m_bucket_sort_workgroup_size;
+
+    auto specialize = [workgroup_size](vren::specialized_shader& shader)
+    {
+        shader.set_specialization_data(0, &workgroup_size, sizeof(uint32_t)); // local_size_x_id = 0
+    };
+
+    return {
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/bucket_sort_count.comp.spv", specialize),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/bucket_sort_write.comp.spv", specialize)
+    };
+}
 
 vren::bucket_sort::bucket_sort(vren::context const& context) :
+    bucket_sort(context, create_pipelines(context))
+{
+}
+
+vren::bucket_sort::bucket_sort(vren::context const& context, vren::pipeline_futures<2> pipelines) :
     m_context(&context),
+    m_workgroup_size(vren::get_primitive_tuning(context).m_bucket_sort_workgroup_size),
     m_descriptor_set_layout(create_descriptor_set_layout()),
-    m_count_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/bucket_sort_count.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_write_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/bucket_sort_write.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_count_pipeline(pipelines[0].get()),
+    m_write_pipeline(pipelines[1].get())
 {}
 
 vren::vk_descriptor_set_layout vren::bucket_sort::create_descriptor_set_layout()
@@ -85,7 +97,7 @@ void vren::bucket_sort::operator()(
 
     size_t bucket_count_buffer_offset = output_buffer_offset + vren::round_to_next_multiple_of(input_buffer_length * sizeof(glm::uvec2), (size_t) VREN_MIN_STORAGE_BUFFER_OFFSET_ALIGNMENT);
 
-    const uint32_t num_workgroups = vren::divide_and_ceil(input_buffer_length, k_workgroup_size);
+    const uint32_t num_workgroups = vren::divide_and_ceil(input_buffer_length, m_workgroup_size);
 
     auto descriptor_set = std::make_shared<vren::pooled_vk_descriptor_set>(
         m_context->m_toolbox->m_descriptor_pool.acquire(m_descriptor_set_layout.m_handle)
@@ -1,15 +1,16 @@
 #pragma once
 
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/vk_raii.hpp"
 
 namespace vren
 {
+    /// The workgroup size is a specialization constant (see vren::primitive_tuning).
     class bucket_sort
     {
     public:
-        inline static const uint32_t k_workgroup_size = 1024;
         inline static const uint32_t k_max_items = 1;
 
         inline static const uint32_t k_key_size = 1 << 16;
@@ -17,6 +18,7 @@ namespace vren
 
     private:
         vren::context const* m_context;
+        uint32_t m_workgroup_size;
 
         vren::vk_descriptor_set_layout m_descriptor_set_layout;
 
@@ -24,7 +26,10 @@ namespace vren
         vren::pipeline m_write_pipeline;
 
     public:
+        static vren::pipeline_futures<2> create_pipelines(vren::context const& context);
+
         bucket_sort(vren::context const& context);
+        bucket_sort(vren::context const& context, vren::pipeline_futures<2> pipelines);
 
     private:
         vren::vk_descriptor_set_layout create_descriptor_set_layout();
@@ -5,14 +5,19 @@
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
 
+vren::pipeline_future vren::build_bvh::create_pipeline(vren::context const& context)
+{
+    return vren::create_compute_pipeline_async(context, ".vren/resources/shaders/build_bvh.comp.spv");
+}
+
 vren::build_bvh::build_bvh(vren::context const& context) :
+    build_bvh(context, create_pipeline(context))
+{
+}
+
+vren::build_bvh::build_bvh(vren::context const& context, vren::pipeline_future pipeline) :
     m_context(&context),
-    m_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, ".vren/resources/shaders/build_bvh.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_pipeline(pipeline.get())
 {
 }
 
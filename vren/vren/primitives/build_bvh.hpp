@@ -2,6 +2,7 @@
 
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 
 namespace vren
 {
@@ -11,7 +12,7 @@ namespace vren
         inline static const uint32_t k_invalid_node = 0xFFFFFFFEu;
 
         glm::vec3 m_min; uint32_t m_next;
-        glm::vec3 m_max; uint32_t _pad;
+        glm::vec3 m_max; float m_radius; // The radius of the bounding sphere centered in the AABB center, it must be written for leaves
 
         inline bool is_leaf() const { return m_next == k_leaf_node; };
         inline bool is_invalid() const { return m_next == k_invalid_node; };
@@ -28,7 +29,10 @@ namespace vren
         vren::pipeline m_pipeline;
 
     public:
+        static vren::pipeline_future create_pipeline(vren::context const& context);
+
         build_bvh(vren::context const& context);
+        build_bvh(vren::context const& context, vren::pipeline_future pipeline);
 
     private:
         void write_descriptor_set(
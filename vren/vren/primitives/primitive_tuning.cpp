@@ -0,0 +1,70 @@
+#include "primitive_tuning.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "context.hpp"
+
+namespace
+{
+    constexpr uint32_t k_vendor_id_amd = 0x1002;
+    constexpr uint32_t k_vendor_id_nvidia = 0x10DE;
+    constexpr uint32_t k_vendor_id_intel = 0x8086;
+
+    constexpr vren::primitive_tuning_table_entry k_primitive_tuning_table[]{
+        // Warps of 32 invocations, large workgroups keep the number of reduction dispatches low
+        { .m_vendor_id = k_vendor_id_nvidia, .m_device_id = 0, .m_subgroup_size = 32, .m_tuning = { .m_reduce_workgroup_size = 1024, .m_blelloch_scan_workgroup_size = 1024, .m_bucket_sort_workgroup_size = 1024, }, },
+
+        // Wave64 (GCN) and wave32 (RDNA), smaller workgroups occupy the compute units better than 1024-wide ones
+        { .m_vendor_id = k_vendor_id_amd, .m_device_id = 0, .m_subgroup_size = 64, .m_tuning = { .m_reduce_workgroup_size = 256, .m_blelloch_scan_workgroup_size = 512, .m_bucket_sort_workgroup_size = 256, }, },
+        { .m_vendor_id = k_vendor_id_amd, .m_device_id = 0, .m_subgroup_size = 32, .m_tuning = { .m_reduce_workgroup_size = 512, .m_blelloch_scan_workgroup_size = 512, .m_bucket_sort_workgroup_size = 256, }, },
+
+        // SIMD8 to SIMD32 depending on the generation
+        { .m_vendor_id = k_vendor_id_intel, .m_device_id = 0, .m_subgroup_size = 0, .m_tuning = { .m_reduce_workgroup_size = 256, .m_blelloch_scan_workgroup_size = 256, .m_bucket_sort_workgroup_size = 256, }, },
+
+        // Any device, clamped to its limits
+        { .m_vendor_id = 0, .m_device_id = 0, .m_subgroup_size = 0, .m_tuning = { .m_reduce_workgroup_size = 1024, .m_blelloch_scan_workgroup_size = 1024, .m_bucket_sort_workgroup_size = 1024, }, },
+    };
+
+    uint32_t clamp_workgroup_size(uint32_t workgroup_size, uint32_t max_workgroup_size, uint32_t subgroup_size)
+    {
+        return std::max(std::bit_floor(std::min(workgroup_size, max_workgroup_size)), subgroup_size);
+    }
+}
+
+std::span<vren::primitive_tuning_table_entry const> vren::get_primitive_tuning_table()
+{
+    return k_primitive_tuning_table;
+}
+
+vren::primitive_tuning vren::find_primitive_tuning(
+    VkPhysicalDeviceProperties const& physical_device_properties,
+    uint32_t subgroup_size
+)
+{
+    auto matches = [&](vren::primitive_tuning_table_entry const& entry)
+    {
+        return
+            (entry.m_vendor_id == 0 || entry.m_vendor_id == physical_device_properties.vendorID) &&
+            (entry.m_device_id == 0 || entry.m_device_id == physical_device_properties.deviceID) &&
+            (entry.m_subgroup_size == 0 || entry.m_subgroup_size == subgroup_size);
+    };
+
+    std::span<vren::primitive_tuning_table_entry const> table = get_primitive_tuning_table();
+    vren::primitive_tuning tuning = std::find_if(table.begin(), table.end(), matches)->m_tuning; // The last entry always matches
+
+    VkPhysicalDeviceLimits const& limits = physical_device_properties.limits;
+    uint32_t max_workgroup_size = std::min(limits.maxComputeWorkGroupSize[0], limits.maxComputeWorkGroupInvocations);
+
+    // The reduction keeps one element per invocation in shared memory (vec4 at most), the scan one uint
+    tuning.m_reduce_workgroup_size = clamp_workgroup_size(tuning.m_reduce_workgroup_size, std::min<uint32_t>(max_workgroup_size, limits.maxComputeSharedMemorySize / (4 * sizeof(float))), subgroup_size);
+    tuning.m_blelloch_scan_workgroup_size = clamp_workgroup_size(tuning.m_blelloch_scan_workgroup_size, std::min<uint32_t>(max_workgroup_size, limits.maxComputeSharedMemorySize / sizeof(uint32_t)), subgroup_size);
+    tuning.m_bucket_sort_workgroup_size = clamp_workgroup_size(tuning.m_bucket_sort_workgroup_size, max_workgroup_size, subgroup_size);
+
+    return tuning;
+}
+
+vren::primitive_tuning vren::get_primitive_tuning(vren::context const& context)
+{
+    return find_primitive_tuning(context.m_physical_device_properties, context.m_physical_device_subgroup_properties.subgroupSize);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+#include <volk.h>
+
+namespace vren
+{
+    // Forward decl
+    class context;
+
+    /// The configuration of the primitives for a device, passed to their shaders as specialization constants. The workgroup sizes are powers of two.
+    struct primitive_tuning
+    {
+        uint32_t m_reduce_workgroup_size;
+        uint32_t m_blelloch_scan_workgroup_size;
+        uint32_t m_bucket_sort_workgroup_size;
+    };
+
+    struct primitive_tuning_table_entry
+    {
+        uint32_t m_vendor_id;     // 0 matches any vendor
+        uint32_t m_device_id;     // 0 matches any device of the vendor
+        uint32_t m_subgroup_size; // 0 matches any subgroup size
+        vren::primitive_tuning m_tuning;
+    };
+
+    /// Searched in order: the entries for specific devices come before the per-vendor ones, the last entry matches any device.
+    std::span<vren::primitive_tuning_table_entry const> get_primitive_tuning_table();
+
+    /// Takes the first entry of the table matching the device, then clamps the workgroup sizes to the device limits.
+    vren::primitive_tuning find_primitive_tuning(
+        VkPhysicalDeviceProperties const& physical_device_properties,
+        uint32_t subgroup_size
+    );
+
+    vren::primitive_tuning get_primitive_tuning(vren::context const& context);
+}
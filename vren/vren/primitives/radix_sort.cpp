@@ -4,27 +4,26 @@
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
 
+vren::pipeline_futures<3> vren::radix_sort::create_pipelines(vren::context const& context)
+{
+    return {
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/radix_sort_local_count.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/radix_sort_global_offset.comp.spv"),
+        vren::create_compute_pipeline_async(context, ".vren/resources/shaders/radix_sort_reorder.comp.spv")
+    };
+}
+
 vren::radix_sort::radix_sort(vren::context const& context) :
+    radix_sort(context, create_pipelines(context))
+{
+}
+
+vren::radix_sort::radix_sort(vren::context const& context, vren::pipeline_futures<3> pipelines) :
     m_context(&context),
     m_descriptor_set_layout(create_descriptor_set_layout()),
-    m_local_count_pipeline([&]()
-    {
-        vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/radix_sort_local_count.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_mod);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_global_offset_pipeline([&]()
-    {
-        vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/radix_sort_global_offset.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_mod);
-        return vren::create_compute_pipeline(context, shader);
-    }()),
-    m_reorder_pipeline([&]()
-    {
-        vren::shader_module shader_mod = vren::load_shader_module_from_file(context, ".vren/resources/shaders/radix_sort_reorder.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_mod);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_local_count_pipeline(pipelines[0].get()),
+    m_global_offset_pipeline(pipelines[1].get()),
+    m_reorder_pipeline(pipelines[2].get())
 {}
 
 vren::vk_descriptor_set_layout vren::radix_sort::create_descriptor_set_layout()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 #include "vk_helpers/buffer.hpp"
 #include "primitives/blelloch_scan.hpp"
 
@@ -25,7 +26,10 @@ namespace vren
         vren::pipeline m_reorder_pipeline;
 
     public:
+        static vren::pipeline_futures<3> create_pipelines(vren::context const& context);
+
         radix_sort(vren::context const& context);
+        radix_sort(vren::context const& context, vren::pipeline_futures<3> pipelines);
 
     private:
         vren::vk_descriptor_set_layout create_descriptor_set_layout();
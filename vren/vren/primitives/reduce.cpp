@@ -6,26 +6,39 @@
 
 #include "toolbox.hpp"
 #include "vk_helpers/misc.hpp"
+#include "primitives/primitive_tuning.hpp"
 
-template<typename _data_type_t, vren::reduce_operation _operation_t>
+template<typename _data_type_t>
 char const* get_shader_filepath();
 
-template<> char const* get_shader_filepath<glm::vec4, vren::ReduceOperationAdd>() { return ".vren/resources/shaders/reduce_vec4_add.comp.spv"; };
-template<> char const* get_shader_filepath<glm::vec4, vren::ReduceOperationMin>() { return ".vren/resources/shaders/reduce_vec4_min.comp.spv"; };
-template<> char const* get_shader_filepath<glm::vec4, vren::ReduceOperationMax>() { return ".vren/resources/shaders/reduce_vec4_max.comp.spv"; };
-template<> char const* get_shader_filepath<glm::uint, vren::ReduceOperationAdd>() { return ".vren/resources/shaders/reduce_uint_add.comp.spv"; };
-template<> char const* get_shader_filepath<glm::uint, vren::ReduceOperationMin>() { return ".vren/resources/shaders/reduce_uint_min.comp.spv"; };
-template<> char const* get_shader_filepath<glm::uint, vren::ReduceOperationMax>() { return ".vren/resources/shaders/reduce_uint_max.comp.spv"; };
+template<> char const* get_shader_filepath<glm::vec4>() { return ".vren/resources/shaders/reduce_vec4.comp.spv"; };
+template<> char const* get_shader_filepath<glm::uint>() { return ".vren/resources/shaders/reduce_uint.comp.spv"; };
+
+template<typename _data_type_t, vren::reduce_operation _operation_t>
+vren::pipeline_future vren::reduce<_data_type_t, _operation_t>::create_pipeline(vren::context const& context)
+{
+    uint32_t workgroup_size = vren::get_primitive_tuning(context).m_reduce_workgroup_size;
+
+    return vren::create_compute_pipeline_async(context, get_shader_filepath<_data_type_t>(), [workgroup_size](vren::specialized_shader& shader)
+    {
+        uint32_t operation = _operation_t;
+
+        shader.set_specialization_data(0, &workgroup_size, sizeof(uint32_t)); // local_size_x_id = 0
+        shader.set_specialization_data("k_operation", &operation, sizeof(uint32_t));
+    });
+}
 
 template<typename _data_type_t, vren::reduce_operation _operation_t>
 vren::reduce<_data_type_t, _operation_t>::reduce(vren::context const& context) :
+    reduce(context, create_pipeline(context))
+{
+}
+
+template<typename _data_type_t, vren::reduce_operation _operation_t>
+vren::reduce<_data_type_t, _operation_t>::reduce(vren::context const& context, vren::pipeline_future pipeline) :
     m_context(&context),
-    m_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(context, get_shader_filepath<_data_type_t, _operation_t>());
-        vren::specialized_shader shader = vren::specialized_shader(shader_module);
-        return vren::create_compute_pipeline(context, shader);
-    }())
+    m_workgroup_size(vren::get_primitive_tuning(context).m_reduce_workgroup_size),
+    m_pipeline(pipeline.get())
 {
 }
 
@@ -77,7 +90,7 @@ void vren::reduce<_data_type_t, _operation_t>::operator()(
         descriptor_set_2
     );
 
-    int32_t max_levels_per_dispatch = glm::log2<int32_t>(k_workgroup_size);
+    int32_t max_levels_per_dispatch = glm::log2<int32_t>(m_workgroup_size);
     int32_t levels = glm::max(glm::log2<int32_t>(length_power_of_2), 1);
 
     for (uint32_t level = 0; level < levels; level += max_levels_per_dispatch)
@@ -108,7 +121,7 @@ void vren::reduce<_data_type_t, _operation_t>::operator()(
         VkDescriptorSet descriptor_set = level == 0 ? descriptor_set_1->m_handle.m_descriptor_set : descriptor_set_2->m_handle.m_descriptor_set;
         m_pipeline.bind_descriptor_set(command_buffer, 0, descriptor_set);
 
-        uint32_t workgroups_num = vren::divide_and_ceil(1 << (levels - level), k_workgroup_size);
+        uint32_t workgroups_num = vren::divide_and_ceil(1 << (levels - level), m_workgroup_size);
         m_pipeline.dispatch(command_buffer, workgroups_num, blocks_num, 1);
     }
 }
@@ -2,28 +2,36 @@
 
 #include "vk_helpers/buffer.hpp"
 #include "vk_helpers/shader.hpp"
+#include "vk_helpers/pipeline_builder.hpp"
 
 namespace vren
 {
-    enum reduce_operation
+    enum reduce_operation // Specialization constant of reduce.comp
     {
-        ReduceOperationAdd,
-        ReduceOperationMin,
-        ReduceOperationMax
+        ReduceOperationAdd = 0,
+        ReduceOperationMin = 1,
+        ReduceOperationMax = 2
     };
 
+    /// One SPIR-V per data type: the operation and the workgroup size (see vren::primitive_tuning) are specialization constants.
     template<typename _data_type_t, vren::reduce_operation _operation_t>
     class reduce
     {
-    public:
-        inline static const uint32_t k_workgroup_size = 1024;
-
     private:
         vren::context const* m_context;
+        uint32_t m_workgroup_size;
         vren::pipeline m_pipeline;
 
     public:
+        static vren::pipeline_future create_pipeline(vren::context const& context);
+
         reduce(vren::context const& context);
+        reduce(vren::context const& context, vren::pipeline_future pipeline);
+
+        inline uint32_t get_workgroup_size() const
+        {
+            return m_workgroup_size;
+        }
 
         void operator()(
             VkCommandBuffer command_buffer,
@@ -51,23 +51,45 @@ vren::descriptor_pool vren::toolbox::create_descriptor_pool()
 	return vren::descriptor_pool(*m_context, 32, pool_sizes);
 }
 
+vren::toolbox::primitive_pipelines vren::toolbox::create_primitive_pipelines(vren::context const& context)
+{
+	return {
+		.m_reduce_uint_add = vren::reduce<glm::uint, vren::ReduceOperationAdd>::create_pipeline(context),
+		.m_reduce_uint_min = vren::reduce<glm::uint, vren::ReduceOperationMin>::create_pipeline(context),
+		.m_reduce_uint_max = vren::reduce<glm::uint, vren::ReduceOperationMax>::create_pipeline(context),
+		.m_reduce_vec4_add = vren::reduce<glm::vec4, vren::ReduceOperationAdd>::create_pipeline(context),
+		.m_reduce_vec4_min = vren::reduce<glm::vec4, vren::ReduceOperationMin>::create_pipeline(context),
+		.m_reduce_vec4_max = vren::reduce<glm::vec4, vren::ReduceOperationMax>::create_pipeline(context),
+
+		.m_blelloch_scan = vren::blelloch_scan::create_pipelines(context),
+		.m_radix_sort = vren::radix_sort::create_pipelines(context),
+		.m_bucket_sort = vren::bucket_sort::create_pipelines(context),
+
+		.m_build_bvh = vren::build_bvh::create_pipeline(context),
+	};
+}
+
 vren::toolbox::toolbox(vren::context const& context) :
+	toolbox(context, create_primitive_pipelines(context))
+{}
+
+vren::toolbox::toolbox(vren::context const& context, primitive_pipelines pipelines) :
 	m_context(&context),
 	m_graphics_command_pool(create_graphics_command_pool()),
 	m_transfer_command_pool(create_transfer_command_pool()),
 	m_descriptor_pool(create_descriptor_pool()),
 	m_texture_manager(context),
 
-	m_reduce_uint_add(context),
-	m_reduce_uint_min(context),
-	m_reduce_uint_max(context),
-	m_reduce_vec4_add(context),
-	m_reduce_vec4_min(context),
-	m_reduce_vec4_max(context),
+	m_reduce_uint_add(context, std::move(pipelines.m_reduce_uint_add)),
+	m_reduce_uint_min(context, std::move(pipelines.m_reduce_uint_min)),
+	m_reduce_uint_max(context, std::move(pipelines.m_reduce_uint_max)),
+	m_reduce_vec4_add(context, std::move(pipelines.m_reduce_vec4_add)),
+	m_reduce_vec4_min(context, std::move(pipelines.m_reduce_vec4_min)),
+	m_reduce_vec4_max(context, std::move(pipelines.m_reduce_vec4_max)),
 
-	m_blelloch_scan(context),
-	m_radix_sort(context),
-	m_bucket_sort(context),
+	m_blelloch_scan(context, std::move(pipelines.m_blelloch_scan)),
+	m_radix_sort(context, std::move(pipelines.m_radix_sort)),
+	m_bucket_sort(context, std::move(pipelines.m_bucket_sort)),
 
-	m_build_bvh(context)
+	m_build_bvh(context, std::move(pipelines.m_build_bvh))
 {}
@@ -33,6 +33,27 @@ namespace vren
 		vren::command_pool create_transfer_command_pool();
 		vren::descriptor_pool create_descriptor_pool();
 
+		/// The pipelines of the primitives, submitted together to the pipeline builder.
+		struct primitive_pipelines
+		{
+			vren::pipeline_future m_reduce_uint_add;
+			vren::pipeline_future m_reduce_uint_min;
+			vren::pipeline_future m_reduce_uint_max;
+			vren::pipeline_future m_reduce_vec4_add;
+			vren::pipeline_future m_reduce_vec4_min;
+			vren::pipeline_future m_reduce_vec4_max;
+
+			vren::pipeline_futures<2> m_blelloch_scan;
+			vren::pipeline_futures<3> m_radix_sort;
+			vren::pipeline_futures<2> m_bucket_sort;
+
+			vren::pipeline_future m_build_bvh;
+		};
+
+		static primitive_pipelines create_primitive_pipelines(vren::context const& context);
+
+		toolbox(vren::context const& ctx, primitive_pipelines pipelines);
+
 	public:
 		vren::command_pool m_graphics_command_pool;
 		vren::command_pool m_transfer_command_pool;
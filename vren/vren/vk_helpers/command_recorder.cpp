@@ -0,0 +1,118 @@
+#include "command_recorder.hpp"
+
+#include <algorithm>
+
+#include "context.hpp"
+#include "vk_helpers/misc.hpp"
+
+vren::command_recorder::command_recorder(vren::context const& context, uint32_t worker_count) :
+	m_context(&context)
+{
+	for (uint32_t i = 0; i < std::max<uint32_t>(worker_count, 1); i++)
+	{
+		m_command_pools.push_back(create_command_pool());
+	}
+
+	m_workers.reserve(worker_count);
+	for (uint32_t i = 0; i < worker_count; i++)
+	{
+		m_workers.emplace_back(&vren::command_recorder::run_worker, this, i);
+	}
+}
+
+vren::command_recorder::~command_recorder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+std::unique_ptr<vren::command_pool> vren::command_recorder::create_command_pool()
+{
+	VkCommandPoolCreateInfo command_pool_info{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = m_context->m_queue_families.m_graphics_idx,
+	};
+	VkCommandPool command_pool;
+	VREN_CHECK(vkCreateCommandPool(m_context->m_device, &command_pool_info, nullptr, &command_pool), m_context);
+	return std::make_unique<vren::command_pool>(*m_context, vren::vk_command_pool(*m_context, command_pool), VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+}
+
+void vren::command_recorder::run_worker(uint32_t worker_idx)
+{
+	vren::command_pool& command_pool = *m_command_pools.at(worker_idx);
+
+	while (true)
+	{
+		record_job_t job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+			if (m_jobs.empty())
+			{
+				return; // Stopping, the pending jobs are done before
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job(command_pool);
+	}
+}
+
+bool vren::command_recorder::can_inherit_queries() const
+{
+	return m_context->m_physical_device_features.inheritedQueries;
+}
+
+vren::secondary_command_buffer_future vren::command_recorder::record(
+	VkCommandBufferInheritanceInfo const& inheritance_info,
+	std::function<void(VkCommandBuffer command_buffer)> record_func
+)
+{
+	record_job_t job([context = m_context, inheritance_info, record_func = std::move(record_func)](vren::command_pool& command_pool)
+	{
+		vren::pooled_vk_command_buffer command_buffer = command_pool.acquire();
+
+		VkCommandBufferBeginInfo begin_info{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+			.pInheritanceInfo = &inheritance_info
+		};
+		VREN_CHECK(vkBeginCommandBuffer(command_buffer.m_handle, &begin_info), context);
+
+		record_func(command_buffer.m_handle);
+
+		VREN_CHECK(vkEndCommandBuffer(command_buffer.m_handle), context);
+
+		return command_buffer;
+	});
+	vren::secondary_command_buffer_future future = job.get_future();
+
+	if (m_workers.empty())
+	{
+		job(*m_command_pools.front());
+		return future;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_condition.notify_one();
+
+	return future;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <volk.h>
+
+#include "pool/command_pool.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// ------------------------------------------------------------------------------------------------
+	// Command recorder
+	// ------------------------------------------------------------------------------------------------
+
+	using secondary_command_buffer_future = std::future<vren::pooled_vk_command_buffer>;
+
+	/** Records secondary command buffers concurrently on a pool of worker threads, used by the render graph executor to record the nodes
+	 * marked for parallel recording (see vren::render_graph_node::set_parallel_recording).
+	 *
+	 * Every worker has its own command pool of the graphics queue family, only accessed by its worker (a VkCommandPool requires external
+	 * synchronization): the command buffers are acquired, reset and recorded on the worker. They return to the pool of their worker when
+	 * released, which is typically when the resource container of their frame is cleared, once the frame has completed.
+	 */
+	class command_recorder
+	{
+	private:
+		using record_job_t = std::packaged_task<vren::pooled_vk_command_buffer(vren::command_pool& command_pool)>;
+
+		vren::context const* m_context;
+
+		std::vector<std::unique_ptr<vren::command_pool>> m_command_pools; // One per worker, or one for the calling thread with no worker
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<record_job_t> m_jobs;
+		bool m_stopping = false;
+
+		std::unique_ptr<vren::command_pool> create_command_pool();
+
+		void run_worker(uint32_t worker_idx);
+
+	public:
+		/// With no worker the command buffers are recorded on the submitting thread, a single thread must then record at once.
+		command_recorder(vren::context const& context, uint32_t worker_count);
+		command_recorder(vren::command_recorder const& other) = delete;
+		command_recorder(vren::command_recorder&& other) = delete;
+
+		~command_recorder();
+
+		inline uint32_t get_worker_count() const
+		{
+			return (uint32_t) m_workers.size();
+		}
+
+		/// Whether the command buffers can be executed while a query is active on the primary command buffer (the inheritedQueries
+		/// feature), otherwise no query must be active and their inheritance info must have no pipeline statistics.
+		bool can_inherit_queries() const;
+
+		/// Begins a secondary command buffer with the given inheritance info, calls record_func on it and ends it. The exceptions thrown by
+		/// record_func are rethrown by the future.
+		vren::secondary_command_buffer_future record(
+			VkCommandBufferInheritanceInfo const& inheritance_info,
+			std::function<void(VkCommandBuffer command_buffer)> record_func
+		);
+	};
+}
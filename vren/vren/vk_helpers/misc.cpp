@@ -56,6 +56,26 @@ vren::vk_semaphore vren::vk_utils::create_semaphore(vren::context const& ctx)
 	return vren::vk_semaphore(ctx, sem);
 }
 
+vren::vk_semaphore vren::vk_utils::create_timeline_semaphore(vren::context const& ctx, uint64_t initial_value)
+{
+	VkSemaphoreTypeCreateInfo sem_type_info{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+		.pNext = nullptr,
+		.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+		.initialValue = initial_value
+	};
+
+	VkSemaphoreCreateInfo sem_info{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+		.pNext = &sem_type_info,
+		.flags = NULL
+	};
+
+	VkSemaphore sem;
+	VREN_CHECK(vkCreateSemaphore(ctx.m_device, &sem_info, nullptr, &sem), &ctx);
+	return vren::vk_semaphore(ctx, sem);
+}
+
 vren::vk_fence vren::vk_utils::create_fence(vren::context const& ctx, bool signaled)
 {
 	VkFenceCreateInfo fence_info{
@@ -23,6 +23,7 @@ namespace vren::vk_utils
 	void check(VkResult result);
 
 	vren::vk_semaphore create_semaphore(vren::context const& ctx);
+	vren::vk_semaphore create_timeline_semaphore(vren::context const& ctx, uint64_t initial_value = 0);
 
 	vren::vk_fence create_fence(vren::context const& ctx, bool signaled = false);
 
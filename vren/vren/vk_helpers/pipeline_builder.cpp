@@ -0,0 +1,96 @@
+#include "pipeline_builder.hpp"
+
+#include "context.hpp"
+
+vren::pipeline_builder::pipeline_builder(uint32_t worker_count)
+{
+	m_workers.reserve(worker_count);
+	for (uint32_t i = 0; i < worker_count; i++)
+	{
+		m_workers.emplace_back(&vren::pipeline_builder::run_worker, this);
+	}
+}
+
+vren::pipeline_builder::~pipeline_builder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+void vren::pipeline_builder::run_worker()
+{
+	while (true)
+	{
+		std::packaged_task<vren::pipeline()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+			if (m_jobs.empty())
+			{
+				return; // Stopping, the pending jobs are done before
+			}
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		job();
+	}
+}
+
+vren::pipeline_future vren::pipeline_builder::submit(std::function<vren::pipeline()> create_pipeline)
+{
+	std::packaged_task<vren::pipeline()> job(std::move(create_pipeline));
+	vren::pipeline_future future = job.get_future();
+
+	if (m_workers.empty())
+	{
+		job();
+		return future;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_jobs.push_back(std::move(job));
+	}
+	m_condition.notify_one();
+
+	return future;
+}
+
+vren::pipeline vren::create_compute_pipeline_from_file(
+	vren::context const& context,
+	char const* shader_path,
+	std::function<void(vren::specialized_shader& shader)> const& specialize_func
+)
+{
+	vren::shader_module shader_module = vren::load_shader_module_from_file(context, shader_path);
+	vren::specialized_shader shader = vren::specialized_shader(shader_module);
+	if (specialize_func)
+	{
+		specialize_func(shader);
+	}
+	return vren::create_compute_pipeline(context, shader);
+}
+
+vren::pipeline_future vren::create_compute_pipeline_async(
+	vren::context const& context,
+	std::string shader_path,
+	std::function<void(vren::specialized_shader& shader)> specialize_func
+)
+{
+	return context.m_pipeline_builder->submit([&context, shader_path = std::move(shader_path), specialize_func = std::move(specialize_func)]()
+	{
+		return vren::create_compute_pipeline_from_file(context, shader_path.c_str(), specialize_func);
+	});
+}
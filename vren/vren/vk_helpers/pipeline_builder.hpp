@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shader.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// ------------------------------------------------------------------------------------------------
+	// Pipeline builder
+	// ------------------------------------------------------------------------------------------------
+
+	using pipeline_future = std::future<vren::pipeline>;
+
+	template<size_t _count>
+	using pipeline_futures = std::array<vren::pipeline_future, _count>;
+
+	/** Creates pipelines concurrently on a pool of worker threads: loading the SPIR-V, reflecting it and vkCreate*Pipelines are
+	 * independent between pipelines (the pipeline cache is internally synchronized). The classes owning several pipelines submit
+	 * them all before waiting for the first one, through a constructor taking the futures of their pipelines.
+	 */
+	class pipeline_builder
+	{
+	private:
+		std::vector<std::thread> m_workers;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<std::packaged_task<vren::pipeline()>> m_jobs;
+		bool m_stopping = false;
+
+		void run_worker();
+
+	public:
+		/// With no worker the pipelines are created on the submitting thread.
+		explicit pipeline_builder(uint32_t worker_count);
+		pipeline_builder(vren::pipeline_builder const& other) = delete;
+		pipeline_builder(vren::pipeline_builder&& other) = delete;
+
+		~pipeline_builder();
+
+		inline uint32_t get_worker_count() const
+		{
+			return (uint32_t) m_workers.size();
+		}
+
+		/// The exceptions thrown by create_pipeline are rethrown by the future.
+		vren::pipeline_future submit(std::function<vren::pipeline()> create_pipeline);
+	};
+
+	/// Loads the shader and creates its compute pipeline, specialize_func sets the specialization constants.
+	vren::pipeline create_compute_pipeline_from_file(
+		vren::context const& context,
+		char const* shader_path,
+		std::function<void(vren::specialized_shader& shader)> const& specialize_func = nullptr
+	);
+
+	/// Same as create_compute_pipeline_from_file on the pipeline builder of the context.
+	vren::pipeline_future create_compute_pipeline_async(
+		vren::context const& context,
+		std::string shader_path,
+		std::function<void(vren::specialized_shader& shader)> specialize_func = nullptr
+	);
+}
@@ -0,0 +1,147 @@
+#include "pipeline_cache.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "context.hpp"
+#include "log.hpp"
+#include "misc.hpp"
+
+vren::vk_utils::pipeline_cache_file_header vren::vk_utils::make_pipeline_cache_file_header(VkPhysicalDeviceProperties const& physical_device_properties, uint64_t data_size)
+{
+	vren::vk_utils::pipeline_cache_file_header header{
+		.m_magic = vren::vk_utils::k_pipeline_cache_file_magic,
+		.m_version = vren::vk_utils::k_pipeline_cache_file_version,
+		.m_vendor_id = physical_device_properties.vendorID,
+		.m_device_id = physical_device_properties.deviceID,
+		.m_driver_version = physical_device_properties.driverVersion,
+		._pad = 0,
+		.m_data_size = data_size,
+	};
+	std::memcpy(header.m_pipeline_cache_uuid, physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return header;
+}
+
+bool vren::vk_utils::is_pipeline_cache_file_valid(VkPhysicalDeviceProperties const& physical_device_properties, std::span<uint8_t const> file_data)
+{
+	if (file_data.size() < sizeof(vren::vk_utils::pipeline_cache_file_header))
+	{
+		return false;
+	}
+
+	vren::vk_utils::pipeline_cache_file_header header{};
+	std::memcpy(&header, file_data.data(), sizeof(header));
+
+	vren::vk_utils::pipeline_cache_file_header expected_header =
+		vren::vk_utils::make_pipeline_cache_file_header(physical_device_properties, file_data.size() - sizeof(header));
+	if (std::memcmp(&header, &expected_header, sizeof(header)) != 0)
+	{
+		return false;
+	}
+
+	// The header written by the driver must agree with the device too
+	if (header.m_data_size < sizeof(VkPipelineCacheHeaderVersionOne))
+	{
+		return false;
+	}
+
+	VkPipelineCacheHeaderVersionOne vk_header{};
+	std::memcpy(&vk_header, file_data.data() + sizeof(header), sizeof(vk_header));
+
+	return
+		vk_header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+		vk_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		vk_header.vendorID == physical_device_properties.vendorID &&
+		vk_header.deviceID == physical_device_properties.deviceID &&
+		std::memcmp(vk_header.pipelineCacheUUID, physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::filesystem::path vren::vk_utils::get_pipeline_cache_file_path(VkPhysicalDeviceProperties const& physical_device_properties, std::filesystem::path const& directory)
+{
+	std::string file_name;
+	for (uint8_t byte : physical_device_properties.pipelineCacheUUID)
+	{
+		file_name += fmt::format("{:02x}", byte);
+	}
+	return directory / (file_name + ".bin");
+}
+
+VkPipelineCache vren::vk_utils::create_pipeline_cache(vren::context const& context, std::filesystem::path const& file_path)
+{
+	std::vector<uint8_t> file_data;
+
+	std::ifstream f(file_path, std::ios::ate | std::ios::binary);
+	if (f.is_open())
+	{
+		file_data.resize(f.tellg());
+		f.seekg(0);
+		f.read(reinterpret_cast<char*>(file_data.data()), file_data.size());
+
+		if (!f || !vren::vk_utils::is_pipeline_cache_file_valid(context.m_physical_device_properties, file_data))
+		{
+			VREN_WARN("Discarded the pipeline cache file {} written for another device or driver\n", file_path.string());
+			file_data.clear();
+		}
+	}
+
+	size_t header_size = sizeof(vren::vk_utils::pipeline_cache_file_header);
+
+	VkPipelineCacheCreateInfo pipeline_cache_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.initialDataSize = file_data.empty() ? 0 : file_data.size() - header_size,
+		.pInitialData = file_data.empty() ? nullptr : file_data.data() + header_size
+	};
+
+	VkPipelineCache pipeline_cache;
+	VREN_CHECK(vkCreatePipelineCache(context.m_device, &pipeline_cache_info, nullptr, &pipeline_cache), &context);
+
+	if (!file_data.empty())
+	{
+		VREN_INFO("Loaded the pipeline cache file {} ({} bytes)\n", file_path.string(), file_data.size());
+	}
+
+	return pipeline_cache;
+}
+
+void vren::vk_utils::save_pipeline_cache(vren::context const& context, VkPipelineCache pipeline_cache, std::filesystem::path const& file_path)
+{
+	size_t data_size = 0;
+	VREN_CHECK(vkGetPipelineCacheData(context.m_device, pipeline_cache, &data_size, nullptr), &context);
+
+	std::vector<uint8_t> data(data_size);
+	VREN_CHECK(vkGetPipelineCacheData(context.m_device, pipeline_cache, &data_size, data.data()), &context);
+	data.resize(data_size);
+
+	vren::vk_utils::pipeline_cache_file_header header =
+		vren::vk_utils::make_pipeline_cache_file_header(context.m_physical_device_properties, data_size);
+
+	// Written aside then renamed, a concurrent launch never reads a partial file
+	std::filesystem::path temp_file_path = file_path;
+	temp_file_path += ".tmp";
+
+	std::error_code error_code;
+	std::filesystem::create_directories(file_path.parent_path(), error_code);
+
+	{
+		std::ofstream f(temp_file_path, std::ios::binary | std::ios::trunc);
+		f.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		f.write(reinterpret_cast<char const*>(data.data()), data.size());
+
+		if (!f)
+		{
+			VREN_WARN("Failed to write the pipeline cache file {}\n", temp_file_path.string());
+			return;
+		}
+	}
+
+	std::filesystem::rename(temp_file_path, file_path, error_code);
+	if (error_code)
+	{
+		VREN_WARN("Failed to write the pipeline cache file {}: {}\n", file_path.string(), error_code.message());
+	}
+}
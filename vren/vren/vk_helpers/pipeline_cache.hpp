@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+#include <volk.h>
+
+namespace vren
+{
+	// Forward decl
+	class context;
+}
+
+namespace vren::vk_utils
+{
+	// ------------------------------------------------------------------------------------------------
+	// Pipeline cache
+	// ------------------------------------------------------------------------------------------------
+
+	inline constexpr uint32_t k_pipeline_cache_file_magic = 0x43505256; // "VRPC"
+	inline constexpr uint32_t k_pipeline_cache_file_version = 1;
+
+	/// The pipeline cache file is this header followed by the data returned by vkGetPipelineCacheData. The driver version isn't part of
+	/// the Vulkan pipeline cache header: a file written by another driver is discarded even if it has the same pipeline cache UUID.
+	struct pipeline_cache_file_header
+	{
+		uint32_t m_magic;
+		uint32_t m_version;
+		uint32_t m_vendor_id;
+		uint32_t m_device_id;
+		uint32_t m_driver_version;
+		uint8_t m_pipeline_cache_uuid[VK_UUID_SIZE];
+		uint32_t _pad;
+		uint64_t m_data_size;
+	};
+
+	vren::vk_utils::pipeline_cache_file_header make_pipeline_cache_file_header(VkPhysicalDeviceProperties const& physical_device_properties, uint64_t data_size);
+
+	/// Checks that the file header and the Vulkan pipeline cache header that follows it were written for this device and driver.
+	bool is_pipeline_cache_file_valid(VkPhysicalDeviceProperties const& physical_device_properties, std::span<uint8_t const> file_data);
+
+	/// The pipeline cache file of the device in the given directory, named by its pipeline cache UUID.
+	std::filesystem::path get_pipeline_cache_file_path(VkPhysicalDeviceProperties const& physical_device_properties, std::filesystem::path const& directory);
+
+	/// Creates a pipeline cache, initialized with the data of the file if it's valid (it's created empty otherwise).
+	VkPipelineCache create_pipeline_cache(vren::context const& context, std::filesystem::path const& file_path);
+
+	/// Writes the pipeline cache data to the file, does nothing but warn on failure. The file is replaced atomically.
+	void save_pipeline_cache(vren::context const& context, VkPipelineCache pipeline_cache, std::filesystem::path const& file_path);
+}
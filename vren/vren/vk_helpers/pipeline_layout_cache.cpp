@@ -0,0 +1,194 @@
+#include "pipeline_layout_cache.hpp"
+
+#include <algorithm>
+
+#include "context.hpp"
+#include "shader.hpp"
+#include "misc.hpp"
+
+namespace
+{
+	void hash_combine(size_t& hash, uint64_t value)
+	{
+		hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	}
+}
+
+size_t vren::pipeline_layout_key_hash::operator()(vren::descriptor_set_layout_key const& key) const noexcept
+{
+	size_t hash = key.m_bindings.size();
+	for (vren::descriptor_set_layout_key::binding const& binding : key.m_bindings)
+	{
+		hash_combine(hash, binding.m_binding);
+		hash_combine(hash, binding.m_descriptor_type);
+		hash_combine(hash, binding.m_descriptor_count);
+	}
+	return hash;
+}
+
+size_t vren::pipeline_layout_key_hash::operator()(vren::pipeline_layout_key const& key) const noexcept
+{
+	size_t hash = key.m_descriptor_set_layouts.size();
+	for (VkDescriptorSetLayout descriptor_set_layout : key.m_descriptor_set_layouts)
+	{
+		hash_combine(hash, (uint64_t) descriptor_set_layout);
+	}
+	for (vren::pipeline_layout_key::push_constant_range const& push_constant_range : key.m_push_constant_ranges)
+	{
+		hash_combine(hash, push_constant_range.m_stage_flags);
+		hash_combine(hash, (uint64_t(push_constant_range.m_offset) << 32) | push_constant_range.m_size);
+	}
+	return hash;
+}
+
+vren::pipeline_layout_cache::pipeline_layout_cache(vren::context const& context) :
+	m_context(&context)
+{}
+
+vren::pipeline_layout_cache::~pipeline_layout_cache()
+{
+	for (auto const& [key, pipeline_layout] : m_pipeline_layouts)
+	{
+		vkDestroyPipelineLayout(m_context->m_device, pipeline_layout, nullptr);
+	}
+
+	for (auto const& [key, descriptor_set_layout] : m_descriptor_set_layouts)
+	{
+		vkDestroyDescriptorSetLayout(m_context->m_device, descriptor_set_layout, nullptr);
+	}
+}
+
+VkDescriptorSetLayout vren::pipeline_layout_cache::create_descriptor_set_layout(vren::descriptor_set_layout_key const& key)
+{
+	std::vector<VkDescriptorSetLayoutBinding> bindings{};
+	std::vector<VkDescriptorBindingFlags> binding_flags{};
+
+	for (vren::descriptor_set_layout_key::binding const& binding : key.m_bindings)
+	{
+		bool variable_descriptor_count = binding.m_descriptor_count == 0;
+
+		bindings.push_back(VkDescriptorSetLayoutBinding{
+			.binding = binding.m_binding,
+			.descriptorType = binding.m_descriptor_type,
+			.descriptorCount = variable_descriptor_count ? vren::k_max_variable_count_descriptor_count : binding.m_descriptor_count,
+			.stageFlags = VK_SHADER_STAGE_ALL,
+			.pImmutableSamplers = nullptr
+		});
+		binding_flags.push_back(variable_descriptor_count ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT : NULL);
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+		.pNext = nullptr,
+		.bindingCount = (uint32_t) binding_flags.size(),
+		.pBindingFlags = binding_flags.data()
+	};
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
+		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+		.pNext = &binding_flags_create_info,
+		.flags = NULL,
+		.bindingCount = (uint32_t) bindings.size(),
+		.pBindings = bindings.data()
+	};
+	VkDescriptorSetLayout descriptor_set_layout;
+	VREN_CHECK(vkCreateDescriptorSetLayout(m_context->m_device, &descriptor_set_layout_create_info, nullptr, &descriptor_set_layout), m_context);
+	return descriptor_set_layout;
+}
+
+VkPipelineLayout vren::pipeline_layout_cache::create_pipeline_layout(vren::pipeline_layout_key const& key)
+{
+	std::vector<VkPushConstantRange> push_constant_ranges{};
+	for (vren::pipeline_layout_key::push_constant_range const& push_constant_range : key.m_push_constant_ranges)
+	{
+		push_constant_ranges.push_back(VkPushConstantRange{
+			.stageFlags = push_constant_range.m_stage_flags,
+			.offset = push_constant_range.m_offset,
+			.size = push_constant_range.m_size
+		});
+	}
+
+	VkPipelineLayoutCreateInfo pipeline_layout_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+		.pNext = nullptr,
+		.flags = NULL,
+		.setLayoutCount = (uint32_t) key.m_descriptor_set_layouts.size(),
+		.pSetLayouts = key.m_descriptor_set_layouts.data(),
+		.pushConstantRangeCount = (uint32_t) push_constant_ranges.size(),
+		.pPushConstantRanges = push_constant_ranges.data(),
+	};
+	VkPipelineLayout pipeline_layout;
+	VREN_CHECK(vkCreatePipelineLayout(m_context->m_device, &pipeline_layout_info, nullptr, &pipeline_layout), m_context);
+	return pipeline_layout;
+}
+
+VkDescriptorSetLayout vren::pipeline_layout_cache::get_descriptor_set_layout(vren::shader_module_descriptor_set_layout_info_t const& descriptor_set_layout_info)
+{
+	vren::descriptor_set_layout_key key{};
+	for (auto const& [binding, binding_info] : descriptor_set_layout_info)
+	{
+		key.m_bindings.push_back({
+			.m_binding = binding,
+			.m_descriptor_type = binding_info.m_descriptor_type,
+			.m_descriptor_count = binding_info.m_descriptor_count,
+		});
+	}
+
+	std::sort(key.m_bindings.begin(), key.m_bindings.end(), [](auto const& a, auto const& b)
+	{
+		return a.m_binding < b.m_binding;
+	});
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto found = m_descriptor_set_layouts.find(key);
+	if (found != m_descriptor_set_layouts.end())
+	{
+		return found->second;
+	}
+
+	VkDescriptorSetLayout descriptor_set_layout = create_descriptor_set_layout(key);
+	m_descriptor_set_layouts.emplace(std::move(key), descriptor_set_layout);
+	return descriptor_set_layout;
+}
+
+VkPipelineLayout vren::pipeline_layout_cache::get_pipeline_layout(
+	std::span<VkDescriptorSetLayout const> descriptor_set_layouts,
+	std::span<VkPushConstantRange const> push_constant_ranges
+)
+{
+	vren::pipeline_layout_key key{
+		.m_descriptor_set_layouts = std::vector<VkDescriptorSetLayout>(descriptor_set_layouts.begin(), descriptor_set_layouts.end()),
+	};
+	for (VkPushConstantRange const& push_constant_range : push_constant_ranges)
+	{
+		key.m_push_constant_ranges.push_back({
+			.m_stage_flags = push_constant_range.stageFlags,
+			.m_offset = push_constant_range.offset,
+			.m_size = push_constant_range.size,
+		});
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto found = m_pipeline_layouts.find(key);
+	if (found != m_pipeline_layouts.end())
+	{
+		return found->second;
+	}
+
+	VkPipelineLayout pipeline_layout = create_pipeline_layout(key);
+	m_pipeline_layouts.emplace(std::move(key), pipeline_layout);
+	return pipeline_layout;
+}
+
+size_t vren::pipeline_layout_cache::get_descriptor_set_layout_count() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_descriptor_set_layouts.size();
+}
+
+size_t vren::pipeline_layout_cache::get_pipeline_layout_count() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_pipeline_layouts.size();
+}
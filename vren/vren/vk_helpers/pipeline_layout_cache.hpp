@@ -0,0 +1,92 @@
+#pragma once
+
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <volk.h>
+
+#include "shader_reflection.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+
+	// ------------------------------------------------------------------------------------------------
+	// Pipeline layout cache
+	// ------------------------------------------------------------------------------------------------
+
+	struct descriptor_set_layout_key
+	{
+		struct binding
+		{
+			uint32_t m_binding;
+			VkDescriptorType m_descriptor_type;
+			uint32_t m_descriptor_count; // Count 0 means it's a variable descriptor count
+
+			bool operator==(binding const& other) const = default;
+		};
+
+		std::vector<binding> m_bindings; // Sorted by binding
+
+		bool operator==(vren::descriptor_set_layout_key const& other) const = default;
+	};
+
+	struct pipeline_layout_key
+	{
+		struct push_constant_range
+		{
+			VkShaderStageFlags m_stage_flags;
+			uint32_t m_offset;
+			uint32_t m_size;
+
+			bool operator==(push_constant_range const& other) const = default;
+		};
+
+		std::vector<VkDescriptorSetLayout> m_descriptor_set_layouts;
+		std::vector<push_constant_range> m_push_constant_ranges;
+
+		bool operator==(vren::pipeline_layout_key const& other) const = default;
+	};
+
+	struct pipeline_layout_key_hash
+	{
+		size_t operator()(vren::descriptor_set_layout_key const& key) const noexcept;
+		size_t operator()(vren::pipeline_layout_key const& key) const noexcept;
+	};
+
+	/** Context-wide table of the descriptor set layouts and pipeline layouts, keyed by their definition: the pipelines whose shaders
+	 * declare the same bindings share the same layout objects. Sharing the pipeline layout keeps the descriptor sets bound when switching
+	 * between such pipelines, and the descriptor pool recycles the descriptor sets across them. The layouts live as long as the context.
+	 */
+	class pipeline_layout_cache
+	{
+	private:
+		vren::context const* m_context;
+
+		mutable std::mutex m_mutex; // The pipelines are created concurrently (see vren::pipeline_builder)
+		std::unordered_map<vren::descriptor_set_layout_key, VkDescriptorSetLayout, vren::pipeline_layout_key_hash> m_descriptor_set_layouts;
+		std::unordered_map<vren::pipeline_layout_key, VkPipelineLayout, vren::pipeline_layout_key_hash> m_pipeline_layouts;
+
+		VkDescriptorSetLayout create_descriptor_set_layout(vren::descriptor_set_layout_key const& key);
+		VkPipelineLayout create_pipeline_layout(vren::pipeline_layout_key const& key);
+
+	public:
+		explicit pipeline_layout_cache(vren::context const& context);
+		pipeline_layout_cache(vren::pipeline_layout_cache const& other) = delete;
+		pipeline_layout_cache(vren::pipeline_layout_cache&& other) = delete;
+
+		~pipeline_layout_cache();
+
+		VkDescriptorSetLayout get_descriptor_set_layout(vren::shader_module_descriptor_set_layout_info_t const& descriptor_set_layout_info);
+		VkPipelineLayout get_pipeline_layout(
+			std::span<VkDescriptorSetLayout const> descriptor_set_layouts,
+			std::span<VkPushConstantRange const> push_constant_ranges
+		);
+
+		size_t get_descriptor_set_layout_count() const;
+		size_t get_pipeline_layout_count() const;
+	};
+}
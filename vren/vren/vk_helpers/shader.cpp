@@ -1,12 +1,12 @@
 #include "shader.hpp"
 
+#include <cstring>
 #include <fstream>
 
-#include <spirv_cross.hpp>
-
 #include "context.hpp"
 #include "toolbox.hpp"
 #include "misc.hpp"
+#include "pipeline_layout_cache.hpp"
 
 #include "log.hpp"
 
@@ -116,188 +116,22 @@ std::string composed_shader_stage_name(VkShaderStageFlags shader_stages)
 
 vren::shader_module vren::load_shader_module(vren::context const& context, uint32_t const* code, size_t code_length, char const* name)
 {
-	spirv_cross::Compiler compiler(code, code_length);
-
-	VREN_DEBUG0("[shader] ----------------------------------------------------------------\n");
-	VREN_DEBUG0("[shader] Shader module: \"{}\"\n", name);
-	VREN_DEBUG0("[shader] ----------------------------------------------------------------\n");
-
-	// Entry points
-	std::vector<vren::shader_module_entry_point> entry_points{};
-
-	auto parse_shader_stage = [](spv::ExecutionModel execution_model) -> VkShaderStageFlags
-	{
-		switch (execution_model)
-		{
-		case spv::ExecutionModelVertex:    return VK_SHADER_STAGE_VERTEX_BIT;
-		case spv::ExecutionModelFragment:  return VK_SHADER_STAGE_FRAGMENT_BIT;
-		case spv::ExecutionModelTaskNV:    return VK_SHADER_STAGE_TASK_BIT_NV;
-		case spv::ExecutionModelMeshNV:    return VK_SHADER_STAGE_MESH_BIT_NV;
-		case spv::ExecutionModelKernel:    return VK_SHADER_STAGE_COMPUTE_BIT;
-		case spv::ExecutionModelGLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
-		default:
-			throw std::runtime_error("Execution model not recognized");
-		}
-	};
-
-	for (spirv_cross::EntryPoint const& spirv_entry_point : compiler.get_entry_points_and_stages())
-	{
-		vren::shader_module_entry_point entry_point{
-			.m_name = spirv_entry_point.name,
-			.m_shader_stage = parse_shader_stage(spirv_entry_point.execution_model)
-		};
-		entry_points.push_back(entry_point);
-
-		VREN_DEBUG0("[shader] Entry point: \"{}\" (shader stage: {:#010x})\n", entry_point.m_name, entry_point.m_shader_stage);
-	}
-
-	assert(entry_points.size() > 0);
-
-	// Descriptor set layouts
-	spirv_cross::ShaderResources shader_resources = compiler.get_shader_resources();
-
-	std::unordered_map<uint32_t, vren::shader_module_descriptor_set_layout_info_t> descriptor_set_layouts;
-
-	auto load_resources = [&](
-		spirv_cross::SmallVector<spirv_cross::Resource> const& resources,
-		std::function<VkDescriptorType(spirv_cross::Resource const&)> deduct_descriptor_type
-	)
-	{
-		for (spirv_cross::Resource const& resource : resources)
-		{
-			assert(compiler.has_decoration(resource.id, spv::DecorationDescriptorSet));
-			assert(compiler.has_decoration(resource.id, spv::DecorationBinding));
-
-			uint32_t descriptor_set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
-
-			spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
-
-			assert(type.array.size() == 0 || (type.array.size() == 1 && type.array_size_literal[0])); // Multi-dimensional arrays aren't supported
-
-			VkDescriptorType descriptor_type = deduct_descriptor_type(resource);
-			vren::shader_module_binding_info binding_info{
-				.m_descriptor_type = descriptor_type,
-				.m_descriptor_count = type.array.size() > 0 ? type.array[0] : 1,
-			};
-			descriptor_set_layouts.emplace(descriptor_set, std::unordered_map<uint32_t, vren::shader_module_binding_info>{});
-			descriptor_set_layouts.at(descriptor_set).emplace(binding, binding_info);
-
-			VREN_DEBUG0("[shader] Descriptor {}.{} - descriptor type: {:#010x} - count: {} - variable count: {}\n",
-				descriptor_set,
-				binding,
-				binding_info.m_descriptor_type,
-				binding_info.m_descriptor_count,
-				binding_info.is_variable_descriptor_count() ? "true" : "false"
-			);
-		}
-	};
-
-	load_resources(shader_resources.sampled_images, [&](spirv_cross::Resource const& resource)
-	{
-		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	});
-
-	load_resources(shader_resources.separate_images, [&](spirv_cross::Resource const& resource)
-	{
-		spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
-
-		return type.image.dim == spv::Dim::DimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-	});
-
-	load_resources(shader_resources.storage_images, [&](spirv_cross::Resource const& resource)
-	{
-		spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
-
-		return type.image.dim == spv::Dim::DimBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	});
-
-	load_resources(shader_resources.separate_samplers, [&](spirv_cross::Resource const& resource)
-	{
-		return VK_DESCRIPTOR_TYPE_SAMPLER;
-	});
-
-	load_resources(shader_resources.uniform_buffers, [&](spirv_cross::Resource const& resource)
-	{
-		return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	});
-
-	load_resources(shader_resources.storage_buffers, [&](spirv_cross::Resource const& resource)
-	{
-		return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	});
-
-	// Push constants
-	size_t push_constant_block_size = 0;
-	if (shader_resources.push_constant_buffers.size() > 0)
-	{
-		spirv_cross::Resource const& resource = shader_resources.push_constant_buffers[0];
-
-		if (shader_resources.push_constant_buffers.size() > 1)
-		{
-			VREN_WARN("[shader] Only one push-constant block per stage is supported, taking: \"{}\"\n", resource.name);
-		}
-
-		std::string name = compiler.get_name(resource.id);
-		push_constant_block_size = compiler.get_declared_struct_size(compiler.get_type(resource.type_id));
-
-		VREN_DEBUG0("[shader] Push-constant block \"{}\" - size: {}\n",
-			name,
-			push_constant_block_size
-		);
-	}
-
-	// Specialization constants
-	std::vector<std::string> specialization_constant_names{};
-	std::vector<VkSpecializationMapEntry> specialization_map_entries{};
-	uint32_t specialization_constant_offset = 0;
-
-	for (spirv_cross::SpecializationConstant const& spirv_specialization_constant : compiler.get_specialization_constants())
-	{
-		spirv_cross::SPIRConstant value = compiler.get_constant(spirv_specialization_constant.id);
-		spirv_cross::SPIRType type = compiler.get_type(value.constant_type);
-
-		size_t data_size;
-		switch (type.basetype)
-		{
-		case (spirv_cross::SPIRType::BaseType::Boolean): data_size = sizeof(VkBool32); break;
-		case (spirv_cross::SPIRType::BaseType::Char):    data_size = sizeof(char); break;
-		case (spirv_cross::SPIRType::BaseType::Int):     data_size = sizeof(int32_t); break;
-		case (spirv_cross::SPIRType::BaseType::UInt):    data_size = sizeof(uint32_t); break;
-		case (spirv_cross::SPIRType::BaseType::Float):   data_size = sizeof(float); break;
-		case (spirv_cross::SPIRType::BaseType::Double):  data_size = sizeof(double); break;
-		case (spirv_cross::SPIRType::BaseType::Int64):   data_size = sizeof(int64_t); break;
-		default:
-			throw std::runtime_error("Invalid specialization constant data type");
-		}
-
-		std::string specialization_constant_name = compiler.get_name(spirv_specialization_constant.id);
-
-		uint32_t specialization_constant_id = spirv_specialization_constant.constant_id;
-
-		specialization_constant_names.push_back(specialization_constant_name);
-		specialization_map_entries.push_back(VkSpecializationMapEntry{
-			.constantID = spirv_specialization_constant.constant_id,
-			.offset = specialization_constant_offset,
-			.size = data_size,
-		});
+	return load_shader_module(context, code, code_length, vren::reflect_shader(code, code_length, name), name);
+}
 
-		VREN_DEBUG0("[shader] Specialization constant {} (ID: {}) - size: {}\n",
-			specialization_constant_name,
-			specialization_constant_id,
-			data_size
-		);
-	}
+vren::shader_module vren::load_shader_module(vren::context const& context, uint32_t const* code, size_t code_length, vren::shader_reflection&& reflection, char const* name)
+{
+	assert(reflection.m_entry_points.size() > 0);
 
-	//
 	return {
 		.m_name = name,
 		.m_handle = create_vk_shader_module(context, code, code_length * sizeof(uint32_t)),
-		.m_entry_points = std::move(entry_points),
-		.m_descriptor_set_layouts = std::move(descriptor_set_layouts),
-		.m_push_constant_block_size = push_constant_block_size,
-		.m_specialization_constant_names = std::move(specialization_constant_names),
-		.m_specialization_map_entries = std::move(specialization_map_entries),
+		.m_entry_points = std::move(reflection.m_entry_points),
+		.m_descriptor_set_layouts = std::move(reflection.m_descriptor_set_layouts),
+		.m_push_constant_block_size = reflection.m_push_constant_block_size,
+		.m_specialization_constant_names = std::move(reflection.m_specialization_constant_names),
+		.m_specialization_map_entries = std::move(reflection.m_specialization_map_entries),
+		.m_specialization_default_data = std::move(reflection.m_specialization_default_data),
 	};
 }
 
@@ -305,7 +139,18 @@ vren::shader_module vren::load_shader_module_from_file(vren::context const& cont
 {
 	std::vector<char> buffer{};
 	load_bin_file(filename, buffer);
-	vren::shader_module shader_module = load_shader_module(context, reinterpret_cast<uint32_t const*>(buffer.data()), buffer.size() / sizeof(uint32_t), filename);
+
+	uint32_t const* code = reinterpret_cast<uint32_t const*>(buffer.data());
+	size_t code_length = buffer.size() / sizeof(uint32_t);
+
+	vren::shader_reflection reflection{};
+	if (!vren::read_shader_reflection_file(vren::get_shader_reflection_file_path(filename), vren::hash_spirv_code(code, code_length), reflection))
+	{
+		VREN_DEBUG0("[shader] No up-to-date reflection file for \"{}\", reflecting the SPIR-V\n", filename);
+		reflection = vren::reflect_shader(code, code_length, filename);
+	}
+
+	vren::shader_module shader_module = load_shader_module(context, code, code_length, std::move(reflection), filename);
 
 	vren::vk_utils::set_name(context, shader_module, filename);
 
@@ -316,12 +161,19 @@ vren::shader_module vren::load_shader_module_from_file(vren::context const& cont
 // Pipeline
 // --------------------------------------------------------------------------------------------------------------------------------
 
-vren::pipeline::~pipeline()
+vren::pipeline::pipeline(
+	vren::context const& context,
+	std::vector<VkDescriptorSetLayout>&& descriptor_set_layouts,
+	VkPipelineLayout pipeline_layout,
+	vren::vk_pipeline&& pipeline,
+	VkPipelineBindPoint bind_point
+) :
+	m_context(&context),
+	m_descriptor_set_layouts(std::move(descriptor_set_layouts)),
+	m_pipeline_layout(pipeline_layout),
+	m_pipeline(std::move(pipeline)),
+	m_bind_point(bind_point)
 {
-	for (VkDescriptorSetLayout desc_set_layout : m_descriptor_set_layouts)
-	{
-		vkDestroyDescriptorSetLayout(m_context->m_device, desc_set_layout, nullptr);
-	}
 }
 
 void vren::pipeline::bind(VkCommandBuffer command_buffer) const
@@ -341,12 +193,12 @@ void vren::pipeline::bind_index_buffer(VkCommandBuffer command_buffer, VkBuffer
 
 void vren::pipeline::bind_descriptor_set(VkCommandBuffer command_buffer, uint32_t descriptor_set_idx, VkDescriptorSet descriptor_set) const
 {
-	vkCmdBindDescriptorSets(command_buffer, m_bind_point, m_pipeline_layout.m_handle, descriptor_set_idx, 1, &descriptor_set, 0, nullptr);
+	vkCmdBindDescriptorSets(command_buffer, m_bind_point, m_pipeline_layout, descriptor_set_idx, 1, &descriptor_set, 0, nullptr);
 }
 
 void vren::pipeline::push_constants(VkCommandBuffer command_buffer, VkShaderStageFlags shader_stage, void const* data, uint32_t length, uint32_t offset) const
 {
-	vkCmdPushConstants(command_buffer, m_pipeline_layout.m_handle, shader_stage, offset, length, data);
+	vkCmdPushConstants(command_buffer, m_pipeline_layout, shader_stage, offset, length, data);
 }
 
 void vren::pipeline::acquire_and_bind_descriptor_set(vren::context const& context, VkCommandBuffer command_buffer, vren::resource_container& resource_container, uint32_t descriptor_set_idx, std::function<void(VkDescriptorSet)> const& update_func)
@@ -414,9 +266,9 @@ std::unordered_map<uint32_t, vren::shader_module_descriptor_set_layout_info_t> m
 }
 
 /**
- * Merge the descriptor definitions and create the descriptor set layouts for the given shaders. 
+ * Merge the descriptor definitions and get the descriptor set layouts for the given shaders from the layout cache of the context.
  */
-std::vector<VkDescriptorSetLayout> create_descriptor_set_layouts(
+std::vector<VkDescriptorSetLayout> get_descriptor_set_layouts(
 	vren::context const& context,
 	std::span<vren::specialized_shader const> shaders
 )
@@ -431,50 +283,10 @@ std::vector<VkDescriptorSetLayout> create_descriptor_set_layouts(
 
 	for (int32_t descriptor_set_idx = 0; descriptor_set_idx <= max_descriptor_set_idx; descriptor_set_idx++)
 	{
-		std::vector<VkDescriptorSetLayoutBinding> bindings{};
-		std::vector<VkDescriptorBindingFlags> binding_flags{};
-
-		if (merged_descriptor_info.contains(descriptor_set_idx))
-		{
-			vren::shader_module_descriptor_set_layout_info_t const& descriptor_info = merged_descriptor_info.at(descriptor_set_idx);
-			for (auto const& [binding, binding_info] : descriptor_info)
-			{
-				VkDescriptorSetLayoutBinding descriptor_set_layout_binding{
-					.binding = binding,
-					.descriptorType = binding_info.m_descriptor_type,
-					.descriptorCount = binding_info.is_variable_descriptor_count() ? vren::k_max_variable_count_descriptor_count : binding_info.m_descriptor_count,
-					.stageFlags = VK_SHADER_STAGE_ALL,
-					.pImmutableSamplers = nullptr
-				};
-				bindings.push_back(descriptor_set_layout_binding);
-
-				if (binding_info.is_variable_descriptor_count())
-				{
-					binding_flags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT);
-				}
-				else
-				{
-					binding_flags.push_back(NULL);
-				}
-			}
-		}
-
-		VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info{
-			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
-			.pNext = nullptr,
-			.bindingCount = (uint32_t) binding_flags.size(),
-			.pBindingFlags = binding_flags.data()
-		};
-		VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info{
-			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-			.pNext = &binding_flags_create_info,
-			.flags = NULL,
-			.bindingCount = (uint32_t) bindings.size(),
-			.pBindings = bindings.data()
-		};
-		VkDescriptorSetLayout descriptor_set_layout;
-		VREN_CHECK(vkCreateDescriptorSetLayout(context.m_device, &descriptor_set_layout_create_info, nullptr, &descriptor_set_layout), &context);
-		descriptor_set_layouts[descriptor_set_idx] = descriptor_set_layout;
+		// The descriptor sets that aren't used by the shaders get an empty layout
+		descriptor_set_layouts[descriptor_set_idx] = context.m_pipeline_layout_cache->get_descriptor_set_layout(
+			merged_descriptor_info.contains(descriptor_set_idx) ? merged_descriptor_info.at(descriptor_set_idx) : vren::shader_module_descriptor_set_layout_info_t{}
+		);
 	}
 
 	return descriptor_set_layouts;
@@ -485,7 +297,7 @@ vren::pipeline vren::create_compute_pipeline(vren::context const& context, vren:
 	vren::shader_module const& shader_module = shader.get_shader_module();
 
 	// Descriptor set layouts
-	std::vector<VkDescriptorSetLayout> descriptor_set_layouts = create_descriptor_set_layouts(context, std::span(&shader, 1));
+	std::vector<VkDescriptorSetLayout> descriptor_set_layouts = get_descriptor_set_layouts(context, std::span(&shader, 1));
 
 	// Push constant range
 	VkPushConstantRange push_constant_range{
@@ -495,17 +307,10 @@ vren::pipeline vren::create_compute_pipeline(vren::context const& context, vren:
 	};
 
 	// Pipeline layout
-	VkPipelineLayoutCreateInfo pipeline_layout_info{
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = NULL,
-		.setLayoutCount = (uint32_t) descriptor_set_layouts.size(),
-		.pSetLayouts = descriptor_set_layouts.data(),
-		.pushConstantRangeCount = shader_module.has_push_constant_block() ? 1u : 0u,
-		.pPushConstantRanges = shader_module.has_push_constant_block() ? &push_constant_range : nullptr,
-	};
-	VkPipelineLayout pipeline_layout;
-	VREN_CHECK(vkCreatePipelineLayout(context.m_device, &pipeline_layout_info, nullptr, &pipeline_layout), &context);
+	VkPipelineLayout pipeline_layout = context.m_pipeline_layout_cache->get_pipeline_layout(
+		descriptor_set_layouts,
+		shader_module.has_push_constant_block() ? std::span(&push_constant_range, 1) : std::span<VkPushConstantRange const>()
+	);
 
 	// Shader stage
 	VkSpecializationInfo specialization_info{
@@ -525,6 +330,31 @@ vren::pipeline vren::create_compute_pipeline(vren::context const& context, vren:
 		.pSpecializationInfo = shader.has_specialization_data() ? &specialization_info : nullptr
 	};
 
+	// Required subgroup size
+	VkPipelineShaderStageRequiredSubgroupSizeCreateInfo required_subgroup_size_info{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO,
+		.pNext = nullptr,
+		.requiredSubgroupSize = shader.get_required_subgroup_size()
+	};
+
+	if (shader.get_required_subgroup_size() > 0)
+	{
+		VkPhysicalDeviceSubgroupSizeControlFeatures const& features = context.m_physical_device_subgroup_size_control_features;
+		VkPhysicalDeviceSubgroupSizeControlProperties const& properties = context.m_physical_device_subgroup_size_control_properties;
+
+		if (!features.subgroupSizeControl ||
+			!features.computeFullSubgroups ||
+			!(properties.requiredSubgroupSizeStages & VK_SHADER_STAGE_COMPUTE_BIT) ||
+			shader.get_required_subgroup_size() < properties.minSubgroupSize ||
+			shader.get_required_subgroup_size() > properties.maxSubgroupSize)
+		{
+			throw std::runtime_error("Unsupported required subgroup size");
+		}
+
+		pipeline_shader_stage_info.pNext = &required_subgroup_size_info;
+		pipeline_shader_stage_info.flags = VK_PIPELINE_SHADER_STAGE_CREATE_REQUIRE_FULL_SUBGROUPS_BIT;
+	}
+
 	// Compute pipeline
 	VkComputePipelineCreateInfo pipeline_info{
 		.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -536,16 +366,16 @@ vren::pipeline vren::create_compute_pipeline(vren::context const& context, vren:
 		.basePipelineIndex = 0,
 	};
 	VkPipeline pipeline;
-	VREN_CHECK(vkCreateComputePipelines(context.m_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline), &context);
+	VREN_CHECK(vkCreateComputePipelines(context.m_device, context.m_pipeline_cache, 1, &pipeline_info, nullptr, &pipeline), &context);
 
 	//
-	return vren::pipeline{
-		.m_context = &context,
-		.m_descriptor_set_layouts = std::move(descriptor_set_layouts),
-		.m_pipeline_layout = vren::vk_pipeline_layout(context, pipeline_layout),
-		.m_pipeline = vren::vk_pipeline(context, pipeline),
-		.m_bind_point = VK_PIPELINE_BIND_POINT_COMPUTE,
-	};
+	return vren::pipeline(
+		context,
+		std::move(descriptor_set_layouts),
+		pipeline_layout,
+		vren::vk_pipeline(context, pipeline),
+		VK_PIPELINE_BIND_POINT_COMPUTE
+	);
 }
 
 vren::pipeline vren::create_graphics_pipeline(
@@ -566,12 +396,14 @@ vren::pipeline vren::create_graphics_pipeline(
 )
 {
 	// Descriptor set layouts
-	std::vector<VkDescriptorSetLayout> descriptor_set_layouts = create_descriptor_set_layouts(context, shaders);
+	std::vector<VkDescriptorSetLayout> descriptor_set_layouts = get_descriptor_set_layouts(context, shaders);
 
 	// Shader stages
 	std::vector<VkSpecializationInfo> specialization_infos{};
 	std::vector<VkPipelineShaderStageCreateInfo> pipeline_shader_stages{};
 
+	specialization_infos.reserve(shaders.size()); // The shader stages point to the specialization infos, they mustn't be reallocated
+
 	for (vren::specialized_shader const& shader : shaders)
 	{
 		vren::shader_module const& shader_module = shader.get_shader_module();
@@ -616,17 +448,7 @@ vren::pipeline vren::create_graphics_pipeline(
 	}
 
 	// Pipeline layout
-	VkPipelineLayoutCreateInfo pipeline_layout_info{
-		.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-		.pNext = nullptr,
-		.flags = NULL,
-		.setLayoutCount = (uint32_t) descriptor_set_layouts.size(),
-		.pSetLayouts = descriptor_set_layouts.data(),
-		.pushConstantRangeCount = (uint32_t)push_constant_ranges.size(),
-		.pPushConstantRanges = push_constant_ranges.data(),
-	};
-	VkPipelineLayout pipeline_layout;
-	VREN_CHECK(vkCreatePipelineLayout(context.m_device, &pipeline_layout_info, nullptr, &pipeline_layout), &context);
+	VkPipelineLayout pipeline_layout = context.m_pipeline_layout_cache->get_pipeline_layout(descriptor_set_layouts, push_constant_ranges);
 
 	// Graphics pipeline
 	VkGraphicsPipelineCreateInfo pipeline_info{
@@ -650,13 +472,13 @@ vren::pipeline vren::create_graphics_pipeline(
 		.basePipelineIndex = 0,
 	};
 	VkPipeline pipeline;
-	VREN_CHECK(vkCreateGraphicsPipelines(context.m_device, VK_NULL_HANDLE, 1, &pipeline_info, nullptr, &pipeline), &context);
-
-	return {
-		.m_context = &context,
-		.m_descriptor_set_layouts = std::move(descriptor_set_layouts),
-		.m_pipeline_layout = vren::vk_pipeline_layout(context, pipeline_layout),
-		.m_pipeline = vren::vk_pipeline(context, pipeline),
-		.m_bind_point = VK_PIPELINE_BIND_POINT_GRAPHICS
-	};
+	VREN_CHECK(vkCreateGraphicsPipelines(context.m_device, context.m_pipeline_cache, 1, &pipeline_info, nullptr, &pipeline), &context);
+
+	return vren::pipeline(
+		context,
+		std::move(descriptor_set_layouts),
+		pipeline_layout,
+		vren::vk_pipeline(context, pipeline),
+		VK_PIPELINE_BIND_POINT_GRAPHICS
+	);
 }
@@ -9,6 +9,7 @@
 #include "base/base.hpp"
 #include "base/resource_container.hpp"
 #include "vk_raii.hpp"
+#include "shader_reflection.hpp"
 
 namespace vren
 {
@@ -23,25 +24,6 @@ namespace vren
 	// Shader module
 	// ------------------------------------------------------------------------------------------------
 
-	struct shader_module_entry_point
-	{
-		std::string m_name;
-		VkShaderStageFlags m_shader_stage;
-	};
-
-	struct shader_module_binding_info
-	{
-		VkDescriptorType m_descriptor_type;
-		uint32_t m_descriptor_count; // Count 0 means it's a variable descriptor count
-
-		inline bool is_variable_descriptor_count() const
-		{
-			return m_descriptor_count == 0;
-		}
-	};
-
-	using shader_module_descriptor_set_layout_info_t = std::unordered_map<uint32_t, shader_module_binding_info>;
-
 	//void print_descriptor_set_layouts(std::unordered_map<uint32_t, vren::shader_module_descriptor_set_layout_info_t> const& descriptor_set_layouts);
 
 	struct shader_module
@@ -56,6 +38,7 @@ namespace vren
 		
 		std::vector<std::string> m_specialization_constant_names;
 		std::vector<VkSpecializationMapEntry> m_specialization_map_entries;
+		std::vector<uint8_t> m_specialization_default_data; // The default values of the specialization constants, laid out as the map entries
 
 		inline shader_module_entry_point const& get_entry_point(std::string const& name) const
 		{
@@ -70,6 +53,11 @@ namespace vren
 			return m_push_constant_block_size > 0;
 		}
 
+		inline bool has_specialization_constant(std::string const& constant_name) const
+		{
+			return std::find(m_specialization_constant_names.begin(), m_specialization_constant_names.end(), constant_name) != m_specialization_constant_names.end();
+		}
+
 		inline uint32_t get_specialization_constant_id(std::string const& constant_name) const
 		{
 			auto found = std::find(m_specialization_constant_names.begin(), m_specialization_constant_names.end(), constant_name);
@@ -83,6 +71,9 @@ namespace vren
 	};
 
 	vren::shader_module load_shader_module(vren::context const& context, uint32_t const* code, size_t code_length, char const* name = "untitled");
+	vren::shader_module load_shader_module(vren::context const& context, uint32_t const* code, size_t code_length, vren::shader_reflection&& reflection, char const* name = "untitled");
+
+	/// Takes the reflection from the shader reflection file next to the SPIR-V when it's up-to-date, reflects the SPIR-V otherwise.
 	vren::shader_module load_shader_module_from_file(vren::context const& context, char const* filename);
 
 	// ------------------------------------------------------------------------------------------------
@@ -96,6 +87,7 @@ namespace vren
 		vren::shader_module_entry_point const* m_entry_point;
 
 		std::vector<uint8_t> m_specialization_data;
+		uint32_t m_required_subgroup_size = 0; // 0 if the driver may choose the subgroup size
 
 	public:
 		inline specialized_shader(
@@ -103,14 +95,9 @@ namespace vren
 			std::string const& entry_point = "main"
 		) :
 			m_shader_module(&shader_module),
-			m_entry_point(&shader_module.get_entry_point(entry_point))
+			m_entry_point(&shader_module.get_entry_point(entry_point)),
+			m_specialization_data(shader_module.m_specialization_default_data) // The constants that aren't set keep the value declared in the shader
 		{
-			size_t specialization_data_size = 0;
-			for (VkSpecializationMapEntry const& specialization_map_entry : shader_module.m_specialization_map_entries)
-			{
-				specialization_data_size += specialization_map_entry.size;
-			}
-			m_specialization_data.resize(specialization_data_size);
 		}
 
 		specialized_shader(vren::specialized_shader const& other) = delete;
@@ -118,7 +105,8 @@ namespace vren
 		inline specialized_shader(vren::specialized_shader const&& other) :
 			m_shader_module(other.m_shader_module),
 			m_entry_point(other.m_entry_point),
-			m_specialization_data(std::move(other.m_specialization_data))
+			m_specialization_data(std::move(other.m_specialization_data)),
+			m_required_subgroup_size(other.m_required_subgroup_size)
 		{
 		}
 
@@ -152,6 +140,19 @@ namespace vren
 			return m_specialization_data.size() > 0;
 		}
 
+		inline uint32_t get_required_subgroup_size() const
+		{
+			return m_required_subgroup_size;
+		}
+
+		/** The shader is dispatched with the given subgroup size and full subgroups, for the compute shaders whose workgroup is
+		 * assumed to be made of whole subgroups. The pipeline creation throws if the device can't guarantee it.
+		 */
+		inline void set_required_subgroup_size(uint32_t subgroup_size)
+		{
+			m_required_subgroup_size = subgroup_size;
+		}
+
 		inline void set_specialization_data(uint32_t constant_id, void const* data, size_t size)
 		{
 			size_t offset = 0;
@@ -185,13 +186,24 @@ namespace vren
 	{
 		vren::context const* m_context;
 
+		// The layouts are shared with the pipelines having the same bindings and are owned by the context (see vren::pipeline_layout_cache)
 		std::vector<VkDescriptorSetLayout> m_descriptor_set_layouts;
-		vren::vk_pipeline_layout m_pipeline_layout;
+		VkPipelineLayout m_pipeline_layout;
 		vren::vk_pipeline m_pipeline;
 
 		VkPipelineBindPoint m_bind_point;
 
-		~pipeline();
+		pipeline(
+			vren::context const& context,
+			std::vector<VkDescriptorSetLayout>&& descriptor_set_layouts,
+			VkPipelineLayout pipeline_layout,
+			vren::vk_pipeline&& pipeline,
+			VkPipelineBindPoint bind_point
+		);
+		pipeline(vren::pipeline const& other) = delete;
+		pipeline(vren::pipeline&& other) noexcept = default; // Movable to be handed back by the pipeline builder (see vren::pipeline_builder)
+
+		vren::pipeline& operator=(vren::pipeline&& other) noexcept = default; // Replaced by a reloaded pipeline (see vren::shader_registry)
 
 		void bind(VkCommandBuffer command_buffer) const;
 		void bind_vertex_buffer(VkCommandBuffer command_buffer, uint32_t binding, VkBuffer vertex_buffer, VkDeviceSize offset = 0) const;
@@ -0,0 +1,466 @@
+#include "shader_reflection.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+
+#include <spirv_cross.hpp>
+
+#include "log.hpp"
+
+#ifdef VREN_LOG_SHADER_DETAILED
+#	define VREN_DEBUG0(m, ...) VREN_DEBUG(m, __VA_ARGS__)
+#else
+#	define VREN_DEBUG0
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Shader reflection
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::shader_reflection vren::reflect_shader(uint32_t const* code, size_t code_length, char const* name)
+{
+	spirv_cross::Compiler compiler(code, code_length);
+
+	VREN_DEBUG0("[shader] ----------------------------------------------------------------\n");
+	VREN_DEBUG0("[shader] Shader module: \"{}\"\n", name);
+	VREN_DEBUG0("[shader] ----------------------------------------------------------------\n");
+
+	// Entry points
+	std::vector<vren::shader_module_entry_point> entry_points{};
+
+	auto parse_shader_stage = [](spv::ExecutionModel execution_model) -> VkShaderStageFlags
+	{
+		switch (execution_model)
+		{
+		case spv::ExecutionModelVertex:    return VK_SHADER_STAGE_VERTEX_BIT;
+		case spv::ExecutionModelFragment:  return VK_SHADER_STAGE_FRAGMENT_BIT;
+		case spv::ExecutionModelTaskNV:    return VK_SHADER_STAGE_TASK_BIT_NV;
+		case spv::ExecutionModelMeshNV:    return VK_SHADER_STAGE_MESH_BIT_NV;
+		case spv::ExecutionModelKernel:    return VK_SHADER_STAGE_COMPUTE_BIT;
+		case spv::ExecutionModelGLCompute: return VK_SHADER_STAGE_COMPUTE_BIT;
+		default:
+			throw std::runtime_error("Execution model not recognized");
+		}
+	};
+
+	for (spirv_cross::EntryPoint const& spirv_entry_point : compiler.get_entry_points_and_stages())
+	{
+		vren::shader_module_entry_point entry_point{
+			.m_name = spirv_entry_point.name,
+			.m_shader_stage = parse_shader_stage(spirv_entry_point.execution_model)
+		};
+		entry_points.push_back(entry_point);
+
+		VREN_DEBUG0("[shader] Entry point: \"{}\" (shader stage: {:#010x})\n", entry_point.m_name, entry_point.m_shader_stage);
+	}
+
+	assert(entry_points.size() > 0);
+
+	// Descriptor set layouts
+	spirv_cross::ShaderResources shader_resources = compiler.get_shader_resources();
+
+	std::unordered_map<uint32_t, vren::shader_module_descriptor_set_layout_info_t> descriptor_set_layouts;
+
+	auto load_resources = [&](
+		spirv_cross::SmallVector<spirv_cross::Resource> const& resources,
+		std::function<VkDescriptorType(spirv_cross::Resource const&)> deduct_descriptor_type
+	)
+	{
+		for (spirv_cross::Resource const& resource : resources)
+		{
+			assert(compiler.has_decoration(resource.id, spv::DecorationDescriptorSet));
+			assert(compiler.has_decoration(resource.id, spv::DecorationBinding));
+
+			uint32_t descriptor_set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
+			uint32_t binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
+
+			spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
+
+			assert(type.array.size() == 0 || (type.array.size() == 1 && type.array_size_literal[0])); // Multi-dimensional arrays aren't supported
+
+			VkDescriptorType descriptor_type = deduct_descriptor_type(resource);
+			vren::shader_module_binding_info binding_info{
+				.m_descriptor_type = descriptor_type,
+				.m_descriptor_count = type.array.size() > 0 ? type.array[0] : 1,
+			};
+			descriptor_set_layouts.emplace(descriptor_set, std::unordered_map<uint32_t, vren::shader_module_binding_info>{});
+			descriptor_set_layouts.at(descriptor_set).emplace(binding, binding_info);
+
+			VREN_DEBUG0("[shader] Descriptor {}.{} - descriptor type: {:#010x} - count: {} - variable count: {}\n",
+				descriptor_set,
+				binding,
+				binding_info.m_descriptor_type,
+				binding_info.m_descriptor_count,
+				binding_info.is_variable_descriptor_count() ? "true" : "false"
+			);
+		}
+	};
+
+	load_resources(shader_resources.sampled_images, [&](spirv_cross::Resource const& resource)
+	{
+		return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	});
+
+	load_resources(shader_resources.separate_images, [&](spirv_cross::Resource const& resource)
+	{
+		spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
+
+		return type.image.dim == spv::Dim::DimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	});
+
+	load_resources(shader_resources.storage_images, [&](spirv_cross::Resource const& resource)
+	{
+		spirv_cross::SPIRType type = compiler.get_type(resource.type_id);
+
+		return type.image.dim == spv::Dim::DimBuffer ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	});
+
+	load_resources(shader_resources.separate_samplers, [&](spirv_cross::Resource const& resource)
+	{
+		return VK_DESCRIPTOR_TYPE_SAMPLER;
+	});
+
+	load_resources(shader_resources.uniform_buffers, [&](spirv_cross::Resource const& resource)
+	{
+		return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	});
+
+	load_resources(shader_resources.storage_buffers, [&](spirv_cross::Resource const& resource)
+	{
+		return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	});
+
+	// Push constants
+	size_t push_constant_block_size = 0;
+	if (shader_resources.push_constant_buffers.size() > 0)
+	{
+		spirv_cross::Resource const& resource = shader_resources.push_constant_buffers[0];
+
+		if (shader_resources.push_constant_buffers.size() > 1)
+		{
+			VREN_WARN("[shader] Only one push-constant block per stage is supported, taking: \"{}\"\n", resource.name);
+		}
+
+		std::string name = compiler.get_name(resource.id);
+		push_constant_block_size = compiler.get_declared_struct_size(compiler.get_type(resource.type_id));
+
+		VREN_DEBUG0("[shader] Push-constant block \"{}\" - size: {}\n",
+			name,
+			push_constant_block_size
+		);
+	}
+
+	// Specialization constants
+	std::vector<std::string> specialization_constant_names{};
+	std::vector<VkSpecializationMapEntry> specialization_map_entries{};
+	std::vector<uint8_t> specialization_default_data{};
+	uint32_t specialization_constant_offset = 0;
+
+	for (spirv_cross::SpecializationConstant const& spirv_specialization_constant : compiler.get_specialization_constants())
+	{
+		spirv_cross::SPIRConstant value = compiler.get_constant(spirv_specialization_constant.id);
+		spirv_cross::SPIRType type = compiler.get_type(value.constant_type);
+
+		size_t data_size;
+		switch (type.basetype)
+		{
+		case (spirv_cross::SPIRType::BaseType::Boolean): data_size = sizeof(VkBool32); break;
+		case (spirv_cross::SPIRType::BaseType::Char):    data_size = sizeof(char); break;
+		case (spirv_cross::SPIRType::BaseType::Int):     data_size = sizeof(int32_t); break;
+		case (spirv_cross::SPIRType::BaseType::UInt):    data_size = sizeof(uint32_t); break;
+		case (spirv_cross::SPIRType::BaseType::Float):   data_size = sizeof(float); break;
+		case (spirv_cross::SPIRType::BaseType::Double):  data_size = sizeof(double); break;
+		case (spirv_cross::SPIRType::BaseType::Int64):   data_size = sizeof(int64_t); break;
+		default:
+			throw std::runtime_error("Invalid specialization constant data type");
+		}
+
+		std::string specialization_constant_name = compiler.get_name(spirv_specialization_constant.id);
+
+		uint32_t specialization_constant_id = spirv_specialization_constant.constant_id;
+
+		specialization_constant_names.push_back(specialization_constant_name);
+		specialization_map_entries.push_back(VkSpecializationMapEntry{
+			.constantID = spirv_specialization_constant.constant_id,
+			.offset = specialization_constant_offset,
+			.size = data_size,
+		});
+
+		// The constant holds its default value, the first bytes of the 64-bit scalar on little-endian hosts
+		uint64_t default_value = data_size == sizeof(uint64_t) ? value.scalar_u64() : value.scalar();
+		specialization_default_data.resize(specialization_constant_offset + data_size);
+		std::memcpy(&specialization_default_data[specialization_constant_offset], &default_value, data_size);
+
+		specialization_constant_offset += data_size;
+
+		VREN_DEBUG0("[shader] Specialization constant {} (ID: {}) - size: {}\n",
+			specialization_constant_name,
+			specialization_constant_id,
+			data_size
+		);
+	}
+
+	//
+	return {
+		.m_entry_points = std::move(entry_points),
+		.m_descriptor_set_layouts = std::move(descriptor_set_layouts),
+		.m_push_constant_block_size = push_constant_block_size,
+		.m_specialization_constant_names = std::move(specialization_constant_names),
+		.m_specialization_map_entries = std::move(specialization_map_entries),
+		.m_specialization_default_data = std::move(specialization_default_data),
+	};
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Shader reflection file
+// --------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+	class shader_reflection_file_writer
+	{
+	private:
+		std::vector<uint8_t> m_data;
+
+	public:
+		template<typename _t>
+		void write(_t value)
+		{
+			size_t offset = m_data.size();
+			m_data.resize(offset + sizeof(_t));
+			std::memcpy(&m_data[offset], &value, sizeof(_t));
+		}
+
+		void write_bytes(void const* data, size_t size)
+		{
+			write<uint32_t>((uint32_t) size);
+
+			size_t offset = m_data.size();
+			m_data.resize(offset + size);
+			std::memcpy(m_data.data() + offset, data, size);
+		}
+
+		inline std::vector<uint8_t> const& get_data() const
+		{
+			return m_data;
+		}
+	};
+
+	class shader_reflection_file_reader
+	{
+	private:
+		std::vector<uint8_t> const* m_data;
+		size_t m_offset = 0;
+
+	public:
+		explicit shader_reflection_file_reader(std::vector<uint8_t> const& data) :
+			m_data(&data)
+		{}
+
+		template<typename _t>
+		_t read()
+		{
+			if (m_offset + sizeof(_t) > m_data->size())
+			{
+				throw std::runtime_error("Unexpected end of the shader reflection file");
+			}
+
+			_t value;
+			std::memcpy(&value, m_data->data() + m_offset, sizeof(_t));
+			m_offset += sizeof(_t);
+			return value;
+		}
+
+		std::vector<uint8_t> read_bytes()
+		{
+			uint32_t size = read<uint32_t>();
+			if (m_offset + size > m_data->size())
+			{
+				throw std::runtime_error("Unexpected end of the shader reflection file");
+			}
+
+			std::vector<uint8_t> bytes(m_data->begin() + m_offset, m_data->begin() + m_offset + size);
+			m_offset += size;
+			return bytes;
+		}
+
+		std::string read_string()
+		{
+			std::vector<uint8_t> bytes = read_bytes();
+			return std::string(bytes.begin(), bytes.end());
+		}
+
+		inline bool is_at_end() const
+		{
+			return m_offset == m_data->size();
+		}
+	};
+}
+
+uint64_t vren::hash_spirv_code(uint32_t const* code, size_t code_length)
+{
+	// FNV-1a
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < code_length; i++)
+	{
+		hash ^= code[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+std::filesystem::path vren::get_shader_reflection_file_path(std::filesystem::path const& shader_path)
+{
+	std::filesystem::path file_path = shader_path;
+	file_path += ".refl";
+	return file_path;
+}
+
+void vren::write_shader_reflection_file(std::filesystem::path const& file_path, vren::shader_reflection const& reflection, uint64_t code_hash)
+{
+	shader_reflection_file_writer writer;
+
+	writer.write<uint32_t>(vren::k_shader_reflection_file_magic);
+	writer.write<uint32_t>(vren::k_shader_reflection_file_version);
+	writer.write<uint64_t>(code_hash);
+
+	// Entry points
+	writer.write<uint32_t>((uint32_t) reflection.m_entry_points.size());
+	for (vren::shader_module_entry_point const& entry_point : reflection.m_entry_points)
+	{
+		writer.write_bytes(entry_point.m_name.data(), entry_point.m_name.size());
+		writer.write<uint32_t>(entry_point.m_shader_stage);
+	}
+
+	// Descriptor set layouts
+	writer.write<uint32_t>((uint32_t) reflection.m_descriptor_set_layouts.size());
+	for (auto const& [descriptor_set_idx, descriptor_set_layout_info] : reflection.m_descriptor_set_layouts)
+	{
+		writer.write<uint32_t>(descriptor_set_idx);
+		writer.write<uint32_t>((uint32_t) descriptor_set_layout_info.size());
+		for (auto const& [binding, binding_info] : descriptor_set_layout_info)
+		{
+			writer.write<uint32_t>(binding);
+			writer.write<uint32_t>(binding_info.m_descriptor_type);
+			writer.write<uint32_t>(binding_info.m_descriptor_count);
+		}
+	}
+
+	// Push constants
+	writer.write<uint64_t>(reflection.m_push_constant_block_size);
+
+	// Specialization constants
+	writer.write<uint32_t>((uint32_t) reflection.m_specialization_map_entries.size());
+	for (size_t i = 0; i < reflection.m_specialization_map_entries.size(); i++)
+	{
+		VkSpecializationMapEntry const& map_entry = reflection.m_specialization_map_entries.at(i);
+		std::string const& name = reflection.m_specialization_constant_names.at(i);
+
+		writer.write_bytes(name.data(), name.size());
+		writer.write<uint32_t>(map_entry.constantID);
+		writer.write<uint32_t>(map_entry.offset);
+		writer.write<uint64_t>(map_entry.size);
+	}
+	writer.write_bytes(reflection.m_specialization_default_data.data(), reflection.m_specialization_default_data.size());
+
+	//
+	std::ofstream f(file_path, std::ios::binary | std::ios::trunc);
+	f.write(reinterpret_cast<char const*>(writer.get_data().data()), writer.get_data().size());
+
+	if (!f)
+	{
+		throw std::runtime_error("Failed to write the shader reflection file");
+	}
+}
+
+bool vren::read_shader_reflection_file(std::filesystem::path const& file_path, uint64_t code_hash, vren::shader_reflection& reflection)
+{
+	std::ifstream f(file_path, std::ios::ate | std::ios::binary);
+	if (!f.is_open())
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> data(f.tellg());
+	f.seekg(0);
+	f.read(reinterpret_cast<char*>(data.data()), data.size());
+	if (!f)
+	{
+		return false;
+	}
+
+	try
+	{
+		shader_reflection_file_reader reader(data);
+
+		if (reader.read<uint32_t>() != vren::k_shader_reflection_file_magic ||
+			reader.read<uint32_t>() != vren::k_shader_reflection_file_version ||
+			reader.read<uint64_t>() != code_hash)
+		{
+			return false;
+		}
+
+		vren::shader_reflection result{};
+
+		// Entry points
+		uint32_t entry_point_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < entry_point_count; i++)
+		{
+			vren::shader_module_entry_point& entry_point = result.m_entry_points.emplace_back();
+			entry_point.m_name = reader.read_string();
+			entry_point.m_shader_stage = reader.read<uint32_t>();
+		}
+
+		// Descriptor set layouts
+		uint32_t descriptor_set_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < descriptor_set_count; i++)
+		{
+			uint32_t descriptor_set_idx = reader.read<uint32_t>();
+			vren::shader_module_descriptor_set_layout_info_t& descriptor_set_layout_info = result.m_descriptor_set_layouts[descriptor_set_idx];
+
+			uint32_t binding_count = reader.read<uint32_t>();
+			for (uint32_t j = 0; j < binding_count; j++)
+			{
+				uint32_t binding = reader.read<uint32_t>();
+				VkDescriptorType descriptor_type = static_cast<VkDescriptorType>(reader.read<uint32_t>());
+				uint32_t descriptor_count = reader.read<uint32_t>();
+
+				descriptor_set_layout_info.emplace(binding, vren::shader_module_binding_info{
+					.m_descriptor_type = descriptor_type,
+					.m_descriptor_count = descriptor_count,
+				});
+			}
+		}
+
+		// Push constants
+		result.m_push_constant_block_size = reader.read<uint64_t>();
+
+		// Specialization constants
+		uint32_t specialization_constant_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < specialization_constant_count; i++)
+		{
+			result.m_specialization_constant_names.push_back(reader.read_string());
+
+			VkSpecializationMapEntry& map_entry = result.m_specialization_map_entries.emplace_back();
+			map_entry.constantID = reader.read<uint32_t>();
+			map_entry.offset = reader.read<uint32_t>();
+			map_entry.size = reader.read<uint64_t>();
+		}
+		result.m_specialization_default_data = reader.read_bytes();
+
+		if (!reader.is_at_end())
+		{
+			return false;
+		}
+
+		reflection = std::move(result);
+		return true;
+	}
+	catch (std::runtime_error const& error)
+	{
+		VREN_WARN("[shader] Malformed shader reflection file {}: {}\n", file_path.string(), error.what());
+		return false;
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <volk.h>
+
+namespace vren
+{
+	// ------------------------------------------------------------------------------------------------
+	// Shader reflection
+	// ------------------------------------------------------------------------------------------------
+
+	struct shader_module_entry_point
+	{
+		std::string m_name;
+		VkShaderStageFlags m_shader_stage;
+	};
+
+	struct shader_module_binding_info
+	{
+		VkDescriptorType m_descriptor_type;
+		uint32_t m_descriptor_count; // Count 0 means it's a variable descriptor count
+
+		inline bool is_variable_descriptor_count() const
+		{
+			return m_descriptor_count == 0;
+		}
+	};
+
+	using shader_module_descriptor_set_layout_info_t = std::unordered_map<uint32_t, shader_module_binding_info>;
+
+	/// Everything the shader module needs from the SPIR-V besides the code itself.
+	struct shader_reflection
+	{
+		std::vector<vren::shader_module_entry_point> m_entry_points;
+		std::unordered_map<uint32_t, vren::shader_module_descriptor_set_layout_info_t> m_descriptor_set_layouts;
+		size_t m_push_constant_block_size = 0;
+
+		std::vector<std::string> m_specialization_constant_names;
+		std::vector<VkSpecializationMapEntry> m_specialization_map_entries;
+		std::vector<uint8_t> m_specialization_default_data;
+	};
+
+	/// Reflects the SPIR-V with SPIRV-Cross.
+	vren::shader_reflection reflect_shader(uint32_t const* code, size_t code_length, char const* name = "untitled");
+
+	// ------------------------------------------------------------------------------------------------
+	// Shader reflection file
+	// ------------------------------------------------------------------------------------------------
+
+	inline constexpr uint32_t k_shader_reflection_file_magic = 0x52535256; // "VRSR"
+	inline constexpr uint32_t k_shader_reflection_file_version = 1;
+
+	/** The shader reflection file is written next to the .spv at build time (see the vren_reflect_shader tool), loading a shader module
+	 * then skips SPIRV-Cross. The file records the hash of the SPIR-V it was written for: a stale file is ignored.
+	 */
+	uint64_t hash_spirv_code(uint32_t const* code, size_t code_length);
+
+	std::filesystem::path get_shader_reflection_file_path(std::filesystem::path const& shader_path);
+
+	/// Throws if the file can't be written.
+	void write_shader_reflection_file(std::filesystem::path const& file_path, vren::shader_reflection const& reflection, uint64_t code_hash);
+
+	/// Returns false if the file doesn't exist, is malformed or was written for another SPIR-V.
+	bool read_shader_reflection_file(std::filesystem::path const& file_path, uint64_t code_hash, vren::shader_reflection& reflection);
+}
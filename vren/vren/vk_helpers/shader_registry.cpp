@@ -0,0 +1,394 @@
+#include "shader_registry.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#include "context.hpp"
+#include "pipeline_builder.hpp"
+#include "log.hpp"
+
+namespace
+{
+	std::filesystem::path normalize_path(std::filesystem::path const& path)
+	{
+		std::error_code error_code;
+		std::filesystem::path normalized_path = std::filesystem::weakly_canonical(path, error_code);
+		return error_code ? path : normalized_path;
+	}
+
+	std::filesystem::file_time_type get_write_time(std::filesystem::path const& path)
+	{
+		std::error_code error_code;
+		std::filesystem::file_time_type write_time = std::filesystem::last_write_time(path, error_code);
+		return error_code ? std::filesystem::file_time_type::min() : write_time;
+	}
+
+	std::string quote_argument(std::string const& argument)
+	{
+		return "\"" + argument + "\"";
+	}
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Shader watch
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::shader_watch::shader_watch(vren::shader_registry& registry, uint32_t id) :
+	m_registry(&registry),
+	m_id(id)
+{}
+
+vren::shader_watch::shader_watch(vren::shader_watch&& other) noexcept :
+	m_registry(std::exchange(other.m_registry, nullptr)),
+	m_id(std::exchange(other.m_id, 0))
+{}
+
+vren::shader_watch::~shader_watch()
+{
+	if (m_registry)
+	{
+		m_registry->unwatch(m_id);
+	}
+}
+
+vren::shader_watch& vren::shader_watch::operator=(vren::shader_watch&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (m_registry)
+		{
+			m_registry->unwatch(m_id);
+		}
+
+		m_registry = std::exchange(other.m_registry, nullptr);
+		m_id = std::exchange(other.m_id, 0);
+	}
+	return *this;
+}
+
+// --------------------------------------------------------------------------------------------------------------------------------
+// Shader registry
+// --------------------------------------------------------------------------------------------------------------------------------
+
+vren::shader_registry::shader_registry(vren::context const& context, std::filesystem::path const& shader_sources_file) :
+	m_context(&context)
+{
+	load_shader_sources(shader_sources_file);
+
+	m_thread = std::thread([this]()
+	{
+		run();
+	});
+}
+
+vren::shader_registry::~shader_registry()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_condition.notify_all();
+
+	m_thread.join();
+}
+
+void vren::shader_registry::load_shader_sources(std::filesystem::path const& shader_sources_file)
+{
+	// Every line is written by compile_shader: the SPIR-V path, the GLSL source path and the glslc command, separated by tabs
+	std::ifstream f(shader_sources_file);
+	if (!f.is_open())
+	{
+		VREN_WARN("[shader_registry] Shader sources file not found: {}, only the changed SPIR-V will be reloaded\n", shader_sources_file.string());
+		return;
+	}
+
+	std::string line;
+	while (std::getline(f, line))
+	{
+		std::vector<std::string> tokens;
+		std::istringstream line_stream(line);
+		for (std::string token; std::getline(line_stream, token, '\t');)
+		{
+			if (!token.empty())
+			{
+				tokens.push_back(token);
+			}
+		}
+
+		if (tokens.size() < 3)
+		{
+			continue;
+		}
+
+		shader_source shader_source{
+			.m_spv_path = normalize_path(tokens[0]),
+			.m_source_path = normalize_path(tokens[1]),
+			.m_compile_command = std::vector<std::string>(tokens.begin() + 2, tokens.end()),
+		};
+		for (size_t i = 0; i + 1 < shader_source.m_compile_command.size(); i++)
+		{
+			if (shader_source.m_compile_command[i] == "-I")
+			{
+				shader_source.m_include_dir = normalize_path(shader_source.m_compile_command[i + 1]);
+			}
+		}
+
+		m_shader_sources.push_back(std::move(shader_source));
+	}
+
+	VREN_INFO("[shader_registry] Watching {} shader sources\n", m_shader_sources.size());
+}
+
+void vren::shader_registry::run()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait_for(lock, k_poll_interval, [this]() { return m_stopping; });
+			if (m_stopping)
+			{
+				return;
+			}
+		}
+
+		recompile_changed_sources();
+		reload_changed_pipelines();
+	}
+}
+
+void vren::shader_registry::recompile_changed_sources()
+{
+	// A file is recorded the first time it's seen: only the edits made while running trigger a compilation
+	auto has_changed = [this](std::filesystem::path const& path)
+	{
+		std::filesystem::file_time_type write_time = get_write_time(path);
+
+		auto [iterator, inserted] = m_source_write_times.try_emplace(path, write_time);
+		if (inserted || iterator->second == write_time)
+		{
+			return false;
+		}
+
+		iterator->second = write_time;
+		return true;
+	};
+
+	// The includes are shared by many shaders, a changed include recompiles all the shaders of its directory
+	std::vector<std::filesystem::path> changed_include_dirs;
+	for (shader_source const& shader_source : m_shader_sources)
+	{
+		std::filesystem::path const& include_dir = shader_source.m_include_dir;
+		if (include_dir.empty() || std::find(changed_include_dirs.begin(), changed_include_dirs.end(), include_dir) != changed_include_dirs.end())
+		{
+			continue;
+		}
+
+		std::error_code error_code;
+		bool include_changed = false;
+		for (auto const& entry : std::filesystem::recursive_directory_iterator(include_dir, error_code))
+		{
+			if (entry.is_regular_file() && entry.path().extension() == ".glsl")
+			{
+				include_changed |= has_changed(normalize_path(entry.path()));
+			}
+		}
+
+		if (include_changed)
+		{
+			changed_include_dirs.push_back(include_dir);
+		}
+	}
+
+	for (shader_source const& shader_source : m_shader_sources)
+	{
+		bool source_changed = has_changed(shader_source.m_source_path);
+		bool include_changed = std::find(changed_include_dirs.begin(), changed_include_dirs.end(), shader_source.m_include_dir) != changed_include_dirs.end();
+		if (source_changed || include_changed)
+		{
+			compile(shader_source);
+		}
+	}
+}
+
+bool vren::shader_registry::compile(shader_source const& shader_source)
+{
+	// Compiled to a temporary file first so that a failed compilation leaves the last SPIR-V in place
+	std::filesystem::path tmp_spv_path = shader_source.m_spv_path;
+	tmp_spv_path += ".tmp";
+
+	std::string command;
+	for (std::string const& argument : shader_source.m_compile_command)
+	{
+		command += quote_argument(argument) + " ";
+	}
+	command += "-o " + quote_argument(tmp_spv_path.string()) + " " + quote_argument(shader_source.m_source_path.string());
+
+	VREN_INFO("[shader_registry] Recompiling shader: {}\n", shader_source.m_source_path.string());
+
+	int result = std::system(command.c_str());
+
+	std::error_code error_code;
+	if (result != 0)
+	{
+		VREN_WARN("[shader_registry] Failed to compile shader: {} (exit code {}), keeping the old pipelines\n", shader_source.m_source_path.string(), result);
+
+		std::filesystem::remove(tmp_spv_path, error_code);
+		return false;
+	}
+
+	std::filesystem::rename(tmp_spv_path, shader_source.m_spv_path, error_code);
+	if (error_code)
+	{
+		VREN_WARN("[shader_registry] Failed to replace SPIR-V: {} ({})\n", shader_source.m_spv_path.string(), error_code.message());
+
+		std::filesystem::remove(tmp_spv_path, error_code);
+		return false;
+	}
+
+	return true;
+}
+
+void vren::shader_registry::reload_changed_pipelines()
+{
+	std::vector<std::shared_ptr<watched_pipeline>> watched_pipelines;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto const& [id, watched_pipeline] : m_watched_pipelines)
+		{
+			watched_pipelines.push_back(watched_pipeline);
+		}
+	}
+
+	for (std::shared_ptr<watched_pipeline> const& watched_pipeline : watched_pipelines)
+	{
+		bool changed = false;
+		for (size_t i = 0; i < watched_pipeline->m_spv_paths.size(); i++)
+		{
+			std::filesystem::file_time_type write_time = get_write_time(watched_pipeline->m_spv_paths.at(i));
+			if (write_time != watched_pipeline->m_spv_write_times.at(i))
+			{
+				watched_pipeline->m_spv_write_times.at(i) = write_time;
+				changed = true;
+			}
+		}
+
+		if (!changed)
+		{
+			continue;
+		}
+
+		try
+		{
+			vren::pipeline pipeline = watched_pipeline->m_create_pipeline();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			watched_pipeline->m_reloaded_pipeline.emplace(std::move(pipeline));
+		}
+		catch (std::exception const& exception)
+		{
+			VREN_WARN("[shader_registry] Failed to reload pipeline: {}, keeping the old one\n", exception.what());
+		}
+	}
+}
+
+vren::shader_watch vren::shader_registry::watch(
+	vren::pipeline& pipeline,
+	std::vector<std::filesystem::path> spv_paths,
+	std::function<vren::pipeline()> create_pipeline
+)
+{
+	auto watched_pipeline = std::make_shared<vren::shader_registry::watched_pipeline>();
+	watched_pipeline->m_pipeline = &pipeline;
+	watched_pipeline->m_create_pipeline = std::move(create_pipeline);
+
+	for (std::filesystem::path const& spv_path : spv_paths)
+	{
+		watched_pipeline->m_spv_write_times.push_back(get_write_time(spv_path));
+	}
+	watched_pipeline->m_spv_paths = std::move(spv_paths);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32_t id = m_next_id++;
+	m_watched_pipelines.emplace(id, std::move(watched_pipeline));
+
+	return vren::shader_watch(*this, id);
+}
+
+vren::shader_watch vren::shader_registry::watch_compute_pipeline(
+	vren::pipeline& pipeline,
+	std::string shader_path,
+	std::function<void(vren::specialized_shader& shader)> specialize_func
+)
+{
+	std::vector<std::filesystem::path> spv_paths{ shader_path };
+	return watch(pipeline, std::move(spv_paths), [context = m_context, shader_path = std::move(shader_path), specialize_func = std::move(specialize_func)]()
+	{
+		return vren::create_compute_pipeline_from_file(*context, shader_path.c_str(), specialize_func);
+	});
+}
+
+void vren::shader_registry::unwatch(uint32_t id)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_watched_pipelines.erase(id);
+}
+
+std::vector<std::filesystem::path> vren::shader_registry::get_spv_paths(std::filesystem::path const& source_path) const
+{
+	std::filesystem::path normalized_source_path = normalize_path(source_path);
+
+	// As in recompile_changed_sources, an include is any .glsl file within the include directory
+	auto is_included = [&](std::filesystem::path const& include_dir)
+	{
+		if (include_dir.empty() || normalized_source_path.extension() != ".glsl")
+		{
+			return false;
+		}
+
+		auto [include_dir_end, source_path_it] = std::mismatch(include_dir.begin(), include_dir.end(), normalized_source_path.begin(), normalized_source_path.end());
+		return include_dir_end == include_dir.end();
+	};
+
+	std::vector<std::filesystem::path> spv_paths;
+	for (shader_source const& shader_source : m_shader_sources)
+	{
+		if (shader_source.m_source_path == normalized_source_path || is_included(shader_source.m_include_dir))
+		{
+			spv_paths.push_back(shader_source.m_spv_path);
+		}
+	}
+	return spv_paths;
+}
+
+uint32_t vren::shader_registry::swap_reloaded_pipelines(vren::resource_container& resource_container)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	uint32_t swapped_count = 0;
+	for (auto const& [id, watched_pipeline] : m_watched_pipelines)
+	{
+		if (!watched_pipeline->m_reloaded_pipeline.has_value())
+		{
+			continue;
+		}
+
+		resource_container.add_resource(std::make_shared<vren::pipeline>(std::move(*watched_pipeline->m_pipeline)));
+
+		*watched_pipeline->m_pipeline = std::move(*watched_pipeline->m_reloaded_pipeline);
+		watched_pipeline->m_reloaded_pipeline.reset();
+
+		swapped_count++;
+	}
+
+	if (swapped_count > 0)
+	{
+		VREN_INFO("[shader_registry] Swapped {} reloaded pipelines\n", swapped_count);
+	}
+
+	return swapped_count;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "shader.hpp"
+#include "base/resource_container.hpp"
+
+namespace vren
+{
+	// Forward decl
+	class context;
+	class shader_registry;
+
+	// ------------------------------------------------------------------------------------------------
+	// Shader watch
+	// ------------------------------------------------------------------------------------------------
+
+	/// Keeps a pipeline registered for hot reload while alive (see vren::shader_registry::watch).
+	class shader_watch
+	{
+	private:
+		vren::shader_registry* m_registry = nullptr;
+		uint32_t m_id = 0;
+
+	public:
+		shader_watch() = default;
+		shader_watch(vren::shader_registry& registry, uint32_t id);
+		shader_watch(vren::shader_watch const& other) = delete;
+		shader_watch(vren::shader_watch&& other) noexcept;
+
+		~shader_watch();
+
+		vren::shader_watch& operator=(vren::shader_watch&& other) noexcept;
+	};
+
+	// ------------------------------------------------------------------------------------------------
+	// Shader registry
+	// ------------------------------------------------------------------------------------------------
+
+	/** Reloads the pipelines whose SPIR-V changes on disk. A background thread polls the watched SPIR-V files and the GLSL sources
+	 * they're built from, listed by compile_shader in the shader sources file: a changed source is recompiled with glslc, then the
+	 * pipelines using the SPIR-V are created again on the background thread. A failed compilation or pipeline creation is logged and the
+	 * old pipeline is kept. The reloaded pipelines replace the old ones in swap_reloaded_pipelines, called between frames.
+	 */
+	class shader_registry
+	{
+	private:
+		struct shader_source
+		{
+			std::filesystem::path m_spv_path;
+			std::filesystem::path m_source_path;
+			std::filesystem::path m_include_dir;
+			std::vector<std::string> m_compile_command; // glslc and its arguments, the output path excluded
+		};
+
+		struct watched_pipeline
+		{
+			vren::pipeline* m_pipeline;
+			std::vector<std::filesystem::path> m_spv_paths;
+			std::function<vren::pipeline()> m_create_pipeline;
+
+			std::vector<std::filesystem::file_time_type> m_spv_write_times; // Only accessed by the background thread once watched
+			std::optional<vren::pipeline> m_reloaded_pipeline;
+		};
+
+		vren::context const* m_context;
+
+		std::vector<shader_source> m_shader_sources;
+		std::map<std::filesystem::path, std::filesystem::file_time_type> m_source_write_times; // Sources and includes
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+		uint32_t m_next_id = 1;
+		std::unordered_map<uint32_t, std::shared_ptr<watched_pipeline>> m_watched_pipelines;
+
+		std::thread m_thread;
+
+		void load_shader_sources(std::filesystem::path const& shader_sources_file);
+
+		void run();
+		void recompile_changed_sources();
+		bool compile(shader_source const& shader_source);
+		void reload_changed_pipelines();
+
+	public:
+		inline static const std::chrono::milliseconds k_poll_interval = std::chrono::milliseconds(500);
+
+		shader_registry(vren::context const& context, std::filesystem::path const& shader_sources_file);
+		shader_registry(vren::shader_registry const& other) = delete;
+		shader_registry(vren::shader_registry&& other) = delete;
+
+		~shader_registry();
+
+		/// The pipeline must keep its address while watched, create_pipeline is called on the background thread.
+		[[nodiscard]] vren::shader_watch watch(
+			vren::pipeline& pipeline,
+			std::vector<std::filesystem::path> spv_paths,
+			std::function<vren::pipeline()> create_pipeline
+		);
+
+		[[nodiscard]] vren::shader_watch watch_compute_pipeline(
+			vren::pipeline& pipeline,
+			std::string shader_path,
+			std::function<void(vren::specialized_shader& shader)> specialize_func = nullptr
+		);
+
+		void unwatch(uint32_t id);
+
+		/// The SPIR-V recompiled when the given GLSL source changes: the ones built from it, or from the shaders of its include directory.
+		std::vector<std::filesystem::path> get_spv_paths(std::filesystem::path const& source_path) const;
+
+		/// Replaces the pipelines reloaded since the last call. The old pipelines are kept alive by the resource container of the frame
+		/// (the command buffers in flight may still use them). Returns the number of replaced pipelines.
+		uint32_t swap_reloaded_pipelines(vren::resource_container& resource_container);
+	};
+}
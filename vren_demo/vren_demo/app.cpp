@@ -7,17 +7,19 @@
 #include <vren/base/base.hpp>
 #include <vren/model/basic_model_uploader.hpp>
 #include <vren/model/model_clusterizer.hpp>
+#include <vren/model/model_optimizer.hpp>
 #include <vren/model/clusterized_model_uploader.hpp>
 #include <vren/pipeline/imgui_utils.hpp>
+#include <vren/vk_helpers/command_recorder.hpp>
+#include <vren/vk_helpers/shader_registry.hpp>
 
-#include <glm/gtc/random.hpp>
 
 #include "clusterized_model_debugger.hpp"
 
-vren_demo::app::app(GLFWwindow* window) :
+vren_demo::app::app(GLFWwindow* window, bool shader_hot_reload) :
 	m_window(window),
 
-	m_context([]() {
+	m_context([shader_hot_reload]() {
 		vren::context_info context_info{
 			.m_app_name = "vren_demo",
 			.m_app_version = VK_MAKE_VERSION(1, 0, 0),
@@ -25,6 +27,7 @@ vren_demo::app::app(GLFWwindow* window) :
 			.m_extensions = {},
 			.m_device_extensions = {}
 		};
+		context_info.m_shader_hot_reload = shader_hot_reload;
 
 		// Add GLFW extensions
 		uint32_t glfw_extension_count = 0;
@@ -78,36 +81,14 @@ vren_demo::app::app(GLFWwindow* window) :
 	),
 
 	// Lighting
-	m_light_arrays(
-		vren::create_array<vren::light_array, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index) {
-			return vren::light_array(m_context);
-		})
-	),
+	m_light_store(m_context),
 
-	m_point_light_bouncer(m_context),
+	m_point_light_simulation(m_context, VREN_MAX_POINT_LIGHT_COUNT),
 	m_fill_point_light_debug_draw_buffer(m_context),
 
 	m_visualize_bvh(m_context),
 
 	// Point lights
-	m_point_light_direction_buffers([&]()
-	{
-		std::vector<glm::vec4> point_light_directions(VREN_MAX_POINT_LIGHT_COUNT);
-		for (glm::vec4& direction : point_light_directions)
-		{
-			direction = glm::vec4(glm::ballRand(1.0f), 0.0f);
-		}
-
-		return vren::create_array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t idx)
-		{
-			return vren::vk_utils::create_device_only_buffer(
-				m_context,
-				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-				point_light_directions.data(),
-				point_light_directions.size() * sizeof(glm::vec4)
-			);
-		});
-	}()),
 	m_point_light_debug_draw_buffers(vren::create_array<vren::debug_renderer_draw_buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT>([&](uint32_t index)
 	{
 		vren::debug_renderer_draw_buffer draw_buffer(m_context);
@@ -122,8 +103,12 @@ vren_demo::app::app(GLFWwindow* window) :
 	// Clustered shading
 	m_cluster_and_shade(m_context),
 
-	m_show_clusters(m_context),
-	m_show_clusters_geometry(m_context),
+	m_show_clusters(m_context, m_cluster_and_shade.get_cluster_key_layout()),
+	m_show_clusters_geometry(m_context, m_cluster_and_shade.get_cluster_key_layout()),
+
+	// Cascaded shadow map
+	m_cascaded_shadow_map(m_context),
+	m_cascaded_shadow_map_renderer(m_context),
 
 	// Output
 	m_color_buffer{},
@@ -162,15 +147,11 @@ void vren_demo::app::late_initialize()
 	});
 
 	// Init directional light
-	m_light_array_fork.enqueue([](uint32_t idx, vren::light_array& light_array)
-	{
-		vren::directional_light* directional_lights = light_array.m_directional_light_buffer.get_mapped_pointer<vren::directional_light>();
-
-		directional_lights[0].m_direction = glm::vec3(1.0f, 1.0f, 0.0f);
-		directional_lights[0].m_color = glm::vec3(1.0f, 1.0f, 1.0f);
-
-		light_array.m_directional_light_count = 1;
-	});
+	m_light_store.m_directional_lights.resize(1);
+	m_light_store.m_directional_lights.edit(0, 1)[0] = {
+		.m_direction = glm::vec3(1.0f, 1.0f, 0.0f),
+		.m_color = glm::vec3(1.0f, 1.0f, 1.0f),
+	};
 }
 
 void vren_demo::app::on_swapchain_change(vren::swapchain const& swapchain)
@@ -242,6 +223,12 @@ void vren_demo::app::on_key_press(int key, int scancode, int action, int mods)
 		m_take_next_render_graph_dump = true;
 	}
 
+	if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+	{
+		m_profiler.start_trace_capture(vren_demo::k_trace_capture_frame_count);
+		m_trace_capture_pending = true;
+	}
+
 	if (action == GLFW_PRESS)
 	{
 		switch (key)
@@ -321,6 +308,11 @@ void vren_demo::app::load_scene(char const* gltf_model_filename)
 		material_buffer.m_material_count += materials.size();
 	});
 
+	VREN_INFO("[vren_demo] Optimizing model\n");
+
+	vren::model_optimizer model_optimizer{};
+	model_optimizer.optimize(parsed_model);
+
 	VREN_INFO("[vren_demo] Computing AABB\n");
 
 	parsed_model.compute_aabb();
@@ -366,43 +358,19 @@ void vren_demo::app::on_update(float dt)
 	m_camera.m_aspect_ratio = framebuffer_width / (float) framebuffer_height;
 
 	m_freecam_controller.update(m_camera, dt, m_camera_speed, glm::radians(45.0f));
-
-	if (m_point_light_speed > std::numeric_limits<float>::epsilon())
-	{
-		m_light_array_fork.enqueue([
-			this,
-			speed = m_point_light_speed,
-			dt
-		](uint32_t idx, vren::light_array& light_array)
-		{
-			vren::vk_utils::immediate_graphics_queue_submit(m_context, [&](VkCommandBuffer command_buffer, vren::resource_container& resource_container)
-			{
-				m_point_light_bouncer.bounce(
-					0,
-					command_buffer,
-					resource_container,
-					light_array.m_point_light_position_buffer,
-					m_point_light_direction_buffers.at(idx),
-					VREN_MAX_POINT_LIGHT_COUNT,
-					m_model_min,
-					m_model_max,
-					speed,
-					dt
-				);
-			});
-		});
-	}
 }
 
 void vren_demo::app::record_commands(
 	uint32_t frame_idx,
-	uint32_t swapchain_image_idx,
-	vren::swapchain const& swapchain,
 	VkCommandBuffer command_buffer,
 	vren::resource_container& resource_container,
 	float dt
 )
 {
+	vren::profiler_cpu_zone record_commands_zone(m_profiler, "record_commands");
+
+	vren::swapchain const& swapchain = *m_presenter.get_swapchain(); // The image isn't acquired yet with late acquire
+
 	// We make sure that every frame is processed sequentially GPU-side
 	VkMemoryBarrier memory_barrier{
 		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
@@ -419,7 +387,7 @@ void vren_demo::app::record_commands(
 		m_gbuffer
 	);
 
-	vren::light_array& light_array = m_light_arrays.at(frame_idx);
+	vren::light_array& light_array = m_light_store.get_light_array();
 	vren::material_buffer& material_buffer = m_material_buffers.at(frame_idx);
 
 	m_debug_draw_buffer.clear();
@@ -434,13 +402,15 @@ void vren_demo::app::record_commands(
 	// Model AABB
 	//m_debug_draw_buffer.add_cube({ .m_min = m_model_min, .m_max = m_model_max, .m_color = 0xffffff });
 
-	// Dump profiling data
-	for (uint32_t slot_idx = 0; slot_idx < ProfileSlot_Count; slot_idx++)
+	// Read the profiling scopes of the last time this frame was recorded
+	m_profiler.read_scopes(frame_idx);
+
+	if (m_trace_capture_pending && !m_profiler.is_capturing_trace())
 	{
-		uint64_t time_elapsed = m_profiler.read_elapsed_time(slot_idx, frame_idx);
-		if (time_elapsed != UINT64_MAX) {
-			m_delta_time_by_profile_slot[slot_idx].push_value(time_elapsed);
-		}
+		std::ofstream output(m_trace_file);
+		m_profiler.write_chrome_trace(output);
+
+		m_trace_capture_pending = false;
 	}
 
 	vkCmdSetCheckpointNV(command_buffer, "Frame start");
@@ -453,7 +423,6 @@ void vren_demo::app::record_commands(
 		.m_z_near = m_camera.m_near_plane,
 	};
 
-	m_light_array_fork.apply(frame_idx, light_array);
 	m_material_buffer_fork.apply(frame_idx, material_buffer);
 
 	auto render_target = vren::render_target::cover(swapchain.m_image_width, swapchain.m_image_height, *m_color_buffer, *m_depth_buffer);
@@ -461,13 +430,48 @@ void vren_demo::app::record_commands(
 	// Render-graph begin
 	vren::render_graph_builder render_graph(m_render_graph_allocator);
 
+	// Upload the edited lights (also updates the light counts)
+	if (m_light_store.is_dirty())
+	{
+		m_cluster_and_shade.invalidate_light_assignments(); // The light lists reused across frames are stale
+	}
+	render_graph.concat(m_light_store.upload(m_render_graph_allocator, frame_idx));
+
+	// Simulate the point lights: they're spawned, moved and killed on the device, and written to the light array
+	m_point_light_simulation.m_bounds_mode = vren::LightSimulationBoundsModeBounce;
+	m_point_light_simulation.m_bounds_min = m_model_min;
+	m_point_light_simulation.m_bounds_max = m_model_max;
+	m_point_light_simulation.m_fade_out_time = 1.0f;
+
+	m_point_light_emission_remainder += m_point_light_emission_rate * dt;
+	uint32_t emitted_point_light_count = (uint32_t) m_point_light_emission_remainder;
+	m_point_light_emission_remainder -= emitted_point_light_count;
+
+	m_point_light_simulation.emit({
+		.m_position = (m_model_min + m_model_max) / 2.0f,
+		.m_direction = glm::vec3(0, 1, 0),
+		.m_spread = glm::radians(30.0f),
+		.m_min_speed = m_point_light_speed * 0.5f,
+		.m_max_speed = m_point_light_speed,
+		.m_color_variation = 1.0f,
+		.m_lifetime = m_point_light_lifetime,
+		.m_lifetime_variation = 0.5f,
+	}, emitted_point_light_count);
+
+	render_graph.concat(m_point_light_simulation(m_render_graph_allocator, frame_idx, light_array, dt));
+
+	if (m_point_light_simulation.get_point_light_bound() > 0)
+	{
+		m_cluster_and_shade.invalidate_light_assignments(); // The lights moved
+	}
+
 	// Clear color buffer
 	auto clear_color_buffer = vren::clear_color_buffer(m_render_graph_allocator, m_color_buffer->get_image(), { m_background_color.x, m_background_color.y, m_background_color.z, 0.0f });
-	render_graph.concat(m_profiler.profile(m_render_graph_allocator, clear_color_buffer, vren_demo::ProfileSlot_CLEAR_COLOR_BUFFER, frame_idx));
+	render_graph.concat(m_profiler.profile_scope(m_render_graph_allocator, clear_color_buffer, "clear_color_buffer"));
 
 	// Clear depth buffer
 	auto clear_depth_buffer = vren::clear_depth_stencil_buffer(m_render_graph_allocator, m_depth_buffer->get_image(), { .depth = 1.0f });
-	render_graph.concat(m_profiler.profile(m_render_graph_allocator, clear_depth_buffer, vren_demo::ProfileSlot_CLEAR_DEPTH_BUFFER, frame_idx));
+	render_graph.concat(m_profiler.profile_scope(m_render_graph_allocator, clear_depth_buffer, "clear_depth_buffer"));
 
 	// Clear gbuffer
 	auto clear_gbuffer = vren::clear_gbuffer(m_render_graph_allocator, *m_gbuffer);
@@ -482,7 +486,7 @@ void vren_demo::app::record_commands(
 		if (m_basic_model_draw_buffer)
 		{
 			auto basic_render = m_basic_renderer.render(m_render_graph_allocator, screen, m_camera, *m_basic_model_draw_buffer, *m_gbuffer, *m_depth_buffer);
-			render_graph.concat(m_profiler.profile(m_render_graph_allocator, basic_render, vren_demo::ProfileSlot_BASIC_RENDERER, frame_idx));
+			render_graph.concat(m_profiler.profile_scope(m_render_graph_allocator, basic_render, "basic_renderer"));
 		}
 		break;
 	case vren_demo::RendererType_MESH_SHADER_RENDERER:
@@ -498,7 +502,7 @@ void vren_demo::app::record_commands(
 				*m_gbuffer,
 				*m_depth_buffer
 			);
-			render_graph.concat(m_profiler.profile(m_render_graph_allocator, mesh_shader_render, vren_demo::ProfileSlot_MESH_SHADER_RENDERER, frame_idx));
+			render_graph.concat(m_profiler.profile_scope(m_render_graph_allocator, mesh_shader_render, "mesh_shader_renderer"));
 
 			resource_container.add_resource(m_mesh_shader_renderer);
 		}
@@ -507,18 +511,58 @@ void vren_demo::app::record_commands(
 		break;
 	}
 
-	// Cluster and shade
+	// Render the cascaded shadow map of the first directional light (every cascade is profiled in its own scope, nested in the shadow map's)
+	bool directional_light_shadows = m_directional_light_shadows && light_array.m_directional_light_count > 0 && m_clusterized_model_draw_buffer;
+	if (directional_light_shadows)
+	{
+		vren::directional_light const* directional_lights = m_light_store.m_directional_lights.data();
+		m_cascaded_shadow_map.update_cascades(frame_idx, m_camera, directional_lights[0].m_direction);
+
+		vren::render_graph_builder shadow_map_render_graph(m_render_graph_allocator);
+		for (uint32_t cascade_idx = 0; cascade_idx < vren::cascaded_shadow_map::k_cascade_count; cascade_idx++)
+		{
+			auto render_cascade = m_cascaded_shadow_map_renderer.render_cascade(m_render_graph_allocator, m_cascaded_shadow_map, cascade_idx, *m_clusterized_model_draw_buffer);
+			shadow_map_render_graph.concat(
+				m_profiler.profile_scope(m_render_graph_allocator, render_cascade, "cascade_" + std::to_string(cascade_idx))
+			);
+		}
+
+		render_graph.concat(
+			m_profiler.profile_scope(m_render_graph_allocator, shadow_map_render_graph.get_head(), "shadow_map")
+		);
+	}
+	m_cluster_and_shade.m_directional_light_shadows = directional_light_shadows; // The cascades are only sampled if rendered this frame
+
+	// Cluster and shade (profiled in a different scope for every light binning mode and shading variant, to compare them as the light
+	// count changes: the variants only differ by the shading dispatch)
+	vren::light_binning_mode light_binning_mode = m_cluster_and_shade.select_light_binning_mode(light_array.m_point_light_count);
+
+	std::string cluster_and_shade_scope_name = light_binning_mode == vren::LightBinningModeFroxels ? "froxel_shading" : "clustered_shading";
+	if (light_binning_mode == vren::LightBinningModeClusters)
+	{
+		if (m_cluster_and_shade.m_material_sorted_shading)
+		{
+			cluster_and_shade_scope_name += "_material_sorted";
+		}
+		else if (m_cluster_and_shade.m_shared_light_prefetch)
+		{
+			cluster_and_shade_scope_name += "_shared_lights";
+		}
+	}
+
+	auto cluster_and_shade = m_cluster_and_shade(
+		m_render_graph_allocator,
+		screen,
+		m_camera,
+		*m_gbuffer,
+		*m_depth_buffer,
+		light_array,
+		material_buffer,
+		m_cascaded_shadow_map,
+		*m_color_buffer
+	);
 	render_graph.concat(
-		m_cluster_and_shade(
-			m_render_graph_allocator,
-			screen,
-			m_camera,
-			*m_gbuffer,
-			*m_depth_buffer,
-			light_array,
-			material_buffer,
-			*m_color_buffer
-		)
+		m_profiler.profile_scope(m_render_graph_allocator, cluster_and_shade, cluster_and_shade_scope_name)
 	);
 
 	// Build depth buffer pyramid
@@ -538,7 +582,7 @@ void vren_demo::app::record_commands(
 	}
 
 	// Visualize light BVH
-	if (light_array.m_point_light_count > 0 && m_show_light_bvh)
+	if (light_array.m_point_light_count > 0 && m_show_light_bvh && light_binning_mode == vren::LightBinningModeClusters) // The light BVH is only built for clusters
 	{
 		render_graph.concat(
 			m_visualize_bvh.write(
@@ -671,7 +715,7 @@ void vren_demo::app::record_commands(
 	}
 
 	render_graph.concat(
-		m_profiler.profile(m_render_graph_allocator, debug_render_graph.get_head(), vren_demo::ProfileSlot_DEBUG_RENDERER, frame_idx)
+		m_profiler.profile_scope(m_render_graph_allocator, debug_render_graph.get_head(), "debug_renderer")
 	);
 
 	// Show clusters
@@ -693,37 +737,37 @@ void vren_demo::app::record_commands(
 	{
 		auto show_ui = [&]()
 		{
+			vren::profiler_cpu_zone show_ui_zone(m_profiler, "show_ui");
+
 			m_ui.show(frame_idx, resource_container);
 		};
 
 		auto imgui_render_node = m_imgui_renderer.render(m_render_graph_allocator, render_target, show_ui);
 		render_graph.concat(
-			m_profiler.profile(m_render_graph_allocator, imgui_render_node, vren_demo::ProfileSlot_IMGUI_RENDERER, frame_idx)
+			m_profiler.profile_scope(m_render_graph_allocator, imgui_render_node, "imgui_renderer")
 		);
 	}
 
-	// Blit to swapchain image
-	auto blit_to_swapchain_node = vren::blit_color_buffer_to_swapchain_image(
-		m_render_graph_allocator,
-		*m_color_buffer,
-		swapchain.m_image_width,
-		swapchain.m_image_height,
-		swapchain.m_images.at(swapchain_image_idx),
-		swapchain.m_image_width,
-		swapchain.m_image_height
-	);
+	// Leave the color buffer ready to be blit to the swapchain image (see record_present_commands)
 	render_graph.concat(
-		m_profiler.profile(m_render_graph_allocator, blit_to_swapchain_node, vren_demo::ProfileSlot_BLIT_COLOR_BUFFER_TO_SWAPCHAIN_IMAGE, frame_idx)
+		vren::transit_color_buffer_to_blit_layout(m_render_graph_allocator, *m_color_buffer)
 	);
 
-	// Ensure swapchain image is in "present" layout
-	render_graph.concat(
-		vren::transit_swapchain_image_to_present_layout(m_render_graph_allocator, swapchain.m_images.at(swapchain_image_idx))
-	);
+	// Execute render-graph (every node is timestamped while profiling the nodes or capturing a trace)
+	{
+		vren::profiler_cpu_zone execute_render_graph_zone(m_profiler, "execute_render_graph");
 
-	// Execute render-graph
-	vren::render_graph_executor executor(frame_idx, command_buffer, resource_container);
-	executor.execute(m_render_graph_allocator, render_graph.get_head());
+		bool profile_nodes = m_profile_render_graph_nodes || m_profiler.is_capturing_trace();
+
+		vren::render_graph_executor executor(
+			frame_idx,
+			command_buffer,
+			resource_container,
+			profile_nodes ? &m_profiler : nullptr,
+			m_parallel_recording ? m_context.m_command_recorder.get() : nullptr
+		);
+		executor.execute(m_render_graph_allocator, render_graph.get_head());
+	}
 
 	// Take a render-graph dump if requested
 	if (m_take_next_render_graph_dump)
@@ -740,6 +784,28 @@ void vren_demo::app::record_commands(
 	m_render_graph_allocator.clear();
 }
 
+void vren_demo::app::record_present_commands(
+	uint32_t frame_idx,
+	uint32_t swapchain_image_idx,
+	vren::swapchain const& swapchain,
+	VkCommandBuffer command_buffer,
+	vren::resource_container& resource_container
+)
+{
+	m_profiler.profile_scope(command_buffer, resource_container, frame_idx, "blit_to_swapchain", [&](VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		vren::record_blit_color_buffer_to_swapchain_image(
+			command_buffer,
+			*m_color_buffer,
+			swapchain.m_image_width,
+			swapchain.m_image_height,
+			swapchain.m_images.at(swapchain_image_idx),
+			swapchain.m_image_width,
+			swapchain.m_image_height
+		);
+	});
+}
+
 float vren_demo::app::calc_frame_parallelism_percentage(uint32_t frame_idx)
 {
 	// The following algorithm is used to take the temporal interval while one frame was working in parallel
@@ -791,7 +857,7 @@ float vren_demo::app::calc_frame_parallelism_percentage(uint32_t frame_idx)
 
 void vren_demo::app::on_frame(float dt)
 {
-	m_presenter.present([&](uint32_t frame_idx, uint32_t swapchain_image_idx, vren::swapchain const& swapchain, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	auto record_func = [&](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
 	{
 		m_frame_ended_at[frame_idx] =
 			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
@@ -818,6 +884,19 @@ void vren_demo::app::on_frame(float dt)
 			m_last_fps_time = now;
 		}
 
-		record_commands(frame_idx, swapchain_image_idx, swapchain, command_buffer, resource_container, dt);
-	});
+		// Between frames: the pipelines replaced are kept alive by the resource container of this frame
+		if (m_context.m_shader_registry)
+		{
+			m_context.m_shader_registry->swap_reloaded_pipelines(resource_container);
+		}
+
+		record_commands(frame_idx, command_buffer, resource_container, dt);
+	};
+
+	auto render_func = [&](uint32_t frame_idx, uint32_t swapchain_image_idx, vren::swapchain const& swapchain, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		record_present_commands(frame_idx, swapchain_image_idx, swapchain, command_buffer, resource_container);
+	};
+
+	m_presenter.present(record_func, render_func);
 }
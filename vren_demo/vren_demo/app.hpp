@@ -9,6 +9,7 @@
 #include "vren/pipeline/debug_renderer.hpp"
 #include "vren/pipeline/imgui_renderer.hpp"
 #include "vren/pipeline/depth_buffer_pyramid.hpp"
+#include "vren/pipeline/cascaded_shadow_map.hpp"
 #include <vren/presenter.hpp>
 #include "vren/pipeline/profiler.hpp"
 #include <vren/model/basic_model_draw_buffer.hpp>
@@ -16,10 +17,11 @@
 #include <vren/model/clusterized_model_draw_buffer.hpp>
 #include <vren/base/operation_fork.hpp>
 #include <vren/pipeline/clustered_shading.hpp>
+#include <vren/pipeline/light_simulation.hpp>
 #include <vren/camera.hpp>
 
 #include "camera_controller.hpp"
-#include "point_light_bouncer.hpp"
+#include "fill_point_light_debug_draw_buffer.hpp"
 #include "ui.hpp"
 #include "visualize_bvh.hpp"
 #include "clustered_shading_debug.hpp"
@@ -59,40 +61,7 @@ namespace vren_demo
 	// Profiling
 	// ------------------------------------------------------------------------------------------------
 
-	enum profile_slot_enum_t
-	{
-		ProfileSlot_NONE = 0,
-		ProfileSlot_CLEAR_COLOR_BUFFER,
-		ProfileSlot_CLEAR_DEPTH_BUFFER,
-		ProfileSlot_BASIC_RENDERER,
-		ProfileSlot_MESH_SHADER_RENDERER,
-		ProfileSlot_DEBUG_RENDERER,
-		ProfileSlot_IMGUI_RENDERER,
-		ProfileSlot_BUILD_DEPTH_BUFFER_PYRAMID,
-		ProfileSlot_BLIT_COLOR_BUFFER_TO_SWAPCHAIN_IMAGE,
-		ProfileSlot_CONSTRUCT_LIGHT_ARRAY_BVH,
-
-		ProfileSlot_Count
-	};
-
-	inline char const* profile_slot_nmae(profile_slot_enum_t profile_slot)
-	{
-		switch (profile_slot)
-		{
-		case ProfileSlot_NONE: return "NONE";
-		case ProfileSlot_CLEAR_COLOR_BUFFER: return "CLEAR_COLOR_BUFFER";
-		case ProfileSlot_CLEAR_DEPTH_BUFFER: return "CLEAR_DEPTH_BUFFER";
-		case ProfileSlot_BASIC_RENDERER: return "BASIC_RENDERER";
-		case ProfileSlot_MESH_SHADER_RENDERER: return "MESH_SHADER_RENDERER";
-		case ProfileSlot_DEBUG_RENDERER: return "DEBUG_RENDERER";
-		case ProfileSlot_IMGUI_RENDERER: return "IMGUI_RENDERER";
-		case ProfileSlot_BUILD_DEPTH_BUFFER_PYRAMID: return "BUILD_DEPTH_BUFFER_PYRAMID";
-		case ProfileSlot_BLIT_COLOR_BUFFER_TO_SWAPCHAIN_IMAGE: return "BLIT_TO_SWAPCHAIN";
-		case ProfileSlot_CONSTRUCT_LIGHT_ARRAY_BVH: return "CONSTRUCT_LIGHT_ARRAY_BVH";
-		default:
-			return "?";
-		}
-	}
+	inline constexpr uint32_t k_trace_capture_frame_count = 60;
 
 	template<size_t _sample_count>
 	struct profiled_data
@@ -180,19 +149,21 @@ namespace vren_demo
 		std::array<vren::material_buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_material_buffers;
 		vren::operation_fork<vren::material_buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_material_buffer_fork;
 
-		// Lighting
-		std::array<vren::light_array, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_light_arrays;
-		vren::operation_fork<vren::light_array, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_light_array_fork;
+		// Lighting (a single device-local light array, only the edited lights are uploaded)
+		vren::light_store m_light_store;
 
-		vren_demo::point_light_bouncer m_point_light_bouncer;
+		// Point lights (simulated on the device, they bounce within the model)
+		vren::light_simulation m_point_light_simulation;
 		vren_demo::fill_point_light_debug_draw_buffer m_fill_point_light_debug_draw_buffer;
 
-		// Point light
-		std::array<vren::vk_utils::buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_point_light_direction_buffers;
 		std::array<vren::debug_renderer_draw_buffer, VREN_MAX_FRAME_IN_FLIGHT_COUNT> m_point_light_debug_draw_buffers;
 
 		float m_point_light_speed = 0.1f;
 
+		float m_point_light_emission_rate = 0.0f; // The lights per second shot upward from the model center
+		float m_point_light_emission_remainder = 0.0f;
+		float m_point_light_lifetime = 5.0f; // The lifetime of the emitted lights
+
 		// Clustered shading
 		vren::cluster_and_shade m_cluster_and_shade;
 
@@ -201,6 +172,12 @@ namespace vren_demo
 
 		std::unique_ptr<vren::debug_renderer_draw_buffer> m_camera_clusters_draw_buffer;
 
+		// Cascaded shadow map (of the first directional light)
+		vren::cascaded_shadow_map m_cascaded_shadow_map;
+		vren::cascaded_shadow_map_renderer m_cascaded_shadow_map_renderer;
+
+		bool m_directional_light_shadows = true;
+
 		// Color buffer
 		std::shared_ptr<vren::vk_utils::color_buffer_t> m_color_buffer;
 
@@ -216,9 +193,13 @@ namespace vren_demo
 		vren::render_graph_allocator m_render_graph_allocator;
 		char m_render_graph_dump_file[256] = "render_graph.dot";
 		bool m_take_next_render_graph_dump = false;
+		bool m_parallel_recording = true; // The nodes marked for parallel recording are recorded on the command recorder's workers
 
 		// Profiling
 		vren::profiler m_profiler;
+		bool m_profile_render_graph_nodes = false;
+		char m_trace_file[256] = "vren_trace.json";
+		bool m_trace_capture_pending = false; // Written once the profiler has captured the frames
 
 		double m_last_fps_time = -1.0;
 		uint32_t m_fps_counter = 0;
@@ -229,8 +210,6 @@ namespace vren_demo
 		vren_demo::profiled_data<720> m_frame_dt{};
 		vren_demo::profiled_data<32> m_frame_parallelism_pct{};
 
-		std::array<vren_demo::profiled_data<32>, ProfileSlot_Count> m_delta_time_by_profile_slot{};
-
 		// Camera
 		vren::camera m_camera;
 		float m_camera_speed = 0.1f;
@@ -260,7 +239,8 @@ namespace vren_demo
 		int32_t m_show_clusters_mode = -1;
 
 	public:
-		app(GLFWwindow* window);
+		/// The shader hot reload recompiles the shaders edited while running, it's only meant for development.
+		app(GLFWwindow* window, bool shader_hot_reload = false);
 		~app();
 
 	private:
@@ -287,15 +267,23 @@ namespace vren_demo
 		float calc_frame_parallelism_percentage(uint32_t frame_idx);
 
 	private:
+		/// Records the frame up to the color buffer, before the swapchain image is acquired when late acquire is enabled.
 		void record_commands(
 			uint32_t frame_idx,
-			uint32_t swapchain_image_idx,
-			vren::swapchain const& swapchain,
 			VkCommandBuffer command_buffer,
 			vren::resource_container& resource_container,
 			float dt
 		);
 
+		/// Blits the color buffer to the acquired swapchain image.
+		void record_present_commands(
+			uint32_t frame_idx,
+			uint32_t swapchain_image_idx,
+			vren::swapchain const& swapchain,
+			VkCommandBuffer command_buffer,
+			vren::resource_container& resource_container
+		);
+
 	public:
 		void on_frame(
 			float dt
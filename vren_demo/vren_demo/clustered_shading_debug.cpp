@@ -4,13 +4,15 @@
 #include <vren/vk_helpers/misc.hpp>
 
 vren_demo::show_clusters::show_clusters(
-    vren::context const& context
+    vren::context const& context,
+	vren::clustered_shading::cluster_key_layout const& cluster_key_layout
 ) :
     m_context(&context),
 	m_pipeline([&]()
 	{
-		vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, "resources/shaders/show_clusters.comp.spv");
+		vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, cluster_key_layout.is_64_bit() ? "resources/shaders/show_clusters_64_bit_keys.comp.spv" : "resources/shaders/show_clusters.comp.spv");
 		vren::specialized_shader shader = vren::specialized_shader(shader_module, "main");
+		vren::clustered_shading::specialize_cluster_key_layout(shader, cluster_key_layout);
 		return vren::create_compute_pipeline(*m_context, shader);
 	}())
 {
@@ -67,10 +69,7 @@ vren::render_graph_t vren_demo::show_clusters::operator()(
 
 		push_constants = {
 			.m_mode = mode,
-			.m_num_tiles = glm::uvec2(
-				vren::divide_and_ceil(screen.x, 32u),
-				vren::divide_and_ceil(screen.y, 32u)
-			),
+			.m_num_tiles = cluster_and_shade.get_cluster_key_layout().get_tile_count(screen),
 		};
 
 		m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &push_constants, sizeof(push_constants));
@@ -100,15 +99,18 @@ vren::render_graph_t vren_demo::show_clusters::operator()(
 }
 
 vren_demo::show_clusters_geometry::show_clusters_geometry(
-	vren::context const& context
+	vren::context const& context,
+	vren::clustered_shading::cluster_key_layout const& cluster_key_layout
 ) :
 	m_context(&context),
 	m_pipeline([&]()
 	{
-		vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, "resources/shaders/show_clusters_geometry.comp.spv");
+		vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, cluster_key_layout.is_64_bit() ? "resources/shaders/show_clusters_geometry_64_bit_keys.comp.spv" : "resources/shaders/show_clusters_geometry.comp.spv");
 		vren::specialized_shader shader = vren::specialized_shader(shader_module, "main");
+		vren::clustered_shading::specialize_cluster_key_layout(shader, cluster_key_layout);
 		return vren::create_compute_pipeline(*m_context, shader);
-	}())
+	}()),
+	m_cluster_key_layout(cluster_key_layout)
 {
 }
 
@@ -160,18 +162,15 @@ vren::debug_renderer_draw_buffer vren_demo::show_clusters_geometry::operator()(
 		struct {
 			glm::uvec2 m_num_tiles;
 			float m_camera_near;
-			float m_camera_half_fov;
+			float m_camera_far;
 			glm::mat4 m_camera_proj;
 			glm::mat4 m_camera_view;
 		} push_constants;
 
 		push_constants = {
-			.m_num_tiles = glm::uvec2(
-				vren::divide_and_ceil(screen.x, 32u),
-				vren::divide_and_ceil(screen.y, 32u)
-			),
+			.m_num_tiles = m_cluster_key_layout.get_tile_count(glm::uvec2(screen)),
 			.m_camera_near = camera.m_near_plane,
-			.m_camera_half_fov = camera.m_fov_y / 2.0f,
+			.m_camera_far = camera.m_far_plane,
 			.m_camera_proj = camera.get_projection(),
 			.m_camera_view = camera.get_view(),
 		};
@@ -212,7 +211,8 @@ vren::debug_renderer_draw_buffer vren_demo::debug_camera_clusters_geometry(
 	const uint32_t k_camera_frustum_color = 0xffffff;
 	const uint32_t k_camera_plane_color = 0xffffff;
 
-	glm::uvec2 num_tiles = glm::uvec2(glm::ceil(screen / glm::vec2(32)));
+	vren::clustered_shading::cluster_key_layout const& cluster_key_layout = cluster_and_shade.get_cluster_key_layout();
+	glm::uvec2 num_tiles = cluster_key_layout.get_tile_count(glm::uvec2(screen));
 
 	glm::mat4 inv_view = glm::inverse(camera.get_view());
 	glm::mat4 inv_proj = glm::inverse(camera.get_projection());
@@ -262,7 +262,7 @@ vren::debug_renderer_draw_buffer vren_demo::debug_camera_clusters_geometry(
 		tile_min = glm::min(tile_min, tile_max);
 		tile_max = glm::max(tile_max, tmp);
 
-		float near_k = camera.m_near_plane * glm::pow(1.0f + ((2.0f * tan_half_fov) / float(num_tiles.y)), float(cluster_ijk.z));
+		float near_k = camera.m_near_plane * glm::pow(camera.m_far_plane / camera.m_near_plane, cluster_ijk.z / float(cluster_key_layout.m_depth_slice_count));
 		float h_k = (tile_max.y * tan_half_fov * near_k) - (tile_min.y * tan_half_fov * near_k);
 		float far_k = near_k + h_k;
 
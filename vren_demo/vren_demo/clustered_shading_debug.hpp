@@ -22,7 +22,7 @@ namespace vren_demo
 		vren::pipeline m_pipeline;
 
 	public:
-		show_clusters(vren::context const& context);
+		show_clusters(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
 
 		vren::render_graph_t operator()(
 			vren::render_graph_allocator& render_graph_allocator,
@@ -44,8 +44,10 @@ namespace vren_demo
 
 		vren::pipeline m_pipeline;
 
+		vren::clustered_shading::cluster_key_layout m_cluster_key_layout;
+
 	public:
-		show_clusters_geometry(vren::context const& context);
+		show_clusters_geometry(vren::context const& context, vren::clustered_shading::cluster_key_layout const& cluster_key_layout);
 
 		vren::debug_renderer_draw_buffer operator()(
 			vren::context const& context,
@@ -1,61 +1,9 @@
-#include "point_light_bouncer.hpp"
+#include "fill_point_light_debug_draw_buffer.hpp"
 
 #include <vren/base/base.hpp>
 #include <vren/toolbox.hpp>
 #include <vren/vk_helpers/misc.hpp>
 
-vren_demo::point_light_bouncer::point_light_bouncer(vren::context const& context) :
-    m_context(&context),
-    m_pipeline([&]()
-    {
-        vren::shader_module shader_module = vren::load_shader_module_from_file(*m_context, "resources/shaders/bounce_point_lights.comp.spv");
-        vren::specialized_shader shader = vren::specialized_shader(shader_module, "main");
-        return vren::create_compute_pipeline(*m_context, shader);
-    }())
-{}
-
-void vren_demo::point_light_bouncer::bounce(
-    uint32_t frame_idx,
-    VkCommandBuffer command_buffer,
-    vren::resource_container& resource_container,
-    vren::vk_utils::buffer const& point_light_position_buffer,
-    vren::vk_utils::buffer const& point_light_direction_buffer,
-    uint32_t point_light_count,
-    glm::vec3 const& aabb_min,
-    glm::vec3 const& aabb_max,
-    float speed,
-    float dt
-)
-{
-    m_pipeline.bind(command_buffer);
-
-    struct push_constants
-    {
-        glm::vec3 m_aabb_min; float _pad;
-        glm::vec3 m_aabb_max; float _pad1;
-        float m_speed;
-        float m_dt;
-        float _pad2[2];
-    };
-
-    push_constants my_push_constants{
-        .m_aabb_min = aabb_min,
-        .m_aabb_max = aabb_max,
-        .m_speed = speed,
-        .m_dt = dt,
-    };
-    m_pipeline.push_constants(command_buffer, VK_SHADER_STAGE_COMPUTE_BIT, &my_push_constants, sizeof(push_constants), 0);
-
-    m_pipeline.acquire_and_bind_descriptor_set(*m_context, command_buffer, resource_container, 0, [&](VkDescriptorSet descriptor_set)
-    {
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 0, point_light_position_buffer.m_buffer.m_handle, point_light_count * sizeof(glm::vec4), 0);
-        vren::vk_utils::write_buffer_descriptor(*m_context, descriptor_set, 1, point_light_direction_buffer.m_buffer.m_handle, point_light_count * sizeof(vren::point_light), 0);
-    });
-
-    uint32_t k_num_workgroups_x = vren::divide_and_ceil(point_light_count, k_workgroup_size);
-    m_pipeline.dispatch(command_buffer, k_num_workgroups_x, 1, 1);
-}
-
 vren_demo::fill_point_light_debug_draw_buffer::fill_point_light_debug_draw_buffer(vren::context const& context) :
     m_context(&context),
     m_pipeline([&]()
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <memory>
 #include <numeric>
 
@@ -24,9 +25,10 @@ int main(int argc, char* argv[])
 	std::srand(std::time(nullptr));
 
 	// Command-line arguments processing
-	if (argc != (1 + 1))
+	bool shader_hot_reload = argc == (1 + 2) && std::strcmp(argv[2], "--shader-hot-reload") == 0;
+	if (argc != (1 + 1) && !shader_hot_reload)
 	{
-		VREN_ERROR("Invalid usage: <scene_filepath>\n");
+		VREN_ERROR("Invalid usage: <scene_filepath> [--shader-hot-reload]\n");
 		exit(1);
 	}
 	argv++;
@@ -55,7 +57,7 @@ int main(int argc, char* argv[])
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	// App creation
-	auto app = std::make_unique<vren_demo::app>(window); // Dynamically allocated not to exceed stack allocation limits
+	auto app = std::make_unique<vren_demo::app>(window, shader_hot_reload); // Dynamically allocated not to exceed stack allocation limits
 
 	// Scene loading
 	app->load_scene(argv[0]);
@@ -157,65 +157,51 @@ void vren_demo::ui::show_scene_window()
 
 		ImGui::Spacing();
 
-		int point_light_count = m_point_light_count;
-		
-		// Count
-		if (ImGui::SliderInt("Count##point_lights-scene_ui", &point_light_count, 0, VREN_MAX_POINT_LIGHT_COUNT, "%d", ImGuiSliderFlags_Logarithmic))
+		// The lights are spawned over the model and then only live on the device, they're respawned when edited
+		auto spawn_point_lights = [&]()
 		{
-			m_app->m_light_array_fork.enqueue([
-				from_count = m_point_light_count,
-				to_count = point_light_count,
-				color = m_point_light_color,
-				intensity = m_point_light_intensity
-			](uint32_t idx, vren::light_array& light_array)
-			{
-				vren::point_light* point_lights = light_array.m_point_light_buffer.get_mapped_pointer<vren::point_light>();
-				glm::vec4* point_light_positions = light_array.m_point_light_position_buffer.get_mapped_pointer<glm::vec4>();
+			vren::light_simulation& light_simulation = m_app->m_point_light_simulation;
 
-				for (uint32_t i = from_count; i < to_count; i++)
-				{
-					point_lights[i] = {
-						.m_color = color,
-						.m_intensity = intensity,
-					};
-					point_light_positions[i] = glm::vec4{ 0, 0, 0, 1 };
-				}
+			light_simulation.clear();
+			light_simulation.emit({
+				.m_position = (m_app->m_model_min + m_app->m_model_max) / 2.0f,
+				.m_extent = (m_app->m_model_max - m_app->m_model_min) / 2.0f,
+				.m_min_speed = m_app->m_point_light_speed,
+				.m_max_speed = m_app->m_point_light_speed,
+				.m_color = m_point_light_color,
+				.m_intensity = m_point_light_intensity,
+			}, m_point_light_count);
+		};
 
-				light_array.m_point_light_count = to_count;
-			});
+		bool respawn = false;
 
-			m_point_light_count = point_light_count;
-		}
+		// Count
+		respawn |= ImGui::SliderInt("Count##point_lights-scene_ui", &m_point_light_count, 0, m_app->m_point_light_simulation.get_capacity(), "%d", ImGuiSliderFlags_Logarithmic);
 
 		// Color
-		if (ImGui::ColorEdit3("Color##point_lights-scene_ui", reinterpret_cast<float*>(&m_point_light_color), ImGuiColorEditFlags_Float))
-		{
-			m_app->m_light_array_fork.enqueue([color = m_point_light_color](uint32_t idx, vren::light_array& light_array)
-			{
-				vren::point_light* point_lights = light_array.m_point_light_buffer.get_mapped_pointer<vren::point_light>();
-				std::for_each(std::execution::par, point_lights, point_lights + light_array.m_point_light_count, [&](vren::point_light& point_light)
-				{
-					point_light.m_color = color;
-				});
-			});
-		}
+		respawn |= ImGui::ColorEdit3("Color##point_lights-scene_ui", reinterpret_cast<float*>(&m_point_light_color), ImGuiColorEditFlags_Float);
 
 		// Speed
-		ImGui::SliderFloat("Speed##point_lights-scene_ui", &m_app->m_point_light_speed, 0.0f, 0.5f, "%.3f"); // Proportional to model size
+		respawn |= ImGui::SliderFloat("Speed##point_lights-scene_ui", &m_app->m_point_light_speed, 0.0f, 0.5f, "%.3f"); // Proportional to model size
 
 		// Intensity
-		if (ImGui::SliderFloat("Intensity##point_lights-scene_ui", &m_point_light_intensity, 0.001f, 100.0f, "%.3f", ImGuiSliderFlags_Logarithmic))
+		respawn |= ImGui::SliderFloat("Intensity##point_lights-scene_ui", &m_point_light_intensity, 0.001f, 100.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+
+		if (respawn)
 		{
-			m_app->m_light_array_fork.enqueue([intensity = m_point_light_intensity](uint32_t idx, vren::light_array& light_array)
-			{
-				vren::point_light* point_lights = light_array.m_point_light_buffer.get_mapped_pointer<vren::point_light>();
-				std::for_each(std::execution::par, point_lights, point_lights + light_array.m_point_light_count, [&](vren::point_light& point_light)
-				{
-					point_light.m_intensity = intensity;
-				});
-			});
+			spawn_point_lights();
 		}
 
+		// Emission (the emitted lights die, they aren't respawned)
+		ImGui::SliderFloat("Emission rate##point_lights-scene_ui", &m_app->m_point_light_emission_rate, 0.0f, 100000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Lifetime##point_lights-scene_ui", &m_app->m_point_light_lifetime, 0.1f, 30.0f, "%.1f");
+
+		// Attenuation threshold (determines the point light radius)
+		ImGui::SliderFloat("Attenuation threshold##point_lights-scene_ui", &m_app->m_cluster_and_shade.m_light_attenuation_threshold, 0.0001f, 1.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+
+		ImGui::Text("Simulated point light bound: %d", m_app->m_point_light_simulation.get_point_light_bound());
+		ImGui::Text("Last light upload: %.1f KB", m_app->m_light_store.get_last_upload_size() / 1024.0f);
+
 		ImGui::Spacing();
 
 		// Directional light
@@ -231,15 +217,11 @@ void vren_demo::ui::show_scene_window()
 
 		if (changed)
 		{
-			m_app->m_light_array_fork.enqueue([](uint32_t idx, vren::light_array& light_array)
-			{
-				vren::directional_light* directional_lights = light_array.m_directional_light_buffer.get_mapped_pointer<vren::directional_light>();
-
-				directional_lights[0].m_direction = glm::vec3(1.0f, 1.0f, 0.0f);
-				directional_lights[0].m_color = glm::vec3(1.0f, 1.0f, 1.0f);
-
-				light_array.m_directional_light_count = 1;
-			});
+			m_app->m_light_store.m_directional_lights.resize(1);
+			m_app->m_light_store.m_directional_lights.edit(0, 1)[0] = {
+				.m_direction = glm::vec3(1.0f, 1.0f, 0.0f),
+				.m_color = glm::vec3(1.0f, 1.0f, 1.0f),
+			};
 		}
 
 		ImGui::Spacing();
@@ -271,39 +253,153 @@ void vren_demo::ui::show_profiling_window()
 		plot_ui("Frame dt##profiling-general-frame_dt", m_app->m_frame_dt, "ms");
 		ImGui::Text("Frame parallelism: %.1f%% %.1f%%", m_app->m_frame_parallelism_pct.get_last_value() * 100, m_app->m_frame_parallelism_pct.get_last_avg() * 100);
 
-		// Profiling slots
+		// Frame pacing
 		ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing();
 
-		ImGui::Text("Profiling slots");
+		vren::presenter& presenter = m_app->m_presenter;
 
-		ImGui::Spacing();
+		int max_frame_latency = (int) presenter.get_max_frame_latency();
+		if (ImGui::SliderInt("Max frame latency##profiling", &max_frame_latency, 1, VREN_MAX_FRAME_IN_FLIGHT_COUNT))
+		{
+			presenter.set_max_frame_latency((uint32_t) max_frame_latency);
+		}
 
-		if (ImGui::BeginTable("##profiling-slots", 3))
+		bool late_acquire = presenter.get_late_acquire();
+		if (ImGui::Checkbox("Late acquire##profiling", &late_acquire))
 		{
-			ImGui::TableSetupColumn("##profiling-slots-name", ImGuiTableColumnFlags_WidthFixed);
-			ImGui::TableSetupColumn("##profiling-slots-last_val", ImGuiTableColumnFlags_WidthFixed);
-			ImGui::TableSetupColumn("##profiling-slots-last_avg", ImGuiTableColumnFlags_WidthFixed);
+			presenter.set_late_acquire(late_acquire);
+		}
 
-			for (uint32_t slot = 1; slot < ProfileSlot_Count; slot++)
+		vren::presenter_timings const& timings = presenter.get_timings();
+		ImGui::Text("CPU wait: %.3f ms %.3f ms (acquire: %.3f ms)", timings.m_cpu_wait_time.get_last() / (1000 * 1000), timings.m_cpu_wait_time.get_avg() / (1000 * 1000), timings.m_acquire_time.get_avg() / (1000 * 1000));
+		ImGui::Text("GPU wait: %.3f ms %.3f ms", timings.m_gpu_wait_time.get_last() / (1000 * 1000), timings.m_gpu_wait_time.get_avg() / (1000 * 1000));
+		ImGui::Text("GPU frame: %.3f ms %.3f ms", timings.m_gpu_time.get_last() / (1000 * 1000), timings.m_gpu_time.get_avg() / (1000 * 1000));
+
+		// Profiling scopes
+		ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing();
+
+		ImGui::Text("Profiling scopes");
+
+		ImGui::Spacing();
+
+		if (ImGui::BeginTable("##profiling-scopes", 7, ImGuiTableFlags_SizingFixedFit))
+		{
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("Last");
+			ImGui::TableSetupColumn("Min");
+			ImGui::TableSetupColumn("Avg");
+			ImGui::TableSetupColumn("P99");
+			ImGui::TableSetupColumn("Primitives");
+			ImGui::TableSetupColumn("FS/CS invocations");
+			ImGui::TableHeadersRow();
+
+			for (vren::profiler_scope const& scope : m_app->m_profiler.get_scopes())
 			{
-				auto const& profiled_data = m_app->m_delta_time_by_profile_slot.at(slot);
+				vren::rolling_statistics const& elapsed_time = scope.m_elapsed_time;
 
 				ImGui::TableNextRow();
 
 				ImGui::TableNextColumn();
+				ImGui::Text("%*s%s", (int) scope.m_depth * 2, "", scope.m_name.substr(scope.m_name.find_last_of('/') + 1).c_str());
 
-				char const* slot_name = vren_demo::profile_slot_nmae(static_cast<vren_demo::profile_slot_enum_t>(slot));
-				ImGui::Text("%s", slot_name);
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f ms", elapsed_time.get_last() / (1000 * 1000));
+
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f ms", elapsed_time.get_min() / (1000 * 1000));
 
 				ImGui::TableNextColumn();
-				ImGui::Text("%.3f ms", profiled_data.get_last_value() / (1000 * 1000));
+				ImGui::Text("%.3f ms", elapsed_time.get_avg() / (1000 * 1000));
 
 				ImGui::TableNextColumn();
-				ImGui::Text("%.3f ms", profiled_data.get_last_avg() / (1000 * 1000));
+				ImGui::Text("%.3f ms", elapsed_time.get_p99() / (1000 * 1000));
+
+				ImGui::TableNextColumn();
+				if (scope.m_has_pipeline_statistics)
+				{
+					ImGui::Text("%llu", (unsigned long long) scope.m_pipeline_statistics[vren::PipelineStatisticInputAssemblyPrimitives]);
+				}
+
+				ImGui::TableNextColumn();
+				if (scope.m_has_pipeline_statistics)
+				{
+					ImGui::Text(
+						"%llu / %llu",
+						(unsigned long long) scope.m_pipeline_statistics[vren::PipelineStatisticFragmentShaderInvocations],
+						(unsigned long long) scope.m_pipeline_statistics[vren::PipelineStatisticComputeShaderInvocations]
+					);
+				}
 			}
 
 			ImGui::EndTable();
 		}
+
+		ImGui::Checkbox("Time render-graph nodes", &m_app->m_profile_render_graph_nodes);
+		ImGui::Checkbox("Record render-graph nodes in parallel", &m_app->m_parallel_recording);
+
+		if (m_app->m_profile_render_graph_nodes && ImGui::TreeNode("Render-graph nodes##profiling"))
+		{
+			for (vren::profiler_node_timing const& node_timing : m_app->m_profiler.get_node_timings())
+			{
+				ImGui::Text("%s: %.3f ms", node_timing.m_name, node_timing.m_elapsed_time / (1000.0 * 1000.0));
+			}
+
+			ImGui::TreePop();
+		}
+
+		ImGui::InputText("Trace file##profiling", m_app->m_trace_file, std::size(m_app->m_trace_file));
+
+		if (m_app->m_trace_capture_pending)
+		{
+			ImGui::Text("Capturing trace...");
+		}
+		else if (ImGui::Button("Capture trace (F6)##profiling"))
+		{
+			m_app->m_profiler.start_trace_capture(vren_demo::k_trace_capture_frame_count);
+			m_app->m_trace_capture_pending = true;
+		}
+
+		// Clusters
+		if (m_app->m_cluster_and_shade.m_light_binning_mode != vren::LightBinningModeFroxels)
+		{
+			vren::clustered_shading::cluster_key_layout const& cluster_key_layout = m_app->m_cluster_and_shade.get_cluster_key_layout();
+			vren::clustered_shading::cluster_statistics const& statistics = m_app->m_cluster_and_shade.m_cluster_statistics;
+
+			ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing();
+
+			ImGui::Text("Clusters");
+
+			ImGui::Spacing();
+
+			ImGui::Text("Tile: %upx, depth slices: %u, normal cones: %u", cluster_key_layout.m_tile_size, cluster_key_layout.m_depth_slice_count, cluster_key_layout.get_normal_cone_count());
+			ImGui::Text("Key: %u bits (x: %u, y: %u, z: %u, normal: %u)", cluster_key_layout.is_64_bit() ? 64 : 32, cluster_key_layout.m_x_bits, cluster_key_layout.m_y_bits, cluster_key_layout.m_z_bits, cluster_key_layout.m_normal_bits);
+			ImGui::Text("Clusters: %u (occupancy: %.4f%%)", statistics.m_cluster_count, m_app->m_cluster_and_shade.get_cluster_occupancy() * 100);
+			ImGui::Text("Lights per cluster: %.2f avg, %u max", m_app->m_cluster_and_shade.get_average_cluster_light_count(), statistics.m_max_cluster_light_count);
+
+			// Bucket 0 has no light, bucket i has [2^(i-1), 2^i) lights
+			if (ImPlot::BeginPlot("Lights per cluster (log2)##plot", ImVec2(-1, 128), ImPlotFlags_CanvasOnly))
+			{
+				ImPlot::SetupAxes("", "", ImPlotAxisFlags_AutoFit, ImPlotAxisFlags_AutoFit);
+				ImPlot::PlotBars("##light_count_histogram", statistics.m_light_count_histogram, VREN_CLUSTER_LIGHT_COUNT_HISTOGRAM_SIZE);
+				ImPlot::EndPlot();
+			}
+		}
+
+		// Temporal cluster reuse
+		if (m_app->m_cluster_and_shade.m_temporal_cluster_reuse)
+		{
+			vren::clustered_shading::temporal_cluster_statistics const& statistics = m_app->m_cluster_and_shade.m_temporal_cluster_statistics;
+
+			ImGui::Spacing(); ImGui::Separator(); ImGui::Spacing();
+
+			ImGui::Text("Temporal cluster reuse");
+
+			ImGui::Spacing();
+
+			ImGui::Text("Light list hit rate: %.1f%%", m_app->m_cluster_and_shade.get_temporal_cluster_reuse_hit_rate() * 100);
+			ImGui::Text("Reused clusters: %u, assigned clusters: %u", statistics.m_reused_cluster_count, statistics.m_assigned_cluster_count);
+			ImGui::Text("Changed tiles: %u / %u", statistics.m_changed_tile_count, m_app->m_cluster_and_shade.m_temporal_cluster_tile_count);
+		}
 	}
 
 	ImGui::End();
@@ -404,6 +500,25 @@ void vren_demo::ui::show_controls_window()
 		toggled |= ImGui::RadioButton("Show assigned light indices", &value, 5) && show_clusters_mode == 5;
 
 		show_clusters_mode = toggled ? -1 : value;
+
+		ImGui::Spacing();
+
+		// Light binning mode (the clusters visualization is only valid when clusters are used)
+		int32_t light_binning_mode = m_app->m_cluster_and_shade.m_light_binning_mode;
+		ImGui::RadioButton("Auto light binning", &light_binning_mode, vren::LightBinningModeAuto);
+		ImGui::RadioButton("Clusters light binning", &light_binning_mode, vren::LightBinningModeClusters);
+		ImGui::RadioButton("Froxels light binning", &light_binning_mode, vren::LightBinningModeFroxels);
+		m_app->m_cluster_and_shade.m_light_binning_mode = static_cast<vren::light_binning_mode>(light_binning_mode);
+
+		// The clusters visualization decodes the cluster keys, with temporal cluster reuse they are replaced by hash table slots
+		ImGui::Checkbox("Temporal cluster reuse", &m_app->m_cluster_and_shade.m_temporal_cluster_reuse);
+		ImGui::Checkbox("Material sorted shading", &m_app->m_cluster_and_shade.m_material_sorted_shading);
+		ImGui::Checkbox("Shared light prefetch", &m_app->m_cluster_and_shade.m_shared_light_prefetch); // Profiled in the clustered_shading_shared_lights scope
+
+		// Cascaded shadow map (rendered through the mesh shader path, thus needs the clusterized model)
+		ImGui::Checkbox("Directional light shadows", &m_app->m_directional_light_shadows);
+		ImGui::SliderFloat("Shadow split lambda", &m_app->m_cascaded_shadow_map.m_split_lambda, 0.0f, 1.0f);
+		ImGui::SliderFloat("Shadow max distance", &m_app->m_cascaded_shadow_map.m_max_distance, 1.0f, 1000.0f, "%.1f", ImGuiSliderFlags_Logarithmic);
 	}
 
 	ImGui::End();
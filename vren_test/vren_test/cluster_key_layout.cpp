@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <vren/pipeline/clustered_shading.hpp>
+
+TEST(cluster_key_layout, default_grid)
+{
+	vren::clustered_shading::cluster_key_layout layout = vren::clustered_shading::make_cluster_key_layout({}, glm::uvec2(1920, 1080));
+
+	// 60x34 tiles of 32 pixels, 1024 depth slices, 54 normal cones (3x3 per cube face)
+	ASSERT_EQ(layout.m_x_bits, 6);
+	ASSERT_EQ(layout.m_y_bits, 6);
+	ASSERT_EQ(layout.m_z_bits, 10);
+	ASSERT_EQ(layout.m_normal_bits, 6);
+	ASSERT_EQ(layout.m_normal_grid_size, 3);
+	ASSERT_EQ(layout.get_normal_cone_count(), 54);
+	ASSERT_FALSE(layout.is_64_bit());
+	ASSERT_EQ(layout.get_key_size(), sizeof(uint32_t));
+}
+
+TEST(cluster_key_layout, 64_bit_keys)
+{
+	vren::clustered_shading::cluster_grid grid{
+		.m_tile_size = 8,
+		.m_depth_slice_count = 1024,
+		.m_normal_bits = 12,
+	};
+	vren::clustered_shading::cluster_key_layout layout = vren::clustered_shading::make_cluster_key_layout(grid, glm::uvec2(1920, 1080));
+
+	// 240x135 tiles of 8 pixels
+	ASSERT_EQ(layout.m_x_bits, 8);
+	ASSERT_EQ(layout.m_y_bits, 8);
+	ASSERT_TRUE(layout.is_64_bit());
+	ASSERT_EQ(layout.get_key_size(), sizeof(uint64_t));
+
+	// The null normal index (all the normal bits set) is never a normal cone
+	ASSERT_LT(layout.get_normal_cone_count(), (1u << layout.m_normal_bits) - 1);
+	ASSERT_EQ(layout.get_tile_count(glm::uvec2(1920, 1080)), glm::uvec2(240, 135));
+}
+
+TEST(cluster_key_layout, ignored_normals)
+{
+	vren::clustered_shading::cluster_grid grid{
+		.m_normal_bits = 0,
+	};
+	vren::clustered_shading::cluster_key_layout layout = vren::clustered_shading::make_cluster_key_layout(grid, glm::uvec2(1920, 1080));
+
+	ASSERT_EQ(layout.m_normal_bits, 0);
+	ASSERT_EQ(layout.get_normal_cone_count(), 1);
+	ASSERT_EQ(layout.get_bit_count(), 22);
+}
+
+TEST(cluster_key_layout, invalid_grid)
+{
+	ASSERT_THROW(vren::clustered_shading::make_cluster_key_layout({ .m_tile_size = 64 }), std::runtime_error);
+	ASSERT_THROW(vren::clustered_shading::make_cluster_key_layout({ .m_tile_size = 12 }), std::runtime_error);
+	ASSERT_THROW(vren::clustered_shading::make_cluster_key_layout({ .m_depth_slice_count = 0 }), std::runtime_error);
+	ASSERT_THROW(vren::clustered_shading::make_cluster_key_layout({ .m_normal_bits = 2 }), std::runtime_error);
+	ASSERT_THROW(vren::clustered_shading::make_cluster_key_layout({}, glm::uvec2(0, 1080)), std::runtime_error);
+}
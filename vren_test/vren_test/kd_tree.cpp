@@ -2,6 +2,7 @@
 
 #include <random>
 #include <chrono>
+#include <numeric>
 
 #include <vren/base/base.hpp>
 #include <vren/base/kd_tree.hpp>
@@ -26,47 +27,86 @@ void linear_nearest_neighbour_search(float const* points, size_t point_stride, u
 	}
 }
 
-TEST(KDTree, NearestNeigborSearch)
+std::vector<vren::kd_tree_neighbour> linear_radius_search(float const* points, size_t point_stride, size_t count, float const* sample, float radius)
 {
-	std::random_device random_dev;
-	std::mt19937 rng(random_dev());
+	std::vector<vren::kd_tree_neighbour> neighbours;
 
-	const float k_aabb_min = 0.0f;
-	const float k_aabb_max = 100.0f;
-	const size_t k_max_point_count = 1'000'000;
-	const size_t k_sample_count = 100;
-	const size_t k_point_stride = 3;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		float const* point = &points[i * point_stride];
+		float distance_squared =
+			(sample[0] - point[0]) * (sample[0] - point[0]) +
+			(sample[1] - point[1]) * (sample[1] - point[1]) +
+			(sample[2] - point[2]) * (sample[2] - point[2]);
+		if (distance_squared < radius * radius)
+		{
+			neighbours.push_back({ .m_point = i, .m_distance_squared = distance_squared });
+		}
+	}
+	return neighbours;
+}
+
+struct kd_tree_test_data
+{
+	static constexpr float k_aabb_min = 0.0f;
+	static constexpr float k_aabb_max = 100.0f;
+	static constexpr size_t k_point_stride = 3;
 
-	std::uniform_real_distribution<> random_distribution(k_aabb_min, k_aabb_max);
+	std::vector<float> m_points;
+	std::vector<uint32_t> m_indices;
+	std::vector<vren::kd_tree_node> m_kd_tree;
+	size_t m_node_count;
+	vren::kd_tree_packed_points m_packed_points;
 
-	// Points
-	std::vector<float> points(k_max_point_count * k_point_stride);
-	for (uint32_t i = 0; i < k_max_point_count; i++)
+	kd_tree_test_data(std::mt19937& rng, size_t point_count)
 	{
-		points[i * k_point_stride + 0] = random_distribution(rng);
-		points[i * k_point_stride + 1] = random_distribution(rng);
-		points[i * k_point_stride + 2] = random_distribution(rng);
+		std::uniform_real_distribution<> random_distribution(k_aabb_min, k_aabb_max);
+
+		// Points
+		m_points.resize(point_count * k_point_stride);
+		for (float& coordinate : m_points)
+		{
+			coordinate = random_distribution(rng);
+		}
+
+		// Indices
+		m_indices.resize(point_count);
+		for (uint32_t i = 0; i < point_count; i++)
+		{
+			m_indices[i] = i;
+		}
+
+		// Build KD-tree
+		m_kd_tree.resize(vren::kd_tree_calc_median_node_count(point_count, 8));
+		m_node_count = vren::kd_tree_build_median(m_points.data(), k_point_stride, m_indices.data(), m_indices.size(), m_kd_tree.data(), 0, 8);
+
+		vren::kd_tree_pack_points(m_points.data(), k_point_stride, m_kd_tree.data(), m_node_count, m_packed_points);
 	}
 
-	// Indices
-	std::vector<uint32_t> indices(k_max_point_count);
-	for (uint32_t i = 0; i < k_max_point_count; i++)
+	std::vector<float> create_samples(std::mt19937& rng, size_t sample_count) const
 	{
-		indices[i] = i;
+		std::uniform_real_distribution<> random_distribution(k_aabb_min, k_aabb_max);
+
+		std::vector<float> samples(sample_count * k_point_stride);
+		for (float& coordinate : samples)
+		{
+			coordinate = random_distribution(rng);
+		}
+		return samples;
 	}
+};
 
-	// Build KD-tree
-	std::vector<vren::kd_tree_node> kd_tree(k_max_point_count * 2);
-	vren::kd_tree_build(points.data(), k_point_stride, indices.data(), indices.size(), kd_tree.data(), 0, 8);
+TEST(KDTree, NearestNeigborSearch)
+{
+	std::random_device random_dev;
+	std::mt19937 rng(random_dev());
 
-	// Samples
-	std::vector<float> samples(k_sample_count * k_point_stride);
-	for (uint32_t i = 0; i < k_sample_count; i++)
-	{
-		samples[i * k_point_stride + 0] = random_distribution(rng);
-		samples[i * k_point_stride + 1] = random_distribution(rng);
-		samples[i * k_point_stride + 2] = random_distribution(rng);
-	}
+	const size_t k_max_point_count = 1'000'000;
+	const size_t k_sample_count = 100;
+	const size_t k_point_stride = kd_tree_test_data::k_point_stride;
+
+	kd_tree_test_data data(rng, k_max_point_count);
+	std::vector<float> samples = data.create_samples(rng, k_sample_count);
 
 	// Searching
 	uint64_t elapsed_time_1 = 0, elapsed_time_2 = 0;
@@ -74,39 +114,377 @@ TEST(KDTree, NearestNeigborSearch)
 
 	for (uint32_t i = 0; i < k_sample_count; i++)
 	{
-		float best_distance_1, best_distance_2;
-		uint32_t best_point_1, best_point_2;
+		float best_distance_1;
+		uint32_t best_point_1;
 
 		// Linear search
 		start_at = std::chrono::steady_clock::now();
 
-		linear_nearest_neighbour_search(points.data(), k_point_stride, indices.data(), k_max_point_count, &samples[i * k_point_stride], best_point_1, best_distance_1);
+		linear_nearest_neighbour_search(data.m_points.data(), k_point_stride, data.m_indices.data(), k_max_point_count, &samples[i * k_point_stride], best_point_1, best_distance_1);
 
 		elapsed_time_1 += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_at).count();
 
 		// KD-tree search
 		start_at = std::chrono::steady_clock::now();
 
-		best_distance_2 = std::numeric_limits<float>::infinity();
-		best_point_2 = UINT32_MAX;
-		vren::kd_tree_search(points.data(), k_point_stride, indices.data(), k_max_point_count, kd_tree.data(), 0, &samples[i * k_point_stride], vren::k_kd_tree_default_search_filter, best_point_2, best_distance_2);
+		vren::kd_tree_neighbour neighbour{};
+		size_t neighbour_count = vren::kd_tree_knn_search(data.m_kd_tree.data(), data.m_packed_points, &samples[i * k_point_stride], 1, &neighbour);
 
 		elapsed_time_2 += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_at).count();
 
-		// ads asdd s
-		EXPECT_EQ(best_distance_1, best_distance_2);
-		EXPECT_EQ(best_point_1, best_point_2);
+		ASSERT_EQ(neighbour_count, 1);
+		EXPECT_FLOAT_EQ(best_distance_1, neighbour.m_distance_squared);
+		EXPECT_EQ(best_point_1, neighbour.m_point);
 	}
 
-	printf("Linear search - Point count: %lld, Searches: %lld, Elapsed time: %lld ns\n",
+	printf("Linear search - Point count: %zu, Searches: %zu, Elapsed time: %llu ns\n",
 		   k_max_point_count,
 		   k_sample_count,
-		   elapsed_time_1
+		   (unsigned long long) elapsed_time_1
 	);
 
-	printf("KD-tree search - Point count: %lld, Searches: %lld, Elapsed time: %lld ns\n",
+	printf("KD-tree search - Point count: %zu, Searches: %zu, Elapsed time: %llu ns\n",
 		   k_max_point_count,
 		   k_sample_count,
-		   elapsed_time_2
+		   (unsigned long long) elapsed_time_2
 	);
 }
+
+TEST(KDTree, KNearestNeighbourSearch)
+{
+	std::mt19937 rng(0);
+
+	const size_t k_point_count = 100'000;
+	const size_t k_sample_count = 100;
+	const size_t k_neighbour_count = 16;
+	const size_t k_point_stride = kd_tree_test_data::k_point_stride;
+
+	kd_tree_test_data data(rng, k_point_count);
+	std::vector<float> samples = data.create_samples(rng, k_sample_count);
+
+	// Only the points with an even index are searched
+	auto filter = [](uint32_t point) -> bool { return point % 2 == 0; };
+
+	for (uint32_t i = 0; i < k_sample_count; i++)
+	{
+		float const* sample = &samples[i * k_point_stride];
+
+		std::vector<vren::kd_tree_neighbour> expected = linear_radius_search(data.m_points.data(), k_point_stride, k_point_count, sample, std::numeric_limits<float>::infinity());
+		std::erase_if(expected, [&](vren::kd_tree_neighbour const& neighbour) { return !filter(neighbour.m_point); });
+		std::partial_sort(expected.begin(), expected.begin() + k_neighbour_count, expected.end(), [](auto const& a, auto const& b) { return a.m_distance_squared < b.m_distance_squared; });
+
+		vren::kd_tree_neighbour neighbours[k_neighbour_count];
+		size_t neighbour_count = vren::kd_tree_knn_search(data.m_kd_tree.data(), data.m_packed_points, sample, k_neighbour_count, neighbours, filter);
+
+		ASSERT_EQ(neighbour_count, k_neighbour_count);
+		for (uint32_t j = 0; j < k_neighbour_count; j++)
+		{
+			EXPECT_EQ(neighbours[j].m_point, expected[j].m_point);
+			EXPECT_FLOAT_EQ(neighbours[j].m_distance_squared, expected[j].m_distance_squared);
+		}
+	}
+}
+
+TEST(KDTree, RadiusSearch)
+{
+	std::mt19937 rng(0);
+
+	const size_t k_point_count = 100'000;
+	const size_t k_sample_count = 100;
+	const float k_radius = 5.0f;
+	const size_t k_point_stride = kd_tree_test_data::k_point_stride;
+
+	kd_tree_test_data data(rng, k_point_count);
+	std::vector<float> samples = data.create_samples(rng, k_sample_count);
+
+	std::vector<std::vector<vren::kd_tree_neighbour>> neighbours(k_sample_count);
+	vren::kd_tree_radius_search_batch(data.m_kd_tree.data(), data.m_packed_points, samples.data(), k_point_stride, k_sample_count, k_radius, neighbours.data());
+
+	auto compare_neighbours = [](vren::kd_tree_neighbour const& a, vren::kd_tree_neighbour const& b) { return a.m_point < b.m_point; };
+
+	for (uint32_t i = 0; i < k_sample_count; i++)
+	{
+		std::vector<vren::kd_tree_neighbour> expected = linear_radius_search(data.m_points.data(), k_point_stride, k_point_count, &samples[i * k_point_stride], k_radius);
+
+		std::sort(neighbours[i].begin(), neighbours[i].end(), compare_neighbours);
+
+		ASSERT_EQ(neighbours[i].size(), expected.size());
+		for (uint32_t j = 0; j < expected.size(); j++)
+		{
+			EXPECT_EQ(neighbours[i][j].m_point, expected[j].m_point);
+		}
+	}
+}
+
+TEST(KDTree, QueryThroughput)
+{
+	std::mt19937 rng(0);
+
+	const size_t k_point_count = 1'000'000;
+	const size_t k_sample_count = 200'000;
+	const size_t k_point_stride = kd_tree_test_data::k_point_stride;
+
+	kd_tree_test_data data(rng, k_point_count);
+	std::vector<float> samples = data.create_samples(rng, k_sample_count);
+
+	for (size_t k : { 1, 8 })
+	{
+		std::vector<vren::kd_tree_neighbour> neighbours(k_sample_count * k);
+		std::vector<uint32_t> neighbour_counts(k_sample_count);
+
+		// Single-threaded
+		auto start_at = std::chrono::steady_clock::now();
+
+		for (uint32_t i = 0; i < k_sample_count; i++)
+		{
+			neighbour_counts[i] = (uint32_t) vren::kd_tree_knn_search(data.m_kd_tree.data(), data.m_packed_points, &samples[i * k_point_stride], k, &neighbours[i * k]);
+		}
+
+		double elapsed_time_1 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_at).count();
+
+		// Batched
+		start_at = std::chrono::steady_clock::now();
+
+		vren::kd_tree_knn_search_batch(data.m_kd_tree.data(), data.m_packed_points, samples.data(), k_point_stride, k_sample_count, k, neighbours.data(), neighbour_counts.data());
+
+		double elapsed_time_2 = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_at).count();
+
+		printf("KD-tree k-NN search - Point count: %zu, k: %zu, Single-threaded: %.0f queries/s, Batched: %.0f queries/s\n",
+			   k_point_count,
+			   k,
+			   k_sample_count / elapsed_time_1,
+			   k_sample_count / elapsed_time_2
+		);
+
+		for (uint32_t i = 0; i < k_sample_count; i++)
+		{
+			ASSERT_EQ(neighbour_counts[i], k);
+		}
+	}
+}
+
+// ------------------------------------------------------------------------------------------------
+// Build
+// ------------------------------------------------------------------------------------------------
+
+struct kd_tree_quality
+{
+	size_t m_node_count = 0;
+	size_t m_leaf_count = 0;
+	size_t m_point_count = 0;
+	uint32_t m_max_depth = 0;
+	double m_avg_leaf_depth = 0.0;
+};
+
+kd_tree_quality calc_kd_tree_quality(vren::kd_tree_node const* kd_tree, size_t node_count)
+{
+	kd_tree_quality quality{};
+	quality.m_node_count = node_count;
+
+	std::vector<std::pair<size_t, uint32_t>> stack{{ 0, 0 }}; // Node offset and depth
+	while (!stack.empty())
+	{
+		auto [node_offset, depth] = stack.back();
+		stack.pop_back();
+
+		vren::kd_tree_node const& node = kd_tree[node_offset];
+		if (node.m_axis == vren::k_kd_tree_leaf_axis)
+		{
+			quality.m_leaf_count++;
+			quality.m_point_count += node.m_leaf_count;
+			quality.m_max_depth = std::max(quality.m_max_depth, depth);
+			quality.m_avg_leaf_depth += depth;
+		}
+		else
+		{
+			stack.push_back({ node_offset + 1, depth + 1 });
+			stack.push_back({ node_offset + node.m_right_child_distance, depth + 1 });
+		}
+	}
+
+	quality.m_avg_leaf_depth /= (double) quality.m_leaf_count;
+	return quality;
+}
+
+std::vector<float> create_clustered_points(std::mt19937& rng, size_t point_count, size_t cluster_count)
+{
+	std::uniform_real_distribution<float> center_distribution(0.0f, 100.0f);
+	std::normal_distribution<float> offset_distribution(0.0f, 0.5f);
+	std::uniform_int_distribution<size_t> cluster_distribution(0, cluster_count - 1);
+
+	std::vector<float> centers(cluster_count * 3);
+	for (float& coordinate : centers)
+	{
+		coordinate = center_distribution(rng);
+	}
+
+	std::vector<float> points(point_count * 3);
+	for (size_t i = 0; i < point_count; i++)
+	{
+		size_t cluster = cluster_distribution(rng);
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			points[i * 3 + j] = centers[cluster * 3 + j] + offset_distribution(rng);
+		}
+	}
+	return points;
+}
+
+TEST(KDTree, BuildQuality)
+{
+	std::mt19937 rng(0);
+
+	const size_t k_point_count = 1'000'000;
+	const size_t k_sample_count = 100'000;
+	const size_t k_max_leaf_point_count = 8;
+
+	std::uniform_real_distribution<float> random_distribution(0.0f, 100.0f);
+
+	std::vector<float> uniform_points(k_point_count * 3);
+	for (float& coordinate : uniform_points)
+	{
+		coordinate = random_distribution(rng);
+	}
+
+	std::vector<float> clustered_points = create_clustered_points(rng, k_point_count, 16);
+
+	for (auto const& [distribution_name, points] : { std::pair{ "uniform", &uniform_points }, std::pair{ "clustered", &clustered_points } })
+	{
+		// Samples are taken among the points, so that they follow the same distribution
+		std::vector<float> samples(k_sample_count * 3);
+		std::uniform_int_distribution<size_t> point_distribution(0, k_point_count - 1);
+		for (size_t i = 0; i < k_sample_count; i++)
+		{
+			size_t point = point_distribution(rng);
+			for (uint32_t j = 0; j < 3; j++)
+			{
+				samples[i * 3 + j] = (*points)[point * 3 + j] + 0.01f;
+			}
+		}
+
+		for (bool median : { false, true })
+		{
+			std::vector<uint32_t> indices(k_point_count);
+			std::iota(indices.begin(), indices.end(), 0);
+
+			size_t max_node_count = median ? vren::kd_tree_calc_median_node_count(k_point_count, k_max_leaf_point_count) : k_point_count * 2;
+			std::vector<vren::kd_tree_node> kd_tree(max_node_count);
+
+			auto start_at = std::chrono::steady_clock::now();
+
+			size_t node_count = median ?
+				vren::kd_tree_build_median(points->data(), 3, indices.data(), k_point_count, kd_tree.data(), 0, k_max_leaf_point_count) :
+				vren::kd_tree_build(points->data(), 3, indices.data(), k_point_count, kd_tree.data(), 0, k_max_leaf_point_count);
+
+			double build_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_at).count();
+
+			if (median)
+			{
+				EXPECT_EQ(node_count, max_node_count);
+			}
+
+			vren::kd_tree_packed_points packed_points;
+			vren::kd_tree_pack_points(points->data(), 3, kd_tree.data(), node_count, packed_points);
+
+			kd_tree_quality quality = calc_kd_tree_quality(kd_tree.data(), node_count);
+
+			// Query
+			std::vector<vren::kd_tree_neighbour> neighbours(k_sample_count);
+
+			start_at = std::chrono::steady_clock::now();
+
+			for (size_t i = 0; i < k_sample_count; i++)
+			{
+				vren::kd_tree_knn_search(kd_tree.data(), packed_points, &samples[i * 3], 1, &neighbours[i]);
+			}
+
+			double query_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_at).count();
+
+			printf("KD-tree %-6s build (%s points) - Build time: %.1f ms, Nodes: %zu, Leaves: %zu, Max depth: %u, Avg leaf depth: %.1f, 1-NN: %.0f queries/s\n",
+				   median ? "median" : "mean",
+				   distribution_name,
+				   build_time,
+				   node_count,
+				   quality.m_leaf_count,
+				   quality.m_max_depth,
+				   quality.m_avg_leaf_depth,
+				   k_sample_count / query_time
+			);
+
+			EXPECT_EQ(quality.m_point_count, k_point_count);
+			EXPECT_LT(quality.m_max_depth, vren::k_kd_tree_max_depth);
+		}
+	}
+}
+
+TEST(KDTree, BuildCoincidentPoints)
+{
+	// All the points are the same, the mean split can't separate them
+	const size_t k_point_count = 1000;
+
+	std::vector<float> points(k_point_count * 3, 1.0f);
+	std::vector<uint32_t> indices(k_point_count);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	std::vector<vren::kd_tree_node> kd_tree(k_point_count * 2);
+	size_t node_count = vren::kd_tree_build(points.data(), 3, indices.data(), k_point_count, kd_tree.data(), 0, 8);
+
+	EXPECT_EQ(calc_kd_tree_quality(kd_tree.data(), node_count).m_point_count, k_point_count);
+}
+
+TEST(KDTree, BuildSplitAxis)
+{
+	// The points are spread along the z axis, the root must split along it
+	std::mt19937 rng(0);
+	std::uniform_real_distribution<float> random_distribution(0.0f, 1.0f);
+
+	const size_t k_point_count = 1000;
+
+	std::vector<float> points(k_point_count * 3);
+	for (size_t i = 0; i < k_point_count; i++)
+	{
+		points[i * 3 + 0] = random_distribution(rng) * 2.0f;
+		points[i * 3 + 1] = random_distribution(rng);
+		points[i * 3 + 2] = random_distribution(rng) * 10.0f;
+	}
+
+	std::vector<uint32_t> indices(k_point_count);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	std::vector<vren::kd_tree_node> kd_tree(k_point_count * 2);
+	vren::kd_tree_build(points.data(), 3, indices.data(), k_point_count, kd_tree.data(), 0, 8);
+
+	EXPECT_EQ(kd_tree[0].m_axis, 2);
+}
+
+TEST(KDTree, BuildSkewedPoints)
+{
+	// Every point lies far out of the previous ones along the axes in turn: the mean split isolates one point per level and would go
+	// deeper than the search stack (74 levels) without the median split fallback
+	const uint32_t k_step_count = 28;
+	const size_t k_point_count = k_step_count * 3 + 1;
+
+	std::vector<float> points(k_point_count * 3, 0.0f);
+
+	float extents[3] = { 1e-38f, 1e-38f, 1e-38f };
+	size_t point_idx = 1;
+	for (uint32_t step = 0; step < k_step_count; step++)
+	{
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			extents[axis] = extents[axis] * (float) k_point_count * 1.1f;
+			points[point_idx * 3 + axis] = step % 2 == 0 ? extents[axis] : -extents[axis];
+			point_idx++;
+		}
+	}
+
+	std::vector<uint32_t> indices(k_point_count);
+	std::iota(indices.begin(), indices.end(), 0);
+
+	std::vector<vren::kd_tree_node> kd_tree(k_point_count * 2);
+	size_t node_count = vren::kd_tree_build(points.data(), 3, indices.data(), k_point_count, kd_tree.data(), 0, 1);
+
+	kd_tree_quality quality = calc_kd_tree_quality(kd_tree.data(), node_count);
+	EXPECT_EQ(quality.m_point_count, k_point_count);
+	EXPECT_LE(quality.m_max_depth, vren::k_kd_tree_max_depth);
+}
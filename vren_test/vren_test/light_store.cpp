@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include <vren/light.hpp>
+#include <vren/pipeline/render_graph.hpp>
+
+#include "app.hpp"
+
+using light_store_stream_t = vren::light_store_stream<glm::vec4>;
+
+namespace
+{
+	// Pops all the dirty ranges, as if they were uploaded
+	template<typename _t>
+	void pop_all_dirty_ranges(vren::light_store_stream<_t>& stream)
+	{
+		stream.pop_dirty_ranges(SIZE_MAX, [](uint32_t offset, uint32_t count) {});
+	}
+}
+
+TEST(light_store_stream, merge_dirty_ranges)
+{
+	light_store_stream_t stream(1024);
+	stream.resize(1024);
+	pop_all_dirty_ranges(stream);
+
+	uint32_t gap = light_store_stream_t::k_merge_gap;
+
+	stream.mark_dirty(0, 10);
+	stream.mark_dirty(500, 510);
+	ASSERT_EQ(stream.get_dirty_ranges().size(), 2);
+
+	// Within the merge gap of the first range
+	stream.mark_dirty(10 + gap, 20 + gap);
+	ASSERT_EQ(stream.get_dirty_ranges().size(), 2);
+	ASSERT_EQ(stream.get_dirty_ranges()[0].m_begin, 0);
+	ASSERT_EQ(stream.get_dirty_ranges()[0].m_end, 20 + gap);
+
+	// Bridges both ranges
+	stream.mark_dirty(100, 450);
+	ASSERT_EQ(stream.get_dirty_ranges().size(), 1);
+	ASSERT_EQ(stream.get_dirty_ranges()[0].m_begin, 0);
+	ASSERT_EQ(stream.get_dirty_ranges()[0].m_end, 510);
+}
+
+TEST(light_store_stream, pop_dirty_ranges)
+{
+	std::default_random_engine random_generator(42);
+
+	light_store_stream_t stream(4096);
+	stream.resize(4096);
+	pop_all_dirty_ranges(stream);
+
+	std::vector<bool> expected(stream.size(), false);
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		uint32_t begin = std::uniform_int_distribution<uint32_t>(0, stream.size() - 1)(random_generator);
+		uint32_t end = std::min<uint32_t>(begin + std::uniform_int_distribution<uint32_t>(1, 16)(random_generator), stream.size());
+
+		stream.mark_dirty(begin, end);
+		std::fill(expected.begin() + begin, expected.begin() + end, true);
+	}
+
+	// Pop with a small capacity, as when the dirty spans don't fit in the upload segment
+	std::vector<bool> popped(stream.size(), false);
+	size_t capacity = 100 * sizeof(glm::vec4) + 8; // Not a multiple of the element size
+
+	while (stream.is_dirty())
+	{
+		size_t popped_size = stream.pop_dirty_ranges(capacity, [&](uint32_t offset, uint32_t count)
+		{
+			std::fill(popped.begin() + offset, popped.begin() + offset + count, true);
+		});
+		ASSERT_LE(popped_size, capacity);
+		ASSERT_GT(popped_size, 0);
+	}
+
+	// Every edited element is popped (the merge gap may add some more)
+	for (uint32_t i = 0; i < stream.size(); i++)
+	{
+		if (expected[i])
+		{
+			ASSERT_TRUE(popped[i]);
+		}
+	}
+}
+
+TEST(light_store_stream, drop_dirty_ranges_past_size)
+{
+	light_store_stream_t stream(1024);
+	stream.resize(1024);
+	pop_all_dirty_ranges(stream);
+
+	stream.mark_dirty(900, 1000);
+	stream.resize(950);
+
+	uint32_t popped_count = 0;
+	stream.pop_dirty_ranges(SIZE_MAX, [&](uint32_t offset, uint32_t count)
+	{
+		ASSERT_LE(offset + count, 950);
+		popped_count += count;
+	});
+	ASSERT_EQ(popped_count, 50);
+	ASSERT_FALSE(stream.is_dirty());
+}
+
+TEST(light_store_stream, uploaded_count)
+{
+	light_store_stream_t stream(1024);
+
+	stream.resize(1000);
+	ASSERT_TRUE(stream.is_dirty()); // The added elements are uploaded even if not edited
+	ASSERT_EQ(stream.get_uploaded_count(), 0);
+
+	stream.pop_dirty_ranges(300 * sizeof(glm::vec4), [](uint32_t offset, uint32_t count) {});
+	ASSERT_EQ(stream.get_uploaded_count(), 300);
+
+	// Editing an uploaded element doesn't shrink the uploaded prefix
+	stream.edit(100, 10);
+	stream.pop_dirty_ranges(5 * sizeof(glm::vec4), [](uint32_t offset, uint32_t count) {});
+	ASSERT_EQ(stream.get_uploaded_count(), 300);
+
+	pop_all_dirty_ranges(stream);
+	ASSERT_EQ(stream.get_uploaded_count(), 1000);
+
+	// Shrinking drops the removed elements, growing back requires them to be uploaded again
+	stream.resize(500);
+	ASSERT_EQ(stream.get_uploaded_count(), 500);
+
+	stream.resize(800);
+	ASSERT_EQ(stream.get_uploaded_count(), 500);
+
+	pop_all_dirty_ranges(stream);
+	ASSERT_EQ(stream.get_uploaded_count(), 800);
+}
+
+TEST(light_store, publish_uploaded_lights)
+{
+	uint32_t point_light_count = 4096;
+
+	// An upload segment fits all the point light positions but only 1024 point lights
+	size_t upload_segment_size = point_light_count * sizeof(glm::vec4) + 1024 * sizeof(vren::point_light);
+
+	vren::render_graph_allocator allocator;
+	vren::light_store light_store(VREN_TEST_APP()->m_context, upload_segment_size * VREN_MAX_FRAME_IN_FLIGHT_COUNT);
+
+	light_store.m_point_light_positions.resize(point_light_count);
+	light_store.m_point_lights.resize(point_light_count);
+
+	light_store.upload(allocator, 0);
+	allocator.clear();
+
+	// The lights left to the next frames aren't published
+	ASSERT_TRUE(light_store.is_dirty());
+	ASSERT_EQ(light_store.get_last_upload_size(), upload_segment_size);
+	ASSERT_EQ(light_store.get_light_array().m_point_light_count, 1024);
+
+	uint32_t frame_idx = 1;
+	while (light_store.is_dirty())
+	{
+		uint32_t last_point_light_count = light_store.get_light_array().m_point_light_count;
+
+		light_store.upload(allocator, frame_idx);
+		allocator.clear();
+
+		ASSERT_GT(light_store.get_light_array().m_point_light_count, last_point_light_count);
+		ASSERT_LE(light_store.get_light_array().m_point_light_count, point_light_count);
+
+		frame_idx = (frame_idx + 1) % VREN_MAX_FRAME_IN_FLIGHT_COUNT;
+	}
+
+	ASSERT_EQ(light_store.get_light_array().m_point_light_count, point_light_count);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
+
+#include <vren/model/model_clusterizer.hpp>
+#include <vren/model/clusterized_model_compressor.hpp>
+
+#include "procedural_model.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Unit tests
+// ------------------------------------------------------------------------------------------------
+
+TEST(ClusterizedModelCompressor, Accuracy)
+{
+    vren::model model = vren_test::create_procedural_model(16, 64, 128);
+
+    vren::model_clusterizer model_clusterizer{};
+    vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+
+    vren::clusterized_model_compressor compressor{};
+    vren::compressed_clusterized_model compressed_model = compressor.compress(clusterized_model);
+
+    ASSERT_EQ(compressed_model.m_meshlets.size(), clusterized_model.m_meshlets.size());
+
+    double max_position_error = 0.0, sum_position_error = 0.0, max_relative_position_error = 0.0;
+    double max_normal_error = 0.0, sum_normal_error = 0.0; // In degrees
+    double max_texcoord_error = 0.0, sum_texcoord_error = 0.0;
+    size_t vertex_count = 0;
+
+    for (uint32_t meshlet_idx = 0; meshlet_idx < clusterized_model.m_meshlets.size(); meshlet_idx++)
+    {
+        vren::meshlet const& meshlet = clusterized_model.m_meshlets.at(meshlet_idx);
+        vren::meshlet const& compressed_meshlet = compressed_model.m_meshlets.at(meshlet_idx);
+
+        ASSERT_EQ(meshlet.m_vertex_count, compressed_meshlet.m_vertex_count);
+        ASSERT_EQ(meshlet.m_triangle_count, compressed_meshlet.m_triangle_count);
+
+        for (uint32_t i = 0; i < meshlet.m_vertex_count; i++)
+        {
+            vren::vertex const& vertex = clusterized_model.m_vertices.at(clusterized_model.m_meshlet_vertices.at(meshlet.m_vertex_offset + i));
+            vren::vertex decompressed_vertex = vren::decompress_vertex(compressed_model.m_vertices.at(compressed_meshlet.m_vertex_offset + i), compressed_meshlet.m_bounding_sphere);
+
+            double position_error = glm::length(vertex.m_position - decompressed_vertex.m_position);
+            double normal_error = glm::degrees(glm::acos(glm::clamp(glm::dot(glm::normalize(vertex.m_normal), decompressed_vertex.m_normal), -1.0f, 1.0f)));
+            double texcoord_error = glm::length(vertex.m_texcoords - decompressed_vertex.m_texcoords);
+
+            max_position_error = glm::max(max_position_error, position_error);
+            max_relative_position_error = glm::max(max_relative_position_error, position_error / meshlet.m_bounding_sphere.m_radius);
+            max_normal_error = glm::max(max_normal_error, normal_error);
+            max_texcoord_error = glm::max(max_texcoord_error, texcoord_error);
+
+            sum_position_error += position_error;
+            sum_normal_error += normal_error;
+            sum_texcoord_error += texcoord_error;
+
+            vertex_count++;
+        }
+    }
+
+    size_t original_size =
+        clusterized_model.m_vertices.size() * sizeof(vren::vertex) +
+        clusterized_model.m_meshlet_vertices.size() * sizeof(uint32_t);
+    size_t compressed_size = compressed_model.m_vertices.size() * sizeof(vren::compressed_vertex);
+
+    printf("Compression - Meshlets: %zu, Meshlet vertices: %zu, Geometry size: %zu -> %zu bytes (%.1f%%)\n",
+           clusterized_model.m_meshlets.size(),
+           vertex_count,
+           original_size,
+           compressed_size,
+           compressed_size * 100.0 / original_size
+    );
+    printf("Position error - Max: %e, Avg: %e, Max relative to meshlet radius: %e\n", max_position_error, sum_position_error / vertex_count, max_relative_position_error);
+    printf("Normal error (degrees) - Max: %f, Avg: %f\n", max_normal_error, sum_normal_error / vertex_count);
+    printf("Texcoord error - Max: %e, Avg: %e\n", max_texcoord_error, sum_texcoord_error / vertex_count);
+
+    EXPECT_LT(compressed_size * 2, original_size);
+    EXPECT_LT(max_relative_position_error, 1e-4);
+    EXPECT_LT(max_normal_error, 0.1);
+    EXPECT_LT(max_texcoord_error, 1e-3);
+}
+
+// ------------------------------------------------------------------------------------------------
+// Benchmark
+// ------------------------------------------------------------------------------------------------
+
+static void BM_clusterized_model_compressor(benchmark::State& state)
+{
+    vren::model model = vren_test::create_procedural_model(state.range(0), 64, 128);
+
+    vren::model_clusterizer model_clusterizer{};
+    vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+
+    vren::clusterized_model_compressor compressor{};
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(compressor.compress(clusterized_model));
+    }
+}
+
+BENCHMARK(BM_clusterized_model_compressor)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <vren/model/model_clusterizer.hpp>
+
+#include "procedural_model.hpp"
+
+// ------------------------------------------------------------------------------------------------
+
+struct clusterization_statistics
+{
+    size_t m_meshlet_count = 0;
+    float m_avg_triangle_count = 0.0f;
+    float m_avg_vertex_count = 0.0f;
+    float m_avg_radius = 0.0f;
+    size_t m_small_meshlet_count = 0; // Meshlets with less than a quarter of the max triangles
+};
+
+static clusterization_statistics calc_clusterization_statistics(vren::clusterized_model const& clusterized_model)
+{
+    clusterization_statistics statistics{};
+    statistics.m_meshlet_count = clusterized_model.m_meshlets.size();
+
+    for (vren::meshlet const& meshlet : clusterized_model.m_meshlets)
+    {
+        statistics.m_avg_triangle_count += meshlet.m_triangle_count;
+        statistics.m_avg_vertex_count += meshlet.m_vertex_count;
+        statistics.m_avg_radius += meshlet.m_bounding_sphere.m_radius;
+        statistics.m_small_meshlet_count += meshlet.m_triangle_count < vren::k_max_meshlet_primitive_count / 4;
+    }
+
+    if (statistics.m_meshlet_count > 0)
+    {
+        statistics.m_avg_triangle_count /= (float) statistics.m_meshlet_count;
+        statistics.m_avg_vertex_count /= (float) statistics.m_meshlet_count;
+        statistics.m_avg_radius /= (float) statistics.m_meshlet_count;
+    }
+
+    return statistics;
+}
+
+static char const* get_clusterizer_backend_name(vren::clusterizer_backend backend)
+{
+    return backend == vren::ClusterizerBackendMeshOptimizer ? "meshoptimizer" : "native";
+}
+
+// ------------------------------------------------------------------------------------------------
+// Benchmark
+// ------------------------------------------------------------------------------------------------
+
+static void BM_model_clusterizer(benchmark::State& state)
+{
+    vren::clusterizer_backend backend = (vren::clusterizer_backend) state.range(0);
+
+    vren::model model = vren_test::create_procedural_model(state.range(1), 128, 256);
+
+    vren::model_clusterizer model_clusterizer(backend);
+
+    clusterization_statistics statistics{};
+    for (auto _ : state)
+    {
+        vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+
+        state.PauseTiming();
+        statistics = calc_clusterization_statistics(clusterized_model);
+        state.ResumeTiming();
+    }
+
+    state.counters["Meshlets"] = (double) statistics.m_meshlet_count;
+    state.counters["Triangles/meshlet"] = statistics.m_avg_triangle_count;
+    state.counters["Vertices/meshlet"] = statistics.m_avg_vertex_count;
+}
+
+BENCHMARK(BM_model_clusterizer)
+    ->ArgNames({"backend", "meshes"})
+    ->Args({vren::ClusterizerBackendMeshOptimizer, 1})
+    ->Args({vren::ClusterizerBackendMeshOptimizer, 16})
+    ->Args({vren::ClusterizerBackendNative, 1})
+    ->Args({vren::ClusterizerBackendNative, 16})
+    ->Unit(benchmark::kMillisecond);
+
+// ------------------------------------------------------------------------------------------------
+// Unit testing
+// ------------------------------------------------------------------------------------------------
+
+TEST(ModelClusterizer, NativeValidity)
+{
+    vren::model model = vren_test::create_procedural_model(4, 64, 128, 1);
+
+    vren::model_clusterizer model_clusterizer(vren::ClusterizerBackendNative);
+    vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+
+    // Every meshlet must respect the limits and its bounding sphere must contain all of its vertices
+    std::vector<std::array<uint32_t, 3>> clusterized_triangles;
+    for (vren::meshlet const& meshlet : clusterized_model.m_meshlets)
+    {
+        ASSERT_GT(meshlet.m_triangle_count, 0);
+        ASSERT_LE(meshlet.m_triangle_count, vren::k_max_meshlet_primitive_count);
+        ASSERT_LE(meshlet.m_vertex_count, vren::k_max_meshlet_vertex_count);
+
+        for (uint32_t i = 0; i < meshlet.m_vertex_count; i++)
+        {
+            glm::vec3 const& position = clusterized_model.m_vertices[clusterized_model.m_meshlet_vertices[meshlet.m_vertex_offset + i]].m_position;
+            float distance = glm::length(position - meshlet.m_bounding_sphere.m_center);
+            EXPECT_LE(distance, meshlet.m_bounding_sphere.m_radius * 1.001f + 1e-5f);
+        }
+
+        for (uint32_t i = 0; i < meshlet.m_triangle_count; i++)
+        {
+            std::array<uint32_t, 3> triangle{};
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                uint8_t local_vertex = clusterized_model.m_meshlet_triangles[meshlet.m_triangle_offset + i * 3 + j];
+                ASSERT_LT(local_vertex, meshlet.m_vertex_count);
+                triangle[j] = clusterized_model.m_meshlet_vertices[meshlet.m_vertex_offset + local_vertex];
+            }
+            clusterized_triangles.push_back(triangle);
+        }
+    }
+
+    // The clusterized triangles must be exactly the triangles of the model (winding order included)
+    std::vector<std::array<uint32_t, 3>> model_triangles;
+    for (vren::model::mesh const& mesh : model.m_meshes)
+    {
+        for (uint32_t i = mesh.m_index_offset; i < mesh.m_index_offset + mesh.m_index_count; i += 3)
+        {
+            model_triangles.push_back({
+                mesh.m_vertex_offset + model.m_indices[i + 0],
+                mesh.m_vertex_offset + model.m_indices[i + 1],
+                mesh.m_vertex_offset + model.m_indices[i + 2]
+            });
+        }
+    }
+
+    std::sort(clusterized_triangles.begin(), clusterized_triangles.end());
+    std::sort(model_triangles.begin(), model_triangles.end());
+
+    EXPECT_EQ(clusterized_triangles, model_triangles);
+}
+
+TEST(ModelClusterizer, Quality)
+{
+    vren::model model = vren_test::create_procedural_model(4, 256, 512, 1);
+
+    for (vren::clusterizer_backend backend : { vren::ClusterizerBackendMeshOptimizer, vren::ClusterizerBackendNative })
+    {
+        vren::model_clusterizer model_clusterizer(backend);
+
+        auto start = std::chrono::steady_clock::now();
+        vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+        auto elapsed_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        clusterization_statistics statistics = calc_clusterization_statistics(clusterized_model);
+
+        printf("%-14s - Meshlets: %zu, Triangles/meshlet: %.1f, Vertices/meshlet: %.1f, Avg radius: %.4f, Small meshlets: %zu, Time: %.1f ms\n",
+               get_clusterizer_backend_name(backend),
+               statistics.m_meshlet_count,
+               statistics.m_avg_triangle_count,
+               statistics.m_avg_vertex_count,
+               statistics.m_avg_radius,
+               statistics.m_small_meshlet_count,
+               elapsed_time
+        );
+
+        EXPECT_GT(statistics.m_meshlet_count, 0);
+    }
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
+
+#include <vren/model/model_optimizer.hpp>
+#include <vren/model/basic_model_uploader.hpp>
+#include <vren/pipeline/basic_renderer.hpp>
+#include <vren/pipeline/gbuffer.hpp>
+#include <vren/pipeline/render_graph.hpp>
+#include <vren/vk_helpers/image.hpp>
+
+#include "app.hpp"
+#include "procedural_model.hpp"
+
+// ------------------------------------------------------------------------------------------------
+// Benchmark
+// ------------------------------------------------------------------------------------------------
+
+static void BM_model_optimizer(benchmark::State& state)
+{
+    vren::model model = vren_test::create_procedural_model(state.range(0), 128, 256);
+
+    vren::model_optimizer model_optimizer{};
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        vren::model optimized_model = model;
+        state.ResumeTiming();
+
+        model_optimizer.optimize(optimized_model);
+    }
+}
+
+BENCHMARK(BM_model_optimizer)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_gpu_basic_renderer_raster(benchmark::State& state)
+{
+    bool optimize = state.range(0) != 0;
+
+    const glm::uvec2 k_screen(1920, 1080);
+
+    vren::context& context = VREN_TEST_APP()->m_context;
+
+    vren::model model = vren_test::create_procedural_model(16, 256, 512);
+    if (optimize)
+    {
+        vren::model_optimizer model_optimizer{};
+        model_optimizer.optimize(model);
+    }
+
+    vren::basic_model_uploader basic_model_uploader{};
+    vren::basic_model_draw_buffer draw_buffer = basic_model_uploader.upload(context, model);
+
+    vren::basic_renderer basic_renderer(context);
+    vren::gbuffer gbuffer(context, k_screen.x, k_screen.y);
+    vren::vk_utils::depth_buffer_t depth_buffer = vren::vk_utils::create_depth_buffer(context, k_screen.x, k_screen.y, NULL);
+
+    // Look at the row of spheres from the side, so that they overlap each other
+    vren::camera camera{
+        .m_position = glm::vec3(-4.0f, 0.0f, 0.0f),
+        .m_yaw = glm::radians(90.0f),
+        .m_aspect_ratio = k_screen.x / (float) k_screen.y
+    };
+
+    vren::render_graph_allocator render_graph_allocator;
+
+    vren::model_optimizer::statistics statistics = vren::model_optimizer::analyze(model);
+
+    for (auto _ : state)
+    {
+        vren::vk_utils::immediate_graphics_queue_submit(context, [&](VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+        {
+            render_graph_allocator.clear();
+
+            vren::render_graph_builder render_graph(render_graph_allocator);
+            render_graph.concat(vren::clear_depth_stencil_buffer(render_graph_allocator, depth_buffer.get_image(), { .depth = 1.0f }));
+            render_graph.concat(vren::clear_gbuffer(render_graph_allocator, gbuffer));
+            render_graph.concat(VREN_TEST_APP()->m_profiler.profile(
+                render_graph_allocator,
+                basic_renderer.render(render_graph_allocator, k_screen, camera, draw_buffer, gbuffer, depth_buffer),
+                0
+            ));
+
+            vren::render_graph_executor executor(0, command_buffer, resource_container);
+            executor.execute(render_graph_allocator, render_graph.get_head());
+        });
+
+        uint64_t elapsed_time = VREN_TEST_APP()->m_profiler.read_elapsed_time(0);
+
+        state.SetIterationTime(elapsed_time / (double) 1e9);
+    }
+
+    state.counters["ACMR"] = statistics.m_acmr;
+    state.counters["ATVR"] = statistics.m_atvr;
+    state.counters["Overdraw"] = statistics.m_overdraw;
+}
+
+BENCHMARK(BM_gpu_basic_renderer_raster)
+    ->ArgName("optimized")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseManualTime();
+
+// ------------------------------------------------------------------------------------------------
+// Unit testing
+// ------------------------------------------------------------------------------------------------
+
+TEST(ModelOptimizer, Statistics)
+{
+    vren::model model = vren_test::create_procedural_model(8, 64, 128);
+    std::vector<uint32_t> original_indices = model.m_indices;
+
+    vren::model_optimizer::statistics before = vren::model_optimizer::analyze(model);
+
+    vren::model_optimizer model_optimizer{};
+    model_optimizer.optimize(model);
+
+    vren::model_optimizer::statistics after = vren::model_optimizer::analyze(model);
+
+    printf("Before optimization - ACMR: %.3f, ATVR: %.3f, Overdraw: %.3f\n", before.m_acmr, before.m_atvr, before.m_overdraw);
+    printf("After optimization  - ACMR: %.3f, ATVR: %.3f, Overdraw: %.3f\n", after.m_acmr, after.m_atvr, after.m_overdraw);
+
+    EXPECT_LT(after.m_acmr, before.m_acmr);
+    EXPECT_LE(after.m_overdraw, before.m_overdraw * vren::model_optimizer::k_overdraw_threshold);
+
+    // Indices must still address the (possibly shrunk) vertex range of their mesh
+    ASSERT_EQ(model.m_indices.size(), original_indices.size());
+    for (vren::model::mesh const& mesh : model.m_meshes)
+    {
+        for (uint32_t i = mesh.m_index_offset; i < mesh.m_index_offset + mesh.m_index_count; i++)
+        {
+            EXPECT_LT(model.m_indices[i], mesh.m_vertex_count);
+        }
+    }
+}
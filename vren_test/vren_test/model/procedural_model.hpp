@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+#include <glm/gtc/constants.hpp>
+
+#include <vren/model/model.hpp>
+
+namespace vren_test
+{
+    /** Generates a model made of `mesh_count` UV-spheres (one instance each) with `ring_count` x `segment_count` quads each.
+     * Triangles are shuffled to emulate a badly ordered index buffer.
+     */
+    inline vren::model create_procedural_model(uint32_t mesh_count, uint32_t ring_count, uint32_t segment_count, uint32_t seed = 0)
+    {
+        std::mt19937 rng(seed);
+
+        vren::model model{};
+        model.m_name = "procedural_model";
+
+        for (uint32_t mesh_idx = 0; mesh_idx < mesh_count; mesh_idx++)
+        {
+            vren::model::mesh mesh{};
+            mesh.m_vertex_offset = model.m_vertices.size();
+            mesh.m_index_offset = model.m_indices.size();
+            mesh.m_instance_offset = model.m_instances.size();
+            mesh.m_instance_count = 1;
+            mesh.m_material_idx = 0;
+
+            glm::vec3 center((float) mesh_idx * 3.0f, 0.0f, 0.0f);
+
+            for (uint32_t ring = 0; ring <= ring_count; ring++)
+            {
+                for (uint32_t segment = 0; segment <= segment_count; segment++)
+                {
+                    float theta = ring / (float) ring_count * glm::pi<float>();
+                    float phi = segment / (float) segment_count * glm::two_pi<float>();
+
+                    glm::vec3 normal(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+
+                    model.m_vertices.push_back(vren::vertex{
+                        .m_position = center + normal,
+                        .m_normal = normal,
+                        .m_texcoords = glm::vec2(segment / (float) segment_count, ring / (float) ring_count)
+                    });
+                }
+            }
+
+            std::vector<uint32_t> indices;
+            for (uint32_t ring = 0; ring < ring_count; ring++)
+            {
+                for (uint32_t segment = 0; segment < segment_count; segment++)
+                {
+                    uint32_t a = ring * (segment_count + 1) + segment;
+                    uint32_t b = a + segment_count + 1;
+
+                    indices.insert(indices.end(), { a, b, a + 1 });
+                    indices.insert(indices.end(), { a + 1, b, b + 1 });
+                }
+            }
+
+            std::vector<uint32_t> triangles(indices.size() / 3);
+            for (uint32_t i = 0; i < triangles.size(); i++) triangles[i] = i;
+            std::shuffle(triangles.begin(), triangles.end(), rng);
+
+            for (uint32_t triangle : triangles)
+            {
+                // Mesh indices are relative to the mesh' vertex offset
+                model.m_indices.insert(model.m_indices.end(), { indices[triangle * 3], indices[triangle * 3 + 1], indices[triangle * 3 + 2] });
+            }
+
+            mesh.m_vertex_count = model.m_vertices.size() - mesh.m_vertex_offset;
+            mesh.m_index_count = model.m_indices.size() - mesh.m_index_offset;
+
+            model.m_instances.push_back(vren::mesh_instance{ .m_transform = glm::mat4(1.0f) });
+            model.m_meshes.push_back(mesh);
+        }
+
+        model.compute_aabb();
+
+        return model;
+    }
+}
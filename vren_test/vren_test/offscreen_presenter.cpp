@@ -0,0 +1,343 @@
+#include <gtest/gtest.h>
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <vren/offscreen_presenter.hpp>
+#include <vren/camera.hpp>
+#include <vren/light.hpp>
+#include <vren/material.hpp>
+#include <vren/toolbox.hpp>
+#include <vren/model/model_clusterizer.hpp>
+#include <vren/model/clusterized_model_uploader.hpp>
+#include <vren/pipeline/render_graph.hpp>
+#include <vren/pipeline/mesh_shader_renderer.hpp>
+#include <vren/pipeline/clustered_shading.hpp>
+#include <vren/pipeline/cascaded_shadow_map.hpp>
+#include <vren/pipeline/depth_buffer_pyramid.hpp>
+
+#include "app.hpp"
+#include "model/procedural_model.hpp"
+
+namespace
+{
+	// Clears the presented image: the offscreen images are left in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+	void present_clear(vren::offscreen_presenter& presenter, vren::render_graph_allocator& allocator, VkClearColorValue clear_color_value)
+	{
+		presenter.present([&](uint32_t frame_idx, uint32_t swapchain_image_idx, vren::swapchain const& swapchain, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+		{
+			vren::render_graph_t graph = vren::clear_color_buffer(allocator, swapchain.m_images.at(swapchain_image_idx), clear_color_value);
+
+			vren::render_graph_executor executor(frame_idx, command_buffer, resource_container);
+			executor.execute(allocator, graph);
+
+			allocator.clear();
+		});
+	}
+
+	// A white texture shared by the materials of the benchmarks, added once to the texture manager of the test context
+	uint32_t get_white_texture_idx(vren::context const& context)
+	{
+		static uint32_t texture_idx = [&]()
+		{
+			vren::texture_manager& texture_manager = context.m_toolbox->m_texture_manager;
+
+			texture_manager.m_textures.push_back(vren::vk_utils::create_color_texture(context, 255, 255, 255, 255));
+			texture_manager.rewrite_descriptor_set();
+
+			return (uint32_t) texture_manager.m_textures.size() - 1;
+		}();
+		return texture_idx;
+	}
+
+	/** A whole frame as rendered by the demo: a procedural model drawn by the mesh shader renderer (with occlusion culling), lit by
+	 * random point lights and a directional light through the clustered shading, then blit to the presented image. The shadow map
+	 * isn't rendered.
+	 */
+	class full_frame
+	{
+	public:
+		static constexpr uint32_t k_sphere_count = 32;
+
+	private:
+		uint32_t m_width, m_height;
+
+		vren::mesh_shader_renderer m_mesh_shader_renderer;
+		vren::cluster_and_shade m_cluster_and_shade;
+		vren::cascaded_shadow_map m_cascaded_shadow_map; // Only bound by the shading, m_directional_light_shadows is off
+		vren::depth_buffer_reductor m_depth_buffer_reductor;
+
+		vren::clusterized_model_draw_buffer m_draw_buffer;
+		vren::material_buffer m_material_buffer;
+
+		vren::gbuffer m_gbuffer;
+		vren::vk_utils::color_buffer_t m_color_buffer;
+		vren::vk_utils::depth_buffer_t m_depth_buffer;
+		vren::depth_buffer_pyramid m_depth_buffer_pyramid;
+
+		vren::camera m_camera{};
+		vren::render_graph_allocator m_allocator;
+
+		static vren::clusterized_model_draw_buffer upload_model(vren::context const& context)
+		{
+			vren::model model = vren_test::create_procedural_model(k_sphere_count, 32, 64);
+
+			vren::model_clusterizer model_clusterizer{};
+			vren::clusterized_model clusterized_model = model_clusterizer.clusterize(model);
+
+			vren::clusterized_model_uploader clusterized_model_uploader{};
+			return clusterized_model_uploader.upload(context, clusterized_model);
+		}
+
+	public:
+		vren::light_store m_light_store;
+
+		full_frame(vren::context const& context, uint32_t width, uint32_t height, uint32_t point_light_count) :
+			m_width(width),
+			m_height(height),
+			m_mesh_shader_renderer(context, true),
+			m_cluster_and_shade(context),
+			m_cascaded_shadow_map(context),
+			m_depth_buffer_reductor(context),
+			m_draw_buffer(upload_model(context)),
+			m_material_buffer(context),
+			m_gbuffer(context, width, height),
+			m_color_buffer(vren::vk_utils::create_color_buffer(
+				context,
+				width, height,
+				VREN_COLOR_BUFFER_OUTPUT_FORMAT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT
+			)),
+			m_depth_buffer(vren::vk_utils::create_depth_buffer(
+				context,
+				width, height,
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+			)),
+			m_depth_buffer_pyramid(context, width, height),
+			m_light_store(context)
+		{
+			m_cluster_and_shade.m_directional_light_shadows = false;
+
+			// The spheres are lined up along the x axis, the camera looks at all of them
+			float model_length = (k_sphere_count - 1) * 3.0f;
+
+			m_camera.m_position = glm::vec3(model_length / 2.0f, 0.0f, -model_length * 0.75f);
+			m_camera.m_aspect_ratio = width / (float) height;
+
+			m_material_buffer.m_buffer.get_mapped_pointer<vren::material>()[0] = vren::material{
+				.m_base_color_texture_idx = get_white_texture_idx(context),
+				.m_metallic_roughness_texture_idx = get_white_texture_idx(context),
+				.m_metallic_factor = 0.0f,
+				.m_roughness_factor = 0.5f,
+				.m_base_color_factor = glm::vec4(1.0f),
+			};
+			m_material_buffer.m_material_count = 1;
+
+			// Lights
+			m_light_store.m_directional_lights.resize(1);
+			m_light_store.m_directional_lights.edit(0, 1)[0] = {
+				.m_direction = glm::vec3(1.0f, 1.0f, 0.0f),
+				.m_color = glm::vec3(1.0f, 1.0f, 1.0f),
+			};
+
+			std::mt19937 rng(0);
+			std::uniform_real_distribution<float> x_distribution(-2.0f, model_length + 2.0f);
+			std::uniform_real_distribution<float> yz_distribution(-2.0f, 2.0f);
+			std::uniform_real_distribution<float> color_distribution(0.0f, 1.0f);
+
+			m_light_store.m_point_light_positions.resize(point_light_count);
+			m_light_store.m_point_lights.resize(point_light_count);
+
+			std::span<glm::vec4> point_light_positions = m_light_store.m_point_light_positions.edit(0, point_light_count);
+			std::span<vren::point_light> point_lights = m_light_store.m_point_lights.edit(0, point_light_count);
+			for (uint32_t i = 0; i < point_light_count; i++)
+			{
+				point_light_positions[i] = glm::vec4(x_distribution(rng), yz_distribution(rng), yz_distribution(rng), 1.0f);
+				point_lights[i] = {
+					.m_color = glm::vec3(color_distribution(rng), color_distribution(rng), color_distribution(rng)),
+					.m_intensity = 1.0f,
+				};
+			}
+		}
+
+		void render(uint32_t frame_idx, uint32_t swapchain_image_idx, vren::swapchain const& swapchain, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+		{
+			// The frames in flight share the output buffers, they're processed sequentially as in the demo
+			VkMemoryBarrier memory_barrier{
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				.pNext = nullptr,
+				.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+			};
+			vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, NULL, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+
+			glm::uvec2 screen(m_width, m_height);
+			vren::camera_data camera_data{
+				.m_position = m_camera.m_position,
+				.m_view = m_camera.get_view(),
+				.m_projection = m_camera.get_projection(),
+				.m_z_near = m_camera.m_near_plane,
+			};
+
+			vren::light_array& light_array = m_light_store.get_light_array();
+
+			vren::render_graph_builder render_graph(m_allocator);
+
+			if (m_light_store.is_dirty())
+			{
+				m_cluster_and_shade.invalidate_light_assignments();
+			}
+			render_graph.concat(m_light_store.upload(m_allocator, frame_idx));
+
+			render_graph.concat(vren::clear_color_buffer(m_allocator, m_color_buffer.get_image(), { 0.0f, 0.0f, 0.0f, 0.0f }));
+			render_graph.concat(vren::clear_depth_stencil_buffer(m_allocator, m_depth_buffer.get_image(), { .depth = 1.0f }));
+			render_graph.concat(vren::clear_gbuffer(m_allocator, m_gbuffer));
+
+			render_graph.concat(m_mesh_shader_renderer.render(m_allocator, screen, camera_data, light_array, m_draw_buffer, m_depth_buffer_pyramid, m_gbuffer, m_depth_buffer));
+			render_graph.concat(m_cluster_and_shade(m_allocator, screen, m_camera, m_gbuffer, m_depth_buffer, light_array, m_material_buffer, m_cascaded_shadow_map, m_color_buffer));
+			render_graph.concat(m_depth_buffer_reductor.copy_and_reduce(m_allocator, m_depth_buffer, m_depth_buffer_pyramid));
+
+			render_graph.concat(vren::transit_color_buffer_to_blit_layout(m_allocator, m_color_buffer));
+
+			vren::render_graph_executor executor(frame_idx, command_buffer, resource_container);
+			executor.execute(m_allocator, render_graph.get_head());
+
+			m_allocator.clear();
+
+			vren::record_blit_color_buffer_to_swapchain_image(
+				command_buffer,
+				m_color_buffer,
+				m_width,
+				m_height,
+				swapchain.m_images.at(swapchain_image_idx),
+				swapchain.m_image_width,
+				swapchain.m_image_height
+			);
+		}
+	};
+}
+
+// ------------------------------------------------------------------------------------------------
+// Benchmark
+// ------------------------------------------------------------------------------------------------
+
+static void BM_offscreen_presenter_present(benchmark::State& state)
+{
+	vren::render_graph_allocator allocator;
+	vren::offscreen_presenter presenter(VREN_TEST_APP()->m_context, vren::offscreen_presenter_info{
+		.m_width = 1920,
+		.m_height = 1080,
+		.m_final_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.m_readback_interval = (uint32_t) state.range(0),
+	});
+
+	for (auto _ : state)
+	{
+		present_clear(presenter, allocator, VkClearColorValue{ .float32 = { 1.0f, 0.0f, 0.0f, 1.0f } });
+	}
+
+	presenter.flush();
+}
+
+BENCHMARK(BM_offscreen_presenter_present)
+	->Unit(benchmark::kMicrosecond)
+	->Arg(0) // No readback
+	->Arg(1);
+
+/// Once the frames in flight are full, presenting waits for the oldest frame: the time per iteration is the GPU frame time.
+static void BM_offscreen_presenter_full_frame(benchmark::State& state)
+{
+	vren::context const& context = VREN_TEST_APP()->m_context;
+
+	full_frame frame(context, 1920, 1080, (uint32_t) state.range(0));
+	vren::offscreen_presenter presenter(context, vren::offscreen_presenter_info{
+		.m_width = 1920,
+		.m_height = 1080,
+	});
+
+	auto render_func = [&](uint32_t frame_idx, uint32_t swapchain_image_idx, vren::swapchain const& swapchain, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+	{
+		frame.render(frame_idx, swapchain_image_idx, swapchain, command_buffer, resource_container);
+	};
+
+	// Warm-up: the lights are uploaded and the frames in flight are filled
+	for (uint32_t i = 0; i < VREN_MAX_FRAME_IN_FLIGHT_COUNT || frame.m_light_store.is_dirty(); i++)
+	{
+		presenter.present(render_func);
+	}
+
+	for (auto _ : state)
+	{
+		presenter.present(render_func);
+	}
+
+	presenter.flush();
+}
+
+BENCHMARK(BM_offscreen_presenter_full_frame)
+	->Unit(benchmark::kMillisecond)
+	->Arg(1024) // Point light count
+	->Arg(16384);
+
+// ------------------------------------------------------------------------------------------------
+// Unit testing
+// ------------------------------------------------------------------------------------------------
+
+TEST(offscreen_presenter, readback)
+{
+	const uint32_t k_frame_count = 5;
+
+	struct readback_texel
+	{
+		uint64_t m_frame_number;
+		std::array<uint8_t, 4> m_texel;
+	};
+	std::vector<readback_texel> readback_texels;
+
+	vren::render_graph_allocator allocator;
+	vren::offscreen_presenter presenter(VREN_TEST_APP()->m_context, vren::offscreen_presenter_info{
+		.m_width = 64,
+		.m_height = 32,
+		.m_format = VK_FORMAT_R8G8B8A8_UNORM,
+		.m_final_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.m_readback_interval = 1,
+		.m_readback_callback = [&](vren::offscreen_readback const& readback)
+		{
+			ASSERT_EQ(readback.m_pixels.size(), readback.m_width * readback.m_height * 4);
+
+			// Last texel
+			size_t offset = readback.m_pixels.size() - 4;
+			readback_texels.push_back(readback_texel{
+				.m_frame_number = readback.m_frame_number,
+				.m_texel = { readback.m_pixels[offset], readback.m_pixels[offset + 1], readback.m_pixels[offset + 2], readback.m_pixels[offset + 3] },
+			});
+		},
+	});
+
+	ASSERT_EQ(presenter.get_swapchain()->m_handle, VK_NULL_HANDLE);
+	ASSERT_EQ(presenter.get_swapchain()->m_images.size(), 3);
+
+	for (uint32_t i = 0; i < k_frame_count; i++)
+	{
+		present_clear(presenter, allocator, VkClearColorValue{ .float32 = { (i * 10) / 255.0f, 0.0f, 1.0f, 1.0f } });
+	}
+
+	presenter.flush();
+
+	// Every frame is read back once, in order
+	ASSERT_EQ(readback_texels.size(), k_frame_count);
+	for (uint32_t i = 0; i < k_frame_count; i++)
+	{
+		ASSERT_EQ(readback_texels.at(i).m_frame_number, i);
+		ASSERT_NEAR(readback_texels.at(i).m_texel[0], i * 10, 1);
+		ASSERT_EQ(readback_texels.at(i).m_texel[1], 0);
+		ASSERT_EQ(readback_texels.at(i).m_texel[2], 255);
+		ASSERT_EQ(readback_texels.at(i).m_texel[3], 255);
+	}
+
+	ASSERT_EQ(presenter.get_frame_number(), k_frame_count);
+}
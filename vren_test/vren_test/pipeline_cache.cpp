@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include <vren/vk_helpers/pipeline_cache.hpp>
+
+namespace
+{
+	VkPhysicalDeviceProperties make_physical_device_properties(uint32_t vendor_id, uint32_t device_id)
+	{
+		VkPhysicalDeviceProperties properties{};
+		properties.vendorID = vendor_id;
+		properties.deviceID = device_id;
+		properties.driverVersion = 42;
+		for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+		{
+			properties.pipelineCacheUUID[i] = (uint8_t) i;
+		}
+		return properties;
+	}
+
+	// A pipeline cache file as written by vren::vk_utils::save_pipeline_cache, the driver data is only the Vulkan header and some payload
+	std::vector<uint8_t> make_pipeline_cache_file(VkPhysicalDeviceProperties const& properties)
+	{
+		VkPipelineCacheHeaderVersionOne vk_header{
+			.headerSize = sizeof(VkPipelineCacheHeaderVersionOne),
+			.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE,
+			.vendorID = properties.vendorID,
+			.deviceID = properties.deviceID,
+		};
+		std::memcpy(vk_header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+		size_t data_size = sizeof(vk_header) + 64;
+
+		vren::vk_utils::pipeline_cache_file_header header = vren::vk_utils::make_pipeline_cache_file_header(properties, data_size);
+
+		std::vector<uint8_t> file_data(sizeof(header) + data_size, 0xab);
+		std::memcpy(file_data.data(), &header, sizeof(header));
+		std::memcpy(file_data.data() + sizeof(header), &vk_header, sizeof(vk_header));
+		return file_data;
+	}
+}
+
+TEST(pipeline_cache, valid_file)
+{
+	VkPhysicalDeviceProperties properties = make_physical_device_properties(0x10de, 0x2204);
+	ASSERT_TRUE(vren::vk_utils::is_pipeline_cache_file_valid(properties, make_pipeline_cache_file(properties)));
+}
+
+TEST(pipeline_cache, bad_magic)
+{
+	VkPhysicalDeviceProperties properties = make_physical_device_properties(0x10de, 0x2204);
+
+	std::vector<uint8_t> file_data = make_pipeline_cache_file(properties);
+	uint32_t magic = 0xdeadbeef;
+	std::memcpy(file_data.data() + offsetof(vren::vk_utils::pipeline_cache_file_header, m_magic), &magic, sizeof(magic));
+
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(properties, file_data));
+}
+
+TEST(pipeline_cache, other_vendor_or_device)
+{
+	VkPhysicalDeviceProperties properties = make_physical_device_properties(0x10de, 0x2204);
+	std::vector<uint8_t> file_data = make_pipeline_cache_file(properties);
+
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(make_physical_device_properties(0x1002, 0x2204), file_data));
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(make_physical_device_properties(0x10de, 0x2206), file_data));
+
+	// Another driver version with the same pipeline cache UUID
+	VkPhysicalDeviceProperties other_driver_properties = properties;
+	other_driver_properties.driverVersion++;
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(other_driver_properties, file_data));
+
+	// The Vulkan header written by the driver disagrees with the file header
+	size_t vk_header_offset = sizeof(vren::vk_utils::pipeline_cache_file_header);
+	uint32_t device_id = 0x2206;
+	std::memcpy(file_data.data() + vk_header_offset + offsetof(VkPipelineCacheHeaderVersionOne, deviceID), &device_id, sizeof(device_id));
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(properties, file_data));
+}
+
+TEST(pipeline_cache, truncated_file)
+{
+	VkPhysicalDeviceProperties properties = make_physical_device_properties(0x10de, 0x2204);
+	std::vector<uint8_t> file_data = make_pipeline_cache_file(properties);
+
+	// Shorter than the data size written in the header
+	file_data.pop_back();
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(properties, file_data));
+
+	// Shorter than the header
+	file_data.resize(sizeof(vren::vk_utils::pipeline_cache_file_header) - 1);
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(properties, file_data));
+
+	ASSERT_FALSE(vren::vk_utils::is_pipeline_cache_file_valid(properties, {}));
+}
@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+
+#include <vren/primitives/primitive_tuning.hpp>
+
+VkPhysicalDeviceProperties make_physical_device_properties(uint32_t vendor_id, uint32_t max_workgroup_invocations = 1024)
+{
+	VkPhysicalDeviceProperties properties{};
+	properties.vendorID = vendor_id;
+	properties.limits.maxComputeWorkGroupSize[0] = 1024;
+	properties.limits.maxComputeWorkGroupInvocations = max_workgroup_invocations;
+	properties.limits.maxComputeSharedMemorySize = 32768;
+	return properties;
+}
+
+TEST(primitive_tuning, vendor_entries)
+{
+	vren::primitive_tuning nvidia = vren::find_primitive_tuning(make_physical_device_properties(0x10DE), 32);
+	ASSERT_EQ(nvidia.m_reduce_workgroup_size, 1024);
+	ASSERT_EQ(nvidia.m_blelloch_scan_workgroup_size, 1024);
+
+	vren::primitive_tuning amd_wave64 = vren::find_primitive_tuning(make_physical_device_properties(0x1002), 64);
+	ASSERT_EQ(amd_wave64.m_reduce_workgroup_size, 256);
+	ASSERT_EQ(amd_wave64.m_bucket_sort_workgroup_size, 256);
+
+	// Unknown vendor, the last entry of the table
+	vren::primitive_tuning unknown = vren::find_primitive_tuning(make_physical_device_properties(0x1234), 16);
+	ASSERT_EQ(unknown.m_reduce_workgroup_size, 1024);
+}
+
+TEST(primitive_tuning, device_limits)
+{
+	// Rounded down to a power of two within the limits
+	vren::primitive_tuning tuning = vren::find_primitive_tuning(make_physical_device_properties(0x10DE, 768), 32);
+	ASSERT_EQ(tuning.m_reduce_workgroup_size, 512);
+	ASSERT_EQ(tuning.m_blelloch_scan_workgroup_size, 512);
+	ASSERT_EQ(tuning.m_bucket_sort_workgroup_size, 512);
+
+	// The reduction holds a vec4 per invocation in shared memory
+	VkPhysicalDeviceProperties properties = make_physical_device_properties(0x10DE);
+	properties.limits.maxComputeSharedMemorySize = 4096;
+
+	tuning = vren::find_primitive_tuning(properties, 32);
+	ASSERT_EQ(tuning.m_reduce_workgroup_size, 256);
+	ASSERT_EQ(tuning.m_blelloch_scan_workgroup_size, 1024);
+}
+
+TEST(primitive_tuning, table)
+{
+	std::span<vren::primitive_tuning_table_entry const> table = vren::get_primitive_tuning_table();
+	ASSERT_FALSE(table.empty());
+
+	// The last entry matches any device
+	ASSERT_EQ(table.back().m_vendor_id, 0);
+	ASSERT_EQ(table.back().m_device_id, 0);
+	ASSERT_EQ(table.back().m_subgroup_size, 0);
+}
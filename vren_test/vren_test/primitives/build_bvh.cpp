@@ -122,6 +122,7 @@ void run_build_bvh_test(
             node.m_next = vren::bvh_node::k_leaf_node;
             node.m_min = pos - ext;
             node.m_max = pos + ext;
+            node.m_radius = glm::length(ext);
         }
         else
         {
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#include <vren/pipeline/render_graph.hpp>
+#include <vren/pipeline/profiler.hpp>
+#include <vren/vk_helpers/buffer.hpp>
+#include <vren/vk_helpers/command_recorder.hpp>
+#include <vren/vk_helpers/misc.hpp>
+
+#include "app.hpp"
+
+namespace
+{
+	constexpr uint32_t k_node_count = 8;
+	constexpr size_t k_region_size = 256 * 1024; // Large enough for an unsynchronized copy to read a partially filled region
+
+	/** A chain of transfer nodes, every other one marked for parallel recording. The first node fills the first region of the buffer,
+	 * then every node copies the previous region to its own: all the regions are filled only if the nodes were executed in order with
+	 * a barrier between them. Every node also writes its index to the last word of the buffer.
+	 */
+	vren::render_graph_t make_copy_chain(
+		vren::render_graph_allocator& allocator,
+		vren::vk_utils::buffer const& buffer,
+		std::array<std::atomic<uint32_t>, k_node_count>& record_counts
+	)
+	{
+		vren::render_graph_builder builder(allocator);
+
+		for (uint32_t node_idx = 0; node_idx < k_node_count; node_idx++)
+		{
+			vren::render_graph_node* node = allocator.allocate();
+
+			node->set_name("copy_chain");
+			node->set_src_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+			node->set_dst_stage(VK_PIPELINE_STAGE_TRANSFER_BIT);
+			node->set_parallel_recording(node_idx % 2 == 1);
+
+			node->add_buffer({ .m_name = "copy_chain_buffer", .m_buffer = buffer.m_buffer.m_handle }, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT);
+
+			node->set_callback([&buffer, &record_counts, node_idx](uint32_t frame_idx, VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+			{
+				record_counts.at(node_idx)++;
+
+				if (node_idx == 0)
+				{
+					vkCmdFillBuffer(command_buffer, buffer.m_buffer.m_handle, 0, k_region_size, 1);
+				}
+				else
+				{
+					VkBufferCopy region{
+						.srcOffset = (node_idx - 1) * k_region_size,
+						.dstOffset = node_idx * k_region_size,
+						.size = k_region_size
+					};
+					vkCmdCopyBuffer(command_buffer, buffer.m_buffer.m_handle, buffer.m_buffer.m_handle, 1, &region);
+				}
+
+				vkCmdFillBuffer(command_buffer, buffer.m_buffer.m_handle, k_node_count * k_region_size, sizeof(uint32_t), node_idx);
+			});
+
+			builder.concat(vren::render_graph_gather(node));
+		}
+
+		return builder.get_head();
+	}
+
+	void run_copy_chain(vren::profiler* profiler)
+	{
+		vren::context const& context = VREN_TEST_APP()->m_context;
+
+		vren::vk_utils::buffer buffer = vren::vk_utils::alloc_host_visible_buffer(
+			context,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			k_node_count * k_region_size + sizeof(uint32_t),
+			true
+		);
+		std::memset(buffer.get_mapped_pointer<uint8_t>(), 0, k_node_count * k_region_size + sizeof(uint32_t));
+
+		std::array<std::atomic<uint32_t>, k_node_count> record_counts{};
+
+		vren::render_graph_allocator allocator;
+		vren::render_graph_t graph = make_copy_chain(allocator, buffer, record_counts);
+		if (profiler)
+		{
+			graph = profiler->profile_scope(allocator, graph, "render_graph_executor"); // Counts the pipeline statistics
+		}
+
+		vren::vk_utils::immediate_graphics_queue_submit(context, [&](VkCommandBuffer command_buffer, vren::resource_container& resource_container)
+		{
+			vren::render_graph_executor executor(0, command_buffer, resource_container, profiler, context.m_command_recorder.get());
+			executor.execute(allocator, graph);
+		});
+
+		if (profiler)
+		{
+			profiler->read_scopes(0);
+		}
+
+		// Every node is recorded once, on a worker or on the primary command buffer
+		for (uint32_t node_idx = 0; node_idx < k_node_count; node_idx++)
+		{
+			ASSERT_EQ(record_counts.at(node_idx).load(), 1);
+		}
+
+		uint32_t const* data = buffer.get_mapped_pointer<uint32_t>();
+		for (size_t i = 0; i < k_node_count * k_region_size / sizeof(uint32_t); i++)
+		{
+			ASSERT_EQ(data[i], 1) << "Region " << (i * sizeof(uint32_t) / k_region_size) << " wasn't copied in order";
+		}
+
+		ASSERT_EQ(data[k_node_count * k_region_size / sizeof(uint32_t)], k_node_count - 1); // The last node was executed last
+	}
+}
+
+TEST(render_graph_executor, command_recorder_execution_order)
+{
+	run_copy_chain(nullptr);
+}
+
+TEST(render_graph_executor, command_recorder_execution_order_profiled)
+{
+	// Without inherited queries the parallel nodes are recorded on the primary command buffer, within the pipeline statistics query
+	run_copy_chain(&VREN_TEST_APP()->m_profiler);
+
+	vren::profiler_scope const* scope = VREN_TEST_APP()->m_profiler.find_scope("render_graph_executor");
+	ASSERT_NE(scope, nullptr);
+	ASSERT_TRUE(scope->m_has_pipeline_statistics);
+}
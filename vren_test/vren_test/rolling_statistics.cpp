@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <vren/base/rolling_statistics.hpp>
+
+TEST(rolling_statistics, empty)
+{
+	vren::rolling_statistics statistics{};
+	ASSERT_EQ(statistics.get_sample_count(), 0);
+	ASSERT_EQ(statistics.get_last(), 0.0);
+	ASSERT_EQ(statistics.get_avg(), 0.0);
+	ASSERT_EQ(statistics.get_p99(), 0.0);
+}
+
+TEST(rolling_statistics, percentiles)
+{
+	vren::rolling_statistics statistics(100);
+	for (uint32_t i = 1; i <= 100; i++)
+	{
+		statistics.push(double(i));
+	}
+
+	ASSERT_EQ(statistics.get_min(), 1.0);
+	ASSERT_EQ(statistics.get_max(), 100.0);
+	ASSERT_DOUBLE_EQ(statistics.get_avg(), 50.5);
+	ASSERT_EQ(statistics.get_percentile(0.5), 50.0);
+	ASSERT_EQ(statistics.get_p99(), 99.0);
+}
+
+TEST(rolling_statistics, window)
+{
+	// The oldest samples are dropped once the window is full
+	vren::rolling_statistics statistics(4);
+	for (double sample : { 5.0, 1.0, 3.0, 2.0, 4.0 })
+	{
+		statistics.push(sample);
+	}
+
+	ASSERT_EQ(statistics.get_sample_count(), 4);
+	ASSERT_EQ(statistics.get_last(), 4.0);
+	ASSERT_EQ(statistics.get_min(), 1.0);
+	ASSERT_EQ(statistics.get_max(), 4.0);
+	ASSERT_DOUBLE_EQ(statistics.get_avg(), 2.5);
+}
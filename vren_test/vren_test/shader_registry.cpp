@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <vren/vk_helpers/shader_registry.hpp>
+
+#include "app.hpp"
+
+namespace
+{
+	std::filesystem::path make_temp_dir(char const* name)
+	{
+		std::filesystem::path dir = std::filesystem::temp_directory_path() / name;
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir);
+		return dir;
+	}
+
+	void write_file(std::filesystem::path const& path, std::string const& content)
+	{
+		std::ofstream f(path, std::ios::binary | std::ios::trunc);
+		f << content;
+	}
+
+	std::filesystem::path normalize(std::filesystem::path const& path)
+	{
+		return std::filesystem::weakly_canonical(path);
+	}
+
+	// A pipeline without Vulkan objects: the reloaded pipelines are only swapped, never bound
+	vren::pipeline make_null_pipeline()
+	{
+		vren::context const& context = VREN_TEST_APP()->m_context;
+		return vren::pipeline(context, {}, VK_NULL_HANDLE, vren::vk_pipeline(context, VK_NULL_HANDLE), VK_PIPELINE_BIND_POINT_COMPUTE);
+	}
+}
+
+TEST(shader_registry, source_spv_paths)
+{
+	std::filesystem::path dir = make_temp_dir("vren_test_shader_registry_sources");
+	std::filesystem::path include_dir = dir / "include";
+	std::filesystem::create_directories(include_dir);
+
+	write_file(dir / "a.comp", "");
+	write_file(dir / "b.comp", "");
+	write_file(include_dir / "common.glsl", "");
+
+	// As written by compile_shader: the SPIR-V, the source and the glslc command, separated by tabs
+	std::string include_arguments = "\t-I\t" + include_dir.string();
+	write_file(dir / "shader_sources.txt",
+		(dir / "a.comp.spv").string() + "\t" + (dir / "a.comp").string() + "\tglslc" + include_arguments + "\n" +
+		(dir / "a_variant.comp.spv").string() + "\t" + (dir / "a.comp").string() + "\tglslc\t-DVARIANT" + include_arguments + "\n" +
+		(dir / "b.comp.spv").string() + "\t" + (dir / "b.comp").string() + "\tglslc\n"
+	);
+
+	vren::shader_registry registry(VREN_TEST_APP()->m_context, dir / "shader_sources.txt");
+
+	// A source maps to all the SPIR-V built from it
+	std::vector<std::filesystem::path> expected_a_spv_paths{ normalize(dir / "a.comp.spv"), normalize(dir / "a_variant.comp.spv") };
+	ASSERT_EQ(registry.get_spv_paths(dir / "a.comp"), expected_a_spv_paths);
+
+	std::vector<std::filesystem::path> expected_b_spv_paths{ normalize(dir / "b.comp.spv") };
+	ASSERT_EQ(registry.get_spv_paths(dir / "b.comp"), expected_b_spv_paths);
+
+	// An include maps to the shaders of its include directory
+	ASSERT_EQ(registry.get_spv_paths(include_dir / "common.glsl"), expected_a_spv_paths);
+
+	ASSERT_TRUE(registry.get_spv_paths(dir / "unknown.comp").empty());
+}
+
+TEST(shader_registry, reload_watched_pipelines)
+{
+	std::filesystem::path dir = make_temp_dir("vren_test_shader_registry_reload");
+
+	write_file(dir / "a.comp.spv", "a");
+	write_file(dir / "b.comp.spv", "b");
+
+	vren::shader_registry registry(VREN_TEST_APP()->m_context, dir / "shader_sources.txt"); // Not found, only the SPIR-V is watched
+
+	std::atomic<uint32_t> a_reload_count = 0;
+	std::atomic<uint32_t> b_reload_count = 0;
+
+	vren::pipeline a_pipeline = make_null_pipeline();
+	vren::pipeline b_pipeline = make_null_pipeline();
+
+	vren::shader_watch a_watch = registry.watch(a_pipeline, { dir / "a.comp.spv" }, [&]()
+	{
+		a_reload_count++;
+		return make_null_pipeline();
+	});
+	vren::shader_watch b_watch = registry.watch(b_pipeline, { dir / "b.comp.spv" }, [&]()
+	{
+		b_reload_count++;
+		return make_null_pipeline();
+	});
+
+	// Only the pipeline using the changed SPIR-V is reloaded
+	std::filesystem::last_write_time(dir / "a.comp.spv", std::filesystem::last_write_time(dir / "a.comp.spv") + std::chrono::seconds(1));
+
+	vren::resource_container resource_container{};
+
+	uint32_t swapped_count = 0;
+	for (uint32_t i = 0; i < 20 && swapped_count == 0; i++)
+	{
+		std::this_thread::sleep_for(vren::shader_registry::k_poll_interval);
+		swapped_count = registry.swap_reloaded_pipelines(resource_container);
+	}
+
+	ASSERT_EQ(swapped_count, 1);
+	ASSERT_EQ(a_reload_count, 1);
+	ASSERT_EQ(b_reload_count, 0);
+	ASSERT_EQ(resource_container.m_resources.size(), 1); // The old pipeline, kept alive for the frames in flight
+}